@@ -43,25 +43,34 @@ static void ghash_reflect(uint64_t h[2], const uint64_t k[2])
 		h[1] ^= 0xc200000000000000UL;
 }
 
-void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
-			      const struct internal_aes_gcm_key *enc_key)
+void internal_aes_gcm_set_ghash_key(struct internal_ghash_key *ghash_key,
+				    const void *hash_subkey)
 {
 	uint64_t k[2] = { 0 };
 	uint64_t h[2] = { 0 };
 
-	crypto_aes_enc_block(enc_key->data, sizeof(enc_key->data),
-			     enc_key->rounds, state->ctr, k);
+	memcpy(k, hash_subkey, sizeof(k));
 
-	ghash_reflect(state->ghash_key.h, k);
+	ghash_reflect(ghash_key->h, k);
 
 	internal_aes_gcm_gfmul(k, k, h);
-	ghash_reflect(state->ghash_key.h2, h);
+	ghash_reflect(ghash_key->h2, h);
 
 	internal_aes_gcm_gfmul(k, h, h);
-	ghash_reflect(state->ghash_key.h3, h);
+	ghash_reflect(ghash_key->h3, h);
 
 	internal_aes_gcm_gfmul(k, h, h);
-	ghash_reflect(state->ghash_key.h4, h);
+	ghash_reflect(ghash_key->h4, h);
+}
+
+void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
+			      const struct internal_aes_gcm_key *enc_key)
+{
+	uint64_t k[2] = { 0 };
+
+	crypto_aes_enc_block(enc_key->data, sizeof(enc_key->data),
+			     enc_key->rounds, state->ctr, k);
+	internal_aes_gcm_set_ghash_key(&state->ghash_key, k);
 }
 
 static void pmull_ghash_update(int num_blocks, uint64_t dg[2],
@@ -223,26 +223,16 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc, uint32_t flags)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
-	size_t n = 0;
+	short int n = THREAD_ID_INVALID;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
-	}
-
-	thread_unlock_global();
-
-	if (!found_thread)
+	n = thread_claim_free();
+	if (n == THREAD_ID_INVALID)
 		return;
 
+	/* The thread is ours now, its state needs no thread_global_lock */
+	threads[n].state = THREAD_STATE_ACTIVE;
 	l->curr_thread = n;
 
 	threads[n].flags = flags;
@@ -458,8 +448,6 @@ void thread_state_free(void)
 		(void *)(threads[ct].stack_va_end - STACK_THREAD_SIZE),
 		STACK_THREAD_SIZE);
 
-	thread_lock_global();
-
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
@@ -467,7 +455,7 @@ void thread_state_free(void)
 
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		virt_unset_guest();
-	thread_unlock_global();
+	thread_release(ct);
 }
 
 #ifdef CFG_WITH_PAGER
@@ -38,9 +38,11 @@ struct mobj_reg_shm {
 	tee_mm_entry_t *mm;
 	paddr_t page_offset;
 	struct refcount mapcount;
+	unsigned int cache_refs;
 	bool guarded;
 	bool releasing;
 	bool release_frees;
+	bool orphaned;
 	paddr_t pages[];
 };
 
@@ -55,12 +57,45 @@ static size_t mobj_reg_shm_size(size_t nr_pages)
 	return s;
 }
 
-static SLIST_HEAD(reg_shm_head, mobj_reg_shm) reg_shm_list =
-	SLIST_HEAD_INITIALIZER(reg_shm_head);
+/*
+ * Registered shared memory is hashed on cookie. Each bucket has its own
+ * spinlock which also protects the guarded, releasing and release_frees
+ * fields of the mobjs in the bucket.
+ */
+#define REG_SHM_HASH_SIZE	64
+
+SLIST_HEAD(reg_shm_head, mobj_reg_shm);
+
+struct reg_shm_bucket {
+	struct reg_shm_head head;
+	unsigned int lock;
+};
+
+static struct reg_shm_bucket reg_shm_hash[REG_SHM_HASH_SIZE];
 
-static unsigned int reg_shm_slist_lock = SPINLOCK_UNLOCK;
 static unsigned int reg_shm_map_lock = SPINLOCK_UNLOCK;
 
+static struct reg_shm_bucket *reg_shm_bucket(uint64_t cookie)
+{
+	/*
+	 * Cookies are often addresses assigned by normal world, mix in
+	 * the upper bits instead of relying on the lowest ones.
+	 */
+	uint64_t h = cookie * 0x9e3779b97f4a7c15ULL;
+
+	return reg_shm_hash + (h >> 32) % REG_SHM_HASH_SIZE;
+}
+
+static uint32_t reg_shm_lock(struct mobj_reg_shm *r)
+{
+	return cpu_spin_lock_xsave(&reg_shm_bucket(r->cookie)->lock);
+}
+
+static void reg_shm_unlock(struct mobj_reg_shm *r, uint32_t exceptions)
+{
+	cpu_spin_unlock_xrestore(&reg_shm_bucket(r->cookie)->lock, exceptions);
+}
+
 static struct mobj_reg_shm *to_mobj_reg_shm(struct mobj *mobj);
 
 static TEE_Result mobj_reg_shm_get_pa(struct mobj *mobj, size_t offst,
@@ -130,8 +165,17 @@ static void reg_shm_free_helper(struct mobj_reg_shm *mobj_reg_shm)
 
 	cpu_spin_unlock_xrestore(&reg_shm_map_lock, exceptions);
 
-	SLIST_REMOVE(&reg_shm_list, mobj_reg_shm, mobj_reg_shm, next);
-	free(mobj_reg_shm);
+	SLIST_REMOVE(&reg_shm_bucket(mobj_reg_shm->cookie)->head, mobj_reg_shm,
+		     mobj_reg_shm, next);
+
+	/*
+	 * With cache references remaining the structure is freed by the
+	 * last call to mobj_reg_shm_cache_put().
+	 */
+	if (mobj_reg_shm->cache_refs)
+		mobj_reg_shm->orphaned = true;
+	else
+		free(mobj_reg_shm);
 }
 
 static void mobj_reg_shm_free(struct mobj *mobj)
@@ -147,17 +191,17 @@ static void mobj_reg_shm_free(struct mobj *mobj)
 		 * unless mobj_reg_shm_release_by_cookie() is waiting for
 		 * the mobj to be released.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = reg_shm_lock(r);
 		reg_shm_free_helper(r);
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		reg_shm_unlock(r, exceptions);
 	} else {
 		/*
 		 * We've reached the point where an unguarded reg shm can
 		 * be released by cookie. Notify eventual waiters.
 		 */
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = reg_shm_lock(r);
 		r->release_frees = true;
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		reg_shm_unlock(r, exceptions);
 
 		mutex_lock(&shm_mu);
 		if (shm_release_waiters)
@@ -338,9 +382,9 @@ struct mobj *mobj_reg_shm_alloc(paddr_t *pages, size_t num_pages,
 			goto err;
 	}
 
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	SLIST_INSERT_HEAD(&reg_shm_list, mobj_reg_shm, next);
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	exceptions = reg_shm_lock(mobj_reg_shm);
+	SLIST_INSERT_HEAD(&reg_shm_bucket(cookie)->head, mobj_reg_shm, next);
+	reg_shm_unlock(mobj_reg_shm, exceptions);
 
 	return &mobj_reg_shm->mobj;
 err:
@@ -350,17 +394,19 @@ err:
 
 void mobj_reg_shm_unguard(struct mobj *mobj)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	uint32_t exceptions = reg_shm_lock(r);
 
-	to_mobj_reg_shm(mobj)->guarded = false;
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	r->guarded = false;
+	reg_shm_unlock(r, exceptions);
 }
 
-static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
+static struct mobj_reg_shm *reg_shm_find_unlocked(struct reg_shm_bucket *b,
+						  uint64_t cookie)
 {
 	struct mobj_reg_shm *mobj_reg_shm = NULL;
 
-	SLIST_FOREACH(mobj_reg_shm, &reg_shm_list, next)
+	SLIST_FOREACH(mobj_reg_shm, &b->head, next)
 		if (mobj_reg_shm->cookie == cookie)
 			return mobj_reg_shm;
 
@@ -369,10 +415,11 @@ static struct mobj_reg_shm *reg_shm_find_unlocked(uint64_t cookie)
 
 struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 {
-	uint32_t exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	struct mobj_reg_shm *r = reg_shm_find_unlocked(cookie);
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
+	uint32_t exceptions = cpu_spin_lock_xsave(&b->lock);
+	struct mobj_reg_shm *r = reg_shm_find_unlocked(b, cookie);
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 	if (!r)
 		return NULL;
 
@@ -381,6 +428,7 @@ struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie)
 
 TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 {
+	struct reg_shm_bucket *b = reg_shm_bucket(cookie);
 	uint32_t exceptions = 0;
 	struct mobj_reg_shm *r = NULL;
 
@@ -390,14 +438,14 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	 * wrong cookie and perhaps a second time, regardless return
 	 * TEE_ERROR_BAD_PARAMETERS.
 	 */
-	exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
-	r = reg_shm_find_unlocked(cookie);
+	exceptions = cpu_spin_lock_xsave(&b->lock);
+	r = reg_shm_find_unlocked(b, cookie);
 	if (!r || r->guarded || r->releasing)
 		r = NULL;
 	else
 		r->releasing = true;
 
-	cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+	cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 	if (!r)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -418,12 +466,12 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	assert(shm_release_waiters);
 
 	while (true) {
-		exceptions = cpu_spin_lock_xsave(&reg_shm_slist_lock);
+		exceptions = cpu_spin_lock_xsave(&b->lock);
 		if (r->release_frees) {
 			reg_shm_free_helper(r);
 			r = NULL;
 		}
-		cpu_spin_unlock_xrestore(&reg_shm_slist_lock, exceptions);
+		cpu_spin_unlock_xrestore(&b->lock, exceptions);
 
 		if (!r)
 			break;
@@ -437,6 +485,60 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie)
 	return TEE_SUCCESS;
 }
 
+TEE_Result mobj_reg_shm_cache_get(struct mobj *mobj)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj_reg_shm *r = NULL;
+	uint32_t exceptions = 0;
+
+	if (mobj->ops != &mobj_reg_shm_ops)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	r = to_mobj_reg_shm(mobj);
+	exceptions = reg_shm_lock(r);
+	if (r->guarded || r->releasing)
+		res = TEE_ERROR_BAD_STATE;
+	else
+		r->cache_refs++;
+	reg_shm_unlock(r, exceptions);
+
+	return res;
+}
+
+TEE_Result mobj_reg_shm_cache_use(struct mobj *mobj)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	uint32_t exceptions = reg_shm_lock(r);
+
+	assert(r->cache_refs);
+	/*
+	 * The reference held by the registration is only dropped by
+	 * mobj_reg_shm_release_by_cookie() after setting r->releasing so
+	 * the reference counter can't be 0 here unless r->releasing is set.
+	 */
+	if (r->releasing || !refcount_inc(&mobj->refc))
+		res = TEE_ERROR_BAD_STATE;
+	reg_shm_unlock(r, exceptions);
+
+	return res;
+}
+
+void mobj_reg_shm_cache_put(struct mobj *mobj)
+{
+	struct mobj_reg_shm *r = to_mobj_reg_shm(mobj);
+	uint32_t exceptions = reg_shm_lock(r);
+	bool do_free = false;
+
+	assert(r->cache_refs);
+	r->cache_refs--;
+	do_free = !r->cache_refs && r->orphaned;
+	reg_shm_unlock(r, exceptions);
+
+	if (do_free)
+		free(r);
+}
+
 struct mobj *mobj_mapped_shm_alloc(paddr_t *pages, size_t num_pages,
 				  paddr_t page_offset, uint64_t cookie)
 {
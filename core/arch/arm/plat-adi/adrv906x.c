@@ -3,10 +3,12 @@
  * Copyright (c) 2022-2025 Analog Devices Incorporated
  */
 
+#include <assert.h>
 #include <common.h>
 #include <drivers/pl011.h>
 #include <kernel/boot.h>
 #include <kernel/dt.h>
+#include <kernel/mutex.h>
 #include <libfdt.h>
 #include <mm/core_memprot.h>
 #include <mm/core_mmu.h>
@@ -45,6 +47,11 @@ register_phys_mem(MEM_AREA_IO_SEC, OTP_BASE, SMALL_PAGE_SIZE);
 /* Register the physical memory area for OTP registers on the secondary tile */
 register_phys_mem(MEM_AREA_IO_SEC, SEC_OTP_BASE, SMALL_PAGE_SIZE);
 
+/* One lock per OTP controller, primary and secondary tile */
+static struct mutex otp_mutex[2] = { MUTEX_INITIALIZER, MUTEX_INITIALIZER };
+/* Serializes updates of the TE anti-rollback counter */
+static struct mutex te_counter_mutex = MUTEX_INITIALIZER;
+
 static bool is_dual_tile = false;
 static bool is_secondary_linux_enabled = false;
 static uint64_t sysclk_freq = 0ULL;
@@ -122,14 +129,28 @@ bool plat_is_secondary_linux_enabled(void)
 	return is_secondary_linux_enabled;
 }
 
-TEE_Result plat_set_enforcement_counter(void)
+static struct mutex *otp_mutex_of(paddr_t otp_base)
+{
+	assert(otp_base == OTP_BASE || otp_base == SEC_OTP_BASE);
+
+	return &otp_mutex[otp_base == SEC_OTP_BASE];
+}
+
+void plat_otp_lock(paddr_t otp_base)
+{
+	mutex_lock(otp_mutex_of(otp_base));
+}
+
+void plat_otp_unlock(paddr_t otp_base)
+{
+	mutex_unlock(otp_mutex_of(otp_base));
+}
+
+static TEE_Result set_enforcement_counter(vaddr_t base)
 {
-	vaddr_t base;
 	uint32_t current_counter_value;
 	uint32_t counter_value = plat_get_anti_rollback_counter();
 
-	base = (vaddr_t)phys_to_virt_io(OTP_BASE, SMALL_PAGE_SIZE);
-
 	if (adrv906x_otp_get_rollback_counter(base, &current_counter_value) != ADI_OTP_SUCCESS)
 		return TEE_ERROR_GENERIC;
 
@@ -145,7 +166,21 @@ TEE_Result plat_set_enforcement_counter(void)
 	return TEE_SUCCESS;
 }
 
-TEE_Result plat_set_te_enforcement_counter(void)
+TEE_Result plat_set_enforcement_counter(void)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	vaddr_t base;
+
+	base = (vaddr_t)phys_to_virt_io(OTP_BASE, SMALL_PAGE_SIZE);
+
+	plat_otp_lock(OTP_BASE);
+	res = set_enforcement_counter(base);
+	plat_otp_unlock(OTP_BASE);
+
+	return res;
+}
+
+static TEE_Result set_te_enforcement_counter(void)
 {
 	int status = 0;
 	uint32_t current_counter_value;
@@ -171,8 +206,21 @@ TEE_Result plat_set_te_enforcement_counter(void)
 	return TEE_SUCCESS;
 }
 
+TEE_Result plat_set_te_enforcement_counter(void)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	/* The update only increments, concurrent updates would overshoot */
+	mutex_lock(&te_counter_mutex);
+	res = set_te_enforcement_counter();
+	mutex_unlock(&te_counter_mutex);
+
+	return res;
+}
+
 TEE_Result plat_get_enforcement_counter(uint32_t param_types, TEE_Param params[TEE_NUM_PARAMS])
 {
+	int ret;
 	vaddr_t base;
 	uint32_t counter_value;
 	uint32_t exp_param_types = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_OUTPUT,
@@ -184,7 +232,10 @@ TEE_Result plat_get_enforcement_counter(uint32_t param_types, TEE_Param params[T
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	base = (vaddr_t)phys_to_virt_io(OTP_BASE, SMALL_PAGE_SIZE);
-	if (adrv906x_otp_get_rollback_counter(base, &counter_value) != ADI_OTP_SUCCESS)
+	plat_otp_lock(OTP_BASE);
+	ret = adrv906x_otp_get_rollback_counter(base, &counter_value);
+	plat_otp_unlock(OTP_BASE);
+	if (ret != ADI_OTP_SUCCESS)
 		return TEE_ERROR_GENERIC;
 
 	params[0].value.a = counter_value;
@@ -9,10 +9,18 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <tee_internal_api.h>
+#include <types_ext.h>
 
 bool plat_is_dual_tile(void);
 bool plat_is_secondary_linux_enabled(void);
 
+/*
+ * Serializes accesses to the OTP controller at @otp_base (OTP_BASE or
+ * SEC_OTP_BASE), must be held over read-modify-write sequences
+ */
+void plat_otp_lock(paddr_t otp_base);
+void plat_otp_unlock(paddr_t otp_base);
+
 TEE_Result plat_set_enforcement_counter(void);
 TEE_Result plat_set_te_enforcement_counter(void);
 TEE_Result plat_get_enforcement_counter(uint32_t param_types, TEE_Param params[TEE_NUM_PARAMS]);
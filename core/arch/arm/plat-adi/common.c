@@ -10,9 +10,12 @@
 #include <drivers/pl011.h>
 #include <kernel/boot.h>
 #include <kernel/interrupt.h>
+#include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/tee_common_otp.h>
 #include <libfdt.h>
+#include <mm/core_memprot.h>
+#include <mm/core_mmu.h>
 #include <platform_config.h>
 #include <printk.h>
 #include <rng_support.h>
@@ -26,6 +29,12 @@
 
 static struct pl011_data console_data;
 
+/*
+ * Temporary IO mappings are only added and removed with io_map_mutex held
+ * for writing, so any mapping found with it held for reading is static.
+ */
+static struct mutex io_map_mutex = MUTEX_INITIALIZER;
+
 /* Anti-rollback counters */
 static uint32_t anti_rollback_counter = 0;
 static uint32_t te_anti_rollback_counter = 0;
@@ -277,3 +286,41 @@ TEE_Result hw_get_random_bytes(void *buf, size_t len)
 
 	return TEE_SUCCESS;
 }
+
+TEE_Result plat_io_map(paddr_t pa, size_t len, struct plat_io_map *map)
+{
+	map->len = len;
+	map->is_new = false;
+
+	mutex_read_lock(&io_map_mutex);
+	map->va = (vaddr_t)phys_to_virt_io(pa, len);
+	if (map->va)
+		return TEE_SUCCESS;
+	mutex_read_unlock(&io_map_mutex);
+
+	/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
+	mutex_lock(&io_map_mutex);
+	map->va = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, pa, len);
+	if (!map->va) {
+		mutex_unlock(&io_map_mutex);
+		return TEE_ERROR_GENERIC;
+	}
+	map->is_new = true;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result plat_io_unmap(struct plat_io_map *map)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!map->is_new) {
+		mutex_read_unlock(&io_map_mutex);
+		return TEE_SUCCESS;
+	}
+
+	res = core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)map->va, map->len);
+	mutex_unlock(&io_map_mutex);
+
+	return res;
+}
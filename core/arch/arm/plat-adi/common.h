@@ -8,6 +8,20 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <tee_api_types.h>
+#include <types_ext.h>
+
+/*
+ * struct plat_io_map - IO range mapped with plat_io_map()
+ * @va:		Virtual address of the range
+ * @len:	Length of the range
+ * @is_new:	True if a temporary MMU mapping was added for the range
+ */
+struct plat_io_map {
+	vaddr_t va;
+	size_t len;
+	bool is_new;
+};
 
 void common_boot_primary_init_intc(void);
 
@@ -19,4 +33,13 @@ void plat_warn_message(const char *fmt, ...);
 void plat_runtime_error_message(const char *fmt, ...);
 void plat_runtime_warn_message(const char *fmt, ...);
 
+/*
+ * Maps @len bytes of secure IO memory at @pa, a temporary MMU mapping is
+ * added if the range isn't registered with register_phys_mem(). The range
+ * stays mapped until plat_io_unmap() is called. Ranges needing a temporary
+ * mapping are serialized, other ranges may be used concurrently.
+ */
+TEE_Result plat_io_map(paddr_t pa, size_t len, struct plat_io_map *map);
+TEE_Result plat_io_unmap(struct plat_io_map *map);
+
 #endif /* COMMON_H */
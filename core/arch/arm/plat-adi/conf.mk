@@ -33,6 +33,21 @@ CFG_USER_TA_TARGETS ?= ta_arm64
 
 CFG_CRYPTO_WITH_CE ?= y
 
+# Per-CPU caches for small core heap allocations
+CFG_CORE_MALLOC_MAGAZINES ?= y
+
+# Spin briefly on mutexes held by a thread running on another core
+CFG_CORE_MUTEX_SPIN_US ?= 20
+
+# Keep expanded symmetric keys in the key objects
+CFG_TEE_OBJ_KEY_CACHE ?= y
+
+# AArch64 multiply-accumulate kernels for RSA and ECC bignum arithmetic
+CFG_CORE_BIGNUM_ASM ?= y
+
+# Fixed-base comb tables for ECDSA/ECDH and Ed25519
+CFG_CRYPTO_ECC_COMB ?= y
+
 $(call force,CFG_DT,y)
 CFG_DTB_MAX_SIZE ?= 0x100000
 
@@ -4,6 +4,7 @@
  */
 
 #include <console.h>
+#include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <stdio.h>
 #include <string.h>
@@ -24,7 +25,7 @@ static int buffer_length = 0;
 static int read_index = 0;
 static char runtime_log[SIZE_OF_OPTEE_RUNTIME_BUFFER] = { 0 };
 static int write_index = 0;
-static bool lock = false;
+static unsigned int runtime_log_lock = SPINLOCK_UNLOCK;
 
 /* Returns true if buffer is full */
 static bool is_buffer_full(void)
@@ -73,11 +74,10 @@ static char read_char_from_buffer(void)
 void write_to_runtime_buffer(const char *message)
 {
 	char *tmp = (char *)message;
+	uint32_t exceptions = 0;
 
 	/* Obtain lock when available */
-	while (lock)
-		;
-	lock = true;
+	exceptions = cpu_spin_lock_xsave(&runtime_log_lock);
 
 	/* Write each character to runtime buffer */
 	while (*tmp != '\0') {
@@ -89,18 +89,17 @@ void write_to_runtime_buffer(const char *message)
 	write_char_to_buffer(GROUP_SEPARATOR);
 
 	/* Unlock */
-	lock = false;
+	cpu_spin_unlock_xrestore(&runtime_log_lock, exceptions);
 }
 
 /* Read messages from runtime buffer */
 void read_from_runtime_buffer(char *message, int size)
 {
 	int index = 0;
+	uint32_t exceptions = 0;
 
 	/* Obtain lock when available */
-	while (lock)
-		;
-	lock = true;
+	exceptions = cpu_spin_lock_xsave(&runtime_log_lock);
 
 	/* Read each character into buffer */
 	while (read_index != write_index) {
@@ -116,7 +115,7 @@ void read_from_runtime_buffer(char *message, int size)
 	buffer_length = 0;
 
 	/* Unlock */
-	lock = false;
+	cpu_spin_unlock_xrestore(&runtime_log_lock, exceptions);
 }
 
 bool adi_runtime_log_smc(char *buffer, int size)
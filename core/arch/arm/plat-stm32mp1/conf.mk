@@ -252,6 +252,8 @@ endif
 # If any crypto driver is enabled, enable the crypto-framework layer
 ifeq ($(call cfg-one-enabled, CFG_STM32_CRYP CFG_STM32_SAES),y)
 $(call force,CFG_STM32_CRYPTO_DRIVER,y)
+# Short cipher messages are faster on the CPU than through CRYP or SAES
+CFG_CRYPTO_SIZE_SELECT ?= y
 endif
 
 CFG_DRIVERS_RSTCTRL ?= $(CFG_STM32_RSTCTRL)
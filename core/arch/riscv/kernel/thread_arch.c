@@ -334,26 +334,16 @@ static void __thread_alloc_and_run(uint32_t a0, uint32_t a1, uint32_t a2,
 				   void *pc)
 {
 	struct thread_core_local *l = thread_get_core_local();
-	bool found_thread = false;
-	size_t n = 0;
+	short int n = THREAD_ID_INVALID;
 
 	assert(l->curr_thread == THREAD_ID_INVALID);
 
-	thread_lock_global();
-
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state == THREAD_STATE_FREE) {
-			threads[n].state = THREAD_STATE_ACTIVE;
-			found_thread = true;
-			break;
-		}
-	}
-
-	thread_unlock_global();
-
-	if (!found_thread)
+	n = thread_claim_free();
+	if (n == THREAD_ID_INVALID)
 		return;
 
+	/* The thread is ours now, its state needs no thread_global_lock */
+	threads[n].state = THREAD_STATE_ACTIVE;
 	l->curr_thread = n;
 
 	threads[n].flags = 0;
@@ -490,8 +480,6 @@ void thread_state_free(void)
 
 	thread_lazy_restore_ns_vfp();
 
-	thread_lock_global();
-
 	assert(threads[ct].state == THREAD_STATE_ACTIVE);
 	threads[ct].state = THREAD_STATE_FREE;
 	threads[ct].flags = 0;
@@ -499,7 +487,7 @@ void thread_state_free(void)
 
 	if (IS_ENABLED(CFG_NS_VIRTUALIZATION))
 		virt_unset_guest();
-	thread_unlock_global();
+	thread_release(ct);
 }
 
 int thread_state_suspend(uint32_t flags, unsigned long status, vaddr_t pc)
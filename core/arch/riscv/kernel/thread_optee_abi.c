@@ -310,11 +310,10 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 
 	thread_lock_global();
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state != THREAD_STATE_FREE) {
-			rv = false;
-			goto out;
-		}
+	/* Keep new yielding calls out while the RPC caches are updated */
+	if (!thread_claim_all()) {
+		rv = false;
+		goto out;
 	}
 
 	rv = true;
@@ -326,13 +325,15 @@ bool thread_disable_prealloc_rpc_cache(uint64_t *cookie)
 				mobj_put(threads[n].rpc_mobj);
 				threads[n].rpc_arg = NULL;
 				threads[n].rpc_mobj = NULL;
-				goto out;
+				goto out_release;
 			}
 		}
 	}
 
 	*cookie = 0;
 	thread_prealloc_rpc_cache = false;
+out_release:
+	thread_release_all();
 out:
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
@@ -342,7 +343,6 @@ out:
 bool thread_enable_prealloc_rpc_cache(void)
 {
 	bool rv = false;
-	size_t n = 0;
 	uint32_t exceptions = 0;
 
 	if (!IS_ENABLED(CFG_PREALLOC_RPC_CACHE))
@@ -351,15 +351,15 @@ bool thread_enable_prealloc_rpc_cache(void)
 	exceptions = thread_mask_exceptions(THREAD_EXCP_FOREIGN_INTR);
 	thread_lock_global();
 
-	for (n = 0; n < CFG_NUM_THREADS; n++) {
-		if (threads[n].state != THREAD_STATE_FREE) {
-			rv = false;
-			goto out;
-		}
+	/* Keep new yielding calls out while the RPC caches are updated */
+	if (!thread_claim_all()) {
+		rv = false;
+		goto out;
 	}
 
 	rv = true;
 	thread_prealloc_rpc_cache = true;
+	thread_release_all();
 out:
 	thread_unlock_global();
 	thread_unmask_exceptions(exceptions);
@@ -13,6 +13,28 @@ ifeq (y,$(CFG_CRYPTO))
 CRYPTO_MAKEFILES := $(sort $(wildcard core/drivers/crypto/*/crypto.mk))
 include $(CRYPTO_MAKEFILES)
 
+# Run the jobs of the crypto drivers supporting it through a per engine
+# queue: one waiting thread collects the engine completions while the
+# others sleep, and hash and cipher operations fall back to software when
+# the engine queue is saturated.
+CFG_CRYPTO_DRV_QUEUE ?= n
+$(eval $(call cfg-depends-all,CFG_CRYPTO_DRV_QUEUE,CFG_CRYPTO_DRIVER))
+
+# Let hash and cipher operations pick between the software implementation
+# and the crypto driver per message: short messages stay on the CPU, where
+# the device setup cost dominates. The crossover sizes come from an
+# "optee,crypto-select" DT node or, with CFG_CRYPTO_SIZE_SELECT_CALIBRATE,
+# from a short benchmark at boot. The benchmark times the implementations
+# with the Arm generic timer and is only available with ARCH=arm.
+CFG_CRYPTO_SIZE_SELECT ?= n
+ifeq ($(ARCH),arm)
+CFG_CRYPTO_SIZE_SELECT_CALIBRATE ?= $(CFG_CRYPTO_SIZE_SELECT)
+else
+$(call force,CFG_CRYPTO_SIZE_SELECT_CALIBRATE,n,requires ARCH=arm)
+endif
+$(eval $(call cfg-depends-all,CFG_CRYPTO_SIZE_SELECT,CFG_CRYPTO_DRIVER))
+$(eval $(call cfg-depends-all,CFG_CRYPTO_SIZE_SELECT_CALIBRATE,CFG_CRYPTO_SIZE_SELECT))
+
 # Ciphers
 CFG_CRYPTO_AES ?= y
 CFG_CRYPTO_DES ?= y
@@ -64,6 +86,11 @@ CFG_CRYPTO_SM2_DSA ?= y
 CFG_CRYPTO_SM2_KEP ?= y
 CFG_CRYPTO_ED25519 ?= y
 CFG_CRYPTO_X25519 ?= y
+# Fixed-base comb tables for the ECDSA/ECDH scalar multiplications of
+# repeatedly used points (curve generators, peer public keys) and for the
+# Ed25519 base point. These are LibTomCrypt functions, with
+# CFG_CRYPTOLIB_NAME=mbedtls only Ed25519 is covered.
+CFG_CRYPTO_ECC_COMB ?= n
 
 # Authenticated encryption
 CFG_CRYPTO_CCM ?= y
@@ -245,6 +272,15 @@ _CFG_CORE_LTC_SHA3_384 := $(CFG_CRYPTO_SHA3_384)
 _CFG_CORE_LTC_SHA3_512 := $(CFG_CRYPTO_SHA3_512)
 _CFG_CORE_LTC_SHAKE128 := $(CFG_CRYPTO_SHAKE128)
 _CFG_CORE_LTC_SHAKE256 := $(CFG_CRYPTO_SHAKE256)
+
+# MbedTLS does ECDSA/ECDH itself, with its own comb for the generator
+ifeq ($(CFG_CRYPTO_ECC_COMB),y)
+ifneq ($(CFG_CRYPTO_ED25519),y)
+$(error CFG_CRYPTO_ECC_COMB has no effect with CFG_CRYPTOLIB_NAME=mbedtls and CFG_CRYPTO_ED25519=n)
+else ifeq ($(CFG_CRYPTO_ECC),y)
+$(warning Warning: CFG_CRYPTO_ECC_COMB only applies to Ed25519 with CFG_CRYPTOLIB_NAME=mbedtls)
+endif
+endif
 endif
 
 ###############################################################
@@ -284,6 +320,7 @@ else
 _CFG_CORE_LTC_OPTEE_THREAD := n
 endif
 _CFG_CORE_LTC_HWSUPP_PMULL := $(CFG_HWSUPP_PMULL)
+_CFG_CORE_LTC_ECC_COMB := $(CFG_CRYPTO_ECC_COMB)
 
 # Assign aggregated variables
 ltc-one-enabled = $(call cfg-one-enabled,$(foreach v,$(1),_CFG_CORE_LTC_$(v)))
@@ -47,14 +47,10 @@ gcm-revised-spec.pdf
  * corresponds to P^127.
  */
 void internal_aes_gcm_ghash_gen_tbl(struct internal_ghash_key *ghash_key,
-				    const struct internal_aes_gcm_key *ek)
+				    const unsigned char h[16])
 {
 	int i, j;
 	uint64_t vl, vh;
-	unsigned char h[16];
-
-	memset(h, 0, 16);
-	crypto_aes_enc_block(ek->data, sizeof(ek->data), ek->rounds, h, h);
 
 	vh = get_be64(h);
 	vl = get_be64(h + 8);
@@ -10,17 +10,27 @@
 #include <tee_api_types.h>
 #include <types_ext.h>
 
-void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
-			      const struct internal_aes_gcm_key *ek)
+void internal_aes_gcm_set_ghash_key(struct internal_ghash_key *ghash_key,
+				    const void *hash_subkey)
 {
 #ifdef CFG_AES_GCM_TABLE_BASED
-	internal_aes_gcm_ghash_gen_tbl(&state->ghash_key, ek);
+	internal_aes_gcm_ghash_gen_tbl(ghash_key, hash_subkey);
 #else
-	crypto_aes_enc_block(ek->data, sizeof(ek->data), ek->rounds,
-			     state->ctr, state->ghash_key.hash_subkey);
+	memcpy(ghash_key->hash_subkey, hash_subkey,
+	       sizeof(ghash_key->hash_subkey));
 #endif
 }
 
+void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
+			      const struct internal_aes_gcm_key *ek)
+{
+	uint64_t k[2] = { 0 };
+
+	crypto_aes_enc_block(ek->data, sizeof(ek->data), ek->rounds,
+			     state->ctr, k);
+	internal_aes_gcm_set_ghash_key(&state->ghash_key, k);
+}
+
 static void ghash_update_block(struct internal_aes_gcm_state *state,
 			       const void *data)
 {
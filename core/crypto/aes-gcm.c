@@ -66,8 +66,13 @@ static void ghash_update_lengths(struct internal_aes_gcm_state *state,
 	internal_aes_gcm_ghash_update(state, (uint8_t *)len_fields, NULL, 0);
 }
 
+/*
+ * If @ghash_key is NULL the GHASH key is derived from @ek, else the
+ * supplied precomputed GHASH key is used.
+ */
 static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 			     const struct internal_aes_gcm_key *ek,
+			     const struct internal_ghash_key *ghash_key,
 			     TEE_OperationMode mode, const void *nonce,
 			     size_t nonce_len, size_t tag_len)
 {
@@ -79,7 +84,10 @@ static TEE_Result __gcm_init(struct internal_aes_gcm_state *state,
 	memset(state, 0, sizeof(*state));
 
 	state->tag_len = tag_len;
-	internal_aes_gcm_set_key(state, ek);
+	if (ghash_key)
+		state->ghash_key = *ghash_key;
+	else
+		internal_aes_gcm_set_key(state, ek);
 
 	if (nonce_len == (96 / 8)) {
 		memcpy(state->ctr, nonce, nonce_len);
@@ -134,7 +142,23 @@ TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
 	if (res)
 		return res;
 
-	return __gcm_init(&ctx->state, ek, mode, nonce, nonce_len, tag_len);
+	return __gcm_init(&ctx->state, ek, NULL, mode, nonce, nonce_len,
+			  tag_len);
+}
+
+TEE_Result internal_aes_gcm_reinit(struct internal_aes_gcm_ctx *ctx,
+				   TEE_OperationMode mode, const void *nonce,
+				   size_t nonce_len, size_t tag_len)
+{
+	/* __gcm_init() clears the state holding the GHASH key */
+	struct internal_ghash_key ghash_key = ctx->state.ghash_key;
+	TEE_Result res = TEE_SUCCESS;
+
+	res = __gcm_init(&ctx->state, &ctx->key, &ghash_key, mode, nonce,
+			 nonce_len, tag_len);
+	memzero_explicit(&ghash_key, sizeof(ghash_key));
+
+	return res;
 }
 
 static TEE_Result __gcm_update_aad(struct internal_aes_gcm_state *state,
@@ -367,27 +391,60 @@ void internal_aes_gcm_dec_ctr(struct internal_aes_gcm_state *state)
 	}
 }
 
-TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
-				const void *nonce, size_t nonce_len,
-				const void *aad, size_t aad_len,
-				const void *src, size_t len, void *dst,
-				void *tag, size_t *tag_len)
+static TEE_Result gcm_enc(const struct internal_aes_gcm_key *enc_key,
+			  const struct internal_ghash_key *ghash_key,
+			  const void *nonce, size_t nonce_len,
+			  const void *aad, size_t aad_len,
+			  const void *src, size_t len, void *dst,
+			  void *tag, size_t *tag_len)
 {
 	TEE_Result res;
 	struct internal_aes_gcm_state state;
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_ENCRYPT, nonce, nonce_len,
-			 *tag_len);
-	if (res)
-		return res;
+	res = __gcm_init(&state, enc_key, ghash_key, TEE_MODE_ENCRYPT, nonce,
+			 nonce_len, *tag_len);
+	if (!res && aad)
+		res = __gcm_update_aad(&state, aad, aad_len);
+	if (!res)
+		res = __gcm_enc_final(&state, enc_key, src, len, dst, tag,
+			      tag_len);
+
+	memzero_explicit(&state, sizeof(state));
+
+	return res;
+}
 
-	if (aad) {
+static TEE_Result gcm_dec(const struct internal_aes_gcm_key *enc_key,
+			  const struct internal_ghash_key *ghash_key,
+			  const void *nonce, size_t nonce_len,
+			  const void *aad, size_t aad_len,
+			  const void *src, size_t len, void *dst,
+			  const void *tag, size_t tag_len)
+{
+	TEE_Result res;
+	struct internal_aes_gcm_state state;
+
+	res = __gcm_init(&state, enc_key, ghash_key, TEE_MODE_DECRYPT, nonce,
+			 nonce_len, tag_len);
+	if (!res && aad)
 		res = __gcm_update_aad(&state, aad, aad_len);
-		if (res)
-			return res;
-	}
+	if (!res)
+		res = __gcm_dec_final(&state, enc_key, src, len, dst, tag,
+			      tag_len);
+
+	memzero_explicit(&state, sizeof(state));
 
-	return __gcm_enc_final(&state, enc_key, src, len, dst, tag, tag_len);
+	return res;
+}
+
+TEE_Result internal_aes_gcm_enc(const struct internal_aes_gcm_key *enc_key,
+				const void *nonce, size_t nonce_len,
+				const void *aad, size_t aad_len,
+				const void *src, size_t len, void *dst,
+				void *tag, size_t *tag_len)
+{
+	return gcm_enc(enc_key, NULL, nonce, nonce_len, aad, aad_len, src, len,
+		       dst, tag, tag_len);
 }
 
 TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
@@ -396,26 +453,56 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 				const void *src, size_t len, void *dst,
 				const void *tag, size_t tag_len)
 {
-	TEE_Result res;
-	struct internal_aes_gcm_state state;
+	return gcm_dec(enc_key, NULL, nonce, nonce_len, aad, aad_len, src, len,
+		       dst, tag, tag_len);
+}
 
-	res = __gcm_init(&state, enc_key, TEE_MODE_DECRYPT, nonce, nonce_len,
-			 tag_len);
+TEE_Result
+internal_aes_gcm_expand_key(struct internal_aes_gcm_precomp_key *pkey,
+			    const void *key, size_t key_len)
+{
+	struct internal_aes_gcm_state state = { };
+	TEE_Result res = TEE_SUCCESS;
+
+	res = crypto_aes_expand_enc_key(key, key_len, pkey->enc_key.data,
+					sizeof(pkey->enc_key.data),
+					&pkey->enc_key.rounds);
 	if (res)
 		return res;
 
-	if (aad) {
-		res = __gcm_update_aad(&state, aad, aad_len);
-		if (res)
-			return res;
-	}
+	/* The GHASH key is derived by encrypting the all zero block */
+	internal_aes_gcm_set_key(&state, &pkey->enc_key);
+	pkey->ghash_key = state.ghash_key;
+	memzero_explicit(&state, sizeof(state));
+
+	return TEE_SUCCESS;
+}
 
-	return __gcm_dec_final(&state, enc_key, src, len, dst, tag, tag_len);
+TEE_Result
+internal_aes_gcm_enc_precomp(const struct internal_aes_gcm_precomp_key *pkey,
+			     const void *nonce, size_t nonce_len,
+			     const void *aad, size_t aad_len,
+			     const void *src, size_t len, void *dst,
+			     void *tag, size_t *tag_len)
+{
+	return gcm_enc(&pkey->enc_key, &pkey->ghash_key, nonce, nonce_len, aad,
+		       aad_len, src, len, dst, tag, tag_len);
 }
 
+TEE_Result
+internal_aes_gcm_dec_precomp(const struct internal_aes_gcm_precomp_key *pkey,
+			     const void *nonce, size_t nonce_len,
+			     const void *aad, size_t aad_len,
+			     const void *src, size_t len, void *dst,
+			     const void *tag, size_t tag_len)
+{
+	return gcm_dec(&pkey->enc_key, &pkey->ghash_key, nonce, nonce_len, aad,
+		       aad_len, src, len, dst, tag, tag_len);
+}
 
 #ifndef CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <crypto/crypto.h>
 
 struct aes_gcm_ctx {
@@ -448,7 +535,7 @@ TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
 
 static void aes_gcm_free_ctx(struct crypto_authenc_ctx *aec)
 {
-	free(to_aes_gcm_ctx(aec));
+	free_wipe(to_aes_gcm_ctx(aec));
 }
 
 static void aes_gcm_copy_state(struct crypto_authenc_ctx *dst_ctx,
@@ -468,6 +555,16 @@ static TEE_Result aes_gcm_init(struct crypto_authenc_ctx *aec,
 				     key_len, nonce, nonce_len, tag_len);
 }
 
+static TEE_Result aes_gcm_reinit(struct crypto_authenc_ctx *aec,
+				 TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len __unused,
+				 size_t payload_len __unused)
+{
+	return internal_aes_gcm_reinit(&to_aes_gcm_ctx(aec)->ctx, mode, nonce,
+				       nonce_len, tag_len);
+}
+
 static TEE_Result aes_gcm_update_aad(struct crypto_authenc_ctx *aec,
 				     const uint8_t *data, size_t len)
 {
@@ -514,6 +611,7 @@ static const struct crypto_authenc_ops aes_gcm_ops = {
 	.final = aes_gcm_final,
 	.free_ctx = aes_gcm_free_ctx,
 	.copy_state = aes_gcm_copy_state,
+	.reinit = aes_gcm_reinit,
 };
 
 /*
@@ -12,64 +12,86 @@
 #include <kernel/panic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <util.h>
 #include <utee_defines.h>
 
+static TEE_Result sw_hash_alloc_ctx(struct crypto_hash_ctx **ctx,
+				    uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_MD5:
+		res = crypto_md5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA1:
+		res = crypto_sha1_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA224:
+		res = crypto_sha224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA256:
+		res = crypto_sha256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA384:
+		res = crypto_sha384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA512:
+		res = crypto_sha512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_224:
+		res = crypto_sha3_224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_256:
+		res = crypto_sha3_256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_384:
+		res = crypto_sha3_384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHA3_512:
+		res = crypto_sha3_512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHAKE128:
+		res = crypto_shake128_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SHAKE256:
+		res = crypto_shake256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM3:
+		res = crypto_sm3_alloc_ctx(ctx);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
 	struct crypto_hash_ctx *c = NULL;
+	bool hw_busy = drvcrypt_hash_saturated();
 
 	/*
-	 * Use default cryptographic implementation if no matching
-	 * drvcrypt device.
+	 * Pick the drvcrypt device or the software implementation per
+	 * message if a crossover size is registered for the algorithm.
 	 */
-	res = drvcrypt_hash_alloc_ctx(&c, algo);
-
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_MD5:
-			res = crypto_md5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA1:
-			res = crypto_sha1_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA224:
-			res = crypto_sha224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA256:
-			res = crypto_sha256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA384:
-			res = crypto_sha384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA512:
-			res = crypto_sha512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_224:
-			res = crypto_sha3_224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_256:
-			res = crypto_sha3_256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_384:
-			res = crypto_sha3_384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHA3_512:
-			res = crypto_sha3_512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHAKE128:
-			res = crypto_shake128_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SHAKE256:
-			res = crypto_shake256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM3:
-			res = crypto_sm3_alloc_ctx(&c);
-			break;
-		default:
-			break;
-		}
-	}
+	res = crypto_select_hash_alloc_ctx(&c, algo);
+
+	/*
+	 * Otherwise use default cryptographic implementation if no matching
+	 * drvcrypt device or if the device job queue is saturated.
+	 */
+	if (res == TEE_ERROR_NOT_IMPLEMENTED && !hw_busy)
+		res = drvcrypt_hash_alloc_ctx(&c, algo);
+
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = sw_hash_alloc_ctx(&c, algo);
+
+	/* No software implementation, queue the jobs on the device */
+	if (res == TEE_ERROR_NOT_IMPLEMENTED && hw_busy)
+		res = drvcrypt_hash_alloc_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -77,6 +99,18 @@ TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo)
 	return res;
 }
 
+TEE_Result crypto_hash_alloc_sw_ctx(void **ctx, uint32_t algo)
+{
+	struct crypto_hash_ctx *c = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = sw_hash_alloc_ctx(&c, algo);
+	if (!res)
+		*ctx = c;
+
+	return res;
+}
+
 static const struct crypto_hash_ops *hash_ops(void *ctx)
 {
 	struct crypto_hash_ctx *c = ctx;
@@ -86,6 +120,45 @@ static const struct crypto_hash_ops *hash_ops(void *ctx)
 	return c->ops;
 }
 
+/*
+ * Providers tried by crypto_hash_alloc_ctx_like(), crypto_hash_alloc_ctx()
+ * picks among them at runtime.
+ */
+typedef TEE_Result (*hash_alloc_fn)(struct crypto_hash_ctx **ctx,
+				   uint32_t algo);
+
+static const hash_alloc_fn hash_providers[] = {
+	crypto_select_hash_alloc_ctx,
+	drvcrypt_hash_alloc_ctx,
+	sw_hash_alloc_ctx,
+};
+
+TEE_Result crypto_hash_alloc_ctx_like(void **ctx, uint32_t algo,
+				      void *ref_ctx)
+{
+	const struct crypto_hash_ops *ops = hash_ops(ref_ctx);
+	struct crypto_hash_ctx *c = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(hash_providers); n++) {
+		if (hash_providers[n](&c, algo))
+			continue;
+		if (c->ops == ops) {
+			*ctx = c;
+			return TEE_SUCCESS;
+		}
+		c->ops->free_ctx(c);
+		c = NULL;
+	}
+
+	return TEE_ERROR_BAD_STATE;
+}
+
+bool crypto_hash_same_impl(void *ctx1, void *ctx2)
+{
+	return hash_ops(ctx1) == hash_ops(ctx2);
+}
+
 void crypto_hash_free_ctx(void *ctx)
 {
 	if (ctx)
@@ -112,62 +185,83 @@ TEE_Result crypto_hash_final(void *ctx, uint8_t *digest, size_t len)
 	return hash_ops(ctx)->final(ctx, digest, len);
 }
 
+static TEE_Result sw_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
+				      uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_AES_ECB_NOPAD:
+		res = crypto_aes_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CBC_NOPAD:
+		res = crypto_aes_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CTR:
+		res = crypto_aes_ctr_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CTS:
+		res = crypto_aes_cts_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_XTS:
+		res = crypto_aes_xts_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_ECB_NOPAD:
+		res = crypto_des_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_ECB_NOPAD:
+		res = crypto_des3_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_CBC_NOPAD:
+		res = crypto_des_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_CBC_NOPAD:
+		res = crypto_des3_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_ECB_NOPAD:
+		res = crypto_sm4_ecb_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_CBC_NOPAD:
+		res = crypto_sm4_cbc_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_CTR:
+		res = crypto_sm4_ctr_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_XTS:
+		res = crypto_sm4_xts_alloc_ctx(ctx);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
 	struct crypto_cipher_ctx *c = NULL;
+	bool hw_busy = drvcrypt_cipher_saturated();
 
 	/*
-	 * Use default cryptographic implementation if no matching
-	 * drvcrypt device.
+	 * Pick the drvcrypt device or the software implementation per
+	 * message if a crossover size is registered for the algorithm.
 	 */
-	res = drvcrypt_cipher_alloc_ctx(&c, algo);
-
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_AES_ECB_NOPAD:
-			res = crypto_aes_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CBC_NOPAD:
-			res = crypto_aes_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTR:
-			res = crypto_aes_ctr_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CTS:
-			res = crypto_aes_cts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_XTS:
-			res = crypto_aes_xts_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_ECB_NOPAD:
-			res = crypto_des_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_ECB_NOPAD:
-			res = crypto_des3_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_CBC_NOPAD:
-			res = crypto_des_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CBC_NOPAD:
-			res = crypto_des3_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_ECB_NOPAD:
-			res = crypto_sm4_ecb_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_CBC_NOPAD:
-			res = crypto_sm4_cbc_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_CTR:
-			res = crypto_sm4_ctr_alloc_ctx(&c);
-			break;
-		case TEE_ALG_SM4_XTS:
-			res = crypto_sm4_xts_alloc_ctx(&c);
-			break;
-		default:
-			return TEE_ERROR_NOT_IMPLEMENTED;
-		}
-	}
+	res = crypto_select_cipher_alloc_ctx(&c, algo);
+
+	/*
+	 * Otherwise use default cryptographic implementation if no matching
+	 * drvcrypt device or if the device job queue is saturated.
+	 */
+	if (res == TEE_ERROR_NOT_IMPLEMENTED && !hw_busy)
+		res = drvcrypt_cipher_alloc_ctx(&c, algo);
+
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = sw_cipher_alloc_ctx(&c, algo);
+
+	/* No software implementation, queue the jobs on the device */
+	if (res == TEE_ERROR_NOT_IMPLEMENTED && hw_busy)
+		res = drvcrypt_cipher_alloc_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -175,6 +269,18 @@ TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo)
 	return res;
 }
 
+TEE_Result crypto_cipher_alloc_sw_ctx(void **ctx, uint32_t algo)
+{
+	struct crypto_cipher_ctx *c = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = sw_cipher_alloc_ctx(&c, algo);
+	if (!res)
+		*ctx = c;
+
+	return res;
+}
+
 static const struct crypto_cipher_ops *cipher_ops(void *ctx)
 {
 	struct crypto_cipher_ctx *c = ctx;
@@ -184,6 +290,45 @@ static const struct crypto_cipher_ops *cipher_ops(void *ctx)
 	return c->ops;
 }
 
+/*
+ * Providers tried by crypto_cipher_alloc_ctx_like(), crypto_cipher_alloc_ctx()
+ * picks among them at runtime.
+ */
+typedef TEE_Result (*cipher_alloc_fn)(struct crypto_cipher_ctx **ctx,
+				     uint32_t algo);
+
+static const cipher_alloc_fn cipher_providers[] = {
+	crypto_select_cipher_alloc_ctx,
+	drvcrypt_cipher_alloc_ctx,
+	sw_cipher_alloc_ctx,
+};
+
+TEE_Result crypto_cipher_alloc_ctx_like(void **ctx, uint32_t algo,
+					void *ref_ctx)
+{
+	const struct crypto_cipher_ops *ops = cipher_ops(ref_ctx);
+	struct crypto_cipher_ctx *c = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(cipher_providers); n++) {
+		if (cipher_providers[n](&c, algo))
+			continue;
+		if (c->ops == ops) {
+			*ctx = c;
+			return TEE_SUCCESS;
+		}
+		c->ops->free_ctx(c);
+		c = NULL;
+	}
+
+	return TEE_ERROR_BAD_STATE;
+}
+
+bool crypto_cipher_same_impl(void *ctx1, void *ctx2)
+{
+	return cipher_ops(ctx1) == cipher_ops(ctx2);
+}
+
 void crypto_cipher_free_ctx(void *ctx)
 {
 	if (ctx)
@@ -195,6 +340,23 @@ void crypto_cipher_copy_state(void *dst_ctx, void *src_ctx)
 	cipher_ops(dst_ctx)->copy_state(dst_ctx, src_ctx);
 }
 
+TEE_Result crypto_cipher_reinit(void *ctx, TEE_OperationMode mode,
+				const uint8_t *iv, size_t iv_len)
+{
+	if (mode != TEE_MODE_DECRYPT && mode != TEE_MODE_ENCRYPT)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (!cipher_ops(ctx)->reinit)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return cipher_ops(ctx)->reinit(ctx, mode, iv, iv_len);
+}
+
+bool crypto_cipher_can_reinit(void *ctx)
+{
+	return cipher_ops(ctx)->reinit;
+}
+
 TEE_Result crypto_cipher_init(void *ctx, TEE_OperationMode mode,
 			      const uint8_t *key1, size_t key1_len,
 			      const uint8_t *key2, size_t key2_len,
@@ -243,6 +405,76 @@ TEE_Result crypto_cipher_get_block_size(uint32_t algo, size_t *size)
 	}
 }
 
+static TEE_Result sw_mac_alloc_ctx(struct crypto_mac_ctx **ctx,
+				   uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+	case TEE_ALG_HMAC_MD5:
+		res = crypto_hmac_md5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA1:
+		res = crypto_hmac_sha1_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA224:
+		res = crypto_hmac_sha224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA256:
+		res = crypto_hmac_sha256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA384:
+		res = crypto_hmac_sha384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA512:
+		res = crypto_hmac_sha512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA3_224:
+		res = crypto_hmac_sha3_224_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA3_256:
+		res = crypto_hmac_sha3_256_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA3_384:
+		res = crypto_hmac_sha3_384_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SHA3_512:
+		res = crypto_hmac_sha3_512_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_HMAC_SM3:
+		res = crypto_hmac_sm3_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CBC_MAC_NOPAD:
+		res = crypto_aes_cbc_mac_nopad_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CBC_MAC_PKCS5:
+		res = crypto_aes_cbc_mac_pkcs5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_CBC_MAC_NOPAD:
+		res = crypto_des_cbc_mac_nopad_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES_CBC_MAC_PKCS5:
+		res = crypto_des_cbc_mac_pkcs5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_CBC_MAC_NOPAD:
+		res = crypto_des3_cbc_mac_nopad_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_CBC_MAC_PKCS5:
+		res = crypto_des3_cbc_mac_pkcs5_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_DES3_CMAC:
+		res = crypto_des3_cmac_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_AES_CMAC:
+		res = crypto_aes_cmac_alloc_ctx(ctx);
+		break;
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_mac_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_SUCCESS;
@@ -254,69 +486,8 @@ TEE_Result crypto_mac_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_mac_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-		case TEE_ALG_HMAC_MD5:
-			res = crypto_hmac_md5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA1:
-			res = crypto_hmac_sha1_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA224:
-			res = crypto_hmac_sha224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA256:
-			res = crypto_hmac_sha256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA384:
-			res = crypto_hmac_sha384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA512:
-			res = crypto_hmac_sha512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA3_224:
-			res = crypto_hmac_sha3_224_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA3_256:
-			res = crypto_hmac_sha3_256_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA3_384:
-			res = crypto_hmac_sha3_384_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SHA3_512:
-			res = crypto_hmac_sha3_512_alloc_ctx(&c);
-			break;
-		case TEE_ALG_HMAC_SM3:
-			res = crypto_hmac_sm3_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CBC_MAC_NOPAD:
-			res = crypto_aes_cbc_mac_nopad_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CBC_MAC_PKCS5:
-			res = crypto_aes_cbc_mac_pkcs5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_CBC_MAC_NOPAD:
-			res = crypto_des_cbc_mac_nopad_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES_CBC_MAC_PKCS5:
-			res = crypto_des_cbc_mac_pkcs5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CBC_MAC_NOPAD:
-			res = crypto_des3_cbc_mac_nopad_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CBC_MAC_PKCS5:
-			res = crypto_des3_cbc_mac_pkcs5_alloc_ctx(&c);
-			break;
-		case TEE_ALG_DES3_CMAC:
-			res = crypto_des3_cmac_alloc_ctx(&c);
-			break;
-		case TEE_ALG_AES_CMAC:
-			res = crypto_aes_cmac_alloc_ctx(&c);
-			break;
-		default:
-			return TEE_ERROR_NOT_SUPPORTED;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = sw_mac_alloc_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -324,6 +495,18 @@ TEE_Result crypto_mac_alloc_ctx(void **ctx, uint32_t algo)
 	return res;
 }
 
+TEE_Result crypto_mac_alloc_sw_ctx(void **ctx, uint32_t algo)
+{
+	struct crypto_mac_ctx *c = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = sw_mac_alloc_ctx(&c, algo);
+	if (!res)
+		*ctx = c;
+
+	return res;
+}
+
 static const struct crypto_mac_ops *mac_ops(void *ctx)
 {
 	struct crypto_mac_ctx *c = ctx;
@@ -362,6 +545,35 @@ TEE_Result crypto_mac_final(void *ctx, uint8_t *digest, size_t digest_len)
 	return mac_ops(ctx)->final(ctx, digest, digest_len);
 }
 
+static TEE_Result sw_authenc_alloc_ctx(struct crypto_authenc_ctx **ctx,
+				       uint32_t algo)
+{
+	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
+
+	switch (algo) {
+#if defined(CFG_CRYPTO_CCM)
+	case TEE_ALG_AES_CCM:
+		res = crypto_aes_ccm_alloc_ctx(ctx);
+		break;
+#endif
+#if defined(CFG_CRYPTO_GCM)
+	case TEE_ALG_AES_GCM:
+		res = crypto_aes_gcm_alloc_ctx(ctx);
+		break;
+#endif
+	case TEE_ALG_SM4_CCM:
+		res = crypto_sm4_ccm_alloc_ctx(ctx);
+		break;
+	case TEE_ALG_SM4_GCM:
+		res = crypto_sm4_gcm_alloc_ctx(ctx);
+		break;
+	default:
+		break;
+	}
+
+	return res;
+}
+
 TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 {
 	TEE_Result res = TEE_ERROR_NOT_IMPLEMENTED;
@@ -373,22 +585,8 @@ TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 	 */
 	res = drvcrypt_authenc_alloc_ctx(&c, algo);
 
-	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
-		switch (algo) {
-#if defined(CFG_CRYPTO_CCM)
-		case TEE_ALG_AES_CCM:
-			res = crypto_aes_ccm_alloc_ctx(&c);
-			break;
-#endif
-#if defined(CFG_CRYPTO_GCM)
-		case TEE_ALG_AES_GCM:
-			res = crypto_aes_gcm_alloc_ctx(&c);
-			break;
-#endif
-		default:
-			break;
-		}
-	}
+	if (res == TEE_ERROR_NOT_IMPLEMENTED)
+		res = sw_authenc_alloc_ctx(&c, algo);
 
 	if (!res)
 		*ctx = c;
@@ -396,6 +594,18 @@ TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo)
 	return res;
 }
 
+TEE_Result crypto_authenc_alloc_sw_ctx(void **ctx, uint32_t algo)
+{
+	struct crypto_authenc_ctx *c = NULL;
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	res = sw_authenc_alloc_ctx(&c, algo);
+	if (!res)
+		*ctx = c;
+
+	return res;
+}
+
 static const struct crypto_authenc_ops *ae_ops(void *ctx)
 {
 	struct crypto_authenc_ctx *c = ctx;
@@ -477,6 +687,23 @@ void crypto_authenc_copy_state(void *dst_ctx, void *src_ctx)
 	ae_ops(dst_ctx)->copy_state(dst_ctx, src_ctx);
 }
 
+TEE_Result crypto_authenc_reinit(void *ctx, TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len,
+				 size_t payload_len)
+{
+	if (!ae_ops(ctx)->reinit)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	return ae_ops(ctx)->reinit(ctx, mode, nonce, nonce_len, tag_len,
+				   aad_len, payload_len);
+}
+
+bool crypto_authenc_can_reinit(void *ctx)
+{
+	return ae_ops(ctx)->reinit;
+}
+
 #if !defined(CFG_CRYPTO_RSA) && !defined(CFG_CRYPTO_DSA) && \
     !defined(CFG_CRYPTO_DH) && !defined(CFG_CRYPTO_ECC)
 struct bignum *crypto_bignum_allocate(size_t size_bits __unused)
@@ -0,0 +1,675 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ *
+ * Per message selection between the software implementation and the
+ * drvcrypt device of hash and cipher algorithms. Setting up a device job
+ * costs more than processing a short message with the CPU, the device only
+ * pays off above a crossover size which is registered per algorithm, read
+ * from the device tree or measured at boot.
+ */
+
+#ifdef CFG_CRYPTO_SIZE_SELECT_CALIBRATE
+#include <arm.h>
+#endif
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <initcall.h>
+#include <kernel/dt.h>
+#include <libfdt.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
+#include <trace.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#define SELECT_MAX_ALGOS	16
+#define SELECT_MAX_KEY_SIZE	32
+#define SELECT_MAX_IV_SIZE	16
+
+/* Implementations an algorithm is dispatched to */
+enum select_provider {
+	SELECT_SW,
+	SELECT_DRV,
+	SELECT_PROVIDER_COUNT
+};
+
+struct select_entry {
+	uint32_t algo;
+	size_t threshold;	/* Smallest message sent to the device */
+};
+
+/* Written by the initcalls only, read-only afterwards */
+static struct select_entry select_table[SELECT_MAX_ALGOS];
+static size_t select_count;
+
+static struct select_entry *find_entry(uint32_t algo)
+{
+	size_t n = 0;
+
+	for (n = 0; n < select_count; n++)
+		if (select_table[n].algo == algo)
+			return select_table + n;
+
+	return NULL;
+}
+
+TEE_Result crypto_select_set_threshold(uint32_t algo, size_t threshold)
+{
+	struct select_entry *e = find_entry(algo);
+	uint32_t class = TEE_ALG_GET_CLASS(algo);
+
+	if (class != TEE_OPERATION_DIGEST && class != TEE_OPERATION_CIPHER)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	if (!e) {
+		if (select_count == ARRAY_SIZE(select_table))
+			return TEE_ERROR_OUT_OF_MEMORY;
+		e = select_table + select_count;
+		select_count++;
+		e->algo = algo;
+	}
+	e->threshold = threshold;
+
+	return TEE_SUCCESS;
+}
+
+bool crypto_select_get_threshold(uint32_t algo, size_t *threshold)
+{
+	struct select_entry *e = find_entry(algo);
+
+	if (!e)
+		return false;
+
+	*threshold = e->threshold;
+
+	return true;
+}
+
+static enum select_provider pick_provider(size_t threshold, size_t len,
+					  bool drv_busy)
+{
+	if (len < threshold || drv_busy)
+		return SELECT_SW;
+
+	return SELECT_DRV;
+}
+
+/*
+ * Hash: the provider is picked by the length of the first update after
+ * init, which is the whole message for most callers.
+ */
+struct select_hash_ctx {
+	struct crypto_hash_ctx hash_ctx;
+	size_t threshold;
+	struct crypto_hash_ctx *sub[SELECT_PROVIDER_COUNT];
+	struct crypto_hash_ctx *cur;	/* NULL until the first update */
+};
+
+static const struct crypto_hash_ops select_hash_ops;
+
+static struct select_hash_ctx *to_select_hash_ctx(struct crypto_hash_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &select_hash_ops);
+
+	return container_of(ctx, struct select_hash_ctx, hash_ctx);
+}
+
+static TEE_Result select_hash_start(struct select_hash_ctx *c, size_t len)
+{
+	enum select_provider p = pick_provider(c->threshold, len,
+					       drvcrypt_hash_saturated());
+	TEE_Result res = TEE_SUCCESS;
+
+	res = c->sub[p]->ops->init(c->sub[p]);
+	if (!res)
+		c->cur = c->sub[p];
+
+	return res;
+}
+
+static TEE_Result select_hash_init(struct crypto_hash_ctx *ctx)
+{
+	to_select_hash_ctx(ctx)->cur = NULL;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result select_hash_update(struct crypto_hash_ctx *ctx,
+				     const uint8_t *data, size_t len)
+{
+	struct select_hash_ctx *c = to_select_hash_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!c->cur) {
+		res = select_hash_start(c, len);
+		if (res)
+			return res;
+	}
+
+	return c->cur->ops->update(c->cur, data, len);
+}
+
+static TEE_Result select_hash_final(struct crypto_hash_ctx *ctx,
+				    uint8_t *digest, size_t len)
+{
+	struct select_hash_ctx *c = to_select_hash_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!c->cur) {
+		res = select_hash_start(c, 0);
+		if (res)
+			return res;
+	}
+
+	return c->cur->ops->final(c->cur, digest, len);
+}
+
+static void select_hash_free_ctx(struct crypto_hash_ctx *ctx)
+{
+	struct select_hash_ctx *c = to_select_hash_ctx(ctx);
+	size_t n = 0;
+
+	for (n = 0; n < SELECT_PROVIDER_COUNT; n++)
+		crypto_hash_free_ctx(c->sub[n]);
+	free(c);
+}
+
+static void select_hash_copy_state(struct crypto_hash_ctx *dst_ctx,
+				   struct crypto_hash_ctx *src_ctx)
+{
+	struct select_hash_ctx *src = to_select_hash_ctx(src_ctx);
+	struct select_hash_ctx *dst = to_select_hash_ctx(dst_ctx);
+	size_t n = 0;
+
+	dst->cur = NULL;
+	for (n = 0; n < SELECT_PROVIDER_COUNT; n++) {
+		if (src->cur != src->sub[n])
+			continue;
+		dst->sub[n]->ops->copy_state(dst->sub[n], src->sub[n]);
+		dst->cur = dst->sub[n];
+	}
+}
+
+static const struct crypto_hash_ops select_hash_ops = {
+	.init = select_hash_init,
+	.update = select_hash_update,
+	.final = select_hash_final,
+	.free_ctx = select_hash_free_ctx,
+	.copy_state = select_hash_copy_state,
+};
+
+TEE_Result
+crypto_select_hash_alloc_ctx_threshold(struct crypto_hash_ctx **ctx,
+				       uint32_t algo, size_t threshold)
+{
+	struct select_hash_ctx *c = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	void *sw_ctx = NULL;
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	c->hash_ctx.ops = &select_hash_ops;
+	c->threshold = threshold;
+
+	/*
+	 * Both contexts are allocated upfront, copy_state() can then switch
+	 * provider without failing.
+	 */
+	res = crypto_hash_alloc_sw_ctx(&sw_ctx, algo);
+	c->sub[SELECT_SW] = sw_ctx;
+	if (!res)
+		res = drvcrypt_hash_alloc_ctx(&c->sub[SELECT_DRV], algo);
+	if (res) {
+		select_hash_free_ctx(&c->hash_ctx);
+		return res;
+	}
+
+	*ctx = &c->hash_ctx;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result crypto_select_hash_alloc_ctx(struct crypto_hash_ctx **ctx,
+					uint32_t algo)
+{
+	size_t threshold = 0;
+
+	if (!crypto_select_get_threshold(algo, &threshold))
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	return crypto_select_hash_alloc_ctx_threshold(ctx, algo, threshold);
+}
+
+bool crypto_select_hash_on_drv(struct crypto_hash_ctx *ctx)
+{
+	struct select_hash_ctx *c = to_select_hash_ctx(ctx);
+
+	return c->cur && c->cur == c->sub[SELECT_DRV];
+}
+
+/*
+ * Cipher: the keys and IV are kept until the first update picks the
+ * provider. Each provider context remembers whether it is initialized with
+ * the current key so that a new IV doesn't expand the key again.
+ */
+struct select_cipher_ctx {
+	struct crypto_cipher_ctx cipher_ctx;
+	size_t threshold;
+	struct crypto_cipher_ctx *sub[SELECT_PROVIDER_COUNT];
+	bool keyed[SELECT_PROVIDER_COUNT];
+	struct crypto_cipher_ctx *cur;	/* NULL until the first update */
+	TEE_OperationMode mode;
+	uint8_t key1[SELECT_MAX_KEY_SIZE];
+	size_t key1_len;
+	uint8_t key2[SELECT_MAX_KEY_SIZE];
+	size_t key2_len;
+	uint8_t iv[SELECT_MAX_IV_SIZE];
+	size_t iv_len;
+};
+
+static const struct crypto_cipher_ops select_cipher_ops;
+
+static struct select_cipher_ctx *
+to_select_cipher_ctx(struct crypto_cipher_ctx *ctx)
+{
+	assert(ctx && ctx->ops == &select_cipher_ops);
+
+	return container_of(ctx, struct select_cipher_ctx, cipher_ctx);
+}
+
+static TEE_Result select_cipher_start(struct select_cipher_ctx *c,
+				      size_t len)
+{
+	enum select_provider p = pick_provider(c->threshold, len,
+					       drvcrypt_cipher_saturated());
+	struct crypto_cipher_ctx *sub = c->sub[p];
+	TEE_Result res = TEE_ERROR_NOT_SUPPORTED;
+
+	if (c->keyed[p] && sub->ops->reinit)
+		res = sub->ops->reinit(sub, c->mode, c->iv, c->iv_len);
+	if (res == TEE_ERROR_NOT_SUPPORTED)
+		res = sub->ops->init(sub, c->mode, c->key1, c->key1_len,
+				     c->key2, c->key2_len, c->iv, c->iv_len);
+	c->keyed[p] = !res;
+	if (res)
+		return res;
+
+	c->cur = sub;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result select_cipher_set_iv(struct select_cipher_ctx *c,
+				       TEE_OperationMode mode,
+				       const uint8_t *iv, size_t iv_len)
+{
+	if (iv_len > sizeof(c->iv) || (iv_len && !iv))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	c->cur = NULL;
+	c->mode = mode;
+	memcpy(c->iv, iv, iv_len);
+	c->iv_len = iv_len;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result select_cipher_init(struct crypto_cipher_ctx *ctx,
+				     TEE_OperationMode mode,
+				     const uint8_t *key1, size_t key1_len,
+				     const uint8_t *key2, size_t key2_len,
+				     const uint8_t *iv, size_t iv_len)
+{
+	struct select_cipher_ctx *c = to_select_cipher_ctx(ctx);
+	size_t n = 0;
+
+	if (key1_len > sizeof(c->key1) || key2_len > sizeof(c->key2) ||
+	    (key1_len && !key1) || (key2_len && !key2))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < SELECT_PROVIDER_COUNT; n++)
+		c->keyed[n] = false;
+	memcpy(c->key1, key1, key1_len);
+	c->key1_len = key1_len;
+	memcpy(c->key2, key2, key2_len);
+	c->key2_len = key2_len;
+
+	return select_cipher_set_iv(c, mode, iv, iv_len);
+}
+
+static TEE_Result select_cipher_reinit(struct crypto_cipher_ctx *ctx,
+				       TEE_OperationMode mode,
+				       const uint8_t *iv, size_t iv_len)
+{
+	return select_cipher_set_iv(to_select_cipher_ctx(ctx), mode, iv,
+				    iv_len);
+}
+
+static TEE_Result select_cipher_update(struct crypto_cipher_ctx *ctx,
+				       bool last_block, const uint8_t *data,
+				       size_t len, uint8_t *dst)
+{
+	struct select_cipher_ctx *c = to_select_cipher_ctx(ctx);
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!c->cur) {
+		res = select_cipher_start(c, len);
+		if (res)
+			return res;
+	}
+
+	return c->cur->ops->update(c->cur, last_block, data, len, dst);
+}
+
+static void select_cipher_final(struct crypto_cipher_ctx *ctx)
+{
+	struct select_cipher_ctx *c = to_select_cipher_ctx(ctx);
+
+	if (c->cur)
+		c->cur->ops->final(c->cur);
+}
+
+static void select_cipher_free_ctx(struct crypto_cipher_ctx *ctx)
+{
+	struct select_cipher_ctx *c = to_select_cipher_ctx(ctx);
+	size_t n = 0;
+
+	for (n = 0; n < SELECT_PROVIDER_COUNT; n++)
+		crypto_cipher_free_ctx(c->sub[n]);
+	memzero_explicit(c, sizeof(*c));
+	free(c);
+}
+
+static void select_cipher_copy_state(struct crypto_cipher_ctx *dst_ctx,
+				     struct crypto_cipher_ctx *src_ctx)
+{
+	struct select_cipher_ctx *src = to_select_cipher_ctx(src_ctx);
+	struct select_cipher_ctx *dst = to_select_cipher_ctx(dst_ctx);
+	size_t n = 0;
+
+	dst->cur = NULL;
+	dst->mode = src->mode;
+	memcpy(dst->key1, src->key1, sizeof(dst->key1));
+	dst->key1_len = src->key1_len;
+	memcpy(dst->key2, src->key2, sizeof(dst->key2));
+	dst->key2_len = src->key2_len;
+	memcpy(dst->iv, src->iv, sizeof(dst->iv));
+	dst->iv_len = src->iv_len;
+
+	for (n = 0; n < SELECT_PROVIDER_COUNT; n++) {
+		dst->keyed[n] = src->keyed[n];
+		if (!src->keyed[n])
+			continue;
+		dst->sub[n]->ops->copy_state(dst->sub[n], src->sub[n]);
+		if (src->cur == src->sub[n])
+			dst->cur = dst->sub[n];
+	}
+}
+
+static const struct crypto_cipher_ops select_cipher_ops = {
+	.init = select_cipher_init,
+	.update = select_cipher_update,
+	.final = select_cipher_final,
+	.free_ctx = select_cipher_free_ctx,
+	.copy_state = select_cipher_copy_state,
+	.reinit = select_cipher_reinit,
+};
+
+TEE_Result
+crypto_select_cipher_alloc_ctx_threshold(struct crypto_cipher_ctx **ctx,
+					 uint32_t algo, size_t threshold)
+{
+	struct select_cipher_ctx *c = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	void *sw_ctx = NULL;
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	c->cipher_ctx.ops = &select_cipher_ops;
+	c->threshold = threshold;
+
+	res = crypto_cipher_alloc_sw_ctx(&sw_ctx, algo);
+	c->sub[SELECT_SW] = sw_ctx;
+	if (!res)
+		res = drvcrypt_cipher_alloc_ctx(&c->sub[SELECT_DRV], algo);
+	if (res) {
+		select_cipher_free_ctx(&c->cipher_ctx);
+		return res;
+	}
+
+	*ctx = &c->cipher_ctx;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result crypto_select_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
+					  uint32_t algo)
+{
+	size_t threshold = 0;
+
+	if (!crypto_select_get_threshold(algo, &threshold))
+		return TEE_ERROR_NOT_IMPLEMENTED;
+
+	return crypto_select_cipher_alloc_ctx_threshold(ctx, algo, threshold);
+}
+
+bool crypto_select_cipher_on_drv(struct crypto_cipher_ctx *ctx)
+{
+	struct select_cipher_ctx *c = to_select_cipher_ctx(ctx);
+
+	return c->cur && c->cur == c->sub[SELECT_DRV];
+}
+
+/*
+ * The crossover sizes can be given in the device tree as pairs of
+ * TEE_ALG_* identifier and size in bytes, for instance:
+ *
+ * crypto-select {
+ *	compatible = "optee,crypto-select";
+ *	thresholds = <0x50000004 1024>, <0x10000110 4096>;
+ * };
+ *
+ * A size of 0 always uses the device, 0xffffffff never does unless the
+ * algorithm has no software implementation.
+ */
+static TEE_Result select_dt_init(void)
+{
+	const fdt32_t *prop = NULL;
+	void *fdt = get_dt();
+	size_t threshold = 0;
+	uint32_t algo = 0;
+	int node = 0;
+	int len = 0;
+	int n = 0;
+
+	if (!fdt)
+		return TEE_SUCCESS;
+
+	node = fdt_node_offset_by_compatible(fdt, -1, "optee,crypto-select");
+	if (node < 0)
+		return TEE_SUCCESS;
+
+	prop = fdt_getprop(fdt, node, "thresholds", &len);
+	if (!prop || len % (2 * sizeof(*prop))) {
+		EMSG("Invalid crypto-select thresholds");
+		return TEE_SUCCESS;
+	}
+
+	for (n = 0; n < len / (int)sizeof(*prop); n += 2) {
+		algo = fdt32_to_cpu(prop[n]);
+		threshold = fdt32_to_cpu(prop[n + 1]);
+		if (threshold == UINT32_MAX)
+			threshold = SIZE_MAX;
+		if (crypto_select_set_threshold(algo, threshold))
+			EMSG("Can't select implementation of algo %#"PRIx32,
+			     algo);
+	}
+
+	return TEE_SUCCESS;
+}
+
+service_init(select_dt_init);
+
+#ifdef CFG_CRYPTO_SIZE_SELECT_CALIBRATE
+/*
+ * Boot time calibration of the algorithms not set in the device tree. The
+ * software implementation and the device are timed on messages of
+ * increasing size, the crossover size is the smallest from which the
+ * device is faster on all the larger sizes.
+ */
+static const uint32_t calib_algos[] = {
+	TEE_ALG_SHA1, TEE_ALG_SHA224, TEE_ALG_SHA256, TEE_ALG_SHA384,
+	TEE_ALG_SHA512, TEE_ALG_AES_ECB_NOPAD, TEE_ALG_AES_CBC_NOPAD,
+	TEE_ALG_AES_CTR, TEE_ALG_AES_XTS,
+};
+
+static const size_t calib_sizes[] = { 64, 256, 1024, 4096, 16384 };
+
+/* Best of a few runs to filter out interrupts */
+#define CALIB_RUNS		4
+#define CALIB_BUF_SIZE		16384
+
+static const uint8_t calib_key[SELECT_MAX_KEY_SIZE] = { 1, 2, 3 };
+static const uint8_t calib_iv[SELECT_MAX_IV_SIZE] = { 4, 5, 6 };
+
+static TEE_Result time_hash(struct crypto_hash_ctx *ctx, const uint8_t *buf,
+			    size_t len, uint64_t *ticks)
+{
+	uint8_t digest[TEE_MAX_HASH_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	*ticks = UINT64_MAX;
+	for (n = 0; n < CALIB_RUNS; n++) {
+		t = barrier_read_counter_timer();
+		res = ctx->ops->init(ctx);
+		if (!res)
+			res = ctx->ops->update(ctx, buf, len);
+		if (!res)
+			res = ctx->ops->final(ctx, digest, sizeof(digest));
+		if (res)
+			return res;
+		*ticks = MIN(*ticks, barrier_read_counter_timer() - t);
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result time_cipher(struct crypto_cipher_ctx *ctx, uint32_t algo,
+			      uint8_t *buf, size_t len, uint64_t *ticks)
+{
+	size_t key2_len = 0;
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	if (algo == TEE_ALG_AES_XTS)
+		key2_len = 16;
+
+	*ticks = UINT64_MAX;
+	for (n = 0; n < CALIB_RUNS; n++) {
+		t = barrier_read_counter_timer();
+		res = ctx->ops->init(ctx, TEE_MODE_ENCRYPT, calib_key, 16,
+				     calib_key + 16, key2_len, calib_iv,
+				     algo == TEE_ALG_AES_ECB_NOPAD ? 0 : 16);
+		if (!res)
+			res = ctx->ops->update(ctx, true, buf, len, buf);
+		ctx->ops->final(ctx);
+		if (res)
+			return res;
+		*ticks = MIN(*ticks, barrier_read_counter_timer() - t);
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result time_provider(uint32_t algo, enum select_provider p,
+				uint8_t *buf, uint64_t ticks[])
+{
+	struct crypto_cipher_ctx *cipher = NULL;
+	struct crypto_hash_ctx *hash = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	void *sw_ctx = NULL;
+	size_t n = 0;
+
+	if (TEE_ALG_GET_CLASS(algo) == TEE_OPERATION_DIGEST) {
+		if (p == SELECT_SW) {
+			res = crypto_hash_alloc_sw_ctx(&sw_ctx, algo);
+			hash = sw_ctx;
+		} else {
+			res = drvcrypt_hash_alloc_ctx(&hash, algo);
+		}
+		for (n = 0; !res && n < ARRAY_SIZE(calib_sizes); n++)
+			res = time_hash(hash, buf, calib_sizes[n], ticks + n);
+		crypto_hash_free_ctx(hash);
+	} else {
+		if (p == SELECT_SW) {
+			res = crypto_cipher_alloc_sw_ctx(&sw_ctx, algo);
+			cipher = sw_ctx;
+		} else {
+			res = drvcrypt_cipher_alloc_ctx(&cipher, algo);
+		}
+		for (n = 0; !res && n < ARRAY_SIZE(calib_sizes); n++)
+			res = time_cipher(cipher, algo, buf, calib_sizes[n],
+					  ticks + n);
+		crypto_cipher_free_ctx(cipher);
+	}
+
+	return res;
+}
+
+static void calibrate_algo(uint32_t algo, uint8_t *buf)
+{
+	uint64_t sw_ticks[ARRAY_SIZE(calib_sizes)] = { };
+	uint64_t drv_ticks[ARRAY_SIZE(calib_sizes)] = { };
+	size_t threshold = SIZE_MAX;
+	size_t n = ARRAY_SIZE(calib_sizes);
+
+	if (time_provider(algo, SELECT_SW, buf, sw_ticks) ||
+	    time_provider(algo, SELECT_DRV, buf, drv_ticks))
+		return;
+
+	while (n && drv_ticks[n - 1] < sw_ticks[n - 1]) {
+		n--;
+		threshold = calib_sizes[n];
+	}
+	/* The device is faster on the smallest message too, always use it */
+	if (!n)
+		threshold = 0;
+
+	DMSG("algo %#"PRIx32": device from %zu bytes", algo, threshold);
+	if (crypto_select_set_threshold(algo, threshold))
+		EMSG("Can't select implementation of algo %#"PRIx32, algo);
+}
+
+static TEE_Result select_calibrate(void)
+{
+	size_t threshold = 0;
+	uint8_t *buf = NULL;
+	size_t n = 0;
+
+	buf = malloc(CALIB_BUF_SIZE);
+	if (!buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(buf, 0x5a, CALIB_BUF_SIZE);
+
+	for (n = 0; n < ARRAY_SIZE(calib_algos); n++)
+		if (!crypto_select_get_threshold(calib_algos[n], &threshold))
+			calibrate_algo(calib_algos[n], buf);
+
+	free(buf);
+
+	return TEE_SUCCESS;
+}
+
+/* After the drivers registered their drvcrypt operations */
+driver_init_late(select_calibrate);
+#endif /*CFG_CRYPTO_SIZE_SELECT_CALIBRATE*/
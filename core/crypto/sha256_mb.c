@@ -0,0 +1,274 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <crypto/crypto.h>
+#include <crypto/crypto_accel.h>
+#include <io.h>
+#include <string.h>
+#include <utee_defines.h>
+#include <util.h>
+
+static TEE_Result check_jobs(struct crypto_sha256_mb_job *jobs,
+			     size_t num_jobs)
+{
+	size_t n = 0;
+
+	if (num_jobs && !jobs)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < num_jobs; n++)
+		if (!jobs[n].digest ||
+		    jobs[n].num_segs > CRYPTO_SHA256_MB_MAX_SEGS)
+			return TEE_ERROR_BAD_PARAMETERS;
+
+	return TEE_SUCCESS;
+}
+
+#ifdef CFG_CORE_CRYPTO_SHA256_ACCEL
+
+#define SHA256_BLOCK_SIZE	64
+
+static const uint32_t sha256_iv[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+	0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+};
+
+/*
+ * struct sha256_mb_lane - one message in flight
+ * @job:	message being hashed, NULL if the lane is idle
+ * @state:	intermediate hash value
+ * @seg:	current segment of @job
+ * @offs:	offset in the current segment
+ * @msg_len:	number of message bytes consumed so far
+ * @pad_started: the 0x80 padding byte has been appended
+ * @last_block: @block holds the final, length terminated, block
+ * @block:	staging buffer for blocks straddling segments or padding
+ */
+struct sha256_mb_lane {
+	struct crypto_sha256_mb_job *job;
+	uint32_t state[8];
+	size_t seg;
+	size_t offs;
+	uint64_t msg_len;
+	bool pad_started;
+	bool last_block;
+	uint8_t block[SHA256_BLOCK_SIZE];
+};
+
+static void lane_skip_empty(struct sha256_mb_lane *l)
+{
+	while (l->seg < l->job->num_segs &&
+	       l->offs == l->job->seg[l->seg].len) {
+		l->seg++;
+		l->offs = 0;
+	}
+}
+
+static void lane_start(struct sha256_mb_lane *l,
+		       struct crypto_sha256_mb_job *job)
+{
+	l->job = job;
+	memcpy(l->state, sha256_iv, sizeof(l->state));
+	l->seg = 0;
+	l->offs = 0;
+	l->msg_len = 0;
+	l->pad_started = false;
+	l->last_block = false;
+	lane_skip_empty(l);
+}
+
+/* Number of whole blocks which can be compressed in place */
+static size_t lane_direct_blocks(struct sha256_mb_lane *l)
+{
+	if (l->seg == l->job->num_segs)
+		return 0;
+
+	return (l->job->seg[l->seg].len - l->offs) / SHA256_BLOCK_SIZE;
+}
+
+static const void *lane_direct_ptr(struct sha256_mb_lane *l)
+{
+	return (const uint8_t *)l->job->seg[l->seg].data + l->offs;
+}
+
+static void lane_advance(struct sha256_mb_lane *l, size_t block_count)
+{
+	size_t n = block_count * SHA256_BLOCK_SIZE;
+
+	l->offs += n;
+	l->msg_len += n;
+	lane_skip_empty(l);
+}
+
+/*
+ * Gathers the next block into the staging buffer, appending the padding
+ * and the message bit length once the segments are exhausted.
+ */
+static const void *lane_fill_block(struct sha256_mb_lane *l)
+{
+	const uint8_t *src = NULL;
+	size_t pos = 0;
+	size_t n = 0;
+
+	while (pos < SHA256_BLOCK_SIZE && l->seg < l->job->num_segs) {
+		src = l->job->seg[l->seg].data;
+		n = MIN(SHA256_BLOCK_SIZE - pos,
+			l->job->seg[l->seg].len - l->offs);
+		memcpy(l->block + pos, src + l->offs, n);
+		pos += n;
+		l->offs += n;
+		l->msg_len += n;
+		lane_skip_empty(l);
+	}
+	if (pos == SHA256_BLOCK_SIZE)
+		return l->block;
+
+	if (!l->pad_started) {
+		l->block[pos++] = 0x80;
+		l->pad_started = true;
+	}
+	memset(l->block + pos, 0, SHA256_BLOCK_SIZE - pos);
+	if (pos <= SHA256_BLOCK_SIZE - sizeof(uint64_t)) {
+		put_be64(l->block + SHA256_BLOCK_SIZE - sizeof(uint64_t),
+			 l->msg_len * 8);
+		l->last_block = true;
+	}
+
+	return l->block;
+}
+
+/* Outputs the digest if the final block was compressed, loads next job */
+static void lane_complete(struct sha256_mb_lane *l,
+			  struct crypto_sha256_mb_job *jobs, size_t num_jobs,
+			  size_t *next)
+{
+	size_t n = 0;
+
+	if (!l->last_block)
+		return;
+
+	for (n = 0; n < ARRAY_SIZE(l->state); n++)
+		put_be32(l->job->digest + n * sizeof(uint32_t), l->state[n]);
+
+	if (*next < num_jobs) {
+		lane_start(l, jobs + *next);
+		(*next)++;
+	} else {
+		l->job = NULL;
+	}
+}
+
+TEE_Result crypto_sha256_mb(struct crypto_sha256_mb_job *jobs,
+			    size_t num_jobs)
+{
+	struct sha256_mb_lane lanes[2] = { };
+	struct sha256_mb_lane *a = lanes;
+	struct sha256_mb_lane *b = lanes + 1;
+	struct sha256_mb_lane *tmp = NULL;
+	const void *src_a = NULL;
+	const void *src_b = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t next = 0;
+	size_t na = 0;
+	size_t nb = 0;
+
+	res = check_jobs(jobs, num_jobs);
+	if (res)
+		return res;
+
+	for (next = 0; next < MIN(num_jobs, ARRAY_SIZE(lanes)); next++)
+		lane_start(lanes + next, jobs + next);
+
+	while (a->job || b->job) {
+		if (!a->job) {
+			tmp = a;
+			a = b;
+			b = tmp;
+		}
+
+		na = lane_direct_blocks(a);
+		if (!b->job) {
+			/* Last message, nothing to interleave with */
+			if (na) {
+				crypto_accel_sha256_compress(a->state,
+							     lane_direct_ptr(a),
+							     na);
+				lane_advance(a, na);
+			} else {
+				src_a = lane_fill_block(a);
+				crypto_accel_sha256_compress(a->state, src_a,
+							     1);
+				lane_complete(a, jobs, num_jobs, &next);
+			}
+			continue;
+		}
+
+		nb = lane_direct_blocks(b);
+		if (na && nb) {
+			crypto_accel_sha256_compress_2x(a->state, b->state,
+							lane_direct_ptr(a),
+							lane_direct_ptr(b),
+							MIN(na, nb));
+			lane_advance(a, MIN(na, nb));
+			lane_advance(b, MIN(na, nb));
+			continue;
+		}
+
+		if (na)
+			src_a = lane_direct_ptr(a);
+		else
+			src_a = lane_fill_block(a);
+		if (nb)
+			src_b = lane_direct_ptr(b);
+		else
+			src_b = lane_fill_block(b);
+		crypto_accel_sha256_compress_2x(a->state, b->state,
+						src_a, src_b, 1);
+		if (na)
+			lane_advance(a, 1);
+		else
+			lane_complete(a, jobs, num_jobs, &next);
+		if (nb)
+			lane_advance(b, 1);
+		else
+			lane_complete(b, jobs, num_jobs, &next);
+	}
+
+	return TEE_SUCCESS;
+}
+#else
+TEE_Result crypto_sha256_mb(struct crypto_sha256_mb_job *jobs,
+			    size_t num_jobs)
+{
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+	size_t n = 0;
+	size_t m = 0;
+
+	res = check_jobs(jobs, num_jobs);
+	if (res || !num_jobs)
+		return res;
+
+	res = crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256);
+	if (res)
+		return res;
+
+	for (n = 0; n < num_jobs; n++) {
+		res = crypto_hash_init(ctx);
+		for (m = 0; !res && m < jobs[n].num_segs; m++)
+			res = crypto_hash_update(ctx, jobs[n].seg[m].data,
+						 jobs[n].seg[m].len);
+		if (!res)
+			res = crypto_hash_final(ctx, jobs[n].digest,
+						TEE_SHA256_HASH_SIZE);
+		if (res)
+			break;
+	}
+
+	crypto_hash_free_ctx(ctx);
+
+	return res;
+}
+#endif
@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ *
+ * SM4-CCM (RFC 8998) built on the SM4 CBC and CTR primitives, accelerated
+ * with the Cryptographic Extensions when available.
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <util.h>
+
+#include "sm4.h"
+
+#define SM4_BLOCK_SIZE		16
+/* Payload chunk processed by the CBC-MAC pass then by the CTR pass */
+#define SM4_CCM_CHUNK_SIZE	1024
+/* Discarded CBC output of the CBC-MAC computation */
+#define SM4_CCM_SCRATCH_SIZE	256
+
+struct sm4_ccm_ctx {
+	struct crypto_authenc_ctx aec;
+	struct sm4_context key;
+	uint8_t mac[SM4_BLOCK_SIZE];	/* CBC-MAC chaining value */
+	uint8_t buf[SM4_BLOCK_SIZE];	/* Pending CBC-MAC input */
+	size_t buf_pos;
+	uint8_t ctr[SM4_BLOCK_SIZE];	/* Next counter block */
+	uint8_t s0[SM4_BLOCK_SIZE];	/* Encrypted counter block A0 */
+	uint8_t ks[SM4_BLOCK_SIZE];	/* Keystream of a partial block */
+	size_t ks_pos;
+	size_t tag_len;
+	size_t aad_len;
+	size_t aad_count;
+	size_t payload_len;
+	size_t payload_count;
+};
+
+static const struct crypto_authenc_ops sm4_ccm_ops;
+
+static struct sm4_ccm_ctx *to_sm4_ccm_ctx(struct crypto_authenc_ctx *aec)
+{
+	assert(aec && aec->ops == &sm4_ccm_ops);
+
+	return container_of(aec, struct sm4_ccm_ctx, aec);
+}
+
+static void cbc_mac_update(struct sm4_ccm_ctx *c, const uint8_t *data,
+			   size_t len)
+{
+	uint8_t scratch[SM4_CCM_SCRATCH_SIZE] = { };
+	size_t n = 0;
+
+	if (c->buf_pos) {
+		n = MIN(SM4_BLOCK_SIZE - c->buf_pos, len);
+		memcpy(c->buf + c->buf_pos, data, n);
+		c->buf_pos += n;
+		data += n;
+		len -= n;
+
+		if (c->buf_pos != SM4_BLOCK_SIZE)
+			return;
+
+		sm4_crypt_cbc(&c->key, SM4_BLOCK_SIZE, c->mac, c->buf,
+			      scratch);
+		c->buf_pos = 0;
+	}
+
+	while (len >= SM4_BLOCK_SIZE) {
+		n = MIN(ROUNDDOWN(len, SM4_BLOCK_SIZE), sizeof(scratch));
+		sm4_crypt_cbc(&c->key, n, c->mac, data, scratch);
+		data += n;
+		len -= n;
+	}
+
+	if (len) {
+		memcpy(c->buf, data, len);
+		c->buf_pos = len;
+	}
+
+	memzero_explicit(scratch, sizeof(scratch));
+}
+
+static void cbc_mac_pad_zero(struct sm4_ccm_ctx *c)
+{
+	uint8_t scratch[SM4_BLOCK_SIZE] = { };
+
+	if (!c->buf_pos)
+		return;
+
+	memset(c->buf + c->buf_pos, 0, SM4_BLOCK_SIZE - c->buf_pos);
+	sm4_crypt_cbc(&c->key, SM4_BLOCK_SIZE, c->mac, c->buf, scratch);
+	c->buf_pos = 0;
+}
+
+/*
+ * The payload length is bounded by the size of the counter field so the
+ * increments of sm4_crypt_ctr() never carry into the nonce.
+ */
+static void ctr_crypt(struct sm4_ccm_ctx *c, const uint8_t *src, size_t len,
+		      uint8_t *dst)
+{
+	size_t n = 0;
+
+	while (len && c->ks_pos < SM4_BLOCK_SIZE) {
+		*dst++ = *src++ ^ c->ks[c->ks_pos++];
+		len--;
+	}
+
+	n = ROUNDDOWN(len, SM4_BLOCK_SIZE);
+	if (n) {
+		sm4_crypt_ctr(&c->key, n, c->ctr, src, dst);
+		src += n;
+		dst += n;
+		len -= n;
+	}
+
+	if (len) {
+		memset(c->ks, 0, sizeof(c->ks));
+		sm4_crypt_ctr(&c->key, sizeof(c->ks), c->ctr, c->ks, c->ks);
+		for (c->ks_pos = 0; c->ks_pos < len; c->ks_pos++)
+			dst[c->ks_pos] = src[c->ks_pos] ^ c->ks[c->ks_pos];
+	}
+}
+
+static TEE_Result sm4_ccm_start(struct sm4_ccm_ctx *c, const uint8_t *nonce,
+				size_t nonce_len, size_t tag_len,
+				size_t aad_len, size_t payload_len)
+{
+	uint8_t b0[SM4_BLOCK_SIZE] = { };
+	size_t q = SM4_BLOCK_SIZE - 1 - nonce_len;
+	size_t n = 0;
+
+	if (nonce_len < 7 || nonce_len > 13)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (tag_len < 4 || tag_len > SM4_BLOCK_SIZE || (tag_len & 1))
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (q < sizeof(uint64_t) && ((uint64_t)payload_len >> (8 * q)))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	c->tag_len = tag_len;
+	c->aad_len = aad_len;
+	c->aad_count = 0;
+	c->payload_len = payload_len;
+	c->payload_count = 0;
+	c->buf_pos = 0;
+	c->ks_pos = SM4_BLOCK_SIZE;
+	memset(c->mac, 0, sizeof(c->mac));
+
+	/* B0 = flags || nonce || payload length */
+	b0[0] = (aad_len ? BIT(6) : 0) | (((tag_len - 2) / 2) << 3) | (q - 1);
+	memcpy(b0 + 1, nonce, nonce_len);
+	for (n = 0; n < q && n < sizeof(uint64_t); n++)
+		b0[SM4_BLOCK_SIZE - 1 - n] = (uint64_t)payload_len >> (8 * n);
+	cbc_mac_update(c, b0, sizeof(b0));
+
+	/* The AAD is prefixed with its encoded length */
+	if (aad_len) {
+		if (aad_len < 0xFF00) {
+			c->buf[0] = aad_len >> 8;
+			c->buf[1] = aad_len;
+			c->buf_pos = 2;
+		} else if ((uint64_t)aad_len <= UINT32_MAX) {
+			c->buf[0] = 0xFF;
+			c->buf[1] = 0xFE;
+			for (n = 0; n < 4; n++)
+				c->buf[2 + n] = aad_len >> (8 * (3 - n));
+			c->buf_pos = 6;
+		} else {
+			c->buf[0] = 0xFF;
+			c->buf[1] = 0xFF;
+			for (n = 0; n < 8; n++)
+				c->buf[2 + n] = (uint64_t)aad_len >>
+						(8 * (7 - n));
+			c->buf_pos = 10;
+		}
+	}
+
+	/* A0 = flags || nonce || 0, the payload starts with A1 */
+	memset(c->ctr, 0, sizeof(c->ctr));
+	c->ctr[0] = q - 1;
+	memcpy(c->ctr + 1, nonce, nonce_len);
+	memset(c->s0, 0, sizeof(c->s0));
+	sm4_crypt_ctr(&c->key, sizeof(c->s0), c->ctr, c->s0, c->s0);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_ccm_init(struct crypto_authenc_ctx *aec,
+			       TEE_OperationMode mode __unused,
+			       const uint8_t *key, size_t key_len,
+			       const uint8_t *nonce, size_t nonce_len,
+			       size_t tag_len, size_t aad_len,
+			       size_t payload_len)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+
+	if (key_len != 16)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Both CBC-MAC and CTR use the SM4 encryption */
+	sm4_setkey_enc(&c->key, key);
+
+	return sm4_ccm_start(c, nonce, nonce_len, tag_len, aad_len,
+			     payload_len);
+}
+
+static TEE_Result sm4_ccm_reinit(struct crypto_authenc_ctx *aec,
+				 TEE_OperationMode mode __unused,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len,
+				 size_t payload_len)
+{
+	return sm4_ccm_start(to_sm4_ccm_ctx(aec), nonce, nonce_len, tag_len,
+			     aad_len, payload_len);
+}
+
+static TEE_Result sm4_ccm_update_aad(struct crypto_authenc_ctx *aec,
+				     const uint8_t *data, size_t len)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+
+	if (c->payload_count || len > c->aad_len - c->aad_count)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	c->aad_count += len;
+	cbc_mac_update(c, data, len);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_ccm_update_payload(struct crypto_authenc_ctx *aec,
+					 TEE_OperationMode mode,
+					 const uint8_t *src, size_t len,
+					 uint8_t *dst)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+	size_t n = 0;
+
+	if (c->aad_count != c->aad_len)
+		return TEE_ERROR_BAD_STATE;
+	if (len > c->payload_len - c->payload_count)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (!len)
+		return TEE_SUCCESS;
+
+	if (!c->payload_count)
+		cbc_mac_pad_zero(c);
+	c->payload_count += len;
+
+	while (len) {
+		n = MIN(len, (size_t)SM4_CCM_CHUNK_SIZE);
+		if (mode == TEE_MODE_ENCRYPT) {
+			cbc_mac_update(c, src, n);
+			ctr_crypt(c, src, n, dst);
+		} else {
+			ctr_crypt(c, src, n, dst);
+			cbc_mac_update(c, dst, n);
+		}
+		src += n;
+		dst += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_ccm_final_tag(struct sm4_ccm_ctx *c,
+				    TEE_OperationMode mode, const uint8_t *src,
+				    size_t len, uint8_t *dst)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t n = 0;
+
+	res = sm4_ccm_update_payload(&c->aec, mode, src, len, dst);
+	if (res)
+		return res;
+	if (c->payload_count != c->payload_len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	cbc_mac_pad_zero(c);
+	for (n = 0; n < c->tag_len; n++)
+		c->mac[n] ^= c->s0[n];
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_ccm_enc_final(struct crypto_authenc_ctx *aec,
+				    const uint8_t *src, size_t len,
+				    uint8_t *dst, uint8_t *tag, size_t *tag_len)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (*tag_len < c->tag_len)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	res = sm4_ccm_final_tag(c, TEE_MODE_ENCRYPT, src, len, dst);
+	if (res)
+		return res;
+
+	memcpy(tag, c->mac, c->tag_len);
+	*tag_len = c->tag_len;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_ccm_dec_final(struct crypto_authenc_ctx *aec,
+				    const uint8_t *src, size_t len,
+				    uint8_t *dst, const uint8_t *tag,
+				    size_t tag_len)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (tag_len != c->tag_len)
+		return TEE_ERROR_MAC_INVALID;
+
+	res = sm4_ccm_final_tag(c, TEE_MODE_DECRYPT, src, len, dst);
+	if (res)
+		return res;
+
+	if (consttime_memcmp(c->mac, tag, tag_len))
+		return TEE_ERROR_MAC_INVALID;
+
+	return TEE_SUCCESS;
+}
+
+static void sm4_ccm_final(struct crypto_authenc_ctx *aec)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+
+	/* The key is kept for sm4_ccm_reinit() */
+	memzero_explicit(c->mac, sizeof(c->mac));
+	memzero_explicit(c->buf, sizeof(c->buf));
+	memzero_explicit(c->s0, sizeof(c->s0));
+	memzero_explicit(c->ks, sizeof(c->ks));
+}
+
+static void sm4_ccm_free_ctx(struct crypto_authenc_ctx *aec)
+{
+	struct sm4_ccm_ctx *c = to_sm4_ccm_ctx(aec);
+
+	memzero_explicit(&c->key, sizeof(c->key));
+	free(c);
+}
+
+static void sm4_ccm_copy_state(struct crypto_authenc_ctx *dst_ctx,
+			       struct crypto_authenc_ctx *src_ctx)
+{
+	struct sm4_ccm_ctx *src = to_sm4_ccm_ctx(src_ctx);
+	struct sm4_ccm_ctx *dst = to_sm4_ccm_ctx(dst_ctx);
+
+	*dst = *src;
+	dst->aec.ops = &sm4_ccm_ops;
+}
+
+static const struct crypto_authenc_ops sm4_ccm_ops = {
+	.init = sm4_ccm_init,
+	.update_aad = sm4_ccm_update_aad,
+	.update_payload = sm4_ccm_update_payload,
+	.enc_final = sm4_ccm_enc_final,
+	.dec_final = sm4_ccm_dec_final,
+	.final = sm4_ccm_final,
+	.free_ctx = sm4_ccm_free_ctx,
+	.copy_state = sm4_ccm_copy_state,
+	.reinit = sm4_ccm_reinit,
+};
+
+TEE_Result crypto_sm4_ccm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
+{
+	struct sm4_ccm_ctx *c = NULL;
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	c->aec.ops = &sm4_ccm_ops;
+	*ctx_ret = &c->aec;
+
+	return TEE_SUCCESS;
+}
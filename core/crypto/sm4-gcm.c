@@ -0,0 +1,386 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ *
+ * SM4-GCM (RFC 8998) built on the SM4 CTR primitive and the GHASH
+ * implementation of AES-GCM, both accelerated with the Cryptographic
+ * Extensions when available.
+ */
+
+#include <assert.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <crypto/internal_aes-gcm.h>
+#include <io.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tee_api_types.h>
+#include <util.h>
+
+#include "sm4.h"
+
+/*
+ * The payload is processed in chunks of this size, the chunk encrypted
+ * (or authenticated) in the first pass is still in the cache when the
+ * second pass reaches it.
+ */
+#define SM4_GCM_CHUNK_SIZE	1024
+
+/*
+ * The GCM state reuses struct internal_aes_gcm_state:
+ * @ctr:	counter block of the next keystream block
+ * @buf_tag:	encrypted first counter block, then the tag
+ * @buf_hash:	pending GHASH input
+ * @buf_cryp:	keystream of the last partial block
+ */
+struct sm4_gcm_ctx {
+	struct crypto_authenc_ctx aec;
+	struct sm4_context key;
+	struct internal_aes_gcm_state state;
+	size_t ks_pos;
+};
+
+static const struct crypto_authenc_ops sm4_gcm_ops;
+
+static struct sm4_gcm_ctx *to_sm4_gcm_ctx(struct crypto_authenc_ctx *aec)
+{
+	assert(aec && aec->ops == &sm4_gcm_ops);
+
+	return container_of(aec, struct sm4_gcm_ctx, aec);
+}
+
+static void ghash_update(struct internal_aes_gcm_state *state,
+			 const uint8_t *data, size_t len)
+{
+	size_t n = 0;
+
+	while (len) {
+		if (state->buf_pos || len < TEE_AES_BLOCK_SIZE ||
+		    !internal_aes_gcm_ptr_is_block_aligned(data)) {
+			n = MIN(TEE_AES_BLOCK_SIZE - state->buf_pos, len);
+			memcpy(state->buf_hash + state->buf_pos, data, n);
+			state->buf_pos += n;
+			data += n;
+			len -= n;
+
+			if (state->buf_pos != TEE_AES_BLOCK_SIZE)
+				return;
+
+			internal_aes_gcm_ghash_update(state, state->buf_hash,
+						      NULL, 0);
+			state->buf_pos = 0;
+			continue;
+		}
+
+		n = len / TEE_AES_BLOCK_SIZE;
+		internal_aes_gcm_ghash_update(state, NULL, data, n);
+		data += n * TEE_AES_BLOCK_SIZE;
+		len -= n * TEE_AES_BLOCK_SIZE;
+	}
+}
+
+static void ghash_pad_zero(struct internal_aes_gcm_state *state)
+{
+	if (!state->buf_pos)
+		return;
+
+	memset(state->buf_hash + state->buf_pos, 0,
+	       TEE_AES_BLOCK_SIZE - state->buf_pos);
+	internal_aes_gcm_ghash_update(state, state->buf_hash, NULL, 0);
+	state->buf_pos = 0;
+}
+
+static void ghash_update_lengths(struct internal_aes_gcm_state *state,
+				 uint64_t l1, uint64_t l2)
+{
+	uint64_t len_fields[2] = {
+		TEE_U64_TO_BIG_ENDIAN(l1 * 8),
+		TEE_U64_TO_BIG_ENDIAN(l2 * 8)
+	};
+
+	internal_aes_gcm_ghash_update(state, len_fields, NULL, 0);
+}
+
+/*
+ * GCM increments the low 32 bits of the counter block only while
+ * sm4_crypt_ctr() increments the whole block, the blocks are split where
+ * the low 32 bits wrap around.
+ */
+static void ctr_blocks(struct sm4_gcm_ctx *c, const uint8_t *src,
+		       size_t num_blocks, uint8_t *dst)
+{
+	uint8_t *ctr = (uint8_t *)c->state.ctr;
+	uint8_t iv[TEE_AES_BLOCK_SIZE - 4] = { };
+	uint32_t ctr32 = 0;
+	size_t n = 0;
+
+	while (num_blocks) {
+		ctr32 = get_be32(ctr + sizeof(iv));
+		n = MIN((uint64_t)num_blocks, (uint64_t)UINT32_MAX - ctr32 + 1);
+
+		memcpy(iv, ctr, sizeof(iv));
+		sm4_crypt_ctr(&c->key, n * TEE_AES_BLOCK_SIZE, ctr, src, dst);
+		memcpy(ctr, iv, sizeof(iv));
+		put_be32(ctr + sizeof(iv), ctr32 + n);
+
+		src += n * TEE_AES_BLOCK_SIZE;
+		dst += n * TEE_AES_BLOCK_SIZE;
+		num_blocks -= n;
+	}
+}
+
+static void ctr_crypt(struct sm4_gcm_ctx *c, const uint8_t *src, size_t len,
+		      uint8_t *dst)
+{
+	uint8_t *ks = c->state.buf_cryp;
+	size_t n = 0;
+
+	while (len && c->ks_pos < TEE_AES_BLOCK_SIZE) {
+		*dst++ = *src++ ^ ks[c->ks_pos++];
+		len--;
+	}
+
+	n = len / TEE_AES_BLOCK_SIZE;
+	if (n) {
+		ctr_blocks(c, src, n, dst);
+		src += n * TEE_AES_BLOCK_SIZE;
+		dst += n * TEE_AES_BLOCK_SIZE;
+		len -= n * TEE_AES_BLOCK_SIZE;
+	}
+
+	if (len) {
+		memset(ks, 0, TEE_AES_BLOCK_SIZE);
+		ctr_blocks(c, ks, 1, ks);
+		for (c->ks_pos = 0; c->ks_pos < len; c->ks_pos++)
+			dst[c->ks_pos] = src[c->ks_pos] ^ ks[c->ks_pos];
+	}
+}
+
+static TEE_Result sm4_gcm_start(struct sm4_gcm_ctx *c, const uint8_t *nonce,
+				size_t nonce_len, size_t tag_len)
+{
+	struct internal_aes_gcm_state *state = &c->state;
+
+	if (tag_len > sizeof(state->buf_tag) || !nonce_len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	state->tag_len = tag_len;
+	state->aad_bytes = 0;
+	state->payload_bytes = 0;
+	state->buf_pos = 0;
+	memset(state->hash_state, 0, sizeof(state->hash_state));
+
+	if (nonce_len == 96 / 8) {
+		memcpy(state->ctr, nonce, nonce_len);
+		put_be32((uint8_t *)state->ctr + nonce_len, 1);
+	} else {
+		ghash_update(state, nonce, nonce_len);
+		ghash_pad_zero(state);
+		ghash_update_lengths(state, 0, nonce_len);
+
+		memcpy(state->ctr, state->hash_state, sizeof(state->ctr));
+		memset(state->hash_state, 0, sizeof(state->hash_state));
+	}
+
+	memset(state->buf_tag, 0, sizeof(state->buf_tag));
+	ctr_blocks(c, state->buf_tag, 1, state->buf_tag);
+	c->ks_pos = TEE_AES_BLOCK_SIZE;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_gcm_init(struct crypto_authenc_ctx *aec,
+			       TEE_OperationMode mode __unused,
+			       const uint8_t *key, size_t key_len,
+			       const uint8_t *nonce, size_t nonce_len,
+			       size_t tag_len, size_t aad_len __unused,
+			       size_t payload_len __unused)
+{
+	struct sm4_gcm_ctx *c = to_sm4_gcm_ctx(aec);
+	uint64_t h[2] = { };
+
+	if (key_len != 16)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	/* Both directions use the SM4 encryption of the counter blocks */
+	sm4_setkey_enc(&c->key, key);
+	sm4_crypt_ecb(&c->key, sizeof(h), (uint8_t *)h, (uint8_t *)h);
+	internal_aes_gcm_set_ghash_key(&c->state.ghash_key, h);
+	memzero_explicit(h, sizeof(h));
+
+	return sm4_gcm_start(c, nonce, nonce_len, tag_len);
+}
+
+static TEE_Result sm4_gcm_reinit(struct crypto_authenc_ctx *aec,
+				 TEE_OperationMode mode __unused,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len __unused,
+				 size_t payload_len __unused)
+{
+	return sm4_gcm_start(to_sm4_gcm_ctx(aec), nonce, nonce_len, tag_len);
+}
+
+static TEE_Result sm4_gcm_update_aad(struct crypto_authenc_ctx *aec,
+				     const uint8_t *data, size_t len)
+{
+	struct internal_aes_gcm_state *state = &to_sm4_gcm_ctx(aec)->state;
+
+	if (state->payload_bytes)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	state->aad_bytes += len;
+	ghash_update(state, data, len);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_gcm_update_payload(struct crypto_authenc_ctx *aec,
+					 TEE_OperationMode mode,
+					 const uint8_t *src, size_t len,
+					 uint8_t *dst)
+{
+	struct sm4_gcm_ctx *c = to_sm4_gcm_ctx(aec);
+	struct internal_aes_gcm_state *state = &c->state;
+	size_t n = 0;
+
+	if (!len)
+		return TEE_SUCCESS;
+
+	if (!state->payload_bytes)
+		ghash_pad_zero(state);
+	state->payload_bytes += len;
+
+	while (len) {
+		n = MIN(len, (size_t)SM4_GCM_CHUNK_SIZE);
+		if (mode == TEE_MODE_ENCRYPT) {
+			ctr_crypt(c, src, n, dst);
+			ghash_update(state, dst, n);
+		} else {
+			ghash_update(state, src, n);
+			ctr_crypt(c, src, n, dst);
+		}
+		src += n;
+		dst += n;
+		len -= n;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_gcm_final_tag(struct sm4_gcm_ctx *c,
+				    TEE_OperationMode mode, const uint8_t *src,
+				    size_t len, uint8_t *dst)
+{
+	struct internal_aes_gcm_state *state = &c->state;
+	TEE_Result res = TEE_ERROR_GENERIC;
+	size_t n = 0;
+
+	res = sm4_gcm_update_payload(&c->aec, mode, src, len, dst);
+	if (res)
+		return res;
+
+	ghash_pad_zero(state);
+	ghash_update_lengths(state, state->aad_bytes, state->payload_bytes);
+	for (n = 0; n < state->tag_len; n++)
+		state->buf_tag[n] ^= state->hash_state[n];
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_gcm_enc_final(struct crypto_authenc_ctx *aec,
+				    const uint8_t *src, size_t len,
+				    uint8_t *dst, uint8_t *tag, size_t *tag_len)
+{
+	struct sm4_gcm_ctx *c = to_sm4_gcm_ctx(aec);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (*tag_len < c->state.tag_len)
+		return TEE_ERROR_SHORT_BUFFER;
+
+	res = sm4_gcm_final_tag(c, TEE_MODE_ENCRYPT, src, len, dst);
+	if (res)
+		return res;
+
+	memcpy(tag, c->state.buf_tag, c->state.tag_len);
+	*tag_len = c->state.tag_len;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result sm4_gcm_dec_final(struct crypto_authenc_ctx *aec,
+				    const uint8_t *src, size_t len,
+				    uint8_t *dst, const uint8_t *tag,
+				    size_t tag_len)
+{
+	struct sm4_gcm_ctx *c = to_sm4_gcm_ctx(aec);
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (tag_len != c->state.tag_len)
+		return TEE_ERROR_MAC_INVALID;
+
+	res = sm4_gcm_final_tag(c, TEE_MODE_DECRYPT, src, len, dst);
+	if (res)
+		return res;
+
+	if (consttime_memcmp(c->state.buf_tag, tag, tag_len))
+		return TEE_ERROR_MAC_INVALID;
+
+	return TEE_SUCCESS;
+}
+
+static void sm4_gcm_final(struct crypto_authenc_ctx *aec)
+{
+	struct internal_aes_gcm_state *state = &to_sm4_gcm_ctx(aec)->state;
+
+	/* The keys are kept for sm4_gcm_reinit() */
+	memzero_explicit(state->hash_state, sizeof(state->hash_state));
+	memzero_explicit(state->buf_tag, sizeof(state->buf_tag));
+	memzero_explicit(state->buf_hash, sizeof(state->buf_hash));
+	memzero_explicit(state->buf_cryp, sizeof(state->buf_cryp));
+}
+
+static void sm4_gcm_free_ctx(struct crypto_authenc_ctx *aec)
+{
+	struct sm4_gcm_ctx *c = to_sm4_gcm_ctx(aec);
+
+	memzero_explicit(&c->key, sizeof(c->key));
+	free(c);
+}
+
+static void sm4_gcm_copy_state(struct crypto_authenc_ctx *dst_ctx,
+			       struct crypto_authenc_ctx *src_ctx)
+{
+	struct sm4_gcm_ctx *src = to_sm4_gcm_ctx(src_ctx);
+	struct sm4_gcm_ctx *dst = to_sm4_gcm_ctx(dst_ctx);
+
+	dst->key = src->key;
+	dst->state = src->state;
+	dst->ks_pos = src->ks_pos;
+}
+
+static const struct crypto_authenc_ops sm4_gcm_ops = {
+	.init = sm4_gcm_init,
+	.update_aad = sm4_gcm_update_aad,
+	.update_payload = sm4_gcm_update_payload,
+	.enc_final = sm4_gcm_enc_final,
+	.dec_final = sm4_gcm_dec_final,
+	.final = sm4_gcm_final,
+	.free_ctx = sm4_gcm_free_ctx,
+	.copy_state = sm4_gcm_copy_state,
+	.reinit = sm4_gcm_reinit,
+};
+
+TEE_Result crypto_sm4_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx_ret)
+{
+	struct sm4_gcm_ctx *c = NULL;
+
+	c = calloc(1, sizeof(*c));
+	if (!c)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	c->aec.ops = &sm4_gcm_ops;
+	*ctx_ret = &c->aec;
+
+	return TEE_SUCCESS;
+}
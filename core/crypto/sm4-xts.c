@@ -13,6 +13,11 @@
 #include <util.h>
 #include "sm4.h"
 
+/* Data units processed together by crypto_sm4_xts_multi() */
+#define SM4_XTS_LANES		8
+/* Blocks of each data unit handled per SM4 call */
+#define SM4_XTS_LANE_BLOCKS	2
+
 struct sm4_xts_ctx {
 	struct crypto_cipher_ctx ctx;
 	struct sm4_context state;
@@ -115,3 +120,105 @@ TEE_Result crypto_sm4_xts_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
 
 	return TEE_SUCCESS;
 }
+
+/* Multiplies the tweak by the primitive element alpha of GF(2^128) */
+static void xts_mul_alpha(uint8_t t[16])
+{
+	uint8_t carry = 0;
+	uint8_t msb = 0;
+	size_t n = 0;
+
+	for (n = 0; n < 16; n++) {
+		msb = t[n] >> 7;
+		t[n] = (t[n] << 1) | carry;
+		carry = msb;
+	}
+
+	t[0] ^= 0x87 & (0 - carry);
+}
+
+static void xts_multi_lanes(struct sm4_context *k1, struct sm4_context *k2,
+			    struct crypto_sm4_xts_unit *units, size_t lanes,
+			    size_t unit_len)
+{
+	uint8_t buf[SM4_XTS_LANES * SM4_XTS_LANE_BLOCKS * 16] = { };
+	uint8_t tws[SM4_XTS_LANES * SM4_XTS_LANE_BLOCKS * 16] = { };
+	uint8_t tweak[SM4_XTS_LANES][16] = { };
+	const uint8_t *src = NULL;
+	uint8_t *dst = NULL;
+	size_t offs = 0;
+	size_t nb = 0;
+	size_t l = 0;
+	size_t b = 0;
+	size_t i = 0;
+	size_t k = 0;
+
+	/* Encrypt the tweaks of all the lanes at once */
+	for (l = 0; l < lanes; l++)
+		memcpy(tweak[l], units[l].tweak, 16);
+	sm4_crypt_ecb(k2, lanes * 16, tweak[0], tweak[0]);
+
+	for (offs = 0; offs < unit_len; offs += nb * 16) {
+		nb = MIN((unit_len - offs) / 16, (size_t)SM4_XTS_LANE_BLOCKS);
+
+		for (l = 0; l < lanes; l++) {
+			src = (const uint8_t *)units[l].src + offs;
+			for (b = 0; b < nb; b++) {
+				i = (l * nb + b) * 16;
+				memcpy(tws + i, tweak[l], 16);
+				xts_mul_alpha(tweak[l]);
+				for (k = 0; k < 16; k++)
+					buf[i + k] = src[b * 16 + k] ^
+						     tws[i + k];
+			}
+		}
+
+		sm4_crypt_ecb(k1, lanes * nb * 16, buf, buf);
+
+		for (l = 0; l < lanes; l++) {
+			dst = (uint8_t *)units[l].dst + offs;
+			for (b = 0; b < nb; b++) {
+				i = (l * nb + b) * 16;
+				for (k = 0; k < 16; k++)
+					dst[b * 16 + k] = buf[i + k] ^
+							  tws[i + k];
+			}
+		}
+	}
+
+	memzero_explicit(buf, sizeof(buf));
+	memzero_explicit(tws, sizeof(tws));
+	memzero_explicit(tweak, sizeof(tweak));
+}
+
+TEE_Result crypto_sm4_xts_multi(TEE_OperationMode mode,
+				const uint8_t key1[16], const uint8_t key2[16],
+				struct crypto_sm4_xts_unit *units,
+				size_t num_units, size_t unit_len)
+{
+	struct sm4_context k1 = { };
+	struct sm4_context k2 = { };
+	size_t n = 0;
+
+	if (!key1 || !key2 || (num_units && !units) || !unit_len ||
+	    unit_len % 16)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		sm4_setkey_enc(&k1, key1);
+	else if (mode == TEE_MODE_DECRYPT)
+		sm4_setkey_dec(&k1, key1);
+	else
+		return TEE_ERROR_BAD_PARAMETERS;
+	sm4_setkey_enc(&k2, key2);
+
+	for (n = 0; n < num_units; n += SM4_XTS_LANES)
+		xts_multi_lanes(&k1, &k2, units + n,
+				MIN(num_units - n, (size_t)SM4_XTS_LANES),
+				unit_len);
+
+	memzero_explicit(&k1, sizeof(k1));
+	memzero_explicit(&k2, sizeof(k2));
+
+	return TEE_SUCCESS;
+}
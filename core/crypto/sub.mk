@@ -1,4 +1,5 @@
 srcs-y += crypto.c
+srcs-$(CFG_CRYPTO_SIZE_SELECT) += crypto_select.c
 
 ifeq (y-y,$(CFG_CRYPTO_AES)-$(CFG_CRYPTO_GCM))
 srcs-y += aes-gcm.c
@@ -42,4 +43,12 @@ srcs-$(CFG_CRYPTO_ECB) += sm4-ecb.c
 srcs-$(CFG_CRYPTO_CBC) += sm4-cbc.c
 srcs-$(CFG_CRYPTO_CTR) += sm4-ctr.c
 srcs-$(CFG_CRYPTO_XTS) += sm4-xts.c
+srcs-$(CFG_CRYPTO_CCM) += sm4-ccm.c
+# SM4-GCM uses the GHASH implementation of the internal AES-GCM
+ifeq (y-y,$(CFG_CRYPTO_AES)-$(CFG_CRYPTO_GCM))
+ifneq ($(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB),y)
+srcs-y += sm4-gcm.c
+endif
+endif
 endif
+srcs-$(CFG_CRYPTO_SHA256) += sha256_mb.c
@@ -12,6 +12,10 @@
 #include <initcall.h>
 #include <kernel/cache_helpers.h>
 #include <kernel/delay.h>
+#include <kernel/mutex.h>
+#include <kernel/panic.h>
+#include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <mm/core_memprot.h>
 #include <tee_api_types.h>
 
@@ -31,6 +35,9 @@
 #define ETIMEDOUT       60
 
 #define ADI_TE_MAILBOX_REG_SIZE         (0x1000)
+#define TE_BUF_SIZE                     (1024)
+#define TE_BUF_ALIGN                    (64)    /* Cache line size */
+#define TE_MAX_MAILBOXES                (2)     /* Primary and secondary tile */
 
 uint32_t mb_regs_mdr[NUM_MAILBOX_DATA_REGS] = {
 	MB_REGS_MDR0,
@@ -67,8 +74,61 @@ typedef enum {
 	ADI_ENCLAVE_RANDOM			= 0x184,
 } adi_enclave_api_id_t;
 
-static uint8_t te_buf[1024] __attribute__((aligned(sizeof(uint64_t))));    /* Buffer to transfer data through TE mailbox */
-static uintptr_t cur_ptr = (uintptr_t)te_buf;
+/*
+ * Buffer to transfer data through TE mailbox. There's one per thread, and
+ * one for use before threads are available, so only the mailbox itself is
+ * shared. Buffers are cache line aligned since they're invalidated after
+ * each transaction.
+ */
+struct te_xfer {
+	uint8_t buf[TE_BUF_SIZE];
+	uintptr_t cur_ptr;
+} __aligned(TE_BUF_ALIGN);
+
+static struct te_xfer te_xfers[CFG_NUM_THREADS + 1];
+
+/* Serializes transactions on each mailbox */
+struct te_mailbox {
+	uintptr_t base_addr;
+	struct mutex mu;
+};
+
+static struct te_mailbox te_mailboxes[TE_MAX_MAILBOXES] = {
+	{ .mu = MUTEX_INITIALIZER }, { .mu = MUTEX_INITIALIZER },
+};
+static unsigned int te_mailboxes_lock = SPINLOCK_UNLOCK;
+
+static struct te_xfer *get_xfer(void)
+{
+	short int ct = thread_get_id_may_fail();
+
+	if (ct == THREAD_ID_INVALID)
+		return te_xfers + CFG_NUM_THREADS;
+	return te_xfers + ct;
+}
+
+static struct mutex *get_mailbox_mutex(uintptr_t base_addr)
+{
+	struct mutex *mu = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&te_mailboxes_lock);
+	for (n = 0; n < TE_MAX_MAILBOXES; n++) {
+		if (!te_mailboxes[n].base_addr)
+			te_mailboxes[n].base_addr = base_addr;
+		if (te_mailboxes[n].base_addr == base_addr) {
+			mu = &te_mailboxes[n].mu;
+			break;
+		}
+	}
+	cpu_spin_unlock_xrestore(&te_mailboxes_lock, exceptions);
+
+	if (!mu)
+		panic("Too many TE mailboxes");
+
+	return mu;
+}
 
 adi_lifecycle_t adi_enclave_get_lifecycle_state(uintptr_t base_addr)
 {
@@ -118,6 +178,8 @@ static int wait_for_response(uintptr_t base_addr)
 
 static int verify_buf_len_ptr(const void *buf, uint32_t *buflen, uint32_t minlen, uint32_t maxlen)
 {
+	struct te_xfer *xfer = get_xfer();
+
 	if (buf == NULL || buflen == NULL)
 		return HOST_ERROR_INVALID_ARGS;
 
@@ -125,7 +187,7 @@ static int verify_buf_len_ptr(const void *buf, uint32_t *buflen, uint32_t minlen
 		return HOST_ERROR_INVALID_ARGS;
 
 	/* Check for overflow of te_buf */
-	if ((cur_ptr + *buflen) > ((uintptr_t)te_buf + sizeof(te_buf)))
+	if ((xfer->cur_ptr + *buflen) > ((uintptr_t)xfer->buf + sizeof(xfer->buf)))
 		return HOST_ERROR_BUFFER;
 
 	return ADI_TE_RET_OK;
@@ -139,11 +201,12 @@ static int verify_buf_len(const void *buf, uint32_t buflen, uint32_t minlen, uin
 /* Copy buffer to te_buf which is used to transfer data through the mailbox */
 static uintptr_t reserve_buf(uintptr_t buf, uint32_t size)
 {
-	uintptr_t old_ptr = cur_ptr;
+	struct te_xfer *xfer = get_xfer();
+	uintptr_t old_ptr = xfer->cur_ptr;
 
-	memcpy((void *)cur_ptr, (void *)buf, size);
+	memcpy((void *)xfer->cur_ptr, (void *)buf, size);
 
-	cur_ptr += size;
+	xfer->cur_ptr += size;
 
 	return old_ptr;
 }
@@ -151,25 +214,17 @@ static uintptr_t reserve_buf(uintptr_t buf, uint32_t size)
 /* Set pointer back to start of te_buf and clear buffer */
 static void buf_init(void)
 {
-	cur_ptr = (uintptr_t)te_buf;
+	struct te_xfer *xfer = get_xfer();
+
+	xfer->cur_ptr = (uintptr_t)xfer->buf;
 
-	memset(te_buf, 0, sizeof(te_buf));
+	memset(xfer->buf, 0, sizeof(xfer->buf));
 }
 
-/* Data sent through TE mailbox must be copied to te_buf prior to calling this function to be able to flush/invalidate memory */
-static int perform_enclave_transaction(uintptr_t base_addr, adi_enclave_api_id_t requestId, uint32_t args[], uint32_t numArgs)
+static int mailbox_transaction(vaddr_t va, adi_enclave_api_id_t requestId, uint32_t args[], uint32_t numArgs)
 {
 	uint32_t i;
 	int ret;
-	vaddr_t va;
-
-	if ((args == NULL && numArgs != 0) || (numArgs > NUM_MAILBOX_DATA_REGS))
-		return HOST_ERROR_INVALID_ARGS;
-
-	/* Clean cache */
-	dcache_clean_range((void *)virt_to_phys((void *)te_buf), sizeof(te_buf));
-
-	va = (vaddr_t)phys_to_virt_io(base_addr, ADI_TE_MAILBOX_REG_SIZE);
 
 	io_write32(va + MB_REGS_HRC0, requestId);
 
@@ -186,15 +241,44 @@ static int perform_enclave_transaction(uintptr_t base_addr, adi_enclave_api_id_t
 
 	ack_response(va);
 
-	/* Invalidate cache */
-	dcache_inv_range((void *)virt_to_phys((void *)te_buf), sizeof(te_buf));
-
 	for (i = 0; i < numArgs; i++)
 		args[i] = io_read32(va + mb_regs_mdr[i]);
 
 	return io_read32(va + MB_REGS_ERC1);
 }
 
+/* Data sent through TE mailbox must be copied to te_buf prior to calling this function to be able to flush/invalidate memory */
+static int perform_enclave_transaction(uintptr_t base_addr, adi_enclave_api_id_t requestId, uint32_t args[], uint32_t numArgs)
+{
+	struct te_xfer *xfer = get_xfer();
+	struct mutex *mu = NULL;
+	int ret;
+	vaddr_t va;
+
+	if ((args == NULL && numArgs != 0) || (numArgs > NUM_MAILBOX_DATA_REGS))
+		return HOST_ERROR_INVALID_ARGS;
+
+	/* Clean cache */
+	dcache_clean_range((void *)virt_to_phys((void *)xfer->buf), sizeof(xfer->buf));
+
+	va = (vaddr_t)phys_to_virt_io(base_addr, ADI_TE_MAILBOX_REG_SIZE);
+
+	/* Nothing else can use the mailbox before threads are available */
+	if (thread_get_id_may_fail() != THREAD_ID_INVALID)
+		mu = get_mailbox_mutex(base_addr);
+
+	if (mu)
+		mutex_lock(mu);
+	ret = mailbox_transaction(va, requestId, args, numArgs);
+	if (mu)
+		mutex_unlock(mu);
+
+	/* Invalidate cache */
+	dcache_inv_range((void *)virt_to_phys((void *)xfer->buf), sizeof(xfer->buf));
+
+	return ret;
+}
+
 /* Tiny Enclave version */
 int adi_enclave_get_enclave_version(uintptr_t base_addr, uint8_t *output_buffer, uint32_t *o_buff_len)
 {
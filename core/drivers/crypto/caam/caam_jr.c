@@ -22,6 +22,11 @@
 #include <mm/core_memprot.h>
 #include <tee/cache.h>
 
+#ifdef CFG_CRYPTO_DRV_QUEUE
+#include <drvcrypt_queue.h>
+#include <kernel/thread.h>
+#endif
+
 /*
  * Job Free define
  */
@@ -395,6 +400,125 @@ static void job_done(struct caam_jobctx *jobctx)
 	jobctx->completion = true;
 }
 
+#ifdef CFG_CRYPTO_DRV_QUEUE
+/*
+ * Queue of the synchronous jobs. The jobs are pushed in the Job Ring when
+ * it has free entries and one of the waiting threads dequeues the
+ * completed jobs while the others sleep.
+ */
+static struct drvcrypt_queue jr_queue;
+static bool jr_queue_ready;
+
+/*
+ * Queued job completion callback
+ *
+ * @jobctx   Job context
+ */
+static void jr_queue_job_done(struct caam_jobctx *jobctx)
+{
+	jobctx->completion = true;
+	drvcrypt_queue_complete(&jr_queue, jobctx->context, TEE_SUCCESS);
+}
+
+/*
+ * Push queued jobs in the Job Ring
+ *
+ * @queue    Job Ring queue
+ * @jobs     Jobs to push
+ * @nb_jobs  Number of jobs
+ */
+static void jr_queue_submit(struct drvcrypt_queue *queue,
+			    struct drvcrypt_job **jobs, size_t nb_jobs)
+{
+	struct caam_jobctx *jobctx = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < nb_jobs; n++) {
+		jobctx = jobs[n]->data;
+		if (do_jr_enqueue(jobctx, &jobctx->id) != CAAM_NO_ERROR)
+			drvcrypt_queue_complete(queue, jobs[n], TEE_ERROR_BUSY);
+	}
+}
+
+/*
+ * Dequeue the completed jobs, polling for up to 1 millisecond
+ *
+ * @queue    Job Ring queue
+ */
+static void jr_queue_reap(struct drvcrypt_queue *queue __unused)
+{
+	unsigned int nb_loop = 100;
+
+	while (!do_jr_dequeue(UINT32_MAX) && nb_loop--) {
+		if (!caam_hal_jr_check_ack_itr(jr_privdata->baseaddr))
+			caam_udelay(10);
+	}
+}
+
+static const struct drvcrypt_queue_ops jr_queue_ops = {
+	.submit = jr_queue_submit,
+	.reap = jr_queue_reap,
+};
+
+/*
+ * Initialize the Job Ring queue and register it for the hash and
+ * cipher drivers
+ *
+ * @nb_jobs  Number of Job Ring entries
+ */
+static enum caam_status jr_queue_init(uint8_t nb_jobs)
+{
+	if (drvcrypt_queue_init(&jr_queue, &jr_queue_ops, NULL, nb_jobs,
+				nb_jobs, nb_jobs))
+		return CAAM_OUT_MEMORY;
+
+	if (IS_ENABLED(CFG_NXP_CAAM_HASH_DRV))
+		drvcrypt_register_queue(CRYPTO_HASH, &jr_queue);
+	if (IS_ENABLED(CFG_NXP_CAAM_CIPHER_DRV))
+		drvcrypt_register_queue(CRYPTO_CIPHER, &jr_queue);
+
+	jr_queue_ready = true;
+
+	return CAAM_NO_ERROR;
+}
+
+/*
+ * Return true if the calling context can sleep waiting for a queued job
+ */
+static bool jr_queue_usable(void)
+{
+	return jr_queue_ready &&
+	       thread_get_id_may_fail() != THREAD_ID_INVALID &&
+	       thread_is_in_normal_mode();
+}
+
+/*
+ * Run a synchronous job through the Job Ring queue
+ *
+ * @jobctx   Caller's job context
+ */
+static enum caam_status jr_queue_run(struct caam_jobctx *jobctx)
+{
+	struct drvcrypt_job job = { .data = jobctx };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	jobctx->callback = jr_queue_job_done;
+	jobctx->context = &job;
+
+	res = drvcrypt_queue_run(&jr_queue, &job);
+
+	jobctx->callback = NULL;
+
+	if (res != TEE_SUCCESS)
+		return CAAM_BUSY;
+
+	if (JRSTA_SRC_GET(jobctx->status) != JRSTA_SRC(NONE))
+		return CAAM_JOB_STATUS;
+
+	return CAAM_NO_ERROR;
+}
+#endif /* CFG_CRYPTO_DRV_QUEUE */
+
 void caam_jr_cancel(uint32_t job_id)
 {
 	unsigned int idx = 0;
@@ -472,6 +596,11 @@ enum caam_status caam_jr_enqueue(struct caam_jobctx *jobctx, uint32_t *job_id)
 	jobctx->completion = false;
 	jobctx->status = 0;
 
+#ifdef CFG_CRYPTO_DRV_QUEUE
+	if (!job_id && !jobctx->callback && jr_queue_usable())
+		return jr_queue_run(jobctx);
+#endif
+
 	/*
 	 * If parameter job_id is NULL, the job is synchronous, hence use
 	 * the local job_done callback function
@@ -596,7 +725,11 @@ enum caam_status caam_jr_init(struct caam_jrcfg *jrcfg)
 #endif
 	caam_hal_jr_enable_itr(jr_privdata->baseaddr);
 
+#ifdef CFG_CRYPTO_DRV_QUEUE
+	retstatus = jr_queue_init(jr_privdata->nb_jobs);
+#else
 	retstatus = CAAM_NO_ERROR;
+#endif
 
 end_init:
 	if (retstatus != CAAM_NO_ERROR)
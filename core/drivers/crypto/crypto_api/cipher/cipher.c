@@ -9,6 +9,7 @@
 #include <crypto/crypto_impl.h>
 #include <drvcrypt.h>
 #include <drvcrypt_cipher.h>
+#include <drvcrypt_queue.h>
 #include <malloc.h>
 #include <util.h>
 
@@ -196,3 +197,10 @@ TEE_Result drvcrypt_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
 
 	return ret;
 }
+
+#ifdef CFG_CRYPTO_DRV_QUEUE
+bool drvcrypt_cipher_saturated(void)
+{
+	return drvcrypt_queue_saturated(drvcrypt_get_queue(CRYPTO_CIPHER));
+}
+#endif
@@ -0,0 +1,273 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ *
+ * Brief   Asynchronous job queue between the crypto drivers and the
+ *         hardware engines.
+ */
+#include <assert.h>
+#include <drvcrypt.h>
+#include <drvcrypt_queue.h>
+#include <kernel/spinlock.h>
+#include <stdlib.h>
+
+/* Maximum number of jobs handed over to an engine at once */
+#define QUEUE_MAX_BATCH	8
+
+STAILQ_HEAD(job_list, drvcrypt_job);
+
+static struct drvcrypt_queue *crypt_queue[CRYPTO_MAX_ALGO];
+
+TEE_Result drvcrypt_queue_init(struct drvcrypt_queue *queue,
+			       const struct drvcrypt_queue_ops *ops, void *priv,
+			       size_t depth, size_t slots, size_t batch)
+{
+	if (!queue || !ops || !ops->submit || !ops->reap || !depth ||
+	    !slots || !batch)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	queue->ring = calloc(depth, sizeof(*queue->ring));
+	if (!queue->ring)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	queue->ops = ops;
+	queue->priv = priv;
+	queue->depth = depth;
+	queue->head = 0;
+	queue->pending = 0;
+	queue->slots = slots;
+	queue->inflight = 0;
+	queue->batch = MIN(batch, (size_t)QUEUE_MAX_BATCH);
+	queue->dispatching = false;
+	STAILQ_INIT(&queue->done_list);
+	queue->lock = SPINLOCK_UNLOCK;
+
+	mutex_init(&queue->mu);
+	condvar_init(&queue->cv);
+	queue->reaping = false;
+
+	return TEE_SUCCESS;
+}
+
+void drvcrypt_queue_release(struct drvcrypt_queue *queue)
+{
+	if (!queue)
+		return;
+
+	assert(!queue->pending && !queue->inflight);
+
+	condvar_destroy(&queue->cv);
+	mutex_destroy(&queue->mu);
+	free(queue->ring);
+	queue->ring = NULL;
+}
+
+/*
+ * Hand the pending jobs over to the engine while it has free slots. A
+ * single thread dispatches at a time so that jobs are started in
+ * submission order.
+ */
+static void queue_dispatch(struct drvcrypt_queue *queue)
+{
+	struct drvcrypt_job *jobs[QUEUE_MAX_BATCH] = { };
+	uint32_t exceptions = 0;
+	size_t nb_jobs = 0;
+	size_t n = 0;
+
+	exceptions = cpu_spin_lock_xsave(&queue->lock);
+	if (queue->dispatching) {
+		cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+		return;
+	}
+	queue->dispatching = true;
+
+	while (true) {
+		nb_jobs = MIN(queue->pending, queue->slots - queue->inflight);
+		nb_jobs = MIN(nb_jobs, queue->batch);
+		if (!nb_jobs)
+			break;
+
+		for (n = 0; n < nb_jobs; n++) {
+			jobs[n] = queue->ring[queue->head];
+			queue->head = (queue->head + 1) % queue->depth;
+		}
+		queue->pending -= nb_jobs;
+		queue->inflight += nb_jobs;
+
+		cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+		CRYPTO_TRACE("Queue %p start %zu jobs", queue, nb_jobs);
+		queue->ops->submit(queue, jobs, nb_jobs);
+		exceptions = cpu_spin_lock_xsave(&queue->lock);
+	}
+
+	queue->dispatching = false;
+	cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+}
+
+/*
+ * Reap the engine completions and notify them. Called with @queue->mu
+ * held and no reaper running, returns with @queue->mu held.
+ */
+static void queue_reap_locked(struct drvcrypt_queue *queue)
+{
+	struct job_list done = STAILQ_HEAD_INITIALIZER(done);
+	struct job_list waited = STAILQ_HEAD_INITIALIZER(waited);
+	struct drvcrypt_job *job = NULL;
+	uint32_t exceptions = 0;
+
+	assert(!queue->reaping);
+	queue->reaping = true;
+	mutex_unlock(&queue->mu);
+
+	queue->ops->reap(queue);
+
+	/* Completions freed engine slots, start the next jobs */
+	queue_dispatch(queue);
+
+	exceptions = cpu_spin_lock_xsave(&queue->lock);
+	STAILQ_CONCAT(&done, &queue->done_list);
+	cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+
+	while ((job = STAILQ_FIRST(&done))) {
+		STAILQ_REMOVE_HEAD(&done, link);
+		if (job->done)
+			job->done(job);
+		else
+			STAILQ_INSERT_TAIL(&waited, job, link);
+	}
+
+	mutex_lock(&queue->mu);
+	/* A waiter may release its job as soon as it is marked completed */
+	while ((job = STAILQ_FIRST(&waited))) {
+		STAILQ_REMOVE_HEAD(&waited, link);
+		job->completed = true;
+	}
+	queue->reaping = false;
+	condvar_broadcast(&queue->cv);
+}
+
+TEE_Result drvcrypt_queue_submit(struct drvcrypt_queue *queue,
+				 struct drvcrypt_job *job)
+{
+	uint32_t exceptions = 0;
+
+	if (!queue || !job)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	job->completed = false;
+	job->result = TEE_ERROR_GENERIC;
+
+	exceptions = cpu_spin_lock_xsave(&queue->lock);
+	if (queue->pending == queue->depth) {
+		cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+		return TEE_ERROR_BUSY;
+	}
+	queue->ring[(queue->head + queue->pending) % queue->depth] = job;
+	queue->pending++;
+	cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+
+	queue_dispatch(queue);
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result drvcrypt_queue_wait(struct drvcrypt_queue *queue,
+			       struct drvcrypt_job *job)
+{
+	if (!queue || !job || job->done)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mutex_lock(&queue->mu);
+	while (!job->completed) {
+		if (queue->reaping)
+			condvar_wait(&queue->cv, &queue->mu);
+		else
+			queue_reap_locked(queue);
+	}
+	mutex_unlock(&queue->mu);
+
+	return job->result;
+}
+
+TEE_Result drvcrypt_queue_run(struct drvcrypt_queue *queue,
+			      struct drvcrypt_job *job)
+{
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	if (!queue || !job || job->done)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	while (true) {
+		res = drvcrypt_queue_submit(queue, job);
+		if (res != TEE_ERROR_BUSY)
+			break;
+
+		/* Queue full, wait for jobs to be started */
+		mutex_lock(&queue->mu);
+		if (queue->reaping)
+			condvar_wait(&queue->cv, &queue->mu);
+		else
+			queue_reap_locked(queue);
+		mutex_unlock(&queue->mu);
+	}
+
+	if (res)
+		return res;
+
+	return drvcrypt_queue_wait(queue, job);
+}
+
+void drvcrypt_queue_poll(struct drvcrypt_queue *queue)
+{
+	mutex_lock(&queue->mu);
+	if (!queue->reaping)
+		queue_reap_locked(queue);
+	mutex_unlock(&queue->mu);
+}
+
+void drvcrypt_queue_complete(struct drvcrypt_queue *queue,
+			     struct drvcrypt_job *job, TEE_Result result)
+{
+	uint32_t exceptions = 0;
+
+	exceptions = cpu_spin_lock_xsave(&queue->lock);
+	assert(queue->inflight);
+	queue->inflight--;
+	job->result = result;
+	STAILQ_INSERT_TAIL(&queue->done_list, job, link);
+	cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+}
+
+bool drvcrypt_queue_saturated(struct drvcrypt_queue *queue)
+{
+	uint32_t exceptions = 0;
+	bool saturated = false;
+
+	if (!queue)
+		return false;
+
+	exceptions = cpu_spin_lock_xsave(&queue->lock);
+	saturated = queue->pending + queue->inflight >= queue->slots;
+	cpu_spin_unlock_xrestore(&queue->lock, exceptions);
+
+	return saturated;
+}
+
+TEE_Result drvcrypt_register_queue(enum drvcrypt_algo_id algo_id,
+				   struct drvcrypt_queue *queue)
+{
+	if (!crypt_queue[algo_id]) {
+		CRYPTO_TRACE("Registering queue %p for module id %d", queue,
+			     algo_id);
+		crypt_queue[algo_id] = queue;
+		return TEE_SUCCESS;
+	}
+
+	CRYPTO_TRACE("Fail to register queue for module id %d", algo_id);
+	return TEE_ERROR_GENERIC;
+}
+
+struct drvcrypt_queue *drvcrypt_get_queue(enum drvcrypt_algo_id algo_id)
+{
+	return crypt_queue[algo_id];
+}
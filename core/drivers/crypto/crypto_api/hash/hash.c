@@ -7,6 +7,7 @@
 #include <assert.h>
 #include <drvcrypt.h>
 #include <drvcrypt_hash.h>
+#include <drvcrypt_queue.h>
 #include <util.h>
 
 TEE_Result drvcrypt_hash_alloc_ctx(struct crypto_hash_ctx **ctx, uint32_t algo)
@@ -27,3 +28,10 @@ TEE_Result drvcrypt_hash_alloc_ctx(struct crypto_hash_ctx **ctx, uint32_t algo)
 
 	return ret;
 }
+
+#ifdef CFG_CRYPTO_DRV_QUEUE
+bool drvcrypt_hash_saturated(void)
+{
+	return drvcrypt_queue_saturated(drvcrypt_get_queue(CRYPTO_HASH));
+}
+#endif
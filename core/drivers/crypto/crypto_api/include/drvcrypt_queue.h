@@ -0,0 +1,176 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ *
+ * Brief   Asynchronous job queue between the crypto drivers and the
+ *         hardware engines.
+ */
+#ifndef __DRVCRYPT_QUEUE_H__
+#define __DRVCRYPT_QUEUE_H__
+
+#include <drvcrypt.h>
+#include <kernel/mutex.h>
+#include <stdbool.h>
+#include <sys/queue.h>
+#include <tee_api_types.h>
+
+struct drvcrypt_queue;
+
+/*
+ * Job submitted to an engine queue
+ *
+ * A job with a @done callback belongs to the callback once completed and
+ * must not be waited for, the callback runs in the reaping thread and must
+ * not wait for other jobs. A job without callback is waited for with
+ * drvcrypt_queue_wait().
+ */
+struct drvcrypt_job {
+	void *data;        /* Engine request */
+	void (*done)(struct drvcrypt_job *job); /* Completion callback */
+	void *context;     /* Caller context of the completion callback */
+	TEE_Result result; /* Job result, valid once completed */
+	bool completed;    /* Job completion flag */
+	STAILQ_ENTRY(drvcrypt_job) link; /* Completed jobs list */
+};
+
+/*
+ * Engine operations called by the queue
+ */
+struct drvcrypt_queue_ops {
+	/*
+	 * Start @nb_jobs jobs on the engine, in order. The engine has room
+	 * for all of them, a job failing to start is completed with an
+	 * error with drvcrypt_queue_complete().
+	 */
+	void (*submit)(struct drvcrypt_queue *queue, struct drvcrypt_job **jobs,
+		       size_t nb_jobs);
+	/*
+	 * Collect the jobs finished by the engine, calling
+	 * drvcrypt_queue_complete() for each of them. Called by one thread at
+	 * a time while other waiters sleep, it may poll for a short while
+	 * but must return even if nothing completed.
+	 */
+	void (*reap)(struct drvcrypt_queue *queue);
+};
+
+/*
+ * Per engine job queue. Jobs are kept in a ring until the engine has a
+ * free slot and are handed over to the engine in batches.
+ */
+struct drvcrypt_queue {
+	const struct drvcrypt_queue_ops *ops; /* Engine operations */
+	void *priv;                  /* Engine private data */
+
+	struct drvcrypt_job **ring;  /* Jobs not yet started */
+	size_t depth;                /* Number of entries of @ring */
+	size_t head;                 /* Index of the oldest pending job */
+	size_t pending;              /* Number of jobs in @ring */
+	size_t slots;                /* Jobs the engine runs concurrently */
+	size_t inflight;             /* Jobs started on the engine */
+	size_t batch;                /* Max jobs handed over at once */
+	bool dispatching;            /* A thread is starting jobs */
+	STAILQ_HEAD(, drvcrypt_job) done_list; /* Completed, not notified */
+	unsigned int lock;           /* Protects the fields above */
+
+	struct mutex mu;             /* Protects @reaping */
+	struct condvar cv;           /* Signaled after each reap */
+	bool reaping;                /* A thread is reaping completions */
+};
+
+/*
+ * Initialize an engine queue
+ *
+ * @queue   Queue to initialize
+ * @ops     Engine operations
+ * @priv    Engine private data
+ * @depth   Number of jobs which can be pending on top of the engine slots
+ * @slots   Number of jobs the engine can run concurrently
+ * @batch   Maximum number of jobs handed over to the engine at once
+ */
+TEE_Result drvcrypt_queue_init(struct drvcrypt_queue *queue,
+			       const struct drvcrypt_queue_ops *ops, void *priv,
+			       size_t depth, size_t slots, size_t batch);
+
+/*
+ * Release the resources of an engine queue without pending jobs
+ *
+ * @queue   Queue to release
+ */
+void drvcrypt_queue_release(struct drvcrypt_queue *queue);
+
+/*
+ * Submit a job without waiting for its completion. Returns
+ * TEE_ERROR_BUSY if the queue is full, the caller then processes the
+ * request by other means, in software for instance.
+ *
+ * @queue   Engine queue
+ * @job     Job to submit
+ */
+TEE_Result drvcrypt_queue_submit(struct drvcrypt_queue *queue,
+				 struct drvcrypt_job *job);
+
+/*
+ * Wait until a submitted job completes and return its result. One of the
+ * waiting threads reaps the engine completions, the others sleep.
+ *
+ * @queue   Engine queue
+ * @job     Job submitted without completion callback
+ */
+TEE_Result drvcrypt_queue_wait(struct drvcrypt_queue *queue,
+			       struct drvcrypt_job *job);
+
+/*
+ * Submit a job and wait for its completion, sleeping while the queue is
+ * full.
+ *
+ * @queue   Engine queue
+ * @job     Job to run, without completion callback
+ */
+TEE_Result drvcrypt_queue_run(struct drvcrypt_queue *queue,
+			      struct drvcrypt_job *job);
+
+/*
+ * Reap the engine completions unless another thread is already doing so.
+ * Used to make progress on jobs submitted with a completion callback.
+ *
+ * @queue   Engine queue
+ */
+void drvcrypt_queue_poll(struct drvcrypt_queue *queue);
+
+/*
+ * Called by the engine when a job finished. Can be called from any
+ * context, the completion callback and the waiters are notified by the
+ * reaping thread.
+ *
+ * @queue   Engine queue
+ * @job     Job finished
+ * @result  Job result
+ */
+void drvcrypt_queue_complete(struct drvcrypt_queue *queue,
+			     struct drvcrypt_job *job, TEE_Result result);
+
+/*
+ * Return true if a new job would not be started immediately by the
+ * engine
+ *
+ * @queue   Engine queue
+ */
+bool drvcrypt_queue_saturated(struct drvcrypt_queue *queue);
+
+/*
+ * Register the queue of the engine implementing a Cryptographic module
+ *
+ * @algo_id  ID of the Cryptographic module
+ * @queue    Engine queue
+ */
+TEE_Result drvcrypt_register_queue(enum drvcrypt_algo_id algo_id,
+				   struct drvcrypt_queue *queue);
+
+/*
+ * Return the engine queue registered for a Cryptographic module or NULL
+ *
+ * @algo_id  ID of the Cryptographic module
+ */
+struct drvcrypt_queue *drvcrypt_get_queue(enum drvcrypt_algo_id algo_id);
+
+#endif /* __DRVCRYPT_QUEUE_H__ */
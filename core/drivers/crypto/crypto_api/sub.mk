@@ -1,4 +1,5 @@
 srcs-y += drvcrypt.c
+srcs-$(CFG_CRYPTO_DRV_QUEUE) += drvcrypt_queue.c
 
 subdirs-y += math
 
@@ -27,16 +27,63 @@
 
 TEE_Result crypto_init(void);
 
+/*
+ * The crypto_*_alloc_ctx() functions select a drvcrypt driver when one
+ * implements the algorithm, the crypto_*_alloc_sw_ctx() variants always
+ * use the software implementation.
+ */
+
+/*
+ * The implementation behind a hash or cipher context is picked when it is
+ * allocated and may change between allocations, crypto_*_copy_state() must
+ * only be used between contexts for which crypto_*_same_impl() is true.
+ * crypto_*_alloc_ctx_like() allocates a context using the implementation
+ * of @ref_ctx, TEE_ERROR_BAD_STATE is returned if that's not possible.
+ */
+
 /* Message digest functions */
 TEE_Result crypto_hash_alloc_ctx(void **ctx, uint32_t algo);
+TEE_Result crypto_hash_alloc_sw_ctx(void **ctx, uint32_t algo);
 TEE_Result crypto_hash_init(void *ctx);
 TEE_Result crypto_hash_update(void *ctx, const uint8_t *data, size_t len);
 TEE_Result crypto_hash_final(void *ctx, uint8_t *digest, size_t len);
 void crypto_hash_free_ctx(void *ctx);
 void crypto_hash_copy_state(void *dst_ctx, void *src_ctx);
+TEE_Result crypto_hash_alloc_ctx_like(void **ctx, uint32_t algo,
+				      void *ref_ctx);
+bool crypto_hash_same_impl(void *ctx1, void *ctx2);
+
+#define CRYPTO_SHA256_MB_MAX_SEGS	4
+
+/*
+ * struct crypto_sha256_mb_job - one message hashed by crypto_sha256_mb()
+ * @seg:	segments of the message, hashed in order
+ * @num_segs:	number of used entries in @seg
+ * @digest:	receives the TEE_SHA256_HASH_SIZE bytes digest
+ */
+struct crypto_sha256_mb_job {
+	struct {
+		const void *data;
+		size_t len;
+	} seg[CRYPTO_SHA256_MB_MAX_SEGS];
+	size_t num_segs;
+	uint8_t *digest;
+};
+
+/*
+ * crypto_sha256_mb() - computes the SHA-256 digests of independent messages
+ * @jobs:	messages to hash
+ * @num_jobs:	number of entries in @jobs
+ *
+ * With an accelerated implementation the messages are hashed interleaved,
+ * else one after the other.
+ */
+TEE_Result crypto_sha256_mb(struct crypto_sha256_mb_job *jobs,
+			    size_t num_jobs);
 
 /* Symmetric ciphers */
 TEE_Result crypto_cipher_alloc_ctx(void **ctx, uint32_t algo);
+TEE_Result crypto_cipher_alloc_sw_ctx(void **ctx, uint32_t algo);
 TEE_Result crypto_cipher_init(void *ctx, TEE_OperationMode mode,
 			      const uint8_t *key1, size_t key1_len,
 			      const uint8_t *key2, size_t key2_len,
@@ -48,9 +95,51 @@ void crypto_cipher_final(void *ctx);
 TEE_Result crypto_cipher_get_block_size(uint32_t algo, size_t *size);
 void crypto_cipher_free_ctx(void *ctx);
 void crypto_cipher_copy_state(void *dst_ctx, void *src_ctx);
+TEE_Result crypto_cipher_alloc_ctx_like(void **ctx, uint32_t algo,
+					void *ref_ctx);
+bool crypto_cipher_same_impl(void *ctx1, void *ctx2);
+/*
+ * Restarts the operation with a new IV keeping the key expanded by the last
+ * crypto_cipher_init() or copied with crypto_cipher_copy_state(). Returns
+ * TEE_ERROR_NOT_SUPPORTED if the implementation can't do that.
+ */
+TEE_Result crypto_cipher_reinit(void *ctx, TEE_OperationMode mode,
+				const uint8_t *iv, size_t iv_len);
+/* Returns true if crypto_cipher_reinit() is supported for @ctx */
+bool crypto_cipher_can_reinit(void *ctx);
+
+/*
+ * struct crypto_sm4_xts_unit - one data unit of crypto_sm4_xts_multi()
+ * @src:	source data unit
+ * @dst:	destination data unit, may be equal to @src
+ * @tweak:	tweak (IV) of the data unit, typically the sector number
+ */
+struct crypto_sm4_xts_unit {
+	const void *src;
+	void *dst;
+	uint8_t tweak[16];
+};
+
+/*
+ * crypto_sm4_xts_multi() - SM4-XTS processing of independent data units
+ * @mode:	TEE_MODE_ENCRYPT or TEE_MODE_DECRYPT
+ * @key1:	data key
+ * @key2:	tweak key
+ * @units:	data units to process
+ * @num_units:	number of entries in @units
+ * @unit_len:	length of each data unit, a multiple of 16 bytes
+ *
+ * The data units are interleaved so that the blocks of several units are
+ * processed with one call to the (accelerated) SM4 primitive.
+ */
+TEE_Result crypto_sm4_xts_multi(TEE_OperationMode mode,
+				const uint8_t key1[16], const uint8_t key2[16],
+				struct crypto_sm4_xts_unit *units,
+				size_t num_units, size_t unit_len);
 
 /* Message Authentication Code functions */
 TEE_Result crypto_mac_alloc_ctx(void **ctx, uint32_t algo);
+TEE_Result crypto_mac_alloc_sw_ctx(void **ctx, uint32_t algo);
 TEE_Result crypto_mac_init(void *ctx, const uint8_t *key, size_t len);
 TEE_Result crypto_mac_update(void *ctx, const uint8_t *data, size_t len);
 TEE_Result crypto_mac_final(void *ctx, uint8_t *digest, size_t digest_len);
@@ -59,6 +148,7 @@ void crypto_mac_copy_state(void *dst_ctx, void *src_ctx);
 
 /* Authenticated encryption */
 TEE_Result crypto_authenc_alloc_ctx(void **ctx, uint32_t algo);
+TEE_Result crypto_authenc_alloc_sw_ctx(void **ctx, uint32_t algo);
 TEE_Result crypto_authenc_init(void *ctx, TEE_OperationMode mode,
 			       const uint8_t *key, size_t key_len,
 			       const uint8_t *nonce, size_t nonce_len,
@@ -81,6 +171,12 @@ TEE_Result crypto_authenc_dec_final(void *ctx, const uint8_t *src_data,
 void crypto_authenc_final(void *ctx);
 void crypto_authenc_free_ctx(void *ctx);
 void crypto_authenc_copy_state(void *dst_ctx, void *src_ctx);
+/* Like crypto_cipher_reinit() but restarts with a new nonce */
+TEE_Result crypto_authenc_reinit(void *ctx, TEE_OperationMode mode,
+				 const uint8_t *nonce, size_t nonce_len,
+				 size_t tag_len, size_t aad_len,
+				 size_t payload_len);
+bool crypto_authenc_can_reinit(void *ctx);
 
 /* Informs crypto that the data in the buffer will be removed from storage */
 TEE_Result crypto_storage_obj_del(struct tee_obj *obj);
@@ -44,6 +44,13 @@ void crypto_accel_sha1_compress(uint32_t state[5], const void *src,
 				unsigned int block_count);
 void crypto_accel_sha256_compress(uint32_t state[8], const void *src,
 				  unsigned int block_count);
+/*
+ * Compresses @block_count blocks of each of two independent messages,
+ * interleaving them where supported to hide instruction latency.
+ */
+void crypto_accel_sha256_compress_2x(uint32_t state_a[8], uint32_t state_b[8],
+				     const void *src_a, const void *src_b,
+				     unsigned int block_count);
 void crypto_accel_sha512_compress(uint64_t state[8], const void *src,
 				  unsigned int block_count);
 void crypto_accel_sha3_compress(uint64_t state[25], const void *src,
@@ -243,6 +243,10 @@ struct crypto_cipher_ops {
 	void (*free_ctx)(struct crypto_cipher_ctx *ctx);
 	void (*copy_state)(struct crypto_cipher_ctx *dst_ctx,
 			   struct crypto_cipher_ctx *src_ctx);
+	/* Optional, restarts with a new IV using the key of the last init */
+	TEE_Result (*reinit)(struct crypto_cipher_ctx *ctx,
+			     TEE_OperationMode mode,
+			     const uint8_t *iv, size_t iv_len);
 };
 
 #if defined(CFG_CRYPTO_AES) && defined(CFG_CRYPTO_ECB)
@@ -348,11 +352,30 @@ struct crypto_authenc_ops {
 	void (*free_ctx)(struct crypto_authenc_ctx *ctx);
 	void (*copy_state)(struct crypto_authenc_ctx *dst_ctx,
 			   struct crypto_authenc_ctx *src_ctx);
+	/* Optional, restarts with a new nonce using the key of the last init */
+	TEE_Result (*reinit)(struct crypto_authenc_ctx *ctx,
+			     TEE_OperationMode mode,
+			     const uint8_t *nonce, size_t nonce_len,
+			     size_t tag_len, size_t aad_len,
+			     size_t payload_len);
 };
 
 TEE_Result crypto_aes_ccm_alloc_ctx(struct crypto_authenc_ctx **ctx);
 TEE_Result crypto_aes_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx);
 
+#if defined(CFG_CRYPTO_SM4) && defined(CFG_CRYPTO_CCM)
+TEE_Result crypto_sm4_ccm_alloc_ctx(struct crypto_authenc_ctx **ctx);
+#else
+CRYPTO_ALLOC_CTX_NOT_IMPLEMENTED(sm4_ccm, authenc)
+#endif
+
+#if defined(CFG_CRYPTO_SM4) && defined(CFG_CRYPTO_GCM) && \
+	defined(CFG_CRYPTO_AES) && !defined(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB)
+TEE_Result crypto_sm4_gcm_alloc_ctx(struct crypto_authenc_ctx **ctx);
+#else
+CRYPTO_ALLOC_CTX_NOT_IMPLEMENTED(sm4_gcm, authenc)
+#endif
+
 #ifdef CFG_CRYPTO_DRV_HASH
 TEE_Result drvcrypt_hash_alloc_ctx(struct crypto_hash_ctx **ctx, uint32_t algo);
 #else
@@ -376,6 +399,84 @@ drvcrypt_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx __unused,
 }
 #endif /* CFG_CRYPTO_DRV_CIPHER */
 
+/*
+ * Return true if the job queue of the hash or cipher drvcrypt device is
+ * saturated, a software implementation is then preferred.
+ */
+#if defined(CFG_CRYPTO_DRV_QUEUE) && defined(CFG_CRYPTO_DRV_HASH)
+bool drvcrypt_hash_saturated(void);
+#else
+static inline bool drvcrypt_hash_saturated(void)
+{
+	return false;
+}
+#endif
+
+#if defined(CFG_CRYPTO_DRV_QUEUE) && defined(CFG_CRYPTO_DRV_CIPHER)
+bool drvcrypt_cipher_saturated(void);
+#else
+static inline bool drvcrypt_cipher_saturated(void)
+{
+	return false;
+}
+#endif
+
+/*
+ * Per message selection between the software implementation and the
+ * drvcrypt device of a hash or cipher algorithm. Messages of at least the
+ * threshold registered for the algorithm go to the device unless it is
+ * saturated, shorter ones are processed in software.
+ */
+#ifdef CFG_CRYPTO_SIZE_SELECT
+TEE_Result crypto_select_set_threshold(uint32_t algo, size_t threshold);
+bool crypto_select_get_threshold(uint32_t algo, size_t *threshold);
+TEE_Result crypto_select_hash_alloc_ctx(struct crypto_hash_ctx **ctx,
+					uint32_t algo);
+TEE_Result crypto_select_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx,
+					  uint32_t algo);
+
+/*
+ * For the self tests: crypto_select_*_alloc_ctx_threshold() allocate a
+ * context using @threshold instead of the registered one, and
+ * crypto_select_*_on_drv() return true if the message being processed by
+ * such a context was sent to the device.
+ */
+TEE_Result
+crypto_select_hash_alloc_ctx_threshold(struct crypto_hash_ctx **ctx,
+				       uint32_t algo, size_t threshold);
+TEE_Result
+crypto_select_cipher_alloc_ctx_threshold(struct crypto_cipher_ctx **ctx,
+					 uint32_t algo, size_t threshold);
+bool crypto_select_hash_on_drv(struct crypto_hash_ctx *ctx);
+bool crypto_select_cipher_on_drv(struct crypto_cipher_ctx *ctx);
+#else
+static inline TEE_Result
+crypto_select_set_threshold(uint32_t algo __unused, size_t threshold __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline bool crypto_select_get_threshold(uint32_t algo __unused,
+					       size_t *threshold __unused)
+{
+	return false;
+}
+
+static inline TEE_Result
+crypto_select_hash_alloc_ctx(struct crypto_hash_ctx **ctx __unused,
+			     uint32_t algo __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+
+static inline TEE_Result
+crypto_select_cipher_alloc_ctx(struct crypto_cipher_ctx **ctx __unused,
+			       uint32_t algo __unused)
+{
+	return TEE_ERROR_NOT_IMPLEMENTED;
+}
+#endif /* CFG_CRYPTO_SIZE_SELECT */
+
 #ifdef CFG_CRYPTO_DRV_MAC
 /* Cryptographic MAC driver context allocation */
 TEE_Result drvcrypt_mac_alloc_ctx(struct crypto_mac_ctx **ctx, uint32_t algo);
@@ -553,4 +654,11 @@ TEE_Result sw_crypto_acipher_rsassa_verify(uint32_t algo,
 					   int salt_len, const uint8_t *msg,
 					   size_t msg_len, const uint8_t *sig,
 					   size_t sig_len);
+
+/*
+ * Self test of CFG_CRYPTO_ECC_COMB: compares the fixed-base combs with the
+ * generic scalar multiplications for the scalars 0, 1, n - 1 and random
+ * ones. Returns TEE_ERROR_GENERIC on mismatch.
+ */
+TEE_Result crypto_ecc_comb_self_test(void);
 #endif /*__CRYPTO_CRYPTO_IMPL_H*/
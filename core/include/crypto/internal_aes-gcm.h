@@ -52,10 +52,32 @@ struct internal_aes_gcm_ctx {
 	struct internal_aes_gcm_key key;
 };
 
+/*
+ * struct internal_aes_gcm_precomp_key - key material of an AES-GCM key
+ * @enc_key:	expanded AES encryption key
+ * @ghash_key:	GHASH key (including any precomputed powers or tables)
+ *
+ * Expanding the AES key and deriving the GHASH key is done once with
+ * internal_aes_gcm_expand_key(), the result is then used for any number of
+ * GCM operations with internal_aes_gcm_enc_precomp() and
+ * internal_aes_gcm_dec_precomp().
+ */
+struct internal_aes_gcm_precomp_key {
+	struct internal_aes_gcm_key enc_key;
+	struct internal_ghash_key ghash_key;
+};
+
 TEE_Result internal_aes_gcm_init(struct internal_aes_gcm_ctx *ctx,
 				 TEE_OperationMode mode, const void *key,
 				 size_t key_len, const void *nonce,
 				 size_t nonce_len, size_t tag_len);
+/*
+ * Restarts @ctx with a new nonce, the expanded key and the GHASH key from
+ * the last internal_aes_gcm_init() are kept.
+ */
+TEE_Result internal_aes_gcm_reinit(struct internal_aes_gcm_ctx *ctx,
+				   TEE_OperationMode mode, const void *nonce,
+				   size_t nonce_len, size_t tag_len);
 TEE_Result internal_aes_gcm_update_aad(struct internal_aes_gcm_ctx *ctx,
 				       const void *data, size_t len);
 TEE_Result internal_aes_gcm_update_payload(struct internal_aes_gcm_ctx *ctx,
@@ -84,6 +106,23 @@ TEE_Result internal_aes_gcm_dec(const struct internal_aes_gcm_key *enc_key,
 				const void *src, size_t len, void *dst,
 				const void *tag, size_t tag_len);
 
+TEE_Result
+internal_aes_gcm_expand_key(struct internal_aes_gcm_precomp_key *pkey,
+			    const void *key, size_t key_len);
+
+TEE_Result
+internal_aes_gcm_enc_precomp(const struct internal_aes_gcm_precomp_key *pkey,
+			     const void *nonce, size_t nonce_len,
+			     const void *aad, size_t aad_len,
+			     const void *src, size_t len, void *dst,
+			     void *tag, size_t *tag_len);
+TEE_Result
+internal_aes_gcm_dec_precomp(const struct internal_aes_gcm_precomp_key *pkey,
+			     const void *nonce, size_t nonce_len,
+			     const void *aad, size_t aad_len,
+			     const void *src, size_t len, void *dst,
+			     const void *tag, size_t tag_len);
+
 void internal_aes_gcm_gfmul(const uint64_t X[2], const uint64_t Y[2],
 			    uint64_t product[2]);
 
@@ -106,7 +145,7 @@ static inline bool internal_aes_gcm_ptr_is_block_aligned(const void *p)
 
 #ifdef CFG_AES_GCM_TABLE_BASED
 void internal_aes_gcm_ghash_gen_tbl(struct internal_ghash_key *ghash_key,
-				    const struct internal_aes_gcm_key *enc_key);
+				    const unsigned char h[16]);
 void internal_aes_gcm_ghash_mult_tbl(struct internal_ghash_key *ghash_key,
 				     const unsigned char x[16],
 				     unsigned char output[16]);
@@ -117,6 +156,12 @@ void internal_aes_gcm_ghash_mult_tbl(struct internal_ghash_key *ghash_key,
  */
 void internal_aes_gcm_set_key(struct internal_aes_gcm_state *state,
 			      const struct internal_aes_gcm_key *enc_key);
+/*
+ * Derives @ghash_key from the hash subkey H (16 bytes), used by the GCM
+ * modes of other block ciphers which compute H themselves
+ */
+void internal_aes_gcm_set_ghash_key(struct internal_ghash_key *ghash_key,
+				    const void *hash_subkey);
 
 void internal_aes_gcm_ghash_update(struct internal_aes_gcm_state *state,
 				   const void *head, const void *data,
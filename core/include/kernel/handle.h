@@ -7,7 +7,9 @@
 #define __KERNEL_HANDLE_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include <util.h>
 
 struct handle_db {
 	void **ptrs;
@@ -49,4 +51,59 @@ void *handle_put(struct handle_db *db, int handle);
  */
 void *handle_lookup(struct handle_db *db, int handle);
 
+/*
+ * struct handle_table - table of generation tagged handles
+ * @entries:		array of entries
+ * @max_entries:	number of entries in @entries
+ * @free_idx:		index of the first free entry, free entries are
+ *			linked via their next_free field. The list is
+ *			empty when @free_idx >= @max_entries.
+ *
+ * A handle is the index of the entry plus one in the lower
+ * HANDLE_TABLE_IDX_BITS bits and the generation of the entry in the upper
+ * bits. The generation is increased each time a handle is removed so a
+ * stale handle isn't accepted when the entry is reused. A handle is never
+ * 0. All operations except growing the table are O(1).
+ */
+struct handle_table_entry {
+	void *ptr;
+	uint16_t gen;
+	uint16_t next_free;
+};
+
+struct handle_table {
+	struct handle_table_entry *entries;
+	size_t max_entries;
+	size_t free_idx;
+};
+
+#define HANDLE_TABLE_INITIALIZER { NULL, 0, 0 }
+
+#define HANDLE_TABLE_IDX_BITS	16
+#define HANDLE_TABLE_MAX_ENTRIES (BIT32(HANDLE_TABLE_IDX_BITS) - 1)
+
+/*
+ * Frees the internal data structures of the table, but not the pointers
+ * registered in it. The table is empty and safe to reuse afterwards.
+ */
+void handle_table_destroy(struct handle_table *ht);
+
+/*
+ * Allocates a new handle and assigns the supplied pointer to it, ptr must
+ * not be NULL. Returns the handle on success or 0 on failure.
+ */
+uint32_t handle_table_add(struct handle_table *ht, void *ptr);
+
+/*
+ * Deallocates a handle. Returns the associated pointer of the handle if
+ * the handle was valid or NULL if it's invalid.
+ */
+void *handle_table_remove(struct handle_table *ht, uint32_t handle);
+
+/*
+ * Returns the associated pointer of the handle if the handle is a valid
+ * handle or NULL if it's invalid.
+ */
+void *handle_table_lookup(struct handle_table *ht, uint32_t handle);
+
 #endif /*__KERNEL_HANDLE_H*/
@@ -14,6 +14,7 @@ struct mutex {
 	unsigned spin_lock;	/* used when operating on this struct */
 	struct wait_queue wq;
 	short state;		/* -1: write, 0: unlocked, > 0: readers */
+	short owner;		/* writer thread id + 1, 0 if not write locked */
 };
 
 #define MUTEX_INITIALIZER { .wq = WAIT_QUEUE_INITIALIZER }
@@ -76,6 +77,19 @@ void mutex_unlock_recursive(struct recursive_mutex *m);
 void mutex_lock_recursive(struct recursive_mutex *m);
 #endif
 
+#ifdef CFG_WITH_STATS
+struct mutex_stats {
+	uint32_t contended;	/* Lock attempts finding the mutex busy */
+	uint32_t spin_acquired;	/* Contended locks acquired by spinning */
+	uint32_t spin_timeout;	/* Spins given up after the time limit */
+	uint32_t owner_inactive; /* Spins skipped, owner not on a core */
+	uint32_t sleep;		/* Waits in normal world */
+};
+
+/* Returns contention statistics accumulated over all mutexes */
+void mutex_get_stats(struct mutex_stats *stats);
+#endif
+
 struct condvar {
 	unsigned spin_lock;
 	struct mutex *m;
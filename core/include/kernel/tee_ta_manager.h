@@ -68,6 +68,7 @@ struct sample_buf {
 struct tee_ta_ctx {
 	uint32_t flags;		/* TA_FLAGS from TA header */
 	TAILQ_ENTRY(tee_ta_ctx) link;
+	SLIST_ENTRY(tee_ta_ctx) hash_link;	/* Link in UUID hash bucket */
 	struct ts_ctx ts_ctx;
 	uint32_t panicked;	/* True if TA has panicked, written from asm */
 	uint32_t panic_code;	/* Code supplied for panic */
@@ -79,6 +80,8 @@ struct tee_ta_ctx {
 
 struct tee_ta_session {
 	TAILQ_ENTRY(tee_ta_session) link;
+	SLIST_ENTRY(tee_ta_session) hash_link;	/* Link in id hash bucket */
+	struct tee_ta_session_head *head;	/* List the session is on */
 	struct ts_session ts_sess;
 	uint32_t id;		/* Session handle (0 is invalid) */
 	TEE_Identity clnt_id;	/* Identify of client */
@@ -100,6 +103,23 @@ extern struct tee_ta_ctx_head tee_ctxes;
 extern struct mutex tee_ta_mutex;
 extern struct condvar tee_ta_init_cv;
 
+/*
+ * tee_ta_register_ctx() - Add a TA context to the registered contexts
+ * @ctx:	TA context
+ *
+ * Inserts @ctx in @tee_ctxes and in the UUID lookup table. Must be called
+ * with @tee_ta_mutex held.
+ */
+void tee_ta_register_ctx(struct tee_ta_ctx *ctx);
+
+/*
+ * tee_ta_unregister_ctx() - Remove a TA context from the registered contexts
+ * @ctx:	TA context
+ *
+ * Must be called with @tee_ta_mutex held.
+ */
+void tee_ta_unregister_ctx(struct tee_ta_ctx *ctx);
+
 TEE_Result tee_ta_open_session(TEE_ErrorOrigin *err,
 			       struct tee_ta_session **sess,
 			       struct tee_ta_session_head *open_sessions,
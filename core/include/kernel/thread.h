@@ -112,6 +112,20 @@ short int thread_get_id(void);
  */
 short int thread_get_id_may_fail(void);
 
+/*
+ * Returns true if thread @thread_id is currently executing on a core, as
+ * opposed to being free or suspended waiting for normal world. The result
+ * is only a hint since the thread may change state at any time.
+ */
+bool thread_is_active(short int thread_id);
+
+#ifdef CFG_WITH_STATS
+struct pta_stats_thread;
+
+/* Returns thread pool usage statistics */
+void thread_get_stats(struct pta_stats_thread *stats);
+#endif
+
 /* Returns Thread Specific Data (TSD) pointer. */
 struct thread_specific_data *thread_get_tsd(void);
 
@@ -375,6 +389,7 @@ enum thread_shm_type {
  * @THREAD_SHM_CACHE_USER_SOCKET - socket communication
  * @THREAD_SHM_CACHE_USER_FS - filesystem access
  * @THREAD_SHM_CACHE_USER_I2C - I2C communication
+ * @THREAD_SHM_CACHE_USER_RPMB - RPMB device requests
  *
  * To ensure that each user of the shared memory cache doesn't interfere
  * with each other a unique ID per user is used.
@@ -383,6 +398,7 @@ enum thread_shm_cache_user {
 	THREAD_SHM_CACHE_USER_SOCKET,
 	THREAD_SHM_CACHE_USER_FS,
 	THREAD_SHM_CACHE_USER_I2C,
+	THREAD_SHM_CACHE_USER_RPMB,
 };
 
 /*
@@ -87,6 +87,24 @@ void thread_check_canaries(void);
 void thread_lock_global(void);
 void thread_unlock_global(void);
 
+/*
+ * Claims a free thread for a new yielding call, preferring the thread
+ * last released on the calling core. Returns THREAD_ID_INVALID if all
+ * threads are in use. Must be called with foreign interrupts masked.
+ */
+short int thread_claim_free(void);
+
+/* Returns a thread claimed with thread_claim_free() once it's free again */
+void thread_release(short int thread_id);
+
+/*
+ * Claims all threads at once if they are all free, used to get exclusive
+ * access to the per-thread state. Returns false if any thread is in use.
+ * Must be followed by thread_release_all() on success.
+ */
+bool thread_claim_all(void);
+void thread_release_all(void);
+
 /* Frees the cache of allocated FS RPC memory */
 void thread_rpc_shm_cache_clear(struct thread_shm_cache *cache);
 #endif /*__ASSEMBLER__*/
@@ -7,6 +7,7 @@
 #define __KERNEL_USER_TA_H
 
 #include <assert.h>
+#include <kernel/handle.h>
 #include <kernel/tee_ta_manager.h>
 #include <kernel/user_mode_ctx_struct.h>
 #include <kernel/thread.h>
@@ -27,6 +28,8 @@ SLIST_HEAD(load_seg_head, load_seg);
  * @open_sessions:	List of sessions opened by this TA
  * @cryp_states:	List of cryp states created by this TA
  * @objects:		List of storage objects opened by this TA
+ * @cryp_state_handles:	Handles of the cryp states in @cryp_states
+ * @object_handles:	Handles of the objects in @objects
  * @storage_enums:	List of storage enumerators opened by this TA
  * @ta_time_offs:	Time reference used by the TA
  * @uctx:		Generic user mode context
@@ -36,6 +39,8 @@ struct user_ta_ctx {
 	struct tee_ta_session_head open_sessions;
 	struct tee_cryp_state_head cryp_states;
 	struct tee_obj_head objects;
+	struct handle_table cryp_state_handles;
+	struct handle_table object_handles;
 	struct tee_storage_enum_head storage_enums;
 	void *ta_time_offs;
 	struct user_mode_ctx uctx;
@@ -8,10 +8,23 @@
 #include <types_ext.h>
 #include <sys/queue.h>
 
-struct wait_queue_elem;
-SLIST_HEAD(wait_queue, wait_queue_elem);
+/*
+ * Each wait queue has its own spinlock. An all zero wait queue is a valid
+ * empty wait queue, the tail queue head is initialized when the first
+ * element is added and reset when the last one is removed. This keeps
+ * structures embedding an idle wait queue, like a struct mutex, zero
+ * initializable and movable.
+ */
+struct wait_queue {
+	unsigned int lock;
+	TAILQ_HEAD(, wait_queue_elem) elems;
+#ifdef CFG_WITH_STATS
+	uint32_t waits;		/* Elements added to the queue */
+	uint32_t contended;	/* Times the spinlock was found taken */
+#endif
+};
 
-#define WAIT_QUEUE_INITIALIZER { .slh_first = NULL }
+#define WAIT_QUEUE_INITIALIZER { }
 
 struct condvar;
 struct wait_queue_elem {
@@ -19,7 +32,7 @@ struct wait_queue_elem {
 	bool done;
 	bool wait_read;
 	struct condvar *cv;
-	SLIST_ENTRY(wait_queue_elem) link;
+	TAILQ_ENTRY(wait_queue_elem) link;
 };
 
 /*
@@ -60,5 +73,17 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 			int lineno);
 bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv);
 
+#ifdef CFG_WITH_STATS
+struct wait_queue_stats {
+	uint32_t waits;		/* Waits in normal world, all queues */
+	uint32_t wakeups;	/* Wakeup notifications sent */
+	uint32_t contended;	/* Queue spinlocks found taken */
+	uint32_t max_queue_waits; /* Most waits seen on a single queue */
+};
+
+/* Returns statistics accumulated over all wait queues */
+void wq_get_stats(struct wait_queue_stats *stats);
+#endif
+
 #endif /*__KERNEL_WAIT_QUEUE_H*/
 
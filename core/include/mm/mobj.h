@@ -281,6 +281,39 @@ TEE_Result mobj_reg_shm_release_by_cookie(uint64_t cookie);
  */
 void mobj_reg_shm_unguard(struct mobj *mobj);
 
+/**
+ * mobj_reg_shm_cache_get() - take a cache reference on a reg_shm
+ * @mobj:	pointer to a registered shared memory mobj
+ *
+ * A cache reference keeps the mobj structure, but not the shared memory,
+ * valid. It is used by the user mode parameter mapping cache to remember
+ * a mapping between calls. Only unguarded registered shared memory which
+ * isn't being released can be cached.
+ *
+ * Returns TEE_SUCCESS on success, TEE_ERROR_NOT_SUPPORTED if @mobj isn't
+ * a reg_shm or TEE_ERROR_BAD_STATE if it can't be cached.
+ */
+TEE_Result mobj_reg_shm_cache_get(struct mobj *mobj);
+
+/**
+ * mobj_reg_shm_cache_use() - take a normal reference via a cache reference
+ * @mobj:	pointer to a registered shared memory mobj
+ *
+ * Increases the reference counter of a mobj for which a cache reference
+ * is held, unless the shared memory has been released by cookie in
+ * between.
+ *
+ * Returns TEE_SUCCESS on success or TEE_ERROR_BAD_STATE if the shared
+ * memory is released or being released.
+ */
+TEE_Result mobj_reg_shm_cache_use(struct mobj *mobj);
+
+/**
+ * mobj_reg_shm_cache_put() - drop a cache reference on a reg_shm
+ * @mobj:	pointer to a registered shared memory mobj
+ */
+void mobj_reg_shm_cache_put(struct mobj *mobj);
+
 /*
  * mapped_shm represents registered shared buffer
  * which is mapped into OPTEE va space
@@ -304,6 +337,22 @@ static inline struct mobj *mobj_reg_shm_get_by_cookie(uint64_t cookie __unused)
 }
 #endif
 
+#if defined(CFG_CORE_FFA) || !defined(CFG_CORE_DYN_SHM)
+static inline TEE_Result mobj_reg_shm_cache_get(struct mobj *mobj __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline TEE_Result mobj_reg_shm_cache_use(struct mobj *mobj __unused)
+{
+	return TEE_ERROR_NOT_SUPPORTED;
+}
+
+static inline void mobj_reg_shm_cache_put(struct mobj *mobj __unused)
+{
+}
+#endif
+
 struct mobj *mobj_shm_alloc(paddr_t pa, size_t size, uint64_t cookie);
 
 #ifdef CFG_PAGED_USER_TA
@@ -17,22 +17,36 @@
 /* Flag to indicate that pool should use nex_malloc instead of malloc */
 #define TEE_MM_POOL_NEX_MALLOC             (1u << 1)
 
+/*
+ * Allocated entries are kept in an AVL tree ordered by offset. Each node
+ * also records the size of the free gap between the end of the preceding
+ * entry (or the start of the pool) and its own offset, and the largest
+ * such gap in its subtree. This lets tee_mm_alloc() find the lowest (or
+ * with TEE_MM_POOL_HI_ALLOC the highest) free slot that fits, and
+ * tee_mm_find() the entry covering an address, in O(log n).
+ */
 struct _tee_mm_entry_t {
 	struct _tee_mm_pool_t *pool;
-	struct _tee_mm_entry_t *next;
+	struct _tee_mm_entry_t *left;
+	struct _tee_mm_entry_t *right;
 	uint32_t offset;	/* offset in pages/sections */
 	uint32_t size;		/* size in pages/sections */
+	uint32_t gap;		/* free pages/sections before this entry */
+	uint32_t max_gap;	/* largest gap in this subtree */
+	uint8_t height;
 };
 typedef struct _tee_mm_entry_t tee_mm_entry_t;
 
 struct _tee_mm_pool_t {
-	tee_mm_entry_t *entry;
+	tee_mm_entry_t *root;
 	paddr_t lo;		/* low boundary of the pool */
 	paddr_size_t size;	/* pool size */
 	uint32_t flags;		/* Config flags for the pool */
 	uint8_t shift;		/* size shift */
+	bool initialized;
 	unsigned int lock;
 #ifdef CFG_WITH_STATS
+	size_t allocated;	/* in pages/sections */
 	size_t max_allocated;
 #endif
 };
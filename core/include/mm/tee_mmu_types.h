@@ -71,6 +71,12 @@
  * functions.
  */
 #define VM_FLAG_READONLY		BIT(4)
+/*
+ * Tags VM_FLAG_EPHEMERAL regions of registered shared memory kept
+ * between calls by the parameter mapping cache. Such a region is unmapped
+ * before the TA runs again, unless that call passes the buffer again.
+ */
+#define VM_FLAG_PARAM_CACHED		BIT(5)
 
 /*
  * Set of flags used by tee_mmu_is_vbuf_inside_ta_private() and
@@ -121,9 +127,29 @@ struct vm_paged_region {
 TAILQ_HEAD(vm_paged_region_head, vm_paged_region);
 TAILQ_HEAD(vm_region_head, vm_region);
 
+/*
+ * struct vm_info - user mode address space
+ * @regions:		regions sorted on va
+ * @region_index:	array of the same regions sorted on va, used for
+ *			binary search lookups by address
+ * @region_count:	number of regions in @region_index
+ * @region_index_size:	number of allocated entries in @region_index
+ * @asid:		address space identifier
+ * @param_cache:	cached parameter mappings, most recently used first
+ * @param_cache_owner:	id of the session owning @param_cache
+ * @param_cache_active:	true while the cached mobjs are referenced
+ */
 struct vm_info {
 	struct vm_region_head regions;
+	struct vm_region **region_index;
+	size_t region_count;
+	size_t region_index_size;
 	unsigned int asid;
+#if CFG_TA_PARAM_MAP_CACHE_ENTRIES
+	struct vm_region *param_cache[CFG_TA_PARAM_MAP_CACHE_ENTRIES];
+	uint32_t param_cache_owner;
+	bool param_cache_active;
+#endif
 };
 
 static inline void mattr_perm_to_str(char *str, size_t size, uint32_t attr)
@@ -62,6 +62,40 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 			void *param_va[TEE_NUM_PARAMS]);
 void vm_clean_param(struct user_mode_ctx *uctx);
 
+/*
+ * With CFG_TA_PARAM_MAP_CACHE_ENTRIES > 0 vm_clean_param() may keep
+ * parameter regions of registered shared memory for reuse by the next
+ * call from the same session. vm_param_cache_begin() must be called
+ * before vm_map_param(), vm_param_cache_revoke() after it and before
+ * entering the user TA, and vm_param_cache_end() once the TA has
+ * returned. vm_param_cache_revoke() unmaps the cached regions not passed
+ * to vm_map_param(), keeping only their address range.
+ * vm_param_cache_flush() removes all cached regions.
+ */
+#if CFG_TA_PARAM_MAP_CACHE_ENTRIES
+void vm_param_cache_begin(struct user_mode_ctx *uctx, uint32_t sess_id);
+void vm_param_cache_revoke(struct user_mode_ctx *uctx);
+void vm_param_cache_end(struct user_mode_ctx *uctx);
+void vm_param_cache_flush(struct user_mode_ctx *uctx);
+#else
+static inline void vm_param_cache_begin(struct user_mode_ctx *uctx __unused,
+					uint32_t sess_id __unused)
+{
+}
+
+static inline void vm_param_cache_revoke(struct user_mode_ctx *uctx __unused)
+{
+}
+
+static inline void vm_param_cache_end(struct user_mode_ctx *uctx __unused)
+{
+}
+
+static inline void vm_param_cache_flush(struct user_mode_ctx *uctx __unused)
+{
+}
+#endif
+
 /*
  * User mode private memory is defined as user mode image static segment
  * (code, ro/rw static data, heap, stack). The sole other virtual memory
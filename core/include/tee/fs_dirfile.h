@@ -32,6 +32,9 @@ struct tee_fs_dirfile_fileh {
  * @read:		reads from an open file
  * @write:		writes to an open file
  * @commit_writes:	commits changes since the file was opened
+ * @get_hash:		returns hash and version counter of an open file
+ *			without uncommitted changes, optional. Lets a
+ *			reopened dirfile reuse the index built last time.
  */
 struct tee_fs_dirfile_operations {
 	TEE_Result (*open)(bool create, uint8_t *hash, uint32_t min_counter,
@@ -45,6 +48,8 @@ struct tee_fs_dirfile_operations {
 			    const void *buf, size_t len);
 	TEE_Result (*commit_writes)(struct tee_file_handle *fh, uint8_t *hash,
 				    uint32_t *counter);
+	TEE_Result (*get_hash)(struct tee_file_handle *fh, uint8_t *hash,
+			       uint32_t *counter);
 };
 
 /**
@@ -133,6 +133,18 @@ struct tee_fs_htree_meta *tee_fs_htree_get_meta(struct tee_fs_htree *ht);
  */
 void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht);
 
+/**
+ * tee_fs_htree_get_hash() - get hash of root node and version counter
+ * @ht:		hash tree
+ * @hash:	hash of root node is copied here
+ * @counter:	version counter is copied here
+ *
+ * Returns TEE_ERROR_BAD_STATE if the hash tree has changes not yet
+ * synchronized to storage.
+ */
+TEE_Result tee_fs_htree_get_hash(struct tee_fs_htree *ht, uint8_t *hash,
+				 uint32_t *counter);
+
 /**
  * tee_fs_htree_sync_to_storage() - synchronize hash tree to storage
  * @ht:		hash tree
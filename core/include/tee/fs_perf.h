@@ -0,0 +1,77 @@
+/* SPDX-License-Identifier: BSD-2-Clause */
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#ifndef __TEE_FS_PERF_H
+#define __TEE_FS_PERF_H
+
+#include <compiler.h>
+#include <stdint.h>
+
+/*
+ * Secure storage phase timing
+ *
+ * A caller (typically a benchmark) attaches a struct tee_fs_perf_stats to
+ * the current thread. While attached, the secure storage implementation
+ * accumulates the counter timer ticks spent in each phase below for
+ * everything done by that thread. Phases nest: dirfile commit includes
+ * hash tree updates which in turn include crypto and RPC wait.
+ *
+ * @TEE_FS_PERF_RPC:		waiting for normal world (tee-supplicant)
+ * @TEE_FS_PERF_CRYPTO:		authenticated encryption and hashing
+ * @TEE_FS_PERF_HTREE:		hash tree update (sync to storage)
+ * @TEE_FS_PERF_DIRFILE:	directory file commit
+ */
+enum tee_fs_perf_phase {
+	TEE_FS_PERF_RPC,
+	TEE_FS_PERF_CRYPTO,
+	TEE_FS_PERF_HTREE,
+	TEE_FS_PERF_DIRFILE,
+	TEE_FS_PERF_PHASE_COUNT,
+};
+
+struct tee_fs_perf_stats {
+	uint64_t ticks[TEE_FS_PERF_PHASE_COUNT];
+	uint32_t count[TEE_FS_PERF_PHASE_COUNT];
+};
+
+/*
+ * Returned by tee_fs_perf_begin() when no statistics are attached, a
+ * counter value the 64-bit counter timer never reaches in practice
+ */
+#define TEE_FS_PERF_DISABLED	UINT64_MAX
+
+#ifdef CFG_TEE_FS_PERF_STATS
+void tee_fs_perf_attach(struct tee_fs_perf_stats *stats);
+void tee_fs_perf_detach(void);
+
+/*
+ * Returns the counter timer value at the start of a phase, or
+ * TEE_FS_PERF_DISABLED if no statistics are attached to the current
+ * thread. Pass the returned value to tee_fs_perf_end().
+ */
+uint64_t tee_fs_perf_begin(void);
+void tee_fs_perf_end(enum tee_fs_perf_phase phase, uint64_t begin);
+#else
+static inline void
+tee_fs_perf_attach(struct tee_fs_perf_stats *stats __unused)
+{
+}
+
+static inline void tee_fs_perf_detach(void)
+{
+}
+
+static inline uint64_t tee_fs_perf_begin(void)
+{
+	return TEE_FS_PERF_DISABLED;
+}
+
+static inline void tee_fs_perf_end(enum tee_fs_perf_phase phase __unused,
+				   uint64_t begin __unused)
+{
+}
+#endif
+
+#endif /*__TEE_FS_PERF_H*/
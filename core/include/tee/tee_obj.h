@@ -15,6 +15,7 @@
 
 struct tee_obj {
 	TAILQ_ENTRY(tee_obj) link;
+	uint32_t handle;	/* handle used by the TA, 0 if not added */
 	TEE_ObjectInfo info;
 	bool busy;		/* true if used by an operation */
 	uint32_t have_attrs;	/* bitfield identifying set properties */
@@ -22,11 +23,22 @@ struct tee_obj {
 	size_t ds_pos;
 	struct tee_pobj *pobj;	/* ptr to persistant object */
 	struct tee_file_handle *fh;
+	/*
+	 * Crypto context keyed with this object by the last cipher or AE
+	 * init using it, see CFG_TEE_OBJ_KEY_CACHE
+	 */
+	void *key_ctx;
+	uint32_t key_ctx_algo;
 };
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
+/*
+ * Adds @o to the objects of @utc and assigns it a handle in o->handle. On
+ * failure @o is still added, but without a handle, and is to be closed
+ * with tee_obj_close().
+ */
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o);
 
-TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
+TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj);
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o);
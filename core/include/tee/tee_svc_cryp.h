@@ -72,6 +72,7 @@ TEE_Result syscall_authenc_enc_final(unsigned long state,
 TEE_Result syscall_authenc_dec_final(unsigned long state,
 			const void *src_data, size_t src_len, void *dest_data,
 			uint64_t *dest_len, const void *tag, size_t tag_len);
+TEE_Result syscall_cryp_batch(struct utee_cryp_batch_op *ops, size_t count);
 
 TEE_Result syscall_asymm_operate(unsigned long state,
 			const struct utee_attribute *usr_params,
@@ -45,6 +45,11 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 				     struct utee_object_info *info,
 				     void *obj_id, uint64_t *len);
 
+TEE_Result syscall_storage_next_enum_ids(unsigned long obj_enum,
+					 const void *prefix, size_t prefix_len,
+					 void *buf, uint64_t *len,
+					 uint32_t *count);
+
 /*
  * Data Stream Access Functions
  */
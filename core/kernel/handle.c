@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <kernel/handle.h>
+#include <util.h>
 
 /*
  * Define the initial capacity of the database. It should be a low number
@@ -98,3 +99,113 @@ void *handle_lookup(struct handle_db *db, int handle)
 
 	return db->ptrs[handle];
 }
+
+void handle_table_destroy(struct handle_table *ht)
+{
+	if (ht) {
+		free(ht->entries);
+		ht->entries = NULL;
+		ht->max_entries = 0;
+		ht->free_idx = 0;
+	}
+}
+
+static bool handle_table_grow(struct handle_table *ht)
+{
+	struct handle_table_entry *e = NULL;
+	size_t new_max = 0;
+	size_t n = 0;
+
+	if (ht->max_entries >= HANDLE_TABLE_MAX_ENTRIES)
+		return false;
+
+	if (ht->max_entries)
+		new_max = MIN(ht->max_entries * 2,
+			      (size_t)HANDLE_TABLE_MAX_ENTRIES);
+	else
+		new_max = HANDLE_DB_INITIAL_MAX_PTRS;
+
+	e = realloc(ht->entries, new_max * sizeof(*e));
+	if (!e)
+		return false;
+
+	/*
+	 * The free list is empty when growing, link all the new entries.
+	 * The last entry points at new_max which terminates the list.
+	 */
+	for (n = ht->max_entries; n < new_max; n++) {
+		e[n].ptr = NULL;
+		e[n].gen = 1;
+		e[n].next_free = n + 1;
+	}
+	ht->free_idx = ht->max_entries;
+	ht->entries = e;
+	ht->max_entries = new_max;
+
+	return true;
+}
+
+uint32_t handle_table_add(struct handle_table *ht, void *ptr)
+{
+	struct handle_table_entry *e = NULL;
+	size_t idx = 0;
+
+	if (!ht || !ptr)
+		return 0;
+
+	if (ht->free_idx >= ht->max_entries && !handle_table_grow(ht))
+		return 0;
+
+	idx = ht->free_idx;
+	e = ht->entries + idx;
+	ht->free_idx = e->next_free;
+	e->ptr = ptr;
+
+	return SHIFT_U32(e->gen, HANDLE_TABLE_IDX_BITS) | (idx + 1);
+}
+
+static struct handle_table_entry *handle_table_find(struct handle_table *ht,
+						    uint32_t handle)
+{
+	size_t idx = (handle & (BIT32(HANDLE_TABLE_IDX_BITS) - 1)) - 1;
+	struct handle_table_entry *e = NULL;
+
+	/* idx wraps around to UINT32_MAX if the index part is 0 */
+	if (!ht || idx >= ht->max_entries)
+		return NULL;
+
+	e = ht->entries + idx;
+	if (!e->ptr || e->gen != handle >> HANDLE_TABLE_IDX_BITS)
+		return NULL;
+
+	return e;
+}
+
+void *handle_table_remove(struct handle_table *ht, uint32_t handle)
+{
+	struct handle_table_entry *e = handle_table_find(ht, handle);
+	void *p = NULL;
+
+	if (!e)
+		return NULL;
+
+	p = e->ptr;
+	e->ptr = NULL;
+	e->gen++;
+	if (!e->gen)
+		e->gen = 1;
+	e->next_free = ht->free_idx;
+	ht->free_idx = e - ht->entries;
+
+	return p;
+}
+
+void *handle_table_lookup(struct handle_table *ht, uint32_t handle)
+{
+	struct handle_table_entry *e = handle_table_find(ht, handle);
+
+	if (!e)
+		return NULL;
+
+	return e->ptr;
+}
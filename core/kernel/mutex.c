@@ -3,12 +3,15 @@
  * Copyright (c) 2015-2017, Linaro Limited
  */
 
+#include <atomic.h>
+#include <kernel/delay.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/refcount.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
 #include <trace.h>
+#include <util.h>
 
 #include "mutex_lockdep.h"
 
@@ -22,8 +25,96 @@ void mutex_init_recursive(struct recursive_mutex *m)
 	*m = (struct recursive_mutex)RECURSIVE_MUTEX_INITIALIZER;
 }
 
+#ifdef CFG_WITH_STATS
+static struct mutex_stats mutex_counters;
+
+#define MUTEX_STAT_INC(name)	atomic_inc32(&mutex_counters.name)
+
+void mutex_get_stats(struct mutex_stats *stats)
+{
+	stats->contended = atomic_load_u32(&mutex_counters.contended);
+	stats->spin_acquired = atomic_load_u32(&mutex_counters.spin_acquired);
+	stats->spin_timeout = atomic_load_u32(&mutex_counters.spin_timeout);
+	stats->owner_inactive = atomic_load_u32(&mutex_counters.owner_inactive);
+	stats->sleep = atomic_load_u32(&mutex_counters.sleep);
+}
+#else
+#define MUTEX_STAT_INC(name)	do { } while (0)
+#endif
+
+/* Called with m->spin_lock held */
+static void mutex_set_owner(struct mutex *m, short int owner)
+{
+	atomic_store_short(&m->owner, owner + 1);
+}
+
+#if CFG_CORE_MUTEX_SPIN_US
+/* Upper bound of the backoff between two polls, in loop iterations */
+#define MUTEX_SPIN_MAX_DELAY	256
+
+/*
+ * Waiting in normal world costs two world switches, one to sleep and one
+ * to be woken up. If the mutex is write locked by a thread currently
+ * executing on another core it's likely to be released soon, so poll it
+ * with an exponential backoff instead. The total time spent spinning in
+ * one lock attempt is bounded by CFG_CORE_MUTEX_SPIN_US through @timeout.
+ *
+ * Returns true if the mutex looks available and locking should be retried,
+ * or false if the caller should wait in normal world.
+ */
+static bool mutex_spin(struct mutex *m, bool read, uint64_t *timeout)
+{
+	unsigned int delay = 1;
+	unsigned int n = 0;
+	short int state = 0;
+	short int owner = 0;
+
+	if (!*timeout)
+		*timeout = timeout_init_us(CFG_CORE_MUTEX_SPIN_US);
+
+	while (true) {
+		state = atomic_load_short(&m->state);
+		if (!state || (read && state > 0))
+			return true;
+
+		/* Readers aren't tracked, only spin behind a running writer */
+		if (state > 0)
+			return false;
+
+		/*
+		 * The owner is published right after the state under
+		 * m->spin_lock, keep polling if it isn't visible yet.
+		 */
+		owner = atomic_load_short(&m->owner);
+		if (owner && !thread_is_active(owner - 1)) {
+			MUTEX_STAT_INC(owner_inactive);
+			return false;
+		}
+
+		if (timeout_elapsed(*timeout)) {
+			MUTEX_STAT_INC(spin_timeout);
+			return false;
+		}
+
+		for (n = 0; n < delay; n++)
+			barrier();
+		delay = MIN(delay * 2, MUTEX_SPIN_MAX_DELAY);
+	}
+}
+#else
+static bool mutex_spin(struct mutex *m __unused, bool read __unused,
+		       uint64_t *timeout __unused)
+{
+	return false;
+}
+#endif
+
 static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool spin = CFG_CORE_MUTEX_SPIN_US > 0;
+	bool contended = false;
+	uint64_t timeout = 0;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -48,21 +139,37 @@ static void __mutex_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = !m->state;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, false /* wait_read */);
+			if (!spin)
+				wq_wait_init(&m->wq, &wqe,
+					     false /* wait_read */);
 		} else {
 			m->state = -1; /* write locked */
+			mutex_set_owner(m, thread_get_id());
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
+		if (can_lock) {
+			if (contended && spin)
+				MUTEX_STAT_INC(spin_acquired);
+			return;
+		}
+
+		if (!contended) {
+			MUTEX_STAT_INC(contended);
+			contended = true;
+		}
+
+		if (spin) {
+			spin = mutex_spin(m, false /* read */, &timeout);
+		} else {
 			/*
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			MUTEX_STAT_INC(sleep);
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
-			return;
+		}
 	}
 }
 
@@ -102,6 +209,7 @@ static void __mutex_unlock(struct mutex *m, const char *fname, int lineno)
 		panic();
 
 	m->state = 0;
+	mutex_set_owner(m, THREAD_ID_INVALID);
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
@@ -136,8 +244,10 @@ static bool __mutex_trylock(struct mutex *m, const char *fname __unused,
 	old_itr_status = cpu_spin_lock_xsave(&m->spin_lock);
 
 	can_lock_write = !m->state;
-	if (can_lock_write)
+	if (can_lock_write) {
 		m->state = -1;
+		mutex_set_owner(m, thread_get_id());
+	}
 
 	cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
@@ -171,6 +281,10 @@ static void __mutex_read_unlock(struct mutex *m, const char *fname, int lineno)
 
 static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 {
+	bool spin = CFG_CORE_MUTEX_SPIN_US > 0;
+	bool contended = false;
+	uint64_t timeout = 0;
+
 	assert_have_no_spinlock();
 	assert(thread_get_id_may_fail() != THREAD_ID_INVALID);
 	assert(thread_is_in_normal_mode());
@@ -193,21 +307,36 @@ static void __mutex_read_lock(struct mutex *m, const char *fname, int lineno)
 
 		can_lock = m->state != -1;
 		if (!can_lock) {
-			wq_wait_init(&m->wq, &wqe, true /* wait_read */);
+			if (!spin)
+				wq_wait_init(&m->wq, &wqe,
+					     true /* wait_read */);
 		} else {
 			m->state++; /* read_locked */
 		}
 
 		cpu_spin_unlock_xrestore(&m->spin_lock, old_itr_status);
 
-		if (!can_lock) {
+		if (can_lock) {
+			if (contended && spin)
+				MUTEX_STAT_INC(spin_acquired);
+			return;
+		}
+
+		if (!contended) {
+			MUTEX_STAT_INC(contended);
+			contended = true;
+		}
+
+		if (spin) {
+			spin = mutex_spin(m, true /* read */, &timeout);
+		} else {
 			/*
 			 * Someone else is holding the lock, wait in normal
 			 * world for the lock to become available.
 			 */
+			MUTEX_STAT_INC(sleep);
 			wq_wait_final(&m->wq, &wqe, m, fname, lineno);
-		} else
-			return;
+		}
 	}
 }
 
@@ -425,6 +554,7 @@ static void __condvar_wait(struct condvar *cv, struct mutex *m,
 	} else {
 		/* Only one lock (read or write), unlock the mutex */
 		m->state = 0;
+		mutex_set_owner(m, THREAD_ID_INVALID);
 	}
 	new_state = m->state;
 
@@ -5,6 +5,7 @@
  */
 
 #include <assert.h>
+#include <atomic.h>
 #include <kernel/mutex.h>
 #include <kernel/panic.h>
 #include <kernel/pseudo_ta.h>
@@ -54,6 +55,22 @@ struct mutex tee_ta_mutex = MUTEX_INITIALIZER;
 struct condvar tee_ta_init_cv = CONDVAR_INITIALIZER;
 struct tee_ta_ctx_head tee_ctxes = TAILQ_HEAD_INITIALIZER(tee_ctxes);
 
+/*
+ * Lookup tables for sessions (keyed on session id) and TA contexts (keyed
+ * on UUID). Both are only modified with tee_ta_mutex held for writing so
+ * lookups may be done with the mutex held for reading.
+ */
+#define SESS_HASH_SIZE		64
+#define CTX_HASH_SIZE		32
+
+SLIST_HEAD(tee_ta_sess_bucket, tee_ta_session);
+SLIST_HEAD(tee_ta_ctx_bucket, tee_ta_ctx);
+
+static struct tee_ta_sess_bucket sess_hash[SESS_HASH_SIZE];
+static struct tee_ta_ctx_bucket ctx_hash[CTX_HASH_SIZE];
+/* Next session id to hand out, ids are shared by all session lists */
+static uint32_t next_session_id = 1;
+
 #ifndef CFG_CONCURRENT_SINGLE_INSTANCE_TA
 static struct condvar tee_ta_cv = CONDVAR_INITIALIZER;
 static short int tee_ta_single_instance_thread = THREAD_ID_INVALID;
@@ -188,41 +205,92 @@ static void tee_ta_clear_busy(struct tee_ta_ctx *ctx)
 	mutex_unlock(&tee_ta_mutex);
 }
 
+static struct tee_ta_sess_bucket *sess_bucket(uint32_t id)
+{
+	return sess_hash + id % SESS_HASH_SIZE;
+}
+
+static struct tee_ta_ctx_bucket *ctx_bucket(const TEE_UUID *uuid)
+{
+	uint32_t h = uuid->timeLow ^ uuid->timeMid ^
+		     ((uint32_t)uuid->timeHiAndVersion << 16);
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(uuid->clockSeqAndNode); n++)
+		h = h * 31 + uuid->clockSeqAndNode[n];
+
+	return ctx_hash + h % CTX_HASH_SIZE;
+}
+
+void tee_ta_register_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_INSERT_TAIL(&tee_ctxes, ctx, link);
+	SLIST_INSERT_HEAD(ctx_bucket(&ctx->ts_ctx.uuid), ctx, hash_link);
+}
+
+void tee_ta_unregister_ctx(struct tee_ta_ctx *ctx)
+{
+	TAILQ_REMOVE(&tee_ctxes, ctx, link);
+	SLIST_REMOVE(ctx_bucket(&ctx->ts_ctx.uuid), ctx, tee_ta_ctx,
+		     hash_link);
+}
+
+static void link_session(struct tee_ta_session *s,
+			 struct tee_ta_session_head *open_sessions)
+{
+	s->head = open_sessions;
+	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	SLIST_INSERT_HEAD(sess_bucket(s->id), s, hash_link);
+}
+
+static void unlink_session(struct tee_ta_session *s)
+{
+	TAILQ_REMOVE(s->head, s, link);
+	SLIST_REMOVE(sess_bucket(s->id), s, tee_ta_session, hash_link);
+	s->head = NULL;
+}
+
 static void dec_session_ref_count(struct tee_ta_session *s)
 {
 	assert(s->ref_count > 0);
-	s->ref_count--;
-	if (s->ref_count == 1)
+	if (atomic_dec32(&s->ref_count) == 1)
 		condvar_signal(&s->refc_cv);
 }
 
 void tee_ta_put_session(struct tee_ta_session *s)
 {
-	mutex_lock(&tee_ta_mutex);
+	/*
+	 * Neither the lock nor the reference is protected by the mutex,
+	 * holding it for reading only keeps the condvars from being waited
+	 * on while we update the state.
+	 */
+	mutex_read_lock(&tee_ta_mutex);
 
-	if (s->lock_thread == thread_get_id()) {
-		s->lock_thread = THREAD_ID_INVALID;
+	if (atomic_load_short(&s->lock_thread) == thread_get_id()) {
+		atomic_store_release_short(&s->lock_thread,
+					   THREAD_ID_INVALID);
 		condvar_signal(&s->lock_cv);
 	}
 	dec_session_ref_count(s);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_read_unlock(&tee_ta_mutex);
 }
 
+/*
+ * Sessions are looked up in the global table, @open_sessions is still
+ * matched so that an id cannot be used to reach a session opened by
+ * another client.
+ */
 static struct tee_ta_session *tee_ta_find_session_nolock(uint32_t id,
 			struct tee_ta_session_head *open_sessions)
 {
 	struct tee_ta_session *s = NULL;
-	struct tee_ta_session *found = NULL;
 
-	TAILQ_FOREACH(s, open_sessions, link) {
-		if (s->id == id) {
-			found = s;
-			break;
-		}
-	}
+	SLIST_FOREACH(s, sess_bucket(id), hash_link)
+		if (s->id == id)
+			return s->head == open_sessions ? s : NULL;
 
-	return found;
+	return NULL;
 }
 
 struct tee_ta_session *tee_ta_find_session(uint32_t id,
@@ -230,20 +298,56 @@ struct tee_ta_session *tee_ta_find_session(uint32_t id,
 {
 	struct tee_ta_session *s = NULL;
 
-	mutex_lock(&tee_ta_mutex);
+	mutex_read_lock(&tee_ta_mutex);
 
 	s = tee_ta_find_session_nolock(id, open_sessions);
 
-	mutex_unlock(&tee_ta_mutex);
+	mutex_read_unlock(&tee_ta_mutex);
 
 	return s;
 }
 
+/*
+ * Takes a reference, and the session lock if @exclusive, without
+ * waiting. Called with tee_ta_mutex held for reading.
+ */
+static struct tee_ta_session *try_get_session(uint32_t id, bool exclusive,
+			struct tee_ta_session_head *open_sessions,
+			bool *contended)
+{
+	short int unlocked = THREAD_ID_INVALID;
+	struct tee_ta_session *s = NULL;
+
+	s = tee_ta_find_session_nolock(id, open_sessions);
+	if (!s || s->unlink)
+		return NULL;
+
+	atomic_inc32(&s->ref_count);
+	if (!exclusive)
+		return s;
+
+	assert(atomic_load_short(&s->lock_thread) != thread_get_id());
+	if (atomic_cas_short(&s->lock_thread, &unlocked, thread_get_id()))
+		return s;
+
+	dec_session_ref_count(s);
+	*contended = true;
+	return NULL;
+}
+
 struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 			struct tee_ta_session_head *open_sessions)
 {
-	struct tee_ta_session *s;
+	struct tee_ta_session *s = NULL;
+	bool contended = false;
 
+	mutex_read_lock(&tee_ta_mutex);
+	s = try_get_session(id, exclusive, open_sessions, &contended);
+	mutex_read_unlock(&tee_ta_mutex);
+	if (s || !contended)
+		return s;
+
+	/* Session is locked by another thread, wait for it to be released */
 	mutex_lock(&tee_ta_mutex);
 
 	while (true) {
@@ -254,9 +358,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 			s = NULL;
 			break;
 		}
-		s->ref_count++;
-		if (!exclusive)
-			break;
+		atomic_inc32(&s->ref_count);
 
 		assert(s->lock_thread != thread_get_id());
 
@@ -269,7 +371,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 			break;
 		}
 
-		s->lock_thread = thread_get_id();
+		atomic_store_short(&s->lock_thread, thread_get_id());
 		break;
 	}
 
@@ -278,7 +380,7 @@ struct tee_ta_session *tee_ta_get_session(uint32_t id, bool exclusive,
 }
 
 static void tee_ta_unlink_session(struct tee_ta_session *s,
-			struct tee_ta_session_head *open_sessions)
+			struct tee_ta_session_head *open_sessions __maybe_unused)
 {
 	mutex_lock(&tee_ta_mutex);
 
@@ -292,7 +394,8 @@ static void tee_ta_unlink_session(struct tee_ta_session *s,
 	while (s->ref_count != 1)
 		condvar_wait(&s->refc_cv, &tee_ta_mutex);
 
-	TAILQ_REMOVE(open_sessions, s, link);
+	assert(s->head == open_sessions);
+	unlink_session(s);
 
 	mutex_unlock(&tee_ta_mutex);
 }
@@ -330,9 +433,9 @@ static void destroy_context(struct tee_ta_ctx *ctx)
  */
 static struct tee_ta_ctx *tee_ta_context_find(const TEE_UUID *uuid)
 {
-	struct tee_ta_ctx *ctx;
+	struct tee_ta_ctx *ctx = NULL;
 
-	TAILQ_FOREACH(ctx, &tee_ctxes, link) {
+	SLIST_FOREACH(ctx, ctx_bucket(uuid), hash_link) {
 		if (memcmp(&ctx->ts_ctx.uuid, uuid, sizeof(TEE_UUID)) == 0)
 			return ctx;
 	}
@@ -508,7 +611,7 @@ TEE_Result tee_ta_close_session(struct tee_ta_session *csess,
 			(ctx->flags & TA_FLAG_SINGLE_INSTANCE);
 	if (!ctx->ref_count && (ctx->panicked || !keep_alive)) {
 		if (!ctx->is_releasing) {
-			TAILQ_REMOVE(&tee_ctxes, ctx, link);
+			tee_ta_unregister_ctx(ctx);
 			ctx->is_releasing = true;
 		}
 		mutex_unlock(&tee_ta_mutex);
@@ -566,30 +669,31 @@ static TEE_Result tee_ta_init_session_with_context(struct tee_ta_session *s,
 	return TEE_SUCCESS;
 }
 
-static uint32_t new_session_id(struct tee_ta_session_head *open_sessions)
+static bool session_id_in_use(uint32_t id)
 {
-	struct tee_ta_session *last = NULL;
-	uint32_t saved = 0;
-	uint32_t id = 1;
-
-	last = TAILQ_LAST(open_sessions, tee_ta_session_head);
-	if (last) {
-		/* This value is less likely to be already used */
-		id = last->id + 1;
-		if (!id)
-			id++; /* 0 is not valid */
-	}
+	struct tee_ta_session *s = NULL;
+
+	SLIST_FOREACH(s, sess_bucket(id), hash_link)
+		if (s->id == id)
+			return true;
+
+	return false;
+}
+
+/*
+ * Session ids are allocated from a single increasing counter so an id is
+ * not reused until the counter wraps. After a wrap ids still in use are
+ * skipped, there can't be more sessions than ids so this terminates.
+ */
+static uint32_t new_session_id(void)
+{
+	uint32_t id = 0;
 
-	saved = id;
 	do {
-		if (!tee_ta_find_session_nolock(id, open_sessions))
-			return id;
-		id++;
-		if (!id)
-			id++;
-	} while (id != saved);
-
-	return 0;
+		id = next_session_id++;
+	} while (!id || session_id_in_use(id));
+
+	return id;
 }
 
 static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
@@ -611,13 +715,8 @@ static TEE_Result tee_ta_init_session(TEE_ErrorOrigin *err,
 	s->ref_count = 1;
 
 	mutex_lock(&tee_ta_mutex);
-	s->id = new_session_id(open_sessions);
-	if (!s->id) {
-		res = TEE_ERROR_OVERFLOW;
-		goto err_mutex_unlock;
-	}
-
-	TAILQ_INSERT_TAIL(open_sessions, s, link);
+	s->id = new_session_id();
+	link_session(s, open_sessions);
 
 	/* Look for already loaded TA */
 	res = tee_ta_init_session_with_context(s, uuid);
@@ -645,8 +744,7 @@ out:
 	}
 
 	mutex_lock(&tee_ta_mutex);
-	TAILQ_REMOVE(open_sessions, s, link);
-err_mutex_unlock:
+	unlink_session(s);
 	mutex_unlock(&tee_ta_mutex);
 	free(s);
 	return res;
@@ -661,7 +759,7 @@ static void release_ta_ctx(struct tee_ta_ctx *ctx)
 	ctx->is_releasing = true;
 	if (!was_releasing) {
 		DMSG("Releasing panicked TA ctx");
-		TAILQ_REMOVE(&tee_ctxes, ctx, link);
+		tee_ta_unregister_ctx(ctx);
 	}
 	mutex_unlock(&tee_ta_mutex);
 
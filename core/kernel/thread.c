@@ -5,8 +5,10 @@
  * Copyright (c) 2020-2021, Arm Limited
  */
 
+#include <atomic.h>
 #include <config.h>
 #include <crypto/crypto.h>
+#include <io.h>
 #include <kernel/asan.h>
 #include <kernel/boot.h>
 #include <kernel/lockdep.h>
@@ -16,6 +18,8 @@
 #include <kernel/thread.h>
 #include <kernel/thread_private.h>
 #include <mm/mobj.h>
+#include <pta_stats.h>
+#include <string.h>
 
 struct thread_ctx threads[CFG_NUM_THREADS];
 
@@ -168,6 +172,166 @@ void thread_unlock_global(void)
 	cpu_spin_unlock(&thread_global_lock);
 }
 
+/*
+ * Bit n of thread_busy is set while thread n isn't free. Threads are
+ * claimed and released with atomic operations on this bitmap so that
+ * entering a new yielding call doesn't need thread_global_lock.
+ */
+#define THREAD_BUSY_WORDS	DIV_ROUND_UP(CFG_NUM_THREADS, 32)
+
+static uint32_t thread_busy[THREAD_BUSY_WORDS] __nex_bss;
+/* Thread last released on each core, the first one thread_claim_free() tries */
+static short int thread_last_on_core[CFG_TEE_CORE_NB_CORE] __nex_bss;
+
+#ifdef CFG_WITH_STATS
+static struct pta_stats_thread thread_stats __nex_bss;
+#endif
+
+static uint32_t busy_word_mask(size_t w)
+{
+	if (w == THREAD_BUSY_WORDS - 1 && CFG_NUM_THREADS % 32)
+		return BIT32(CFG_NUM_THREADS % 32) - 1;
+	return UINT32_MAX;
+}
+
+static bool claim_thread(size_t n)
+{
+	uint32_t *word = thread_busy + n / 32;
+	uint32_t bit = BIT32(n % 32);
+	uint32_t old = atomic_load_u32(word);
+
+	while (!(old & bit))
+		if (atomic_cas_u32(word, &old, old | bit))
+			return true;
+
+	return false;
+}
+
+static void __nostackcheck release_thread(size_t n)
+{
+	atomic_clear_bits_release_u32(thread_busy + n / 32, BIT32(n % 32));
+}
+
+#ifdef CFG_WITH_STATS
+static void update_thread_stats(bool affinity_hit)
+{
+	uint32_t max = atomic_load_u32(&thread_stats.max_in_use);
+	uint32_t in_use = 0;
+	size_t w = 0;
+
+	for (w = 0; w < THREAD_BUSY_WORDS; w++)
+		in_use += __builtin_popcount(atomic_load_u32(thread_busy + w));
+
+	atomic_inc32(&thread_stats.allocs);
+	if (affinity_hit)
+		atomic_inc32(&thread_stats.affinity_hits);
+	while (in_use > max &&
+	       !atomic_cas_u32(&thread_stats.max_in_use, &max, in_use))
+		;
+}
+
+void thread_get_stats(struct pta_stats_thread *stats)
+{
+	size_t n = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	stats->num_threads = CFG_NUM_THREADS;
+	for (n = 0; n < CFG_NUM_THREADS; n++) {
+		switch (READ_ONCE(threads[n].state)) {
+		case THREAD_STATE_FREE:
+			stats->free++;
+			break;
+		case THREAD_STATE_ACTIVE:
+			stats->active++;
+			break;
+		default:
+			stats->suspended++;
+			break;
+		}
+	}
+	stats->max_in_use = atomic_load_u32(&thread_stats.max_in_use);
+	stats->allocs = atomic_load_u32(&thread_stats.allocs);
+	stats->affinity_hits = atomic_load_u32(&thread_stats.affinity_hits);
+	stats->no_free_thread = atomic_load_u32(&thread_stats.no_free_thread);
+}
+#else
+static void update_thread_stats(bool affinity_hit __unused)
+{
+}
+#endif
+
+short int thread_claim_free(void)
+{
+	size_t pos = get_core_pos();
+	short int n = thread_last_on_core[pos];
+	uint32_t *word = NULL;
+	uint32_t free = 0;
+	uint32_t old = 0;
+	size_t w = 0;
+
+	/* A thread recently run on this core likely has a warm cache */
+	if (claim_thread(n)) {
+		update_thread_stats(true);
+		return n;
+	}
+
+	for (w = 0; w < THREAD_BUSY_WORDS; w++) {
+		word = thread_busy + w;
+		old = atomic_load_u32(word);
+		while (true) {
+			free = ~old & busy_word_mask(w);
+			if (!free)
+				break;
+			n = __builtin_ctz(free);
+			if (atomic_cas_u32(word, &old, old | BIT32(n))) {
+				update_thread_stats(false);
+				return w * 32 + n;
+			}
+		}
+	}
+
+#ifdef CFG_WITH_STATS
+	atomic_inc32(&thread_stats.no_free_thread);
+#endif
+	return THREAD_ID_INVALID;
+}
+
+void thread_release(short int thread_id)
+{
+	assert(thread_id >= 0 && thread_id < CFG_NUM_THREADS);
+	thread_last_on_core[get_core_pos()] = thread_id;
+	release_thread(thread_id);
+}
+
+bool thread_claim_all(void)
+{
+	uint32_t old = 0;
+	size_t w = 0;
+
+	for (w = 0; w < THREAD_BUSY_WORDS; w++) {
+		old = 0;
+		/* The CAS may fail spuriously, retry while all are free */
+		while (!atomic_cas_u32(thread_busy + w, &old,
+				       busy_word_mask(w)))
+			if (old)
+				goto err;
+	}
+
+	return true;
+err:
+	while (w--)
+		atomic_clear_bits_release_u32(thread_busy + w, UINT32_MAX);
+	return false;
+}
+
+void thread_release_all(void)
+{
+	size_t w = 0;
+
+	for (w = 0; w < THREAD_BUSY_WORDS; w++)
+		atomic_clear_bits_release_u32(thread_busy + w, UINT32_MAX);
+}
+
 static struct thread_core_local * __nostackcheck
 get_core_local(unsigned int pos)
 {
@@ -281,6 +445,7 @@ void thread_init_boot_thread(void)
 
 	l->curr_thread = 0;
 	threads[0].state = THREAD_STATE_ACTIVE;
+	claim_thread(0);
 }
 
 void __nostackcheck thread_clr_boot_thread(void)
@@ -290,6 +455,7 @@ void __nostackcheck thread_clr_boot_thread(void)
 	assert(l->curr_thread >= 0 && l->curr_thread < CFG_NUM_THREADS);
 	assert(threads[l->curr_thread].state == THREAD_STATE_ACTIVE);
 	threads[l->curr_thread].state = THREAD_STATE_FREE;
+	release_thread(l->curr_thread);
 	l->curr_thread = THREAD_ID_INVALID;
 }
 
@@ -411,6 +577,14 @@ short int __noprof thread_get_id(void)
 	return ct;
 }
 
+bool thread_is_active(short int thread_id)
+{
+	if (thread_id < 0 || thread_id >= CFG_NUM_THREADS)
+		return false;
+
+	return READ_ONCE(threads[thread_id].state) == THREAD_STATE_ACTIVE;
+}
+
 #ifdef CFG_WITH_PAGER
 static void init_thread_stacks(void)
 {
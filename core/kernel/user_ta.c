@@ -166,12 +166,14 @@ static TEE_Result user_ta_enter(struct ts_session *session,
 		res = TEE_ERROR_OUT_OF_MEMORY;
 		goto out_clr_cancel;
 	}
+	vm_param_cache_begin(&utc->uctx, ta_sess->id);
 	if (ta_sess->param) {
 		/* Map user space memory */
 		res = vm_map_param(&utc->uctx, ta_sess->param, param_va);
 		if (res != TEE_SUCCESS)
 			goto out;
 	}
+	vm_param_cache_revoke(&utc->uctx);
 
 	/* Switch to user ctx */
 	ts_push_current_session(session);
@@ -226,6 +228,10 @@ out_pop_session:
 	assert(ts_sess == session);
 
 out:
+	/* Cached parameter mappings must not outlive the session */
+	if (func == UTEE_ENTRY_FUNC_CLOSE_SESSION)
+		vm_param_cache_flush(&utc->uctx);
+	vm_param_cache_end(&utc->uctx);
 	dec_recursion();
 out_clr_cancel:
 	/*
@@ -498,7 +504,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 	 * until this context is fully initialized. This is needed to
 	 * handle single instance TAs.
 	 */
-	TAILQ_INSERT_TAIL(&tee_ctxes, &utc->ta_ctx, link);
+	tee_ta_register_ctx(&utc->ta_ctx);
 	mutex_unlock(&tee_ta_mutex);
 
 	/*
@@ -519,7 +525,7 @@ TEE_Result tee_ta_init_user_ta_session(const TEE_UUID *uuid,
 		utc->uctx.is_initializing = false;
 	} else {
 		s->ts_sess.ctx = NULL;
-		TAILQ_REMOVE(&tee_ctxes, &utc->ta_ctx, link);
+		tee_ta_unregister_ctx(&utc->ta_ctx);
 	}
 
 	/* The state has changed for the context, notify eventual waiters. */
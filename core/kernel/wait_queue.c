@@ -3,7 +3,10 @@
  * Copyright (c) 2015-2021, Linaro Limited
  */
 
+#include <assert.h>
+#include <atomic.h>
 #include <compiler.h>
+#include <io.h>
 #include <kernel/notif.h>
 #include <kernel/spinlock.h>
 #include <kernel/thread.h>
@@ -13,9 +16,67 @@
 #include <tee_api_defines.h>
 #include <trace.h>
 #include <types_ext.h>
+#include <util.h>
 
-static unsigned wq_spin_lock;
+#ifdef CFG_WITH_STATS
+static struct wait_queue_stats wq_stats;
 
+static uint32_t wq_lock(struct wait_queue *wq)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+
+	if (!cpu_spin_trylock(&wq->lock)) {
+		atomic_inc32(&wq->contended);
+		atomic_inc32(&wq_stats.contended);
+		cpu_spin_lock(&wq->lock);
+	}
+
+	return exceptions;
+}
+
+/* Called with wq->lock held */
+static void wq_stats_add_wait(struct wait_queue *wq)
+{
+	uint32_t max = atomic_load_u32(&wq_stats.max_queue_waits);
+
+	wq->waits++;
+	atomic_inc32(&wq_stats.waits);
+	while (wq->waits > max &&
+	       !atomic_cas_u32(&wq_stats.max_queue_waits, &max, wq->waits))
+		;
+}
+
+static void wq_stats_add_wakeup(void)
+{
+	atomic_inc32(&wq_stats.wakeups);
+}
+
+void wq_get_stats(struct wait_queue_stats *stats)
+{
+	stats->waits = atomic_load_u32(&wq_stats.waits);
+	stats->wakeups = atomic_load_u32(&wq_stats.wakeups);
+	stats->contended = atomic_load_u32(&wq_stats.contended);
+	stats->max_queue_waits = atomic_load_u32(&wq_stats.max_queue_waits);
+}
+#else
+static uint32_t wq_lock(struct wait_queue *wq)
+{
+	return cpu_spin_lock_xsave(&wq->lock);
+}
+
+static void wq_stats_add_wait(struct wait_queue *wq __unused)
+{
+}
+
+static void wq_stats_add_wakeup(void)
+{
+}
+#endif
+
+static void wq_unlock(struct wait_queue *wq, uint32_t exceptions)
+{
+	cpu_spin_unlock_xrestore(&wq->lock, exceptions);
+}
 
 void wq_init(struct wait_queue *wq)
 {
@@ -40,18 +101,21 @@ static void do_notif(TEE_Result (*fn)(uint32_t), int id,
 		DMSG("%s thread %d res %#"PRIx32, cmd_str, id, res);
 }
 
-static void slist_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
+/* Called with wq->lock held */
+static void wq_add_tail(struct wait_queue *wq, struct wait_queue_elem *wqe)
 {
-	struct wait_queue_elem *wqe_iter;
+	if (!wq->elems.tqh_last)
+		TAILQ_INIT(&wq->elems);
+	TAILQ_INSERT_TAIL(&wq->elems, wqe, link);
+}
 
-	/* Add elem to end of wait queue */
-	wqe_iter = SLIST_FIRST(wq);
-	if (wqe_iter) {
-		while (SLIST_NEXT(wqe_iter, link))
-			wqe_iter = SLIST_NEXT(wqe_iter, link);
-		SLIST_INSERT_AFTER(wqe_iter, wqe, link);
-	} else
-		SLIST_INSERT_HEAD(wq, wqe, link);
+/* Called with wq->lock held */
+static void wq_remove(struct wait_queue *wq, struct wait_queue_elem *wqe)
+{
+	TAILQ_REMOVE(&wq->elems, wqe, link);
+	/* Return to the all zero state, see struct wait_queue */
+	if (TAILQ_EMPTY(&wq->elems))
+		wq->elems.tqh_last = NULL;
 }
 
 void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
@@ -64,11 +128,12 @@ void wq_wait_init_condvar(struct wait_queue *wq, struct wait_queue_elem *wqe,
 	wqe->wait_read = wait_read;
 	wqe->cv = cv;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = wq_lock(wq);
 
-	slist_add_tail(wq, wqe);
+	wq_add_tail(wq, wqe);
+	wq_stats_add_wait(wq);
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	wq_unlock(wq, old_itr_status);
 }
 
 void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
@@ -81,25 +146,34 @@ void wq_wait_final(struct wait_queue *wq, struct wait_queue_elem *wqe,
 		do_notif(notif_wait, wqe->handle,
 			 "sleep", sync_obj, fname, lineno);
 
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+		old_itr_status = wq_lock(wq);
 
 		done = wqe->done;
 		if (done)
-			SLIST_REMOVE(wq, wqe, wait_queue_elem, link);
+			wq_remove(wq, wqe);
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+		wq_unlock(wq, old_itr_status);
 	} while (!done);
 }
 
 void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 			const char *fname, int lineno)
 {
+	short handles[CFG_NUM_THREADS] = { };
 	uint32_t old_itr_status;
 	struct wait_queue_elem *wqe;
-	int handle = -1;
-	bool do_wakeup = false;
+	size_t count = 0;
 	bool wake_type_assigned = false;
 	bool wake_read = false; /* avoid gcc warning */
+	size_t n = 0;
+
+	/*
+	 * Callers change the state waited for under a lock which waiters
+	 * also hold while adding themselves to the queue, so any waiter
+	 * that could have missed the change is visible here already.
+	 */
+	if (!READ_ONCE(wq->elems.tqh_first))
+		return;
 
 	/*
 	 * If next type is wait_read wakeup all wqe with wait_read true.
@@ -107,37 +181,35 @@ void wq_wake_next(struct wait_queue *wq, const void *sync_obj,
 	 * done.
 	 */
 
-	while (true) {
-		old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
-
-		SLIST_FOREACH(wqe, wq, link) {
-			if (wqe->cv)
-				continue;
-			if (wqe->done)
-				continue;
-			if (!wake_type_assigned) {
-				wake_read = wqe->wait_read;
-				wake_type_assigned = true;
-			}
-
-			if (wqe->wait_read != wake_read)
-				continue;
-
-			wqe->done = true;
-			handle = wqe->handle;
-			do_wakeup = true;
-			break;
-		}
+	old_itr_status = wq_lock(wq);
 
-		cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	TAILQ_FOREACH(wqe, &wq->elems, link) {
+		if (wqe->cv)
+			continue;
+		if (wqe->done)
+			continue;
+		if (!wake_type_assigned) {
+			wake_read = wqe->wait_read;
+			wake_type_assigned = true;
+		}
 
-		if (do_wakeup)
-			do_notif(notif_send_sync, handle,
-				 "wake ", sync_obj, fname, lineno);
+		if (wqe->wait_read != wake_read)
+			continue;
 
-		if (!do_wakeup || !wake_read)
+		wqe->done = true;
+		assert(count < ARRAY_SIZE(handles));
+		handles[count] = wqe->handle;
+		count++;
+		if (!wake_read)
 			break;
-		do_wakeup = false;
+	}
+
+	wq_unlock(wq, old_itr_status);
+
+	for (n = 0; n < count; n++) {
+		wq_stats_add_wakeup();
+		do_notif(notif_send_sync, handles[n],
+			 "wake ", sync_obj, fname, lineno);
 	}
 }
 
@@ -151,7 +223,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 	if (!cv)
 		return;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = wq_lock(wq);
 
 	/*
 	 * Find condvar waiter(s) and promote each to an active waiter.
@@ -159,7 +231,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 	 * condvar waiter is added to the queue when waiting for the
 	 * condvar.
 	 */
-	SLIST_FOREACH(wqe, wq, link) {
+	TAILQ_FOREACH(wqe, &wq->elems, link) {
 		if (wqe->cv == cv) {
 			if (fname)
 				FMSG("promote thread %u %p %s:%d",
@@ -174,7 +246,7 @@ void wq_promote_condvar(struct wait_queue *wq, struct condvar *cv,
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	wq_unlock(wq, old_itr_status);
 }
 
 bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv)
@@ -183,16 +255,16 @@ bool wq_have_condvar(struct wait_queue *wq, struct condvar *cv)
 	struct wait_queue_elem *wqe;
 	bool rc = false;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = wq_lock(wq);
 
-	SLIST_FOREACH(wqe, wq, link) {
+	TAILQ_FOREACH(wqe, &wq->elems, link) {
 		if (wqe->cv == cv) {
 			rc = true;
 			break;
 		}
 	}
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	wq_unlock(wq, old_itr_status);
 
 	return rc;
 }
@@ -202,11 +274,11 @@ bool wq_is_empty(struct wait_queue *wq)
 	uint32_t old_itr_status;
 	bool ret;
 
-	old_itr_status = cpu_spin_lock_xsave(&wq_spin_lock);
+	old_itr_status = wq_lock(wq);
 
-	ret = SLIST_EMPTY(wq);
+	ret = TAILQ_EMPTY(&wq->elems);
 
-	cpu_spin_unlock_xrestore(&wq_spin_lock, old_itr_status);
+	wq_unlock(wq, old_itr_status);
 
 	return ret;
 }
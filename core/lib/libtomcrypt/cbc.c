@@ -7,6 +7,7 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
@@ -78,7 +79,7 @@ static void ltc_cbc_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_cbc_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_cbc_ctx(ctx));
+	free_wipe(to_cbc_ctx(ctx));
 }
 
 static void ltc_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -92,12 +93,33 @@ static void ltc_cbc_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	dst->state = src->state;
 }
 
+static TEE_Result ltc_cbc_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode, const uint8_t *iv,
+				 size_t iv_len)
+{
+	struct ltc_cbc_ctx *c = to_cbc_ctx(ctx);
+
+	if ((int)iv_len != cipher_descriptor[c->cipher_idx]->block_length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = cbc_encrypt;
+	else
+		c->update = cbc_decrypt;
+
+	if (cbc_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+		return TEE_SUCCESS;
+	else
+		return TEE_ERROR_BAD_STATE;
+}
+
 static const struct crypto_cipher_ops ltc_cbc_ops = {
 	.init = ltc_cbc_init,
 	.update = ltc_cbc_update,
 	.final = ltc_cbc_final,
 	.free_ctx = ltc_cbc_free_ctx,
 	.copy_state = ltc_cbc_copy_state,
+	.reinit = ltc_cbc_reinit,
 };
 
 static TEE_Result ltc_cbc_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
@@ -7,6 +7,7 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
@@ -71,7 +72,7 @@ static void ltc_ctr_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_ctr_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_ctr_ctx(ctx));
+	free_wipe(to_ctr_ctx(ctx));
 }
 
 static void ltc_ctr_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -85,12 +86,33 @@ static void ltc_ctr_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	dst->state = src->state;
 }
 
+static TEE_Result ltc_ctr_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode, const uint8_t *iv,
+				 size_t iv_len)
+{
+	struct ltc_ctr_ctx *c = to_ctr_ctx(ctx);
+
+	if ((int)iv_len != cipher_descriptor[c->cipher_idx]->block_length)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = ctr_encrypt;
+	else
+		c->update = ctr_decrypt;
+
+	if (ctr_setiv(iv, iv_len, &c->state) == CRYPT_OK)
+		return TEE_SUCCESS;
+	else
+		return TEE_ERROR_BAD_STATE;
+}
+
 static const struct crypto_cipher_ops ltc_ctr_ops = {
 	.init = ltc_ctr_init,
 	.update = ltc_ctr_update,
 	.final = ltc_ctr_final,
 	.free_ctx = ltc_ctr_free_ctx,
 	.copy_state = ltc_ctr_copy_state,
+	.reinit = ltc_ctr_reinit,
 };
 
 TEE_Result crypto_aes_ctr_alloc_ctx(struct crypto_cipher_ctx **ctx_ret)
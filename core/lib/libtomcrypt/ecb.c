@@ -7,6 +7,7 @@
 #include <crypto/crypto.h>
 #include <crypto/crypto_impl.h>
 #include <stdlib.h>
+#include <stdlib_ext.h>
 #include <tee_api_types.h>
 #include <tomcrypt_private.h>
 #include <util.h>
@@ -76,7 +77,7 @@ static void ltc_ecb_final(struct crypto_cipher_ctx *ctx)
 
 static void ltc_ecb_free_ctx(struct crypto_cipher_ctx *ctx)
 {
-	free(to_ecb_ctx(ctx));
+	free_wipe(to_ecb_ctx(ctx));
 }
 
 static void ltc_ecb_copy_state(struct crypto_cipher_ctx *dst_ctx,
@@ -90,12 +91,28 @@ static void ltc_ecb_copy_state(struct crypto_cipher_ctx *dst_ctx,
 	dst->state = src->state;
 }
 
+static TEE_Result ltc_ecb_reinit(struct crypto_cipher_ctx *ctx,
+				 TEE_OperationMode mode,
+				 const uint8_t *iv __unused,
+				 size_t iv_len __unused)
+{
+	struct ltc_ecb_ctx *c = to_ecb_ctx(ctx);
+
+	if (mode == TEE_MODE_ENCRYPT)
+		c->update = ecb_encrypt;
+	else
+		c->update = ecb_decrypt;
+
+	return TEE_SUCCESS;
+}
+
 static const struct crypto_cipher_ops ltc_ecb_ops = {
 	.init = ltc_ecb_init,
 	.update = ltc_ecb_update,
 	.final = ltc_ecb_final,
 	.free_ctx = ltc_ecb_free_ctx,
 	.copy_state = ltc_ecb_copy_state,
+	.reinit = ltc_ecb_reinit,
 };
 
 static TEE_Result ltc_ecb_alloc_ctx(struct crypto_cipher_ctx **ctx_ret,
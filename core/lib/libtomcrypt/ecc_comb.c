@@ -0,0 +1,653 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <crypto/crypto.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_ext.h>
+#include <tomcrypt_private.h>
+#include <util.h>
+
+/*
+ * Fixed-base comb scalar multiplication (HAC algorithm 14.117) for points
+ * which are multiplied repeatedly, that is the curve generators when
+ * signing and the public keys of peers which are verified or agreed with
+ * more than once.
+ *
+ * For a point G and a modulus of n bits the scalar is split in COMB_W rows
+ * of gap = ceil((n + 1) / COMB_W) bits. The table holds the COMB_POINTS
+ * sums D + sum(b_j * 2^(j * gap) * G) and k * G is computed column by column
+ * with one doubling and one addition each, instead of one doubling and one
+ * addition per bit with the ladder in ltc_ecc_mulmod().
+ *
+ * The offset D = c * G with a random c keeps the accumulator and the table
+ * entries from being the point at infinity or equal to each other, so each
+ * column performs the same operations whatever the scalar bits are. The
+ * accumulated (2^gap - 1) * D is subtracted at the end. Table entries are
+ * selected by reading all of them.
+ *
+ * Tables are kept in Jacobian coordinates in Montgomery form, as fixed
+ * size big endian byte strings in the core heap since the bignums
+ * themselves live in a per-operation scratch memory pool.
+ */
+
+#define COMB_W			4
+#define COMB_POINTS		BIT(COMB_W)
+/* Size of a coordinate of the largest supported curve */
+#define COMB_COORD_MAX		(ROUNDUP(LTC_MAX_ECC, 8) / 8)
+/* Key is modulus, a in Montgomery form, a flag and the affine point */
+#define COMB_KEY_MAX		(4 * COMB_COORD_MAX + 1)
+#define COMB_CACHE_SIZE		8
+/* A table is built when a point is multiplied for the second time */
+#define COMB_BUILD_USES		2
+
+struct comb_lut {
+	size_t coord_len;
+	size_t gap;
+	/* COMB_POINTS table entries followed by -(2^gap - 1) * D */
+	uint8_t pts[];
+};
+
+struct comb_slot {
+	uint8_t key[COMB_KEY_MAX];
+	size_t key_len;
+	unsigned int uses;
+	unsigned int refcount;
+	uint64_t stamp;
+	struct comb_lut *lut;
+};
+
+static struct comb_slot comb_cache[COMB_CACHE_SIZE];
+static uint64_t comb_clock;
+LTC_MUTEX_GLOBAL(comb_lock)
+
+static size_t comb_point_size(size_t coord_len)
+{
+	return 3 * coord_len;
+}
+
+static int put_coord(void *a, uint8_t *buf, size_t len)
+{
+	size_t sz = mp_unsigned_bin_size(a);
+
+	if (sz > len)
+		return CRYPT_BUFFER_OVERFLOW;
+	memset(buf, 0, len - sz);
+	if (!sz)
+		return CRYPT_OK;
+
+	return mp_to_unsigned_bin(a, buf + len - sz);
+}
+
+static int put_point(ecc_point *P, uint8_t *buf, size_t coord_len)
+{
+	int err = CRYPT_OK;
+
+	err = put_coord(P->x, buf, coord_len);
+	if (!err)
+		err = put_coord(P->y, buf + coord_len, coord_len);
+	if (!err)
+		err = put_coord(P->z, buf + 2 * coord_len, coord_len);
+
+	return err;
+}
+
+static int get_point(const uint8_t *buf, size_t coord_len, ecc_point *P)
+{
+	uint8_t *b = (uint8_t *)buf;
+	int err = CRYPT_OK;
+
+	err = mp_read_unsigned_bin(P->x, b, coord_len);
+	if (!err)
+		err = mp_read_unsigned_bin(P->y, b + coord_len, coord_len);
+	if (!err)
+		err = mp_read_unsigned_bin(P->z, b + 2 * coord_len, coord_len);
+
+	return err;
+}
+
+static const uint8_t *lut_point(const struct comb_lut *lut, size_t idx)
+{
+	return lut->pts + idx * comb_point_size(lut->coord_len);
+}
+
+/* Loads entry @idx into @P, reading every entry of the table */
+static int comb_select(const struct comb_lut *lut, unsigned int idx,
+		       ecc_point *P)
+{
+	size_t psize = comb_point_size(lut->coord_len);
+	uint8_t buf[3 * COMB_COORD_MAX] = { };
+	const uint8_t *src = NULL;
+	unsigned int i = 0;
+	uint8_t mask = 0;
+	size_t n = 0;
+	int err = CRYPT_OK;
+
+	for (i = 0; i < COMB_POINTS; i++) {
+		mask = ((i ^ idx) - 1) >> 8;
+		src = lut_point(lut, i);
+		for (n = 0; n < psize; n++)
+			buf[n] |= src[n] & mask;
+	}
+
+	err = get_point(buf, lut->coord_len, P);
+	memzero_explicit(buf, sizeof(buf));
+
+	return err;
+}
+
+static unsigned int comb_column(const uint8_t *kb, size_t kb_len,
+				size_t gap, size_t col)
+{
+	unsigned int idx = 0;
+	size_t bit = 0;
+	size_t j = 0;
+
+	for (j = 0; j < COMB_W; j++) {
+		bit = col + j * gap;
+		idx |= ((kb[kb_len - 1 - bit / 8] >> (bit % 8)) & 1) << j;
+	}
+
+	return idx;
+}
+
+/* Builds the cache key of @G on the curve given by @ma and @modulus */
+static int comb_key(const ecc_point *G, void *ma, void *modulus,
+		    uint8_t *key, size_t *key_len)
+{
+	size_t len = mp_unsigned_bin_size(modulus);
+	int err = CRYPT_OK;
+
+	if (len > COMB_COORD_MAX || mp_cmp_d(G->z, 1) != LTC_MP_EQ)
+		return CRYPT_INVALID_ARG;
+
+	err = put_coord(modulus, key, len);
+	if (!err && ma)
+		err = put_coord(ma, key + len, len);
+	else if (!err)
+		memset(key + len, 0, len);
+	key[2 * len] = !!ma;
+	if (!err)
+		err = put_coord(G->x, key + 2 * len + 1, len);
+	if (!err)
+		err = put_coord(G->y, key + 3 * len + 1, len);
+	*key_len = 4 * len + 1;
+
+	return err;
+}
+
+static struct comb_slot *find_slot(const uint8_t *key, size_t key_len)
+{
+	size_t n = 0;
+
+	for (n = 0; n < COMB_CACHE_SIZE; n++)
+		if (comb_cache[n].key_len == key_len &&
+		    !memcmp(comb_cache[n].key, key, key_len))
+			return comb_cache + n;
+
+	return NULL;
+}
+
+static struct comb_slot *evict_slot(void)
+{
+	struct comb_slot *slot = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < COMB_CACHE_SIZE; n++) {
+		if (comb_cache[n].refcount)
+			continue;
+		if (!slot || comb_cache[n].stamp < slot->stamp)
+			slot = comb_cache + n;
+	}
+	if (slot) {
+		free(slot->lut);
+		memset(slot, 0, sizeof(*slot));
+	}
+
+	return slot;
+}
+
+/*
+ * Counts a use of the point identified by @key and returns its table with
+ * a reference held, or NULL with @build set if the caller should build it.
+ */
+static struct comb_lut *comb_acquire(const uint8_t *key, size_t key_len,
+				     bool *build)
+{
+	struct comb_lut *lut = NULL;
+	struct comb_slot *slot = NULL;
+
+	*build = false;
+
+	LTC_MUTEX_LOCK(&comb_lock);
+	slot = find_slot(key, key_len);
+	if (!slot) {
+		slot = evict_slot();
+		if (!slot)
+			goto out;
+		memcpy(slot->key, key, key_len);
+		slot->key_len = key_len;
+	}
+	slot->uses++;
+	slot->stamp = ++comb_clock;
+	if (slot->lut) {
+		slot->refcount++;
+		lut = slot->lut;
+	} else if (slot->uses >= COMB_BUILD_USES) {
+		*build = true;
+	}
+out:
+	LTC_MUTEX_UNLOCK(&comb_lock);
+
+	return lut;
+}
+
+/*
+ * Stores a freshly built @lut for @key and returns the table to use with a
+ * reference held, or NULL if the point was evicted in the meantime.
+ */
+static struct comb_lut *comb_install(const uint8_t *key, size_t key_len,
+				     struct comb_lut *lut)
+{
+	struct comb_slot *slot = NULL;
+	struct comb_lut *ret = NULL;
+
+	LTC_MUTEX_LOCK(&comb_lock);
+	slot = find_slot(key, key_len);
+	if (slot) {
+		if (slot->lut)
+			free(lut);
+		else
+			slot->lut = lut;
+		slot->refcount++;
+		ret = slot->lut;
+	} else {
+		free(lut);
+	}
+	LTC_MUTEX_UNLOCK(&comb_lock);
+
+	return ret;
+}
+
+static void comb_release(struct comb_lut *lut)
+{
+	size_t n = 0;
+
+	LTC_MUTEX_LOCK(&comb_lock);
+	for (n = 0; n < COMB_CACHE_SIZE; n++) {
+		if (comb_cache[n].lut == lut) {
+			comb_cache[n].refcount--;
+			break;
+		}
+	}
+	LTC_MUTEX_UNLOCK(&comb_lock);
+}
+
+/* R = c * P with a random c, P in Montgomery form */
+static int random_multiple(const ecc_point *P, ecc_point *R, size_t len,
+			   void *ma, void *modulus, void *mp)
+{
+	uint8_t c[COMB_COORD_MAX] = { };
+	ecc_point *T = NULL;
+	size_t bit = 0;
+	int err = CRYPT_OK;
+
+	if (crypto_rng_read(c, len))
+		return CRYPT_ERROR_READPRNG;
+	/* Highest bit set so the loop below starts with R = P */
+	c[0] |= 0x80;
+
+	T = ltc_ecc_new_point();
+	if (!T)
+		return CRYPT_MEM;
+
+	err = ltc_ecc_copy_point(P, R);
+	for (bit = len * 8 - 1; !err && bit--;) {
+		err = ltc_mp.ecc_ptdbl(R, R, ma, modulus, mp);
+		if (!err && (c[len - 1 - bit / 8] >> (bit % 8)) & 1) {
+			err = ltc_mp.ecc_ptadd(R, P, T, ma, modulus, mp);
+			if (!err)
+				err = ltc_ecc_copy_point(T, R);
+		}
+	}
+
+	ltc_ecc_del_point(T);
+	memzero_explicit(c, sizeof(c));
+
+	return err;
+}
+
+static int comb_build(const ecc_point *G, void *ma, void *modulus,
+		      void *mp, void *mu, struct comb_lut **lut_ret)
+{
+	size_t len = mp_unsigned_bin_size(modulus);
+	size_t psize = comb_point_size(len);
+	ecc_point *B[COMB_W] = { };
+	struct comb_lut *lut = NULL;
+	ecc_point *D = NULL;
+	ecc_point *E = NULL;
+	ecc_point *T = NULL;
+	size_t n = 0;
+	size_t j = 0;
+	int err = CRYPT_MEM;
+
+	lut = calloc(1, sizeof(*lut) + (COMB_POINTS + 1) * psize);
+	if (!lut)
+		return CRYPT_MEM;
+	lut->coord_len = len;
+	lut->gap = (mp_count_bits(modulus) + 1 + COMB_W - 1) / COMB_W;
+
+	for (j = 0; j < COMB_W; j++) {
+		B[j] = ltc_ecc_new_point();
+		if (!B[j])
+			goto out;
+	}
+	D = ltc_ecc_new_point();
+	E = ltc_ecc_new_point();
+	T = ltc_ecc_new_point();
+	if (!D || !E || !T)
+		goto out;
+
+	/* B[0] = G in Montgomery form, B[j] = 2^(j * gap) * G */
+	err = mp_mulmod(G->x, mu, modulus, B[0]->x);
+	if (!err)
+		err = mp_mulmod(G->y, mu, modulus, B[0]->y);
+	if (!err)
+		err = mp_mulmod(G->z, mu, modulus, B[0]->z);
+	for (j = 1; !err && j < COMB_W; j++) {
+		err = ltc_ecc_copy_point(B[j - 1], B[j]);
+		for (n = 0; !err && n < lut->gap; n++)
+			err = ltc_mp.ecc_ptdbl(B[j], B[j], ma, modulus, mp);
+	}
+	if (err)
+		goto out;
+
+	err = random_multiple(B[0], D, len, ma, modulus, mp);
+	if (err)
+		goto out;
+
+	/* Entry n = D + sum of the B[j] selected by the bits of n */
+	err = put_point(D, lut->pts, len);
+	for (n = 1; !err && n < COMB_POINTS; n++) {
+		j = __builtin_ctz(n);
+		err = get_point(lut_point(lut, n & (n - 1)), len, T);
+		if (!err)
+			err = ltc_mp.ecc_ptadd(T, B[j], T, ma, modulus, mp);
+		if (!err)
+			err = put_point(T, lut->pts + n * psize, len);
+	}
+	if (err)
+		goto out;
+
+	/* E = (2^gap - 1) * D, stored negated */
+	err = ltc_ecc_copy_point(D, E);
+	for (n = 1; !err && n < lut->gap; n++) {
+		err = ltc_mp.ecc_ptdbl(E, E, ma, modulus, mp);
+		if (!err)
+			err = ltc_mp.ecc_ptadd(E, D, E, ma, modulus, mp);
+	}
+	if (!err && !mp_iszero(E->y))
+		err = mp_sub(modulus, E->y, E->y);
+	if (!err)
+		err = put_point(E, lut->pts + COMB_POINTS * psize, len);
+
+out:
+	for (j = 0; j < COMB_W; j++)
+		ltc_ecc_del_point(B[j]);
+	ltc_ecc_del_point(D);
+	ltc_ecc_del_point(E);
+	ltc_ecc_del_point(T);
+	if (err) {
+		free(lut);
+		return err;
+	}
+	*lut_ret = lut;
+
+	return CRYPT_OK;
+}
+
+/* Returns the table of @G, building it if it's due, or NULL */
+static struct comb_lut *comb_get(const ecc_point *G, void *ma, void *modulus,
+				 void *mp, void *mu)
+{
+	uint8_t key[COMB_KEY_MAX] = { };
+	struct comb_lut *lut = NULL;
+	size_t key_len = 0;
+	bool build = false;
+
+	if (comb_key(G, ma, modulus, key, &key_len))
+		return NULL;
+
+	lut = comb_acquire(key, key_len, &build);
+	if (lut || !build)
+		return lut;
+
+	if (comb_build(G, ma, modulus, mp, mu, &lut))
+		return NULL;
+
+	return comb_install(key, key_len, lut);
+}
+
+/* Loads the scalar as a big endian string of COMB_W * gap bits */
+static int comb_scalar(void *k, const struct comb_lut *lut, uint8_t *kb,
+		       size_t kb_len)
+{
+	size_t sz = mp_unsigned_bin_size(k);
+
+	if ((size_t)mp_count_bits(k) > COMB_W * lut->gap || sz > kb_len)
+		return CRYPT_INVALID_ARG;
+	memset(kb, 0, kb_len - sz);
+	if (!sz)
+		return CRYPT_OK;
+
+	return mp_to_unsigned_bin(k, kb + kb_len - sz);
+}
+
+static int comb_add_column(const struct comb_lut *lut, const uint8_t *kb,
+			   size_t kb_len, size_t col, ecc_point *R,
+			   ecc_point *T, void *ma, void *modulus, void *mp)
+{
+	int err = CRYPT_OK;
+
+	err = comb_select(lut, comb_column(kb, kb_len, lut->gap, col), T);
+	if (!err)
+		err = ltc_mp.ecc_ptadd(R, T, R, ma, modulus, mp);
+
+	return err;
+}
+
+/*
+ * Montgomery parameters and, if @ma isn't NULL, a in Montgomery form or
+ * NULL for curves with a == -3, as in ltc_ecc_mulmod()
+ */
+static int mont_setup(void *a, void *modulus, void **mp, void **mu, void **ma)
+{
+	void *a_plus3 = NULL;
+	int err = CRYPT_OK;
+
+	*mp = NULL;
+	*mu = NULL;
+	if (ma)
+		*ma = NULL;
+
+	err = mp_montgomery_setup(modulus, mp);
+	if (!err)
+		err = mp_init_multi(mu, &a_plus3, LTC_NULL);
+	if (!err)
+		err = mp_montgomery_normalization(*mu, modulus);
+	if (!err && a && ma) {
+		err = mp_add_d(a, 3, a_plus3);
+		if (!err && mp_cmp(a_plus3, modulus) != LTC_MP_EQ) {
+			err = mp_init(ma);
+			if (!err)
+				err = mp_mulmod(a, *mu, modulus, *ma);
+		}
+	}
+
+	if (a_plus3)
+		mp_clear(a_plus3);
+
+	return err;
+}
+
+static void mont_free(void *mp, void *mu, void *ma)
+{
+	if (ma)
+		mp_clear(ma);
+	if (mu)
+		mp_clear(mu);
+	if (mp)
+		mp_montgomery_free(mp);
+}
+
+int ltc_ecc_comb_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a,
+			void *modulus, int map)
+{
+	uint8_t kb[COMB_KEY_MAX] = { };
+	struct comb_lut *lut = NULL;
+	ecc_point *T = NULL;
+	void *mp = NULL;
+	void *mu = NULL;
+	void *ma = NULL;
+	size_t kb_len = 0;
+	size_t col = 0;
+	int err = CRYPT_OK;
+
+	err = mont_setup(a, modulus, &mp, &mu, &ma);
+	if (!err)
+		lut = comb_get(G, ma, modulus, mp, mu);
+	if (!lut) {
+		mont_free(mp, mu, ma);
+		if (err)
+			return err;
+		return ltc_ecc_mulmod(k, G, R, a, modulus, map);
+	}
+
+	kb_len = ROUNDUP(COMB_W * lut->gap, 8) / 8;
+	if (comb_scalar(k, lut, kb, kb_len)) {
+		comb_release(lut);
+		mont_free(mp, mu, ma);
+		return ltc_ecc_mulmod(k, G, R, a, modulus, map);
+	}
+
+	T = ltc_ecc_new_point();
+	if (!T) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	col = lut->gap - 1;
+	err = comb_select(lut, comb_column(kb, kb_len, lut->gap, col), R);
+	while (!err && col--) {
+		err = ltc_mp.ecc_ptdbl(R, R, ma, modulus, mp);
+		if (!err)
+			err = comb_add_column(lut, kb, kb_len, col, R, T, ma,
+					      modulus, mp);
+	}
+	if (!err)
+		err = get_point(lut_point(lut, COMB_POINTS), lut->coord_len,
+				T);
+	if (!err)
+		err = ltc_mp.ecc_ptadd(R, T, R, ma, modulus, mp);
+	if (!err && map)
+		err = ltc_ecc_map(R, modulus, mp);
+
+out:
+	memzero_explicit(kb, sizeof(kb));
+	ltc_ecc_del_point(T);
+	comb_release(lut);
+	mont_free(mp, mu, ma);
+
+	return err;
+}
+
+#ifdef LTC_ECC_SHAMIR
+/*
+ * kA * A + kB * B with both combs walked together when both points have a
+ * table, which is the case when verifying repeatedly with the same key.
+ */
+int ltc_ecc_comb_mul2add(const ecc_point *A, void *kA, const ecc_point *B,
+			 void *kB, ecc_point *C, void *ma, void *modulus)
+{
+	uint8_t kbA[COMB_KEY_MAX] = { };
+	uint8_t kbB[COMB_KEY_MAX] = { };
+	struct comb_lut *lutA = NULL;
+	struct comb_lut *lutB = NULL;
+	ecc_point *T = NULL;
+	void *mp = NULL;
+	void *mu = NULL;
+	size_t kb_len = 0;
+	size_t col = 0;
+	int err = CRYPT_OK;
+
+	err = mont_setup(NULL, modulus, &mp, &mu, NULL);
+	if (!err) {
+		lutA = comb_get(A, ma, modulus, mp, mu);
+		lutB = comb_get(B, ma, modulus, mp, mu);
+	}
+	if (!lutA || !lutB)
+		goto fallback;
+
+	kb_len = ROUNDUP(COMB_W * lutA->gap, 8) / 8;
+	if (lutA->gap != lutB->gap || comb_scalar(kA, lutA, kbA, kb_len) ||
+	    comb_scalar(kB, lutB, kbB, kb_len))
+		goto fallback;
+
+	T = ltc_ecc_new_point();
+	if (!T) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+
+	col = lutA->gap - 1;
+	err = comb_select(lutA, comb_column(kbA, kb_len, lutA->gap, col), C);
+	if (!err)
+		err = comb_add_column(lutB, kbB, kb_len, col, C, T, ma,
+				      modulus, mp);
+	while (!err && col--) {
+		err = ltc_mp.ecc_ptdbl(C, C, ma, modulus, mp);
+		if (!err)
+			err = comb_add_column(lutA, kbA, kb_len, col, C, T, ma,
+					      modulus, mp);
+		if (!err)
+			err = comb_add_column(lutB, kbB, kb_len, col, C, T, ma,
+					      modulus, mp);
+	}
+	if (!err)
+		err = get_point(lut_point(lutA, COMB_POINTS),
+				lutA->coord_len, T);
+	if (!err)
+		err = ltc_mp.ecc_ptadd(C, T, C, ma, modulus, mp);
+	if (!err)
+		err = get_point(lut_point(lutB, COMB_POINTS),
+				lutB->coord_len, T);
+	if (!err)
+		err = ltc_mp.ecc_ptadd(C, T, C, ma, modulus, mp);
+	if (!err)
+		err = ltc_ecc_map(C, modulus, mp);
+
+out:
+	ltc_ecc_del_point(T);
+	if (lutA)
+		comb_release(lutA);
+	if (lutB)
+		comb_release(lutB);
+	mont_free(mp, mu, NULL);
+
+	return err;
+
+fallback:
+	if (lutA)
+		comb_release(lutA);
+	if (lutB)
+		comb_release(lutB);
+	mont_free(mp, mu, NULL);
+	if (err)
+		return err;
+
+	return ltc_ecc_mul2add(A, kA, B, kB, C, ma, modulus);
+}
+#endif
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <string.h>
+#include <tomcrypt_private.h>
+#include <trace.h>
+#include <util.h>
+
+/*
+ * Cross-check of the fixed-base combs of CFG_CRYPTO_ECC_COMB with the
+ * generic scalar multiplications for the scalars 0, 1, n - 1 and a few
+ * random ones.
+ */
+
+#define COMB_TEST_RANDOM	4
+
+#ifdef LTC_MECC_COMB
+static const char * const comb_test_curves[] = {
+	"SECP256R1", "SECP384R1", "SECP521R1",
+};
+
+/* Returns CRYPT_OK if the comb and ltc_ecc_mulmod() agree on k * G */
+static int comb_test_scalar(void *k, ecc_key *key, ecc_point *R1,
+			    ecc_point *R2)
+{
+	int err = CRYPT_OK;
+
+	err = ltc_ecc_comb_mulmod(k, &key->dp.base, R1, key->dp.A,
+				  key->dp.prime, 1);
+	if (err)
+		return err;
+
+	/* The ladder expects k != 0, 0 * G is the mapped point at infinity */
+	if (mp_iszero(k))
+		err = ltc_ecc_set_point_xyz(0, 0, 1, R2);
+	else
+		err = ltc_ecc_mulmod(k, &key->dp.base, R2, key->dp.A,
+				     key->dp.prime, 1);
+	if (err)
+		return err;
+
+	if (mp_cmp(R1->x, R2->x) != LTC_MP_EQ ||
+	    mp_cmp(R1->y, R2->y) != LTC_MP_EQ ||
+	    mp_cmp(R1->z, R2->z) != LTC_MP_EQ)
+		return CRYPT_ERROR;
+
+	return CRYPT_OK;
+}
+
+static int comb_test_rand(void *k, void *order)
+{
+	uint8_t buf[ROUNDUP(LTC_MAX_ECC, 8) / 8] = { };
+	size_t sz = mp_unsigned_bin_size(order);
+	int err = CRYPT_OK;
+
+	if (crypto_rng_read(buf, sz))
+		return CRYPT_ERROR_READPRNG;
+
+	err = mp_read_unsigned_bin(k, buf, sz);
+	if (!err)
+		err = mp_mod(k, order, k);
+
+	return err;
+}
+
+static int comb_test_curve(const char *name)
+{
+	const ltc_ecc_curve *cu = NULL;
+	ecc_point *R1 = NULL;
+	ecc_point *R2 = NULL;
+	ecc_key key = { };
+	void *k = NULL;
+	size_t n = 0;
+	int err = CRYPT_OK;
+
+	err = ecc_find_curve(name, &cu);
+	if (err)
+		return err;
+	err = ecc_set_curve(cu, &key);
+	if (err)
+		return err;
+
+	R1 = ltc_ecc_new_point();
+	R2 = ltc_ecc_new_point();
+	if (!R1 || !R2) {
+		err = CRYPT_MEM;
+		goto out;
+	}
+	err = mp_init(&k);
+	if (err)
+		goto out;
+
+	/*
+	 * The table of G is built by its second multiplication, this first
+	 * one makes all the scalars below go through the comb.
+	 */
+	err = mp_set(k, 1);
+	if (!err)
+		err = ltc_ecc_comb_mulmod(k, &key.dp.base, R1, key.dp.A,
+					  key.dp.prime, 1);
+
+	for (n = 0; !err && n < 3 + COMB_TEST_RANDOM; n++) {
+		if (n == 0)
+			err = mp_set(k, 0);
+		else if (n == 1)
+			err = mp_set(k, 1);
+		else if (n == 2)
+			err = mp_sub_d(key.dp.order, 1, k);
+		else
+			err = comb_test_rand(k, key.dp.order);
+		if (!err)
+			err = comb_test_scalar(k, &key, R1, R2);
+		if (err)
+			EMSG("%s comb mismatch for scalar %zu", name, n);
+	}
+
+	mp_clear(k);
+out:
+	ltc_ecc_del_point(R1);
+	ltc_ecc_del_point(R2);
+	ecc_free(&key);
+
+	return err;
+}
+
+static TEE_Result ecc_comb_self_test(void)
+{
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(comb_test_curves); n++)
+		if (comb_test_curve(comb_test_curves[n]))
+			return TEE_ERROR_GENERIC;
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result ecc_comb_self_test(void)
+{
+	return TEE_SUCCESS;
+}
+#endif /*LTC_MECC_COMB*/
+
+#ifdef LTC_ED25519_COMB
+/* Group order minus one, little endian */
+static const uint8_t ed25519_l_minus_1[32] = {
+	0xec, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58,
+	0xd6, 0x9c, 0xf7, 0xa2, 0xde, 0xf9, 0xde, 0x14,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+	0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10,
+};
+
+static TEE_Result ed25519_comb_self_test(void)
+{
+	uint8_t s[32] = { };
+	size_t n = 0;
+
+	for (n = 0; n < 3 + COMB_TEST_RANDOM; n++) {
+		memset(s, 0, sizeof(s));
+		if (n == 1)
+			s[0] = 1;
+		else if (n == 2)
+			memcpy(s, ed25519_l_minus_1, sizeof(s));
+		else if (n > 2 && crypto_rng_read(s, sizeof(s)))
+			return TEE_ERROR_GENERIC;
+
+		if (tweetnacl_crypto_comb_check(s)) {
+			EMSG("Ed25519 comb mismatch for scalar %zu", n);
+			return TEE_ERROR_GENERIC;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+#else
+static TEE_Result ed25519_comb_self_test(void)
+{
+	return TEE_SUCCESS;
+}
+#endif /*LTC_ED25519_COMB*/
+
+TEE_Result crypto_ecc_comb_self_test(void)
+{
+	TEE_Result res = ecc_comb_self_test();
+
+	if (!res)
+		res = ed25519_comb_self_test();
+
+	return res;
+}
@@ -679,8 +679,10 @@ ltc_math_descriptor ltc_mp = {
 	.isprime = isprime,
 
 #ifdef LTC_MECC
-#ifdef LTC_MECC_FP
+#if defined(LTC_MECC_FP)
 	.ecc_ptmul = ltc_ecc_fp_mulmod,
+#elif defined(LTC_MECC_COMB)
+	.ecc_ptmul = ltc_ecc_comb_mulmod,
 #else
 	.ecc_ptmul = ltc_ecc_mulmod,
 #endif /* LTC_MECC_FP */
@@ -688,8 +690,10 @@ ltc_math_descriptor ltc_mp = {
 	.ecc_ptdbl = ltc_ecc_projective_dbl_point,
 	.ecc_map = ltc_ecc_map,
 #ifdef LTC_ECC_SHAMIR
-#ifdef LTC_MECC_FP
+#if defined(LTC_MECC_FP)
 	.ecc_mul2add = ltc_ecc_fp_mul2add,
+#elif defined(LTC_MECC_COMB)
+	.ecc_mul2add = ltc_ecc_comb_mul2add,
 #else
 	.ecc_mul2add = ltc_ecc_mul2add,
 #endif /* LTC_MECC_FP */
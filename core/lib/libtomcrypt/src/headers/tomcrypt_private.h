@@ -326,6 +326,11 @@ void ltc_ecc_fp_tablelock(int lock);
 /* R = kG */
 int ltc_ecc_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a, void *modulus, int map);
 
+#if defined(LTC_MECC_COMB)
+/* R = kG with a cached fixed-base comb table of G */
+int ltc_ecc_comb_mulmod(void *k, const ecc_point *G, ecc_point *R, void *a, void *modulus, int map);
+#endif
+
 #ifdef LTC_ECC_SHAMIR
 /* kA*A + kB*B = C */
 int ltc_ecc_mul2add(const ecc_point *A, void *kA,
@@ -334,6 +339,15 @@ int ltc_ecc_mul2add(const ecc_point *A, void *kA,
                                void *ma,
                                void *modulus);
 
+#ifdef LTC_MECC_COMB
+/* kA*A + kB*B = C with cached fixed-base comb tables of A and B */
+int ltc_ecc_comb_mul2add(const ecc_point *A, void *kA,
+                         const ecc_point *B, void *kB,
+                               ecc_point *C,
+                                    void *ma,
+                                    void *modulus);
+#endif
+
 #ifdef LTC_MECC_FP
 /* Shamir's trick with optimized point multiplication using fixed point cache */
 int ltc_ecc_fp_mul2add(const ecc_point *A, void *kA,
@@ -375,6 +389,9 @@ int tweetnacl_crypto_sk_to_pk(unsigned char *pk, const unsigned char *sk);
 int tweetnacl_crypto_scalarmult(unsigned char *q, const unsigned char *n, const unsigned char *p);
 int tweetnacl_crypto_scalarmult_base(unsigned char *q,const unsigned char *n);
 int tweetnacl_crypto_ph(unsigned char *out, const unsigned char *msg, unsigned long long msglen);
+#ifdef LTC_ED25519_COMB
+int tweetnacl_crypto_comb_check(const unsigned char *s);
+#endif
 
 typedef int (*sk_to_pk)(unsigned char *pk ,const unsigned char *sk);
 int ec25519_import_pkcs8(const unsigned char *in, unsigned long inlen,
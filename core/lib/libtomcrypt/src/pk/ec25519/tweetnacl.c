@@ -21,9 +21,12 @@ static const gf
   gf121665 = {0xDB41,1},
   D = {0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070, 0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203},
   D2 = {0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0, 0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406},
-  X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
-  Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
   I = {0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43, 0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83};
+#ifndef LTC_ED25519_COMB
+static const gf
+  X = {0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
+  Y = {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666};
+#endif
 
 static int vn(const u8 *x,const u8 *y,int n)
 {
@@ -297,6 +300,94 @@ sv scalarmult(gf p[4],gf q[4],const u8 *s)
   }
 }
 
+#ifdef LTC_ED25519_COMB
+/*
+ * Fixed-base comb of width 4 and spacing 64: comb_base[n] is the sum of the
+ * 2^(64 * j) * B for the bits j set in n, as affine (x, y, x * y).
+ */
+static const gf comb_base[16][3] = {
+  {{0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+   {0x0001, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000},
+   {0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000, 0x0000}},
+  {{0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c, 0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169},
+   {0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666},
+   {0xdda3, 0xa5b7, 0x8ab3, 0x6dde, 0x52f5, 0x7751, 0x9f80, 0x20f0, 0xe37d, 0x64ab, 0x4e8e, 0x66ea, 0x7665, 0xd78b, 0x5f0f, 0x6787}},
+  {{0xa202, 0xf4ed, 0x6b8f, 0x3e0b, 0x35eb, 0xd51a, 0xdb7e, 0x0078, 0x8a96, 0xb4a0, 0x60cf, 0xd44b, 0xf9d5, 0xbf2d, 0xbd88, 0x6222},
+   {0x5313, 0x82e4, 0xfa57, 0x8f1e, 0x2b06, 0xba90, 0xb608, 0x5410, 0x7c4f, 0x261b, 0xdaed, 0xdd6b, 0xd025, 0xea4e, 0xbb42, 0x0325},
+   {0x0859, 0xb674, 0x92e9, 0x2dfd, 0xbf86, 0x9cc4, 0xbe0e, 0x3b0a, 0x4560, 0x4009, 0x80e6, 0xc799, 0xae0a, 0xc7d3, 0x09e2, 0x628b}},
+  {{0xfba2, 0x61cc, 0x0667, 0x1a70, 0x78c4, 0xff3a, 0x6232, 0x2cdd, 0x50ab, 0x3b19, 0x9bf2, 0xb87d, 0x4ffd, 0x9c29, 0x91a7, 0x0eba},
+   {0x5e46, 0xfe51, 0xbf1d, 0xe5e5, 0x959b, 0x670d, 0xd1f8, 0x5ab5, 0x93a1, 0xc32c, 0x0ede, 0x8597, 0x7f2d, 0xabea, 0x473e, 0x1830},
+   {0xfb70, 0x82df, 0x46f6, 0xfdd3, 0x32b5, 0x3ffd, 0x0996, 0x69a1, 0x2525, 0xa211, 0xb8d9, 0x0752, 0x0af3, 0xce40, 0x1113, 0x38cd}},
+  {{0xe824, 0x60b7, 0x47ae, 0xfc80, 0x23e5, 0xc2e7, 0x85c9, 0x98e6, 0x29a0, 0xe14e, 0x3984, 0x952d, 0xf32c, 0x3c45, 0xafff, 0x4c27},
+   {0xa66b, 0x4bf5, 0xbd11, 0x5bba, 0xc49e, 0x51a4, 0xbe1e, 0x90d0, 0x9c3a, 0x26c2, 0x1eb6, 0x95f1, 0xc87d, 0x526d, 0x99e6, 0x5f2c},
+   {0x338a, 0x46f1, 0x31c9, 0xe9e7, 0xada9, 0x6663, 0x6482, 0x1478, 0x4b6a, 0x0792, 0x5600, 0xd4e1, 0x602f, 0x0bf4, 0x64fd, 0x05a1}},
+  {{0x969a, 0x680c, 0xfd29, 0xfbe2, 0xbce6, 0x31ec, 0xec08, 0xb0e6, 0x6053, 0x8cc3, 0xc1be, 0x8ab3, 0xe48f, 0x2b88, 0xe555, 0x6e64},
+   {0xd09b, 0x7baf, 0x2a64, 0x2535, 0x5210, 0x9ec5, 0x1158, 0x3639, 0x5145, 0x39b8, 0xfc93, 0x6a9d, 0x58be, 0xa4cb, 0x510f, 0x383c},
+   {0x83a9, 0x8146, 0xb0bc, 0xa138, 0x8d60, 0x783b, 0x5278, 0x43fe, 0x3591, 0xa9b9, 0x2eb8, 0x57bf, 0xd8f9, 0x5104, 0x61f8, 0x475c}},
+  {{0xca05, 0x43ab, 0x0e63, 0x8bf3, 0xa641, 0x9bf8, 0x7053, 0x5380, 0x5e86, 0xe38f, 0x0dc3, 0xc818, 0x344b, 0xd81f, 0xbc1d, 0x6df2},
+   {0x3a34, 0xdfbe, 0xf6d9, 0x89f3, 0xe1a1, 0x9f94, 0x4c5d, 0xe95d, 0x49a1, 0xef92, 0x530e, 0x8981, 0x8758, 0x37a6, 0xddf1, 0x6062},
+   {0xf8b2, 0x5a25, 0xd87b, 0x93ce, 0xfc92, 0xd848, 0x88d0, 0xf7e5, 0x19ec, 0xbef7, 0x70e8, 0xe6d7, 0xcb8a, 0x25b2, 0x0226, 0x507c}},
+  {{0x5a63, 0x1b9d, 0xc68c, 0x527d, 0x70ea, 0x6a09, 0x32e1, 0x73f3, 0x1f21, 0x7b07, 0x9b7c, 0xd849, 0xf3c0, 0x7225, 0x9d6f, 0x31ed},
+   {0x3667, 0x5436, 0x9240, 0xe671, 0x2811, 0xad11, 0x3293, 0x7b85, 0xb73e, 0x493b, 0x1c13, 0xb007, 0x932e, 0xfdaa, 0x28fd, 0x3d47},
+   {0xfb39, 0x2865, 0xcdde, 0x703b, 0x4232, 0xe8f4, 0x4737, 0x0f57, 0x8fb7, 0x0baf, 0x85c5, 0xc1b4, 0xa5c4, 0x8e2e, 0x2baf, 0x4e60}},
+  {{0xd28d, 0xc7da, 0xd644, 0xdb7a, 0x7d26, 0xb81d, 0xdee1, 0x7a9d, 0x177d, 0x1c7e, 0x0437, 0x2d8d, 0x5e7c, 0x3818, 0xaf1e, 0x1bc7},
+   {0x4833, 0x0031, 0xf659, 0xcaf2, 0x270f, 0x631b, 0x7e12, 0x1d02, 0xc049, 0x795d, 0xef87, 0x7a5e, 0x1f2f, 0x5566, 0x09d8, 0x61d9},
+   {0xc2c7, 0x6636, 0x4521, 0x51b8, 0x7ef8, 0x56de, 0xf236, 0x9bb8, 0x0fbd, 0x4b1f, 0x64de, 0xccb6, 0xfa44, 0x54b8, 0x0b80, 0x1a34}},
+  {{0x6838, 0x07b0, 0xfca3, 0x85cc, 0x7f10, 0x654c, 0xb365, 0xfafa, 0x53a5, 0xdb6f, 0x4c74, 0x4656, 0xe203, 0x7ad5, 0x1c29, 0x02c6},
+   {0x59bc, 0x04f2, 0x6375, 0x84c0, 0x602f, 0x671c, 0xfd76, 0x8663, 0xfaf3, 0xdcbf, 0x2dd2, 0x9190, 0x33bd, 0xe5a9, 0x0c66, 0x42da},
+   {0xd525, 0x0c62, 0x9d3a, 0x10a3, 0x1ca4, 0xd20a, 0x8620, 0x18da, 0x4f1c, 0x61e1, 0xe5bd, 0x3775, 0x7a47, 0xfe2a, 0xb139, 0x1000}},
+  {{0xca27, 0x66f4, 0xecc2, 0x1492, 0x0657, 0xd063, 0x154d, 0xeb06, 0x5869, 0x774f, 0x8bc5, 0xf0c7, 0xed8e, 0xa064, 0x3cb3, 0x7166},
+   {0x2dc6, 0x0ada, 0xfe0d, 0x2770, 0xf864, 0xfa27, 0x5ff6, 0xa530, 0x6c0d, 0xf2da, 0x5e62, 0x4778, 0x66d3, 0x1c00, 0x56fd, 0x5d1f},
+   {0x46f5, 0x8572, 0x6b49, 0x5daa, 0x5fb7, 0x35dc, 0xf373, 0xbbed, 0x41f9, 0xbc09, 0x84e6, 0x6fe3, 0xa2ec, 0xda39, 0x664d, 0x496c}},
+  {{0x6f3f, 0x4cf4, 0xfdd8, 0x270e, 0x5cc9, 0xbc2b, 0xa4c0, 0x23e7, 0x0229, 0x319f, 0xe9d6, 0x96d7, 0xe0f4, 0x0b5e, 0x130e, 0x3cee},
+   {0xed09, 0x3df2, 0x9176, 0xa4c3, 0xae97, 0x87d4, 0x5dd0, 0x18f6, 0x1f47, 0x671d, 0xcff2, 0xa063, 0x2791, 0x93f8, 0x7545, 0x3f23},
+   {0x2898, 0x7c93, 0x4393, 0x8a14, 0x5b2b, 0x8014, 0xf6c5, 0xe368, 0xe6e9, 0x2ce7, 0x5bc6, 0x437f, 0x3f9a, 0x391c, 0xf66c, 0x7508}},
+  {{0xf1d1, 0x23ad, 0x64dd, 0x9693, 0x7041, 0xf77f, 0xa9f5, 0xa289, 0xb034, 0x1b8d, 0x19ae, 0x4915, 0x2358, 0x876d, 0x4f15, 0x7681},
+   {0x23fb, 0xeab5, 0xaccf, 0x8d54, 0x424e, 0xeb2f, 0x630f, 0x68db, 0xa837, 0x8bcf, 0xf5ab, 0x6ea4, 0x2a96, 0xd6b2, 0x9ebe, 0x0dbd},
+   {0x3b75, 0xfdc5, 0x4939, 0x7caf, 0x9cf1, 0xd493, 0x2ad4, 0x7495, 0x3432, 0x8e61, 0x8937, 0x231c, 0x018e, 0x4d47, 0xe5a8, 0x3e24}},
+  {{0x42b4, 0xcfa9, 0x8301, 0x178a, 0x7647, 0xc6c4, 0x0483, 0x0b95, 0x11fc, 0x62c9, 0x0cb8, 0x8476, 0xb9d9, 0xfa37, 0x7cfc, 0x6dc2},
+   {0x3e58, 0x04b3, 0x8cbb, 0x488f, 0x91bc, 0xcc27, 0xb7f9, 0x1922, 0x2e83, 0xb509, 0xd972, 0x1c54, 0xa14d, 0x0bea, 0xc6f1, 0x7208},
+   {0x0b6b, 0x40a2, 0x8eda, 0xf694, 0x5500, 0x1442, 0x862f, 0xb877, 0x1f1b, 0x68da, 0x21d8, 0x88ad, 0x33fa, 0x31eb, 0x37c1, 0x56bc}},
+  {{0x8746, 0x6e7a, 0x5680, 0x8a0a, 0xddc0, 0x6b11, 0xddd6, 0xdf47, 0xd910, 0xead8, 0xb07c, 0x038f, 0x2e00, 0x8fc1, 0xa844, 0x30d3},
+   {0x8906, 0xf9a2, 0xad34, 0x03dc, 0xed85, 0xa751, 0x9c82, 0x5de7, 0x9352, 0x320c, 0x5b9a, 0xaae1, 0xb8ca, 0x6d02, 0xd43a, 0x3ab1},
+   {0x0106, 0x6d08, 0x1c4b, 0x53d9, 0xc291, 0x5505, 0xe8ad, 0x2deb, 0x1164, 0x1180, 0xd793, 0x3840, 0xf111, 0x8206, 0xd2cb, 0x4ee2}},
+  {{0x5ff0, 0xb5be, 0x100d, 0x386b, 0xac32, 0x8076, 0xcabd, 0x7194, 0xf27a, 0x35c9, 0xde2a, 0x429f, 0x1849, 0xab01, 0xefbc, 0x647c},
+   {0x583f, 0x923d, 0xdb59, 0xdb13, 0x6e58, 0xe00a, 0x91b7, 0x084a, 0xd620, 0x3c2e, 0xc945, 0x178b, 0xe779, 0x90c7, 0x3a99, 0x2518},
+   {0x9fef, 0xd8ec, 0x43d9, 0x7889, 0x27a2, 0x054b, 0x7d3b, 0x30c2, 0x621a, 0x5318, 0x47b9, 0xf891, 0x090a, 0x5f4c, 0xe27a, 0x0410}}
+};
+
+sv scalarbase(gf p[4],const u8 *s)
+{
+  gf q[4];
+  i64 m;
+  int i,j,l;
+  u8 b;
+
+  set25519(p[0],gf0);
+  set25519(p[1],gf1);
+  set25519(p[2],gf1);
+  set25519(p[3],gf0);
+  set25519(q[2],gf1);
+  for (i = 63;i >= 0;--i) {
+    b = 0;
+    FOR(j,4) b |= ((s[(i+64*j)/8]>>(i&7))&1) << j;
+    /* read all entries so the index isn't leaked */
+    set25519(q[0],gf0);
+    set25519(q[1],gf0);
+    set25519(q[3],gf0);
+    FOR(j,16) {
+      m = -(i64)(((u32)(j^b) - 1) >> 31);
+      FOR(l,16) {
+        q[0][l] |= comb_base[j][0][l] & m;
+        q[1][l] |= comb_base[j][1][l] & m;
+        q[3][l] |= comb_base[j][2][l] & m;
+      }
+    }
+    add(p,p);
+    add(p,q);
+  }
+}
+#else
 sv scalarbase(gf p[4],const u8 *s)
 {
   gf q[4];
@@ -306,6 +397,26 @@ sv scalarbase(gf p[4],const u8 *s)
   M(q[3],X,Y);
   scalarmult(p,q,s);
 }
+#endif
+
+#ifdef LTC_ED25519_COMB
+/* Returns 0 if the comb and the generic ladder agree on s * B */
+int tweetnacl_crypto_comb_check(const u8 *s)
+{
+  gf p[4], q[4], b[4];
+  u8 r[32], t[32];
+
+  scalarbase(p,s);
+  set25519(b[0],comb_base[1][0]);
+  set25519(b[1],comb_base[1][1]);
+  set25519(b[2],gf1);
+  set25519(b[3],comb_base[1][2]);
+  scalarmult(q,b,s);
+  pack(r,p);
+  pack(t,q);
+  return tweetnacl_crypto_verify_32(r,t);
+}
+#endif
 
 int tweetnacl_crypto_sk_to_pk(u8 *pk, const u8 *sk)
 {
@@ -101,6 +101,9 @@ ifeq ($(_CFG_CORE_LTC_ECC),y)
 
    # ECC 521 bits is the max supported key size
    cppflags-lib-y += -DLTC_MAX_ECC=521
+
+   # fixed-base comb tables for repeatedly multiplied points
+   cppflags-lib-$(_CFG_CORE_LTC_ECC_COMB) += -DLTC_MECC_COMB
 endif
 ifneq (,$(filter y,$(_CFG_CORE_LTC_SM2_DSA) $(_CFG_CORE_LTC_SM2_PKE)))
    cppflags-lib-y += -DLTC_ECC_SM2
@@ -108,6 +111,9 @@ endif
 
 cppflags-lib-$(_CFG_CORE_LTC_X25519) += -DLTC_CURVE25519
 cppflags-lib-$(_CFG_CORE_LTC_ED25519) += -DLTC_CURVE25519
+ifeq ($(_CFG_CORE_LTC_ED25519),y)
+cppflags-lib-$(_CFG_CORE_LTC_ECC_COMB) += -DLTC_ED25519_COMB
+endif
 
 cppflags-lib-y += -DLTC_NO_PRNGS -DLTC_FORTUNA
 
@@ -126,6 +132,10 @@ srcs-$(_CFG_CORE_LTC_CCM) += ccm.c
 srcs-$(_CFG_CORE_LTC_GCM) += gcm.c
 srcs-$(_CFG_CORE_LTC_DSA) += dsa.c
 srcs-$(_CFG_CORE_LTC_ECC) += ecc.c
+ifeq ($(_CFG_CORE_LTC_ECC),y)
+srcs-$(_CFG_CORE_LTC_ECC_COMB) += ecc_comb.c
+endif
+srcs-$(_CFG_CORE_LTC_ECC_COMB) += ecc_comb_test.c
 srcs-$(_CFG_CORE_LTC_RSA) += rsa.c
 srcs-$(_CFG_CORE_LTC_DH) += dh.c
 srcs-$(_CFG_CORE_LTC_AES) += aes.c
@@ -20,14 +20,6 @@ static void *pmalloc(tee_mm_pool_t *pool, size_t size)
 		return malloc(size);
 }
 
-static void *pcalloc(tee_mm_pool_t *pool, size_t num_el, size_t size)
-{
-	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
-		return nex_calloc(num_el, size);
-	else
-		return calloc(num_el, size);
-}
-
 static void pfree(tee_mm_pool_t *pool, void *ptr)
 {
 	if (pool->flags & TEE_MM_POOL_NEX_MALLOC)
@@ -51,60 +43,301 @@ bool tee_mm_init(tee_mm_pool_t *pool, paddr_t lo, paddr_size_t size,
 
 	assert(((uint64_t)size >> shift) < (uint64_t)UINT32_MAX);
 
-	pool->lo = lo;
-	pool->size = size;
-	pool->shift = shift;
-	pool->flags = flags;
-	pool->entry = pcalloc(pool, 1, sizeof(tee_mm_entry_t));
-
-	if (pool->entry == NULL)
-		return false;
-
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		pool->entry->offset = ((size - 1) >> shift) + 1;
-
-	pool->entry->pool = pool;
-	pool->lock = SPINLOCK_UNLOCK;
+	*pool = (tee_mm_pool_t){
+		.lo = lo,
+		.size = size,
+		.shift = shift,
+		.flags = flags,
+		.initialized = true,
+		.lock = SPINLOCK_UNLOCK,
+	};
 
 	return true;
 }
 
 void tee_mm_final(tee_mm_pool_t *pool)
 {
-	if (pool == NULL || pool->entry == NULL)
+	if (pool == NULL || !pool->initialized)
 		return;
 
-	while (pool->entry->next != NULL)
-		tee_mm_free(pool->entry->next);
-	pfree(pool, pool->entry);
-	pool->entry = NULL;
+	while (pool->root)
+		tee_mm_free(pool->root);
+	pool->initialized = false;
 }
 
-static void tee_mm_add(tee_mm_entry_t *p, tee_mm_entry_t *nn)
+static uint32_t pool_blocks(tee_mm_pool_t *pool)
 {
-	/* add to list */
-	nn->next = p->next;
-	p->next = nn;
+	return pool->size >> pool->shift;
 }
 
-#ifdef CFG_WITH_STATS
-static size_t tee_mm_stats_allocated(tee_mm_pool_t *pool)
+static uint32_t entry_end(tee_mm_entry_t *e)
 {
-	tee_mm_entry_t *entry;
-	uint32_t sz = 0;
+	return e->offset + e->size;
+}
 
-	if (!pool)
-		return 0;
+/*
+ * Orders entries by offset. Zero sized entries may share the offset of
+ * another entry, they sort before it so that a lookup by offset lands on
+ * the entry actually covering it. Any remaining tie is broken by address
+ * to give every entry a unique position in the tree.
+ */
+static int entry_cmp(tee_mm_entry_t *a, tee_mm_entry_t *b)
+{
+	if (a->offset != b->offset)
+		return a->offset < b->offset ? -1 : 1;
+	if (a->size != b->size)
+		return a->size < b->size ? -1 : 1;
+	if (a != b)
+		return (vaddr_t)a < (vaddr_t)b ? -1 : 1;
+	return 0;
+}
+
+static uint8_t node_height(tee_mm_entry_t *e)
+{
+	return e ? e->height : 0;
+}
+
+static void node_update(tee_mm_entry_t *e)
+{
+	e->height = MAX(node_height(e->left), node_height(e->right)) + 1;
+	e->max_gap = e->gap;
+	if (e->left)
+		e->max_gap = MAX(e->max_gap, e->left->max_gap);
+	if (e->right)
+		e->max_gap = MAX(e->max_gap, e->right->max_gap);
+}
+
+static tee_mm_entry_t *rotate_left(tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *r = e->right;
+
+	e->right = r->left;
+	r->left = e;
+	node_update(e);
+	node_update(r);
+
+	return r;
+}
+
+static tee_mm_entry_t *rotate_right(tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *l = e->left;
+
+	e->left = l->right;
+	l->right = e;
+	node_update(e);
+	node_update(l);
+
+	return l;
+}
+
+static tee_mm_entry_t *node_balance(tee_mm_entry_t *e)
+{
+	int bf = node_height(e->left) - node_height(e->right);
+
+	node_update(e);
+
+	if (bf > 1) {
+		if (node_height(e->left->left) < node_height(e->left->right))
+			e->left = rotate_left(e->left);
+		return rotate_right(e);
+	}
+	if (bf < -1) {
+		if (node_height(e->right->right) < node_height(e->right->left))
+			e->right = rotate_right(e->right);
+		return rotate_left(e);
+	}
+
+	return e;
+}
+
+static tee_mm_entry_t *tree_insert(tee_mm_entry_t *t, tee_mm_entry_t *e)
+{
+	if (!t) {
+		e->left = NULL;
+		e->right = NULL;
+		node_update(e);
+		return e;
+	}
+
+	if (entry_cmp(e, t) < 0)
+		t->left = tree_insert(t->left, e);
+	else
+		t->right = tree_insert(t->right, e);
+
+	return node_balance(t);
+}
+
+static tee_mm_entry_t *tree_remove_min(tee_mm_entry_t *t,
+				       tee_mm_entry_t **min)
+{
+	if (!t->left) {
+		*min = t;
+		return t->right;
+	}
+
+	t->left = tree_remove_min(t->left, min);
+
+	return node_balance(t);
+}
+
+static tee_mm_entry_t *tree_remove(tee_mm_entry_t *t, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *min = NULL;
+	int c = 0;
+
+	if (!t)
+		panic("invalid mm_entry");
+
+	c = entry_cmp(e, t);
+	if (c < 0) {
+		t->left = tree_remove(t->left, e);
+	} else if (c > 0) {
+		t->right = tree_remove(t->right, e);
+	} else {
+		if (!t->left || !t->right) {
+			t = t->left ? t->left : t->right;
+			if (t)
+				node_update(t);
+			return t;
+		}
+
+		t->right = tree_remove_min(t->right, &min);
+		min->left = t->left;
+		min->right = t->right;
+		t = min;
+	}
+
+	return node_balance(t);
+}
+
+/*
+ * Finds the neighbours @e would have in the tree, @e itself may or may
+ * not be in the tree already.
+ */
+static void find_neighbours(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+			    tee_mm_entry_t **prev, tee_mm_entry_t **next)
+{
+	tee_mm_entry_t *t = pool->root;
+	int c = 0;
+
+	*prev = NULL;
+	*next = NULL;
+
+	while (t) {
+		c = entry_cmp(e, t);
+		if (c < 0) {
+			*next = t;
+			t = t->left;
+		} else if (c > 0) {
+			*prev = t;
+			t = t->right;
+		} else {
+			break;
+		}
+	}
+
+	if (t) {
+		for (t = t->left; t; t = t->right)
+			*prev = t;
+		for (t = e->right; t; t = t->left)
+			*next = t;
+	}
+}
+
+static tee_mm_entry_t *last_entry(tee_mm_pool_t *pool)
+{
+	tee_mm_entry_t *t = pool->root;
+
+	while (t && t->right)
+		t = t->right;
+
+	return t;
+}
+
+static uint32_t tail_gap(tee_mm_pool_t *pool)
+{
+	tee_mm_entry_t *last = last_entry(pool);
+
+	if (!last)
+		return pool_blocks(pool);
+	return pool_blocks(pool) - entry_end(last);
+}
+
+/* Returns the lowest entry preceded by a gap of at least @psize */
+static tee_mm_entry_t *find_gap_lo(tee_mm_pool_t *pool, uint32_t psize)
+{
+	tee_mm_entry_t *t = pool->root;
 
-	entry = pool->entry;
-	while (entry) {
-		sz += entry->size;
-		entry = entry->next;
+	if (!t || t->max_gap < psize)
+		return NULL;
+
+	while (true) {
+		if (t->left && t->left->max_gap >= psize)
+			t = t->left;
+		else if (t->gap >= psize)
+			return t;
+		else
+			t = t->right;
 	}
+}
+
+/* Returns the highest entry preceded by a gap of at least @psize */
+static tee_mm_entry_t *find_gap_hi(tee_mm_pool_t *pool, uint32_t psize)
+{
+	tee_mm_entry_t *t = pool->root;
+
+	if (!t || t->max_gap < psize)
+		return NULL;
+
+	while (true) {
+		if (t->right && t->right->max_gap >= psize)
+			t = t->right;
+		else if (t->gap >= psize)
+			return t;
+		else
+			t = t->left;
+	}
+}
+
+/* Inserts @e, which must fit between its neighbours, and updates gaps */
+static void tee_mm_add(tee_mm_pool_t *pool, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *prev = NULL;
+	tee_mm_entry_t *next = NULL;
+
+	e->left = NULL;
+	e->right = NULL;
+	find_neighbours(pool, e, &prev, &next);
+
+	e->gap = e->offset;
+	if (prev)
+		e->gap -= entry_end(prev);
+	/* @next is on the insertion path, so its max_gap is updated below */
+	if (next)
+		next->gap = next->offset - entry_end(e);
+
+	pool->root = tree_insert(pool->root, e);
+}
+
+static void tee_mm_del(tee_mm_pool_t *pool, tee_mm_entry_t *e)
+{
+	tee_mm_entry_t *prev = NULL;
+	tee_mm_entry_t *next = NULL;
 
-	return sz << pool->shift;
+	find_neighbours(pool, e, &prev, &next);
+
+	/*
+	 * @next is either an ancestor of @e or the leftmost entry of its
+	 * right subtree, in both cases tree_remove() updates its max_gap.
+	 */
+	if (next)
+		next->gap += e->gap + e->size;
+
+	pool->root = tree_remove(pool->root, e);
 }
 
+#ifdef CFG_WITH_STATS
 void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 			   bool reset)
 {
@@ -118,23 +351,29 @@ void tee_mm_get_pool_stats(tee_mm_pool_t *pool, struct pta_stats_alloc *stats,
 	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
 	stats->size = pool->size;
-	stats->max_allocated = pool->max_allocated;
-	stats->allocated = tee_mm_stats_allocated(pool);
+	stats->max_allocated = pool->max_allocated << pool->shift;
+	stats->allocated = pool->allocated << pool->shift;
 
 	if (reset)
 		pool->max_allocated = 0;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 }
 
-static void update_max_allocated(tee_mm_pool_t *pool)
+static void update_allocated(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+			     bool added)
 {
-	size_t sz = tee_mm_stats_allocated(pool);
-
-	if (sz > pool->max_allocated)
-		pool->max_allocated = sz;
+	if (added) {
+		pool->allocated += e->size;
+		if (pool->allocated > pool->max_allocated)
+			pool->max_allocated = pool->allocated;
+	} else {
+		pool->allocated -= e->size;
+	}
 }
 #else /* CFG_WITH_STATS */
-static inline void update_max_allocated(tee_mm_pool_t *pool __unused)
+static inline void update_allocated(tee_mm_pool_t *pool __unused,
+				    tee_mm_entry_t *e __unused,
+				    bool added __unused)
 {
 }
 #endif /* CFG_WITH_STATS */
@@ -144,78 +383,63 @@ tee_mm_entry_t *tee_mm_alloc(tee_mm_pool_t *pool, size_t size)
 	size_t psize;
 	tee_mm_entry_t *entry;
 	tee_mm_entry_t *nn;
-	size_t remaining;
+	uint32_t tail;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool || !pool->initialized)
 		return NULL;
 
-	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
-	if (!nn)
-		return NULL;
-
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
+	if (!pool->size && !(pool->flags & TEE_MM_POOL_HI_ALLOC))
+		panic("invalid pool");
 
-	entry = pool->entry;
 	if (!size)
 		psize = 0;
 	else
 		psize = ((size - 1) >> pool->shift) + 1;
 
-	/* find free slot */
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL && psize >
-		       (entry->offset - entry->next->offset -
-			entry->next->size))
-			entry = entry->next;
-	} else {
-		while (entry->next != NULL && psize >
-		       (entry->next->offset - entry->size - entry->offset))
-			entry = entry->next;
-	}
-
 	/* check if we have enough memory */
-	if (entry->next == NULL) {
-		if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-			/*
-			 * entry->offset is a "block count" offset from
-			 * pool->lo. The byte offset is
-			 * (entry->offset << pool->shift).
-			 * In the HI_ALLOC allocation scheme the memory is
-			 * allocated from the end of the segment, thus to
-			 * validate there is sufficient memory validate that
-			 * (entry->offset << pool->shift) > size.
-			 */
-			if ((entry->offset << pool->shift) < size) {
-				/* out of memory */
-				goto err;
-			}
-		} else {
-			if (!pool->size)
-				panic("invalid pool");
+	if (psize > pool_blocks(pool))
+		return NULL;
+
+	nn = pmalloc(pool, sizeof(tee_mm_entry_t));
+	if (!nn)
+		return NULL;
 
-			remaining = pool->size;
-			remaining -= ((entry->offset + entry->size) <<
-				      pool->shift);
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
-			if (remaining < size) {
-				/* out of memory */
-				goto err;
-			}
+	/*
+	 * Find a free slot. Without TEE_MM_POOL_HI_ALLOC the lowest gap
+	 * that fits is used and the entry is placed at its start, with
+	 * TEE_MM_POOL_HI_ALLOC the highest one is used and the entry is
+	 * placed at its end. The gap between the last entry and the end of
+	 * the pool isn't stored in the tree so it's checked separately.
+	 */
+	tail = tail_gap(pool);
+	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
+		if (tail >= psize) {
+			nn->offset = pool_blocks(pool) - psize;
+		} else {
+			entry = find_gap_hi(pool, psize);
+			if (!entry)
+				goto err; /* out of memory */
+			nn->offset = entry->offset - psize;
+		}
+	} else {
+		entry = find_gap_lo(pool, psize);
+		if (entry) {
+			nn->offset = entry->offset - entry->gap;
+		} else {
+			if (tail < psize)
+				goto err; /* out of memory */
+			nn->offset = pool_blocks(pool) - tail;
 		}
 	}
-
-	tee_mm_add(entry, nn);
-
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC)
-		nn->offset = entry->offset - psize;
-	else
-		nn->offset = entry->offset + entry->size;
 	nn->size = psize;
 	nn->pool = pool;
 
-	update_max_allocated(pool);
+	tee_mm_add(pool, nn);
+	update_allocated(pool, nn, true);
 
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return nn;
@@ -225,74 +449,59 @@ err:
 	return NULL;
 }
 
-static inline bool fit_in_gap(tee_mm_pool_t *pool, tee_mm_entry_t *e,
+static inline bool fit_in_gap(tee_mm_entry_t *prev, tee_mm_entry_t *next,
 			      paddr_t offslo, paddr_t offshi)
 {
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		if (offshi > e->offset ||
-		    (e->next != NULL &&
-		     (offslo < e->next->offset + e->next->size)) ||
-		    (offshi << pool->shift) - 1 > pool->size)
-			/* memory not available */
-			return false;
-	} else {
-		if (offslo < (e->offset + e->size) ||
-		    (e->next != NULL && (offshi > e->next->offset)) ||
-		    (offshi << pool->shift) > pool->size)
-			/* memory not available */
-			return false;
-	}
+	if ((prev && offslo < entry_end(prev)) ||
+	    (next && offshi > next->offset))
+		/* memory not available */
+		return false;
 
 	return true;
 }
 
 tee_mm_entry_t *tee_mm_alloc2(tee_mm_pool_t *pool, paddr_t base, size_t size)
 {
-	tee_mm_entry_t *entry;
+	tee_mm_entry_t *prev;
+	tee_mm_entry_t *next;
 	paddr_t offslo;
 	paddr_t offshi;
 	tee_mm_entry_t *mm;
 	uint32_t exceptions;
 
 	/* Check that pool is initialized */
-	if (!pool || !pool->entry)
+	if (!pool || !pool->initialized)
 		return NULL;
 
 	/* Wrapping and sanity check */
 	if ((base + size) < base || base < pool->lo)
 		return NULL;
 
+	offslo = (base - pool->lo) >> pool->shift;
+	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
+	if (offshi > pool_blocks(pool))
+		return NULL;
+
 	mm = pmalloc(pool, sizeof(tee_mm_entry_t));
 	if (!mm)
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&pool->lock);
-
-	entry = pool->entry;
-	offslo = (base - pool->lo) >> pool->shift;
-	offshi = ((base - pool->lo + size - 1) >> pool->shift) + 1;
+	mm->offset = offslo;
+	mm->size = offshi - offslo;
+	mm->pool = pool;
+	mm->left = NULL;
+	mm->right = NULL;
 
-	/* find slot */
-	if (pool->flags & TEE_MM_POOL_HI_ALLOC) {
-		while (entry->next != NULL &&
-		       offshi < entry->next->offset + entry->next->size)
-			entry = entry->next;
-	} else {
-		while (entry->next != NULL && offslo > entry->next->offset)
-			entry = entry->next;
-	}
+	exceptions = cpu_spin_lock_xsave(&pool->lock);
 
 	/* Check that memory is available */
-	if (!fit_in_gap(pool, entry, offslo, offshi))
+	find_neighbours(pool, mm, &prev, &next);
+	if (!fit_in_gap(prev, next, offslo, offshi))
 		goto err;
 
-	tee_mm_add(entry, mm);
+	tee_mm_add(pool, mm);
+	update_allocated(pool, mm, true);
 
-	mm->offset = offslo;
-	mm->size = offshi - offslo;
-	mm->pool = pool;
-
-	update_max_allocated(pool);
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 	return mm;
 err:
@@ -303,23 +512,14 @@ err:
 
 void tee_mm_free(tee_mm_entry_t *p)
 {
-	tee_mm_entry_t *entry;
 	uint32_t exceptions;
 
 	if (!p || !p->pool)
 		return;
 
 	exceptions = cpu_spin_lock_xsave(&p->pool->lock);
-	entry = p->pool->entry;
-
-	/* remove entry from list */
-	while (entry->next != NULL && entry->next != p)
-		entry = entry->next;
-
-	if (!entry->next)
-		panic("invalid mm_entry");
-
-	entry->next = entry->next->next;
+	tee_mm_del(p->pool, p);
+	update_allocated(p->pool, p, false);
 	cpu_spin_unlock_xrestore(&p->pool->lock, exceptions);
 
 	pfree(p->pool, p);
@@ -344,11 +544,11 @@ bool tee_mm_is_empty(tee_mm_pool_t *pool)
 	bool ret;
 	uint32_t exceptions;
 
-	if (pool == NULL || pool->entry == NULL)
+	if (pool == NULL || !pool->initialized)
 		return true;
 
 	exceptions = cpu_spin_lock_xsave(&pool->lock);
-	ret = pool->entry == NULL || pool->entry->next == NULL;
+	ret = !pool->root;
 	cpu_spin_unlock_xrestore(&pool->lock, exceptions);
 
 	return ret;
@@ -365,28 +565,33 @@ tee_mm_pool_t tee_mm_shm;
 
 tee_mm_entry_t *tee_mm_find(const tee_mm_pool_t *pool, paddr_t addr)
 {
-	tee_mm_entry_t *entry = pool->entry;
-	uint16_t offset = (addr - pool->lo) >> pool->shift;
+	tee_mm_entry_t *entry = NULL;
+	tee_mm_entry_t *t = NULL;
+	uint32_t offset = 0;
 	uint32_t exceptions;
 
 	if (!tee_mm_addr_is_within_range(pool, addr))
 		return NULL;
 
-	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
+	offset = (addr - pool->lo) >> pool->shift;
 
-	while (entry->next != NULL) {
-		entry = entry->next;
+	exceptions = cpu_spin_lock_xsave(&((tee_mm_pool_t *)pool)->lock);
 
-		if ((offset >= entry->offset) &&
-		    (offset < (entry->offset + entry->size))) {
-			cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock,
-						 exceptions);
-			return entry;
+	/* Find the last entry starting at or below @offset */
+	t = pool->root;
+	while (t) {
+		if (t->offset <= offset) {
+			entry = t;
+			t = t->right;
+		} else {
+			t = t->left;
 		}
 	}
+	if (entry && offset >= entry_end(entry))
+		entry = NULL;
 
 	cpu_spin_unlock_xrestore(&((tee_mm_pool_t *)pool)->lock, exceptions);
-	return NULL;
+	return entry;
 }
 
 uintptr_t tee_mm_get_smem(const tee_mm_entry_t *mm)
@@ -24,6 +24,7 @@
 #include <mm/tee_pager.h>
 #include <mm/vm.h>
 #include <stdlib.h>
+#include <string.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
 #include <trace.h>
@@ -234,6 +235,174 @@ static void set_um_region(struct user_mode_ctx *uctx, struct vm_region *r)
 	}
 }
 
+/*
+ * The regions of a vm_info never overlap, so keeping them in an array
+ * sorted on va is enough to find the region covering an address with a
+ * binary search: it can only be the last region starting at or below the
+ * address.
+ *
+ * The array never shrinks. A region that has been removed can always be
+ * inserted again without allocating, vm_remap() relies on that when
+ * restoring a mapping.
+ */
+static TEE_Result region_index_reserve(struct vm_info *vmi)
+{
+	struct vm_region **idx = NULL;
+	size_t sz = 0;
+
+	if (vmi->region_count < vmi->region_index_size)
+		return TEE_SUCCESS;
+
+	sz = MAX(vmi->region_index_size * 2, (size_t)8);
+	idx = realloc(vmi->region_index, sz * sizeof(*idx));
+	if (!idx)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	vmi->region_index = idx;
+	vmi->region_index_size = sz;
+
+	return TEE_SUCCESS;
+}
+
+/* Returns the number of regions starting at or below @va */
+static size_t region_index_upper(const struct vm_info *vmi, vaddr_t va)
+{
+	size_t lo = 0;
+	size_t hi = vmi->region_count;
+
+	while (lo < hi) {
+		size_t mid = lo + (hi - lo) / 2;
+
+		if (vmi->region_index[mid]->va <= va)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void region_index_insert(struct vm_info *vmi, struct vm_region *reg)
+{
+	struct vm_region **idx = vmi->region_index;
+	size_t n = region_index_upper(vmi, reg->va);
+
+	assert(vmi->region_count < vmi->region_index_size);
+	memmove(idx + n + 1, idx + n, (vmi->region_count - n) * sizeof(*idx));
+	idx[n] = reg;
+	vmi->region_count++;
+}
+
+static void region_index_remove(struct vm_info *vmi, struct vm_region *reg)
+{
+	struct vm_region **idx = vmi->region_index;
+	size_t n = region_index_upper(vmi, reg->va);
+
+	assert(n && idx[n - 1] == reg);
+	n--;
+	memmove(idx + n, idx + n + 1,
+		(vmi->region_count - n - 1) * sizeof(*idx));
+	vmi->region_count--;
+}
+
+static void unlink_vm_region(struct vm_info *vmi, struct vm_region *reg)
+{
+	region_index_remove(vmi, reg);
+	TAILQ_REMOVE(&vmi->regions, reg, link);
+}
+
+static struct vm_region *find_vm_region(const struct vm_info *vmi,
+					vaddr_t va)
+{
+	size_t n = region_index_upper(vmi, va);
+	struct vm_region *r = NULL;
+
+	if (!n)
+		return NULL;
+
+	r = vmi->region_index[n - 1];
+	/* A cached parameter region is only a VA reservation */
+	if (va - r->va < r->size && !(r->flags & VM_FLAG_PARAM_CACHED))
+		return r;
+
+	return NULL;
+}
+
+#if CFG_TA_PARAM_MAP_CACHE_ENTRIES
+/*
+ * Parameter regions of unguarded registered shared memory can be kept by
+ * vm_clean_param() in a small per-context cache, tagged with
+ * VM_FLAG_PARAM_CACHED, so that the next call from the same session
+ * passing the same buffer reuses the virtual address range instead of
+ * allocating a new region.
+ *
+ * A region stays mapped when it's put in the cache, the TA doesn't run
+ * again before the next call. If that call passes the same buffer
+ * vm_map_param() only takes the region out of the cache, the page table
+ * entries and TLB are left untouched. vm_param_cache_revoke() then clears
+ * the page table entries and access permissions of the cached regions
+ * not passed, before the TA is entered, so the TA can't reach a buffer in
+ * a call where it isn't passed as a parameter. Such a region is only a
+ * VA reservation and is mapped again if a later call passes the buffer.
+ * find_vm_region() doesn't return cached regions, so they can't be
+ * remapped or have their protection changed by the TA either.
+ *
+ * A cached region holds a cache reference on its mobj which only keeps
+ * the mobj structure valid, the shared memory can still be released by
+ * normal world. While the TA is executing, between vm_param_cache_begin()
+ * and vm_param_cache_end(), a cached region also holds a normal reference
+ * so that it can be turned back into an ordinary parameter region.
+ * Cached regions of shared memory released in between calls are removed
+ * by vm_param_cache_begin() before the TA is entered again.
+ */
+#define PARAM_CACHE_SIZE	CFG_TA_PARAM_MAP_CACHE_ENTRIES
+#define PARAM_CACHE_PROT	(TEE_MATTR_PRW | TEE_MATTR_URW)
+
+static size_t param_cache_idx(struct vm_info *vmi, struct vm_region *r)
+{
+	size_t n = 0;
+
+	for (n = 0; n < PARAM_CACHE_SIZE; n++)
+		if (vmi->param_cache[n] == r)
+			break;
+
+	return n;
+}
+
+static void param_cache_del(struct vm_info *vmi, struct vm_region *r)
+{
+	size_t n = param_cache_idx(vmi, r);
+
+	assert(n < PARAM_CACHE_SIZE);
+	memmove(vmi->param_cache + n, vmi->param_cache + n + 1,
+		(PARAM_CACHE_SIZE - n - 1) * sizeof(*vmi->param_cache));
+	vmi->param_cache[PARAM_CACHE_SIZE - 1] = NULL;
+	r->flags &= ~VM_FLAG_PARAM_CACHED;
+}
+
+/* Drops the references held by a cached region which is to be freed */
+static void param_cache_unlink(struct vm_info *vmi, struct vm_region *r)
+{
+	param_cache_del(vmi, r);
+	if (vmi->param_cache_active)
+		mobj_put(r->mobj);
+	mobj_reg_shm_cache_put(r->mobj);
+}
+
+/* Turns a cached region back into an ordinary ephemeral region */
+static void param_cache_release(struct vm_info *vmi, struct vm_region *r)
+{
+	assert(vmi->param_cache_active);
+	param_cache_del(vmi, r);
+	mobj_reg_shm_cache_put(r->mobj);
+}
+#else
+static void param_cache_unlink(struct vm_info *vmi __unused,
+			       struct vm_region *r __unused)
+{
+}
+#endif
+
 static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 				  size_t pad_begin, size_t pad_end,
 				  size_t align)
@@ -266,6 +435,9 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (!IS_POWER_OF_TWO(granul))
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	if (region_index_reserve(vmi))
+		return TEE_ERROR_OUT_OF_MEMORY;
+
 	prev_r = &dummy_first_reg;
 	TAILQ_FOREACH(r, &vmi->regions, link) {
 		va = select_va_in_range(prev_r, r, reg, pad_begin, pad_end,
@@ -273,6 +445,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 		if (va) {
 			reg->va = va;
 			TAILQ_INSERT_BEFORE(r, reg, link);
+			region_index_insert(vmi, reg);
 			return TEE_SUCCESS;
 		}
 		prev_r = r;
@@ -286,6 +459,7 @@ static TEE_Result umap_add_region(struct vm_info *vmi, struct vm_region *reg,
 	if (va) {
 		reg->va = va;
 		TAILQ_INSERT_TAIL(&vmi->regions, reg, link);
+		region_index_insert(vmi, reg);
 		return TEE_SUCCESS;
 	}
 
@@ -363,7 +537,7 @@ TEE_Result vm_map_pad(struct user_mode_ctx *uctx, vaddr_t *va, size_t len,
 	return TEE_SUCCESS;
 
 err_rem_reg:
-	TAILQ_REMOVE(&uctx->vm_info.regions, reg, link);
+	unlink_vm_region(&uctx->vm_info, reg);
 err_put_mobj:
 	mobj_put(reg->mobj);
 err_free_reg:
@@ -371,17 +545,6 @@ err_free_reg:
 	return res;
 }
 
-static struct vm_region *find_vm_region(struct vm_info *vm_info, vaddr_t va)
-{
-	struct vm_region *r = NULL;
-
-	TAILQ_FOREACH(r, &vm_info->regions, link)
-		if (va >= r->va && va < r->va + r->size)
-			return r;
-
-	return NULL;
-}
-
 static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 				   size_t len,
 				   bool (*cmp_regs)(const struct vm_region *r0,
@@ -404,6 +567,8 @@ static bool va_range_is_contiguous(struct vm_region *r0, vaddr_t va,
 			return false;
 		if (r_end_va != r_next->va)
 			return false;
+		if (r_next->flags & VM_FLAG_PARAM_CACHED)
+			return false;
 		if (cmp_regs && !cmp_regs(r0, r, r_next))
 			return false;
 		r = r_next;
@@ -418,6 +583,9 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 
 	assert(diff && diff < r->size);
 
+	if (region_index_reserve(&uctx->vm_info))
+		return TEE_ERROR_OUT_OF_MEMORY;
+
 	r2 = calloc(1, sizeof(*r2));
 	if (!r2)
 		return TEE_ERROR_OUT_OF_MEMORY;
@@ -441,6 +609,7 @@ static TEE_Result split_vm_region(struct user_mode_ctx *uctx,
 	r->size = diff;
 
 	TAILQ_INSERT_AFTER(&uctx->vm_info.regions, r, r2, link);
+	region_index_insert(&uctx->vm_info, r2);
 
 	return TEE_SUCCESS;
 }
@@ -530,8 +699,10 @@ static void merge_vm_range(struct user_mode_ctx *uctx, vaddr_t va, size_t len)
 			continue;
 		if (r->offset + r->size != r_next->offset)
 			continue;
+		if (r->flags & VM_FLAG_PARAM_CACHED)
+			continue;
 
-		TAILQ_REMOVE(&uctx->vm_info.regions, r_next, link);
+		unlink_vm_region(&uctx->vm_info, r_next);
 		r->size += r_next->size;
 		mobj_put(r_next->mobj);
 		free(r_next);
@@ -587,7 +758,7 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 			break;
 		r_next = TAILQ_NEXT(r, link);
 		rem_um_region(uctx, r);
-		TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
+		unlink_vm_region(&uctx->vm_info, r);
 		TAILQ_INSERT_TAIL(&regs, r, link);
 	}
 
@@ -637,17 +808,24 @@ TEE_Result vm_remap(struct user_mode_ctx *uctx, vaddr_t *new_va, vaddr_t old_va,
 				 */
 				TAILQ_INSERT_HEAD(&regs, r, link);
 			}
-			if (r_last)
+			/*
+			 * Only r_first up to and including r_last have
+			 * been added, if r_last is NULL nothing was added
+			 * and r is already back in regs.
+			 */
+			if (r_last) {
 				r_stop = TAILQ_NEXT(r_last, link);
-			for (r = r_first; r != r_stop; r = r_next) {
-				r_next = TAILQ_NEXT(r, link);
-				TAILQ_REMOVE(&uctx->vm_info.regions, r, link);
-				if (r_tmp)
-					TAILQ_INSERT_AFTER(&regs, r_tmp, r,
-							   link);
-				else
-					TAILQ_INSERT_HEAD(&regs, r, link);
-				r_tmp = r;
+				for (r = r_first; r != r_stop; r = r_next) {
+					r_next = TAILQ_NEXT(r, link);
+					unlink_vm_region(&uctx->vm_info, r);
+					if (r_tmp)
+						TAILQ_INSERT_AFTER(&regs, r_tmp,
+								   r, link);
+					else
+						TAILQ_INSERT_HEAD(&regs, r,
+								  link);
+					r_tmp = r;
+				}
 			}
 
 			goto err_restore_map;
@@ -806,8 +984,11 @@ TEE_Result vm_set_prot(struct user_mode_ctx *uctx, vaddr_t va, size_t len,
 
 static void umap_remove_region(struct vm_info *vmi, struct vm_region *reg)
 {
-	TAILQ_REMOVE(&vmi->regions, reg, link);
-	mobj_put(reg->mobj);
+	unlink_vm_region(vmi, reg);
+	if (reg->flags & VM_FLAG_PARAM_CACHED)
+		param_cache_unlink(vmi, reg);
+	else
+		mobj_put(reg->mobj);
 	free(reg);
 }
 
@@ -898,25 +1079,169 @@ TEE_Result vm_info_init(struct user_mode_ctx *uctx, struct ts_ctx *ts_ctx)
 	return res;
 }
 
-void vm_clean_param(struct user_mode_ctx *uctx)
+static void unmap_param_region(struct user_mode_ctx *uctx, struct vm_region *r)
+{
+	rem_um_region(uctx, r);
+	umap_remove_region(&uctx->vm_info, r);
+}
+
+#if CFG_TA_PARAM_MAP_CACHE_ENTRIES
+static bool param_cache_add(struct user_mode_ctx *uctx, struct vm_region *r)
+{
+	struct vm_info *vmi = &uctx->vm_info;
+	struct vm_region *lru = vmi->param_cache[PARAM_CACHE_SIZE - 1];
+
+	if (!vmi->param_cache_active ||
+	    (r->attr & TEE_MATTR_PROT_MASK) != PARAM_CACHE_PROT ||
+	    mobj_reg_shm_cache_get(r->mobj))
+		return false;
+
+	if (lru)
+		unmap_param_region(uctx, lru);
+	memmove(vmi->param_cache + 1, vmi->param_cache,
+		(PARAM_CACHE_SIZE - 1) * sizeof(*vmi->param_cache));
+	vmi->param_cache[0] = r;
+	r->flags |= VM_FLAG_PARAM_CACHED;
+
+	return true;
+}
+
+static bool param_cache_lookup(struct user_mode_ctx *uctx,
+			       struct param_mem *mem)
+{
+	struct vm_info *vmi = &uctx->vm_info;
+	struct vm_region *r = NULL;
+	size_t n = 0;
+
+	if (!vmi->param_cache_active)
+		return false;
+
+	for (n = 0; n < PARAM_CACHE_SIZE && vmi->param_cache[n]; n++) {
+		r = vmi->param_cache[n];
+		if (r->mobj != mem->mobj || r->offset != mem->offs ||
+		    r->size != mem->size)
+			continue;
+
+		/*
+		 * Turn it back into an ordinary parameter region,
+		 * vm_clean_param() puts it back first in the cache. It's
+		 * still mapped unless a call in between didn't pass it.
+		 */
+		param_cache_release(vmi, r);
+		if (!(r->attr & TEE_MATTR_PROT_MASK)) {
+			r->attr |= PARAM_CACHE_PROT;
+			set_um_region(uctx, r);
+		}
+		return true;
+	}
+
+	return false;
+}
+
+void vm_param_cache_begin(struct user_mode_ctx *uctx, uint32_t sess_id)
 {
-	struct vm_region *next_r;
-	struct vm_region *r;
+	struct vm_info *vmi = &uctx->vm_info;
+	struct vm_region *r = NULL;
+	size_t n = 0;
+
+	assert(!vmi->param_cache_active);
+
+	if (sess_id != vmi->param_cache_owner) {
+		vm_param_cache_flush(uctx);
+		vmi->param_cache_owner = sess_id;
+	}
 
-	TAILQ_FOREACH_SAFE(r, &uctx->vm_info.regions, link, next_r) {
-		if (r->flags & VM_FLAG_EPHEMERAL) {
-			rem_um_region(uctx, r);
-			umap_remove_region(&uctx->vm_info, r);
+	while (n < PARAM_CACHE_SIZE && vmi->param_cache[n]) {
+		r = vmi->param_cache[n];
+		if (mobj_reg_shm_cache_use(r->mobj)) {
+			/* Released by normal world, the entries are shifted */
+			unmap_param_region(uctx, r);
+			continue;
 		}
+		n++;
 	}
+
+	vmi->param_cache_active = true;
 }
 
-static void check_param_map_empty(struct user_mode_ctx *uctx __maybe_unused)
+void vm_param_cache_revoke(struct user_mode_ctx *uctx)
+{
+	struct vm_info *vmi = &uctx->vm_info;
+	struct vm_region *r = NULL;
+	size_t n = 0;
+
+	for (n = 0; n < PARAM_CACHE_SIZE && vmi->param_cache[n]; n++) {
+		r = vmi->param_cache[n];
+		if (!(r->attr & TEE_MATTR_PROT_MASK))
+			continue;
+
+		/* Keep only the VA range, the TA must not reach the buffer */
+		r->attr &= ~TEE_MATTR_PROT_MASK;
+		pgt_clear_range(uctx, r->va, r->va + r->size);
+		tlbi_va_range_asid(r->va, r->size, SMALL_PAGE_SIZE, vmi->asid);
+	}
+}
+
+void vm_param_cache_end(struct user_mode_ctx *uctx)
+{
+	struct vm_info *vmi = &uctx->vm_info;
+	size_t n = 0;
+
+	assert(vmi->param_cache_active);
+
+	for (n = 0; n < PARAM_CACHE_SIZE && vmi->param_cache[n]; n++)
+		mobj_put(vmi->param_cache[n]->mobj);
+
+	vmi->param_cache_active = false;
+}
+
+void vm_param_cache_flush(struct user_mode_ctx *uctx)
+{
+	while (uctx->vm_info.param_cache[0])
+		unmap_param_region(uctx, uctx->vm_info.param_cache[0]);
+}
+#else
+static bool param_cache_add(struct user_mode_ctx *uctx __unused,
+			    struct vm_region *r __unused)
+{
+	return false;
+}
+
+static bool param_cache_lookup(struct user_mode_ctx *uctx __unused,
+			       struct param_mem *mem __unused)
+{
+	return false;
+}
+#endif
+
+static struct vm_region *find_uncached_param(struct user_mode_ctx *uctx)
 {
 	struct vm_region *r = NULL;
 
 	TAILQ_FOREACH(r, &uctx->vm_info.regions, link)
-		assert(!(r->flags & VM_FLAG_EPHEMERAL));
+		if ((r->flags & (VM_FLAG_EPHEMERAL | VM_FLAG_PARAM_CACHED)) ==
+		    VM_FLAG_EPHEMERAL)
+			return r;
+
+	return NULL;
+}
+
+void vm_clean_param(struct user_mode_ctx *uctx)
+{
+	struct vm_region *r = NULL;
+
+	/*
+	 * Adding a region to the parameter cache may evict another region
+	 * so look up the next region from scratch each time.
+	 */
+	while ((r = find_uncached_param(uctx)))
+		if (!param_cache_add(uctx, r))
+			unmap_param_region(uctx, r);
+}
+
+static void check_param_map_empty(struct user_mode_ctx *uctx __maybe_unused)
+{
+	assert(!find_uncached_param(uctx));
 }
 
 static TEE_Result param_mem_to_user_va(struct user_mode_ctx *uctx,
@@ -930,6 +1255,8 @@ static TEE_Result param_mem_to_user_va(struct user_mode_ctx *uctx,
 
 		if (!(region->flags & VM_FLAG_EPHEMERAL))
 			continue;
+		if (region->flags & VM_FLAG_PARAM_CACHED)
+			continue;
 		if (mem->mobj != region->mobj)
 			continue;
 
@@ -1044,6 +1371,9 @@ TEE_Result vm_map_param(struct user_mode_ctx *uctx, struct tee_ta_param *param,
 	for (n = 0; n < m; n++) {
 		vaddr_t va = 0;
 
+		if (param_cache_lookup(uctx, mem + n))
+			continue;
+
 		res = vm_map(uctx, &va, mem[n].size,
 			     TEE_MATTR_PRW | TEE_MATTR_URW,
 			     VM_FLAG_EPHEMERAL | VM_FLAG_SHAREABLE,
@@ -1093,31 +1423,44 @@ void vm_info_final(struct user_mode_ctx *uctx)
 	while (!TAILQ_EMPTY(&uctx->vm_info.regions))
 		umap_remove_region(&uctx->vm_info,
 				   TAILQ_FIRST(&uctx->vm_info.regions));
+
+	free(uctx->vm_info.region_index);
+	uctx->vm_info.region_index = NULL;
+	uctx->vm_info.region_index_size = 0;
 }
 
 /* return true only if buffer fits inside TA private memory */
 bool vm_buf_is_inside_um_private(const struct user_mode_ctx *uctx,
 				 const void *va, size_t size)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = find_vm_region(&uctx->vm_info, (vaddr_t)va);
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (r->flags & VM_FLAGS_NONPRIV)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
-			return true;
-	}
+	/* Only the region covering @va can hold the entire buffer */
+	if (!r || (r->flags & VM_FLAGS_NONPRIV))
+		return false;
 
-	return false;
+	return core_is_buffer_inside((vaddr_t)va, size, r->va, r->size);
 }
 
 /* return true only if buffer intersects TA private memory */
 bool vm_buf_intersects_um_private(const struct user_mode_ctx *uctx,
 				  const void *va, size_t size)
 {
+	const struct vm_info *vmi = &uctx->vm_info;
 	struct vm_region *r = NULL;
+	size_t n = 0;
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
+	/*
+	 * Start with the last region starting at or below @va, the
+	 * regions before that one end before @va.
+	 */
+	n = region_index_upper(vmi, (vaddr_t)va);
+	if (n)
+		n--;
+	for (; n < vmi->region_count; n++) {
+		r = vmi->region_index[n];
+		if (r->va >= (vaddr_t)va && r->va - (vaddr_t)va >= size)
+			break;
 		if (r->attr & VM_FLAGS_NONPRIV)
 			continue;
 		if (core_is_buffer_intersect((vaddr_t)va, size, r->va, r->size))
@@ -1131,23 +1474,17 @@ TEE_Result vm_buf_to_mboj_offs(const struct user_mode_ctx *uctx,
 			       const void *va, size_t size,
 			       struct mobj **mobj, size_t *offs)
 {
-	struct vm_region *r = NULL;
+	struct vm_region *r = find_vm_region(&uctx->vm_info, (vaddr_t)va);
+	size_t poffs = 0;
 
-	TAILQ_FOREACH(r, &uctx->vm_info.regions, link) {
-		if (!r->mobj)
-			continue;
-		if (core_is_buffer_inside((vaddr_t)va, size, r->va, r->size)) {
-			size_t poffs;
-
-			poffs = mobj_get_phys_offs(r->mobj,
-						   CORE_MMU_USER_PARAM_SIZE);
-			*mobj = r->mobj;
-			*offs = (vaddr_t)va - r->va + r->offset - poffs;
-			return TEE_SUCCESS;
-		}
-	}
+	if (!r || !r->mobj ||
+	    !core_is_buffer_inside((vaddr_t)va, size, r->va, r->size))
+		return TEE_ERROR_BAD_PARAMETERS;
 
-	return TEE_ERROR_BAD_PARAMETERS;
+	poffs = mobj_get_phys_offs(r->mobj, CORE_MMU_USER_PARAM_SIZE);
+	*mobj = r->mobj;
+	*offs = (vaddr_t)va - r->va + r->offset - poffs;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_mmu_user_va2pa_attr(const struct user_mode_ctx *uctx,
@@ -1155,45 +1492,41 @@ static TEE_Result tee_mmu_user_va2pa_attr(const struct user_mode_ctx *uctx,
 {
 	struct vm_region *region = NULL;
 
-	TAILQ_FOREACH(region, &uctx->vm_info.regions, link) {
-		if (!core_is_buffer_inside((vaddr_t)ua, 1, region->va,
-					   region->size))
-			continue;
-
-		if (pa) {
-			TEE_Result res;
-			paddr_t p;
-			size_t offset;
-			size_t granule;
+	region = find_vm_region(&uctx->vm_info, (vaddr_t)ua);
+	if (!region)
+		return TEE_ERROR_ACCESS_DENIED;
 
-			/*
-			 * mobj and input user address may each include
-			 * a specific offset-in-granule position.
-			 * Drop both to get target physical page base
-			 * address then apply only user address
-			 * offset-in-granule.
-			 * Mapping lowest granule is the small page.
-			 */
-			granule = MAX(region->mobj->phys_granule,
-				      (size_t)SMALL_PAGE_SIZE);
-			assert(!granule || IS_POWER_OF_TWO(granule));
+	if (pa) {
+		TEE_Result res;
+		paddr_t p;
+		size_t offset;
+		size_t granule;
 
-			offset = region->offset +
-				 ROUNDDOWN((vaddr_t)ua - region->va, granule);
+		/*
+		 * mobj and input user address may each include
+		 * a specific offset-in-granule position.
+		 * Drop both to get target physical page base
+		 * address then apply only user address
+		 * offset-in-granule.
+		 * Mapping lowest granule is the small page.
+		 */
+		granule = MAX(region->mobj->phys_granule,
+			      (size_t)SMALL_PAGE_SIZE);
+		assert(!granule || IS_POWER_OF_TWO(granule));
 
-			res = mobj_get_pa(region->mobj, offset, granule, &p);
-			if (res != TEE_SUCCESS)
-				return res;
+		offset = region->offset +
+			 ROUNDDOWN((vaddr_t)ua - region->va, granule);
 
-			*pa = p | ((vaddr_t)ua & (granule - 1));
-		}
-		if (attr)
-			*attr = region->attr;
+		res = mobj_get_pa(region->mobj, offset, granule, &p);
+		if (res != TEE_SUCCESS)
+			return res;
 
-		return TEE_SUCCESS;
+		*pa = p | ((vaddr_t)ua & (granule - 1));
 	}
+	if (attr)
+		*attr = region->attr;
 
-	return TEE_ERROR_ACCESS_DENIED;
+	return TEE_SUCCESS;
 }
 
 TEE_Result vm_va2pa(const struct user_mode_ctx *uctx, void *ua, paddr_t *pa)
@@ -1215,6 +1548,10 @@ void *vm_pa2va(const struct user_mode_ctx *uctx, paddr_t pa, size_t pa_size)
 		if (!region->mobj)
 			continue;
 
+		/* Cached parameter regions aren't mapped */
+		if (region->flags & VM_FLAG_PARAM_CACHED)
+			continue;
+
 		/* Physically granulated memory object must be scanned */
 		granule = region->mobj->phys_granule;
 		assert(!granule || IS_POWER_OF_TWO(granule));
@@ -1251,6 +1588,7 @@ void *vm_pa2va(const struct user_mode_ctx *uctx, paddr_t pa, size_t pa_size)
 TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 				  uint32_t flags, uaddr_t uaddr, size_t len)
 {
+	struct vm_region *r = NULL;
 	uaddr_t a = 0;
 	uaddr_t end_addr = 0;
 	size_t addr_incr = MIN(CORE_MMU_USER_CODE_SIZE,
@@ -1271,13 +1609,18 @@ TEE_Result vm_check_access_rights(const struct user_mode_ctx *uctx,
 	   !vm_buf_is_inside_um_private(uctx, (void *)uaddr, len))
 		return TEE_ERROR_ACCESS_DENIED;
 
-	for (a = ROUNDDOWN(uaddr, addr_incr); a < end_addr; a += addr_incr) {
-		uint32_t attr;
-		TEE_Result res;
+	/*
+	 * The attributes are the same for the entire region so it's
+	 * enough to check each region the range spans once.
+	 */
+	for (a = ROUNDDOWN(uaddr, addr_incr); a < end_addr;
+	     a = r->va + r->size) {
+		uint32_t attr = 0;
 
-		res = tee_mmu_user_va2pa_attr(uctx, (void *)a, NULL, &attr);
-		if (res != TEE_SUCCESS)
-			return res;
+		r = find_vm_region(&uctx->vm_info, a);
+		if (!r)
+			return TEE_ERROR_ACCESS_DENIED;
+		attr = r->attr;
 
 		if ((flags & TEE_MEMORY_ACCESS_NONSECURE) &&
 		    (attr & TEE_MATTR_SECURE))
@@ -95,37 +95,27 @@ static TEE_Result adimem_read_handler(TEE_Param params[TEE_NUM_PARAMS])
 {
 	uint32_t address = params[OP_PARAM_ADDR].value.a;
 	size_t size = params[OP_PARAM_SIZE].value.a;
-	vaddr_t base;
-	bool base_is_new_mmu_map = false;
+	struct plat_io_map map;
 	uint32_t value;
 	bool ok;
 
 	/* Remap */
-	base = (vaddr_t)phys_to_virt_io(address, sizeof(uint32_t));
-	if (!base) {
-		/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-		base = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, address, size);
-		if (!base) {
-			plat_runtime_error_message("%s READ  MMU address mapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
-		base_is_new_mmu_map = true;
+	if (plat_io_map(address, size / 8, &map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ  MMU address mapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	/* Read value */
 	switch (size) {
-	case 8:  ok = true; value = io_read8(base); break;
-	case 16: ok = true; value = io_read16(base); break;
-	case 32: ok = true; value = io_read32(base); break;
+	case 8:  ok = true; value = io_read8(map.va); break;
+	case 16: ok = true; value = io_read16(map.va); break;
+	case 32: ok = true; value = io_read32(map.va); break;
 	default: ok = false; break;
 	}
 
-	if (base_is_new_mmu_map) {
-		/* MMU remove mapping */
-		if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, size) != TEE_SUCCESS) {
-			plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
+	if (plat_io_unmap(&map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	if (!ok)
@@ -146,38 +136,28 @@ static TEE_Result adimem_write_handler(TEE_Param params[TEE_NUM_PARAMS])
 {
 	uint32_t address = params[OP_PARAM_ADDR].value.a;
 	size_t size = params[OP_PARAM_SIZE].value.a;
-	vaddr_t base;
-	bool base_is_new_mmu_map = false;
+	struct plat_io_map map;
 	uint32_t value;
 	bool ok;
 
 	/* Remap */
-	base = (vaddr_t)phys_to_virt_io(address, sizeof(uint32_t));
-	if (!base) {
-		/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-		base = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, address, size);
-		if (!base) {
-			plat_runtime_error_message("%s WRITE MMU address mapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
-		base_is_new_mmu_map = true;
+	if (plat_io_map(address, size / 8, &map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s WRITE MMU address mapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	/* Write value */
 	value = params[OP_PARAM_DATA].value.a;
 	switch (size) {
-	case 8:  ok = true;  io_write8(base, value); break;
-	case 16: ok = true; io_write16(base, value); break;
-	case 32: ok = true; io_write32(base, value); break;
+	case 8:  ok = true;  io_write8(map.va, value); break;
+	case 16: ok = true; io_write16(map.va, value); break;
+	case 32: ok = true; io_write32(map.va, value); break;
 	default: ok = false; break;
 	}
 
-	if (base_is_new_mmu_map) {
-		/* MMU remove mapping */
-		if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, size) != TEE_SUCCESS) {
-			plat_runtime_error_message("%s WRITE MMU address unmapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
+	if (plat_io_unmap(&map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s WRITE MMU address unmapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	if (!ok)
@@ -299,5 +279,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = TA_ADIMEM_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
@@ -45,5 +45,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = ENFORCEMENT_COUNTER_PTA_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
@@ -26,6 +26,7 @@
  */
 
 #include <io.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
 #include <mm/core_memprot.h>
 
@@ -74,28 +75,42 @@ typedef struct i2c_params {
 	uint64_t speed;
 } i2c_params_t;
 
-static i2c_params_t i2c_params;
+/* Number of I2C buses accessible through this PTA */
+#define ADI_I2C_NUM_BUSES       1
+
+/* Serializes transfers on each bus, the controller is set up per transfer */
+static struct mutex i2c_bus_mutex[ADI_I2C_NUM_BUSES] = { MUTEX_INITIALIZER };
 
 /*
- * init_i2c_params - initialize i2c structure to hold parameters
+ * init_i2c_params - copy the parameters of this invocation to @i2c_params
  */
-static void init_i2c_params(TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result init_i2c_params(uint32_t param_types, TEE_Param params[TEE_NUM_PARAMS],
+				  i2c_params_t *i2c_params)
 {
-	memcpy(&i2c_params, params[0].memref.buffer, params[0].memref.size);
+	if (TEE_PARAM_TYPE_GET(param_types, 0) != TEE_PARAM_TYPE_MEMREF_INPUT ||
+	    params[0].memref.size > sizeof(*i2c_params)) {
+		plat_runtime_error_message("Bad I2C parameter buffer");
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	memset(i2c_params, 0, sizeof(*i2c_params));
+	memcpy(i2c_params, params[0].memref.buffer, params[0].memref.size);
+
+	return TEE_SUCCESS;
 }
 
 /*
  * adi_i2c_get_current_entry - get current entry if it is in the access table
  */
-static const i2c_entry_t *adi_i2c_get_current_entry(void)
+static const i2c_entry_t *adi_i2c_get_current_entry(const i2c_params_t *i2c_params)
 {
 	const i2c_entry_t *access_table;
 	const size_t num_entries = get_i2c_access_table_num_entries();
 	const i2c_entry_t *cur_entry;
 	size_t cur_entry_idx;
-	uint64_t bus = i2c_params.bus;
-	uint64_t slave = i2c_params.slave;
-	uint64_t addr = i2c_params.address;
+	uint64_t bus = i2c_params->bus;
+	uint64_t slave = i2c_params->slave;
+	uint64_t addr = i2c_params->address;
 
 	access_table = get_i2c_access_table();
 
@@ -113,9 +128,9 @@ static const i2c_entry_t *adi_i2c_get_current_entry(void)
 /*
  * adi_i2c_verify_access - verify bus, slave, and address access
  */
-static bool adi_i2c_verify_access(uint32_t cmd)
+static bool adi_i2c_verify_access(uint32_t cmd, const i2c_params_t *i2c_params)
 {
-	const i2c_entry_t *cur_entry = adi_i2c_get_current_entry();
+	const i2c_entry_t *cur_entry = adi_i2c_get_current_entry(i2c_params);
 
 	if (cur_entry == NULL)
 		return false;
@@ -144,11 +159,12 @@ static bool adi_i2c_verify_access(uint32_t cmd)
 /*
  * adi_i2c_check_params - verify the received parameters are of the expected types
  */
-static TEE_Result adi_i2c_check_params(uint32_t param_types, uint32_t cmd)
+static TEE_Result adi_i2c_check_params(uint32_t param_types, uint32_t cmd,
+				       const i2c_params_t *i2c_params)
 {
-	uint64_t num_set_bytes = i2c_params.set_bytes;
-	uint64_t num_get_bytes = i2c_params.get_bytes;
-	uint64_t speed = i2c_params.speed;
+	uint64_t num_set_bytes = i2c_params->set_bytes;
+	uint64_t num_get_bytes = i2c_params->get_bytes;
+	uint64_t speed = i2c_params->speed;
 
 	switch (cmd) {
 	case TA_ADI_I2C_GET:
@@ -175,7 +191,7 @@ static TEE_Result adi_i2c_check_params(uint32_t param_types, uint32_t cmd)
 	}
 
 	/* Verify I2C bus, slave, and address */
-	if (!adi_i2c_verify_access(cmd)) {
+	if (!adi_i2c_verify_access(cmd, i2c_params)) {
 		plat_runtime_error_message("Access not permitted for specified bus, slave, address, and operation");
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
@@ -195,20 +211,54 @@ static TEE_Result adi_i2c_check_params(uint32_t param_types, uint32_t cmd)
 	return TEE_SUCCESS;
 }
 
+/*
+ * i2c_open - lock the bus and initialize the controller for a transfer
+ */
+static TEE_Result i2c_open(const i2c_params_t *i2c_params, struct adi_i2c_handle *hi2c)
+{
+	/* Initialize I2C */
+	hi2c->sclk = plat_get_sysclk_freq();
+	hi2c->twi_clk = i2c_params->speed;
+
+	switch (i2c_params->bus) {
+	case 0:
+		hi2c->pa = I2C_0_BASE;
+		break;
+	default:
+		return TEE_ERROR_GENERIC;
+	}
+
+	mutex_lock(&i2c_bus_mutex[i2c_params->bus]);
+
+	if (adi_twi_i2c_init(hi2c) < 0) {
+		mutex_unlock(&i2c_bus_mutex[i2c_params->bus]);
+		plat_runtime_error_message("I2C init error");
+		return TEE_ERROR_GENERIC;
+	}
+
+	return TEE_SUCCESS;
+}
+
+/*
+ * i2c_close - unlock the bus locked by i2c_open()
+ */
+static void i2c_close(const i2c_params_t *i2c_params)
+{
+	mutex_unlock(&i2c_bus_mutex[i2c_params->bus]);
+}
+
 /*
  * i2c_set - write to I2C
  */
-static TEE_Result i2c_set(TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result i2c_set(const i2c_params_t *i2c_params, TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct adi_i2c_handle hi2c;
 	uint8_t *buf = NULL;
 	int ret;
-	uint64_t bus = i2c_params.bus;
-	uint64_t slave = i2c_params.slave;
-	uint64_t addr = i2c_params.address;
-	uint64_t addr_len = i2c_params.length;
-	uint64_t num_bytes = i2c_params.set_bytes;
-	uint64_t speed = i2c_params.speed;
+	uint64_t slave = i2c_params->slave;
+	uint64_t addr = i2c_params->address;
+	uint64_t addr_len = i2c_params->length;
+	uint64_t num_bytes = i2c_params->set_bytes;
 
 	buf = malloc(num_bytes);
 	if (buf == NULL) {
@@ -219,28 +269,14 @@ static TEE_Result i2c_set(TEE_Param params[TEE_NUM_PARAMS])
 	/* Copy write data to buffer for I2C write */
 	memcpy(buf, params[OP_PARAM_BUFFER].memref.buffer, num_bytes);
 
-	/* Initialize I2C */
-	hi2c.sclk = plat_get_sysclk_freq();
-	hi2c.twi_clk = speed;
-
-	switch (bus) {
-	case 0:
-		hi2c.pa = I2C_0_BASE;
-		break;
-	default:
-		free(buf);
-		return TEE_ERROR_GENERIC;
-	}
-
-	ret = adi_twi_i2c_init(&hi2c);
-	if (ret < 0) {
-		plat_runtime_error_message("I2C init error");
+	if (i2c_open(i2c_params, &hi2c) != TEE_SUCCESS) {
 		free(buf);
 		return TEE_ERROR_GENERIC;
 	}
 
 	/* Execute I2C write */
 	ret = adi_twi_i2c_write(&hi2c, slave, addr, addr_len, buf, num_bytes);
+	i2c_close(i2c_params);
 	if (ret < 0) {
 		plat_runtime_error_message("I2C write error");
 		free(buf);
@@ -254,17 +290,15 @@ static TEE_Result i2c_set(TEE_Param params[TEE_NUM_PARAMS])
 /*
  * i2c_get - read from I2C
  */
-static TEE_Result i2c_get(TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result i2c_get(const i2c_params_t *i2c_params, TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct adi_i2c_handle hi2c;
 	uint8_t *buf = NULL;
 	int ret;
-	uint64_t bus = i2c_params.bus;
-	uint64_t slave = i2c_params.slave;
-	uint64_t addr = i2c_params.address;
-	uint64_t addr_len = i2c_params.length;
-	uint64_t num_bytes = i2c_params.get_bytes;
-	uint64_t speed = i2c_params.speed;
+	uint64_t slave = i2c_params->slave;
+	uint64_t addr = i2c_params->address;
+	uint64_t addr_len = i2c_params->length;
+	uint64_t num_bytes = i2c_params->get_bytes;
 
 	buf = malloc(num_bytes);
 	if (buf == NULL) {
@@ -272,28 +306,14 @@ static TEE_Result i2c_get(TEE_Param params[TEE_NUM_PARAMS])
 		return TEE_ERROR_GENERIC;
 	}
 
-	/* Initialize I2C */
-	hi2c.sclk = plat_get_sysclk_freq();
-	hi2c.twi_clk = speed;
-
-	switch (bus) {
-	case 0:
-		hi2c.pa = I2C_0_BASE;
-		break;
-	default:
-		free(buf);
-		return TEE_ERROR_GENERIC;
-	}
-
-	ret = adi_twi_i2c_init(&hi2c);
-	if (ret < 0) {
-		plat_runtime_error_message("I2C init error");
+	if (i2c_open(i2c_params, &hi2c) != TEE_SUCCESS) {
 		free(buf);
 		return TEE_ERROR_GENERIC;
 	}
 
 	/* Execute I2C read */
 	ret = adi_twi_i2c_read(&hi2c, slave, addr, addr_len, buf, num_bytes);
+	i2c_close(i2c_params);
 	if (ret < 0) {
 		plat_runtime_error_message("I2C read error");
 		free(buf);
@@ -311,18 +331,16 @@ static TEE_Result i2c_get(TEE_Param params[TEE_NUM_PARAMS])
 /*
  * i2c_set_get - write and then read from I2C
  */
-static TEE_Result i2c_set_get(TEE_Param params[TEE_NUM_PARAMS])
+static TEE_Result i2c_set_get(const i2c_params_t *i2c_params, TEE_Param params[TEE_NUM_PARAMS])
 {
 	struct adi_i2c_handle hi2c;
 	uint8_t *buf = NULL;
 	int ret;
-	uint64_t bus = i2c_params.bus;
-	uint64_t slave = i2c_params.slave;
-	uint64_t addr = i2c_params.address;
-	uint64_t addr_len = i2c_params.length;
-	uint64_t num_get_bytes = i2c_params.get_bytes;
-	uint64_t num_set_bytes = i2c_params.set_bytes;
-	uint64_t speed = i2c_params.speed;
+	uint64_t slave = i2c_params->slave;
+	uint64_t addr = i2c_params->address;
+	uint64_t addr_len = i2c_params->length;
+	uint64_t num_get_bytes = i2c_params->get_bytes;
+	uint64_t num_set_bytes = i2c_params->set_bytes;
 	uint64_t buf_bytes = (num_get_bytes > num_set_bytes) ? num_get_bytes : num_set_bytes;
 
 	buf = malloc(buf_bytes);
@@ -334,28 +352,14 @@ static TEE_Result i2c_set_get(TEE_Param params[TEE_NUM_PARAMS])
 	/* Copy write data to buffer for I2C write */
 	memcpy(buf, params[OP_PARAM_BUFFER].memref.buffer, num_set_bytes);
 
-	/* Initialize I2C */
-	hi2c.sclk = plat_get_sysclk_freq();
-	hi2c.twi_clk = speed;
-
-	switch (bus) {
-	case 0:
-		hi2c.pa = I2C_0_BASE;
-		break;
-	default:
-		free(buf);
-		return TEE_ERROR_GENERIC;
-	}
-
-	ret = adi_twi_i2c_init(&hi2c);
-	if (ret < 0) {
-		plat_runtime_error_message("I2C init error");
+	if (i2c_open(i2c_params, &hi2c) != TEE_SUCCESS) {
 		free(buf);
 		return TEE_ERROR_GENERIC;
 	}
 
 	/* Execute I2C read */
 	ret = adi_twi_i2c_write_read(&hi2c, slave, addr, addr_len, buf, num_set_bytes, num_get_bytes);
+	i2c_close(i2c_params);
 	if (ret < 0) {
 		plat_runtime_error_message("I2C read error");
 		free(buf);
@@ -377,20 +381,23 @@ static TEE_Result invoke_command(void *psess __unused,
 				 uint32_t cmd, uint32_t ptypes,
 				 TEE_Param params[TEE_NUM_PARAMS])
 {
+	i2c_params_t i2c_params;
+
 	/* Initialize I2C param structure */
-	init_i2c_params(params);
+	if (init_i2c_params(ptypes, params, &i2c_params) != TEE_SUCCESS)
+		return TEE_ERROR_BAD_PARAMETERS;
 
 	/* Verify parameters */
-	if (adi_i2c_check_params(ptypes, cmd) != TEE_SUCCESS)
+	if (adi_i2c_check_params(ptypes, cmd, &i2c_params) != TEE_SUCCESS)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	switch (cmd) {
 	case TA_ADI_I2C_GET:
-		return i2c_get(params);
+		return i2c_get(&i2c_params, params);
 	case TA_ADI_I2C_SET:
-		return i2c_set(params);
+		return i2c_set(&i2c_params, params);
 	case TA_ADI_I2C_SET_GET:
-		return i2c_set_get(params);
+		return i2c_set_get(&i2c_params, params);
 	default:
 		break;
 	}
@@ -399,5 +406,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = TA_ADI_I2C_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
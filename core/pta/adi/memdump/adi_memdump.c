@@ -165,8 +165,8 @@ static TEE_Result adi_memdump_handler(TEE_Param params[TEE_NUM_PARAMS])
 	uint32_t record_num = params[OP_PARAM_RECORD_AND_ADDRESS].value.a;
 	uint32_t tmp_address = 0;
 	memdump_registers_t record;
+	struct plat_io_map map;
 	void *base;
-	bool base_is_new_mmu_map = false;
 
 	/* Check validity of record number */
 	if (!valid_record_num(record_num)) {
@@ -215,16 +215,11 @@ static TEE_Result adi_memdump_handler(TEE_Param params[TEE_NUM_PARAMS])
 		}
 
 		/* Remap */
-		base = phys_to_virt_io(tmp_address, record.cpu_mem_width);
-		if (!base) {
-			/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-			base = core_mmu_add_mapping(MEM_AREA_IO_SEC, tmp_address, record.cpu_mem_width);
-			if (!base) {
-				plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
-				return TEE_ERROR_GENERIC;
-			}
-			base_is_new_mmu_map = true;
+		if (plat_io_map(tmp_address, record.cpu_mem_width / 8, &map) != TEE_SUCCESS) {
+			plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
+			return TEE_ERROR_GENERIC;
 		}
+		base = (void *)map.va;
 
 		/* Copy register contents to temp buffer */
 		if (record.cpu_mem_width == 64) {
@@ -256,20 +251,17 @@ static TEE_Result adi_memdump_handler(TEE_Param params[TEE_NUM_PARAMS])
 			plat_runtime_error_message("Not a valid register width %d", record.cpu_mem_width);
 
 			/* Remove mmu mapping and return error */
-			if (base_is_new_mmu_map)
-				core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, record.cpu_mem_width);
+			plat_io_unmap(&map);
 			return TEE_ERROR_GENERIC;
 		}
 
 		/* Increment address pointer */
 		tmp_address = tmp_address + record.cpu_mem_width / 8;
 
-		if (base_is_new_mmu_map) {
-			/* MMU remove mapping */
-			if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, record.cpu_mem_width) != TEE_SUCCESS) {
-				plat_runtime_error_message("%s READ  MMU address unmapping failure", TA_NAME);
-				return TEE_ERROR_GENERIC;
-			}
+		/* MMU remove mapping */
+		if (plat_io_unmap(&map) != TEE_SUCCESS) {
+			plat_runtime_error_message("%s READ  MMU address unmapping failure", TA_NAME);
+			return TEE_ERROR_GENERIC;
 		}
 	}
 
@@ -315,5 +307,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = TA_ADI_MEMDUMP_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
@@ -32,6 +32,7 @@
 #include <tee_internal_api.h>
 
 #include <adrv906x_def.h>
+#include <adrv906x_util.h>
 #include <common.h>
 
 #include <drivers/adi/adi_otp.h>
@@ -103,31 +104,23 @@ static TEE_Result otp_macs_check_params(uint32_t param_types, TEE_Param params[T
  */
 static TEE_Result otp_macs_read_handler(TEE_Param params[TEE_NUM_PARAMS])
 {
-	vaddr_t base;
+	struct plat_io_map map;
 	uint8_t interface = params[OP_PARAM_INTERFACE].value.a;
 	uint8_t mac[MAC_ADDRESS_NUM_BYTES];
-	bool base_is_new_mmu_map = false;
 	int ret;
 
-	base = (vaddr_t)phys_to_virt_io(OTP_BASE, SMALL_PAGE_SIZE);
-	if (!base) {
-		/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-		base = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, OTP_BASE, SMALL_PAGE_SIZE);
-		if (!base) {
-			plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
-		base_is_new_mmu_map = true;
+	if (plat_io_map(OTP_BASE, SMALL_PAGE_SIZE, &map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
-	ret = adrv906x_otp_get_mac_addr(base, interface, mac);
+	plat_otp_lock(OTP_BASE);
+	ret = adrv906x_otp_get_mac_addr(map.va, interface, mac);
+	plat_otp_unlock(OTP_BASE);
 
-	if (base_is_new_mmu_map) {
-		/* MMU remove mapping */
-		if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, SMALL_PAGE_SIZE) != TEE_SUCCESS) {
-			plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
+	if (plat_io_unmap(&map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	if (ret != ADI_OTP_SUCCESS)
@@ -146,11 +139,10 @@ static TEE_Result otp_macs_read_handler(TEE_Param params[TEE_NUM_PARAMS])
  */
 static TEE_Result otp_macs_write_handler(TEE_Param params[TEE_NUM_PARAMS])
 {
-	vaddr_t base;
+	struct plat_io_map map;
 	uint8_t interface = params[OP_PARAM_INTERFACE].value.a;
 	uint8_t mac[MAC_ADDRESS_NUM_BYTES];
 	uint8_t otp_mac[MAC_ADDRESS_NUM_BYTES];
-	bool base_is_new_mmu_map = false;
 	int ret;
 
 	mac[0] = params[OP_PARAM_MAC_VALUE].value.a >> 8 & 0xFF;
@@ -160,35 +152,28 @@ static TEE_Result otp_macs_write_handler(TEE_Param params[TEE_NUM_PARAMS])
 	mac[4] = params[OP_PARAM_MAC_VALUE].value.b >> 8 & 0xFF;
 	mac[5] = params[OP_PARAM_MAC_VALUE].value.b >> 0 & 0xFF;
 
-	base = (vaddr_t)phys_to_virt_io(OTP_BASE, SMALL_PAGE_SIZE);
-	if (!base) {
-		/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-		base = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, OTP_BASE, SMALL_PAGE_SIZE);
-		if (!base) {
-			plat_runtime_error_message("%s WRITE MMU address mapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
-		base_is_new_mmu_map = true;
+	if (plat_io_map(OTP_BASE, SMALL_PAGE_SIZE, &map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s WRITE MMU address mapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
-	/* Check no MAC is already stored in OTP */
-	ret = adrv906x_otp_get_mac_addr(base, interface, otp_mac);
+	/* Check no MAC is already stored in OTP, the lock keeps the check and write atomic */
+	plat_otp_lock(OTP_BASE);
+	ret = adrv906x_otp_get_mac_addr(map.va, interface, otp_mac);
 	if (ret == ADI_OTP_SUCCESS) {
 		if (mac_is_all_zeros(otp_mac)) {
 			/* No MAC in OTP, we can store the new MAC */
-			ret = adrv906x_otp_set_mac_addr(base, interface, mac);
+			ret = adrv906x_otp_set_mac_addr(map.va, interface, mac);
 		} else {
 			plat_runtime_error_message("%s: OTP already contains a MAC for interface %u. MAC write aborted", TA_NAME, interface);
 			ret = ADI_OTP_FAILURE;
 		}
 	}
+	plat_otp_unlock(OTP_BASE);
 
-	if (base_is_new_mmu_map) {
-		/* MMU remove mapping */
-		if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, SMALL_PAGE_SIZE) != TEE_SUCCESS) {
-			plat_runtime_error_message("%s WRITE MMU address unmapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
+	if (plat_io_unmap(&map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s WRITE MMU address unmapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	if (ret != ADI_OTP_SUCCESS)
@@ -225,5 +210,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = TA_OTP_MACS_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
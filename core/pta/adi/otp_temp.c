@@ -104,13 +104,11 @@ static TEE_Result otp_temp_check_params(uint32_t param_types, TEE_Param params[T
  */
 static TEE_Result otp_temp_read_handler(TEE_Param params[TEE_NUM_PARAMS])
 {
-	vaddr_t base;
+	struct plat_io_map map;
 	paddr_t otp_base;
 	adrv906x_temp_group_id_t temp_group_id = (adrv906x_temp_group_id_t)params[OP_PARAM_TEMP_GROUP_ID].value.a;
 	uint32_t value;
 	uint32_t tile = params[OP_PARAM_TILE].value.a;
-
-	bool base_is_new_mmu_map = false;
 	int ret;
 
 	switch (tile) {
@@ -125,25 +123,18 @@ static TEE_Result otp_temp_read_handler(TEE_Param params[TEE_NUM_PARAMS])
 		return TEE_ERROR_BAD_PARAMETERS;
 	}
 
-	base = (vaddr_t)phys_to_virt_io(otp_base, SMALL_PAGE_SIZE);
-	if (!base) {
-		/* MMU add mapping, to support addresses not registered with "register_phys_mem" */
-		base = (vaddr_t)core_mmu_add_mapping(MEM_AREA_IO_SEC, otp_base, SMALL_PAGE_SIZE);
-		if (!base) {
-			plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
-		base_is_new_mmu_map = true;
+	if (plat_io_map(otp_base, SMALL_PAGE_SIZE, &map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ MMU address mapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
-	ret = adrv906x_otp_get_temp_sensor(base, temp_group_id, &value);
+	plat_otp_lock(otp_base);
+	ret = adrv906x_otp_get_temp_sensor(map.va, temp_group_id, &value);
+	plat_otp_unlock(otp_base);
 
-	if (base_is_new_mmu_map) {
-		/* MMU remove mapping */
-		if (core_mmu_remove_mapping(MEM_AREA_IO_SEC, (void *)base, SMALL_PAGE_SIZE) != TEE_SUCCESS) {
-			plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
-			return TEE_ERROR_GENERIC;
-		}
+	if (plat_io_unmap(&map) != TEE_SUCCESS) {
+		plat_runtime_error_message("%s READ MMU address unmapping failure", TA_NAME);
+		return TEE_ERROR_GENERIC;
 	}
 
 	if (ret != ADI_OTP_SUCCESS) {
@@ -183,5 +174,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = TA_OTP_TEMP_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
@@ -4,6 +4,7 @@
  */
 
 #include <io.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
 #include <mm/core_memprot.h>
 
@@ -26,6 +27,9 @@
 
 #define SECONDARY_LAUNCHER_CMD_BOOT_SECONDARY    0
 
+/* Serializes the read-modify-write of the secondary host boot register */
+static struct mutex boot_reg_mutex = MUTEX_INITIALIZER;
+
 static TEE_Result set_boot_successful(void)
 {
 	vaddr_t addr;
@@ -37,9 +41,11 @@ static TEE_Result set_boot_successful(void)
 			addr = (vaddr_t)phys_to_virt_io(SEC_A55_SYS_CFG + HOST_BOOT_OFFSET, SMALL_PAGE_SIZE);
 			if (!addr)
 				return TEE_ERROR_GENERIC;
+			mutex_lock(&boot_reg_mutex);
 			reg = io_read32(addr);
 			reg |= HOST_BOOT_READY_MASK;
 			io_write32(addr, reg);
+			mutex_unlock(&boot_reg_mutex);
 			IMSG("Done\n");
 		} else {
 			plat_runtime_error_message("Refusing to initiate secondary boot. Not configured to boot Linux on secondary tile.");
@@ -70,5 +76,5 @@ static TEE_Result invoke_command(void *psess __unused,
 }
 
 pseudo_ta_register(.uuid = SECONDARY_LAUNCHER_PTA_UUID, .name = TA_NAME,
-		   .flags = PTA_DEFAULT_FLAGS,
+		   .flags = PTA_DEFAULT_FLAGS | TA_FLAG_CONCURRENT,
 		   .invoke_command_entry_point = invoke_command);
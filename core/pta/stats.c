@@ -5,8 +5,11 @@
 #include <compiler.h>
 #include <drivers/clk.h>
 #include <drivers/regulator.h>
+#include <kernel/mutex.h>
 #include <kernel/pseudo_ta.h>
 #include <kernel/tee_time.h>
+#include <kernel/thread.h>
+#include <kernel/wait_queue.h>
 #include <malloc.h>
 #include <mm/tee_mm.h>
 #include <mm/tee_pager.h>
@@ -203,6 +206,113 @@ static TEE_Result print_driver_info(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
 	return TEE_SUCCESS;
 }
 
+static TEE_Result get_malloc_cache_stats(uint32_t type,
+					 TEE_Param p[TEE_NUM_PARAMS])
+{
+	size_t count = 0;
+	size_t sz = 0;
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	count = malloc_get_cache_stats(NULL, 0);
+	if (!count)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	sz = count * sizeof(struct pta_stats_malloc_cache);
+	if (p[0].memref.size < sz) {
+		p[0].memref.size = sz;
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	p[0].memref.size = sz;
+	malloc_get_cache_stats(p[0].memref.buffer, count);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_mutex_stats(uint32_t type, TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pta_stats_mutex stats = { };
+	struct mutex_stats ms = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[0].memref.size < sizeof(stats)) {
+		p[0].memref.size = sizeof(stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	mutex_get_stats(&ms);
+	stats.contended = ms.contended;
+	stats.spin_acquired = ms.spin_acquired;
+	stats.spin_timeout = ms.spin_timeout;
+	stats.owner_inactive = ms.owner_inactive;
+	stats.sleep = ms.sleep;
+	p[0].memref.size = sizeof(stats);
+	memcpy(p[0].memref.buffer, &stats, sizeof(stats));
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_wait_queue_stats(uint32_t type,
+				       TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pta_stats_wait_queue stats = { };
+	struct wait_queue_stats wqs = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[0].memref.size < sizeof(stats)) {
+		p[0].memref.size = sizeof(stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	wq_get_stats(&wqs);
+	stats.waits = wqs.waits;
+	stats.wakeups = wqs.wakeups;
+	stats.contended = wqs.contended;
+	stats.max_queue_waits = wqs.max_queue_waits;
+	p[0].memref.size = sizeof(stats);
+	memcpy(p[0].memref.buffer, &stats, sizeof(stats));
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result get_thread_stats(uint32_t type,
+				   TEE_Param p[TEE_NUM_PARAMS])
+{
+	struct pta_stats_thread stats = { };
+
+	if (TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_OUTPUT,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE,
+			    TEE_PARAM_TYPE_NONE) != type)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	if (p[0].memref.size < sizeof(stats)) {
+		p[0].memref.size = sizeof(stats);
+		return TEE_ERROR_SHORT_BUFFER;
+	}
+
+	thread_get_stats(&stats);
+	p[0].memref.size = sizeof(stats);
+	memcpy(p[0].memref.buffer, &stats, sizeof(stats));
+
+	return TEE_SUCCESS;
+}
+
 /*
  * Trusted Application Entry Points
  */
@@ -224,6 +334,14 @@ static TEE_Result invoke_command(void *psess __unused,
 		return get_system_time(ptypes, params);
 	case STATS_CMD_PRINT_DRIVER_INFO:
 		return print_driver_info(ptypes, params);
+	case STATS_CMD_MALLOC_CACHE_STATS:
+		return get_malloc_cache_stats(ptypes, params);
+	case STATS_CMD_MUTEX_STATS:
+		return get_mutex_stats(ptypes, params);
+	case STATS_CMD_WAIT_QUEUE_STATS:
+		return get_wait_queue_stats(ptypes, params);
+	case STATS_CMD_THREAD_STATS:
+		return get_thread_stats(ptypes, params);
 	default:
 		break;
 	}
@@ -0,0 +1,757 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <config.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#include <kernel/thread.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee_api_defines.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <utee_defines.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define MAX_DATA_SIZE		(1024 * 1024)
+/* Bounds the time spent in one invocation */
+#define MAX_ITERATIONS		65536
+#define MAX_TOTAL_SIZE		(256 * 1024 * 1024)
+/* Buffers are allocated from the core heap, keep them bounded */
+#define DATA_CHUNK_SIZE		(64 * 1024)
+#define MAX_KEY_SIZE		64
+#define MAX_SIG_SIZE		512
+#define TAG_SIZE		16
+#define ED25519_SIG_SIZE	64
+
+struct crypto_perf_ctx {
+	struct pta_invoke_tests_crypto_perf *res;
+	uint8_t *src;
+	uint8_t *dst;
+	uint8_t key[MAX_KEY_SIZE];
+	uint8_t iv[TEE_AES_BLOCK_SIZE];
+	uint8_t tag[TAG_SIZE];
+	uint64_t start;
+	uint64_t t;
+	bool started;
+};
+
+/*
+ * Short operations may take less than a counter tick, the total is taken
+ * from the start of the first operation to the end of the last one
+ * rather than adding up the durations.
+ */
+static void op_start(struct crypto_perf_ctx *ctx)
+{
+	ctx->t = barrier_read_counter_timer();
+	if (!ctx->started) {
+		ctx->start = ctx->t;
+		ctx->started = true;
+	}
+}
+
+static void op_end(struct crypto_perf_ctx *ctx)
+{
+	uint64_t t = barrier_read_counter_timer();
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	uint64_t ticks = t - ctx->t;
+
+	r->total_ticks = t - ctx->start;
+	r->min_ticks = MIN(r->min_ticks, ticks);
+	r->max_ticks = MAX(r->max_ticks, ticks);
+}
+
+static bool is_encrypt(struct crypto_perf_ctx *ctx)
+{
+	return ctx->res->mode != TEE_MODE_DECRYPT;
+}
+
+static TEE_Result alloc_hash(void **ctx, uint32_t algo, uint32_t backend)
+{
+	switch (backend) {
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT:
+		return crypto_hash_alloc_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_SW:
+		return crypto_hash_alloc_sw_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DRV:
+		return drvcrypt_hash_alloc_ctx((struct crypto_hash_ctx **)ctx,
+					       algo);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static TEE_Result alloc_mac(void **ctx, uint32_t algo, uint32_t backend)
+{
+	switch (backend) {
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT:
+		return crypto_mac_alloc_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_SW:
+		return crypto_mac_alloc_sw_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DRV:
+		return drvcrypt_mac_alloc_ctx((struct crypto_mac_ctx **)ctx,
+					      algo);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static TEE_Result alloc_cipher(void **ctx, uint32_t algo, uint32_t backend)
+{
+	switch (backend) {
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT:
+		return crypto_cipher_alloc_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_SW:
+		return crypto_cipher_alloc_sw_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DRV:
+		return drvcrypt_cipher_alloc_ctx((struct crypto_cipher_ctx **)
+						 ctx, algo);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static TEE_Result alloc_authenc(void **ctx, uint32_t algo, uint32_t backend)
+{
+	switch (backend) {
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT:
+		return crypto_authenc_alloc_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_SW:
+		return crypto_authenc_alloc_sw_ctx(ctx, algo);
+	case PTA_INVOKE_TESTS_CRYPTO_PERF_DRV:
+		return drvcrypt_authenc_alloc_ctx((struct crypto_authenc_ctx **)
+						  ctx, algo);
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+static TEE_Result run_hash(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	TEE_Result res = TEE_SUCCESS;
+	void *hctx = NULL;
+	size_t left = 0;
+	size_t len = 0;
+	uint32_t n = 0;
+
+	res = alloc_hash(&hctx, r->algo, r->backend);
+	if (res)
+		return res;
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		res = crypto_hash_init(hctx);
+		for (left = r->data_size; !res && left; left -= len) {
+			len = MIN(left, (size_t)DATA_CHUNK_SIZE);
+			res = crypto_hash_update(hctx, ctx->src, len);
+		}
+		if (!res)
+			res = crypto_hash_final(hctx, ctx->dst,
+						TEE_MAX_HASH_SIZE);
+		op_end(ctx);
+	}
+
+	crypto_hash_free_ctx(hctx);
+
+	return res;
+}
+
+static TEE_Result run_mac(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	size_t mac_len = TEE_ALG_GET_DIGEST_SIZE(r->algo);
+	size_t key_len = r->key_size / 8;
+	TEE_Result res = TEE_SUCCESS;
+	void *mctx = NULL;
+	size_t left = 0;
+	size_t len = 0;
+	uint32_t n = 0;
+
+	if (!mac_len || key_len > MAX_KEY_SIZE)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = alloc_mac(&mctx, r->algo, r->backend);
+	if (res)
+		return res;
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		res = crypto_mac_init(mctx, ctx->key, key_len);
+		for (left = r->data_size; !res && left; left -= len) {
+			len = MIN(left, (size_t)DATA_CHUNK_SIZE);
+			res = crypto_mac_update(mctx, ctx->src, len);
+		}
+		if (!res)
+			res = crypto_mac_final(mctx, ctx->dst, mac_len);
+		op_end(ctx);
+	}
+
+	crypto_mac_free_ctx(mctx);
+
+	return res;
+}
+
+static TEE_Result run_cipher(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	TEE_OperationMode mode = TEE_MODE_ENCRYPT;
+	size_t key_len = r->key_size / 8;
+	TEE_Result res = TEE_SUCCESS;
+	const uint8_t *key2 = NULL;
+	size_t key2_len = 0;
+	void *cctx = NULL;
+	size_t iv_len = 0;
+	size_t left = 0;
+	size_t len = 0;
+	uint32_t n = 0;
+
+	if (!is_encrypt(ctx))
+		mode = TEE_MODE_DECRYPT;
+
+	switch (TEE_ALG_GET_CHAIN_MODE(r->algo)) {
+	case TEE_CHAIN_MODE_ECB_NOPAD:
+		break;
+	case TEE_CHAIN_MODE_XTS:
+		key2 = ctx->key + key_len;
+		key2_len = key_len;
+		iv_len = TEE_AES_BLOCK_SIZE;
+		break;
+	default:
+		if (TEE_ALG_GET_MAIN_ALG(r->algo) == TEE_MAIN_ALGO_DES ||
+		    TEE_ALG_GET_MAIN_ALG(r->algo) == TEE_MAIN_ALGO_DES3)
+			iv_len = TEE_DES_BLOCK_SIZE;
+		else
+			iv_len = TEE_AES_BLOCK_SIZE;
+		break;
+	}
+	if (key_len + key2_len > MAX_KEY_SIZE)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = alloc_cipher(&cctx, r->algo, r->backend);
+	if (res)
+		return res;
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		res = crypto_cipher_init(cctx, mode, ctx->key, key_len, key2,
+					 key2_len, ctx->iv, iv_len);
+		for (left = r->data_size; !res && left; left -= len) {
+			len = MIN(left, (size_t)DATA_CHUNK_SIZE);
+			res = crypto_cipher_update(cctx, mode, len == left,
+						   ctx->src, len, ctx->dst);
+		}
+		crypto_cipher_final(cctx);
+		op_end(ctx);
+	}
+
+	crypto_cipher_free_ctx(cctx);
+
+	return res;
+}
+
+static TEE_Result authenc_init(struct crypto_perf_ctx *ctx, void *actx,
+			       TEE_OperationMode mode)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+
+	return crypto_authenc_init(actx, mode, ctx->key, r->key_size / 8,
+				   ctx->iv, 12, TAG_SIZE, 0, r->data_size);
+}
+
+static TEE_Result authenc_op(struct crypto_perf_ctx *ctx, void *actx,
+			     TEE_OperationMode mode)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	TEE_Result res = TEE_SUCCESS;
+	size_t tag_len = TAG_SIZE;
+	size_t left = r->data_size;
+	size_t len = 0;
+
+	res = authenc_init(ctx, actx, mode);
+
+	while (!res && left > DATA_CHUNK_SIZE) {
+		len = DATA_CHUNK_SIZE;
+		res = crypto_authenc_update_payload(actx, mode, ctx->src,
+						    DATA_CHUNK_SIZE, ctx->dst,
+						    &len);
+		left -= DATA_CHUNK_SIZE;
+	}
+	if (res)
+		goto out;
+
+	len = left;
+	if (mode == TEE_MODE_ENCRYPT)
+		res = crypto_authenc_enc_final(actx, ctx->src, left, ctx->dst,
+					       &len, ctx->tag, &tag_len);
+	else
+		res = crypto_authenc_dec_final(actx, ctx->src, left, ctx->dst,
+					       &len, ctx->tag, TAG_SIZE);
+out:
+	crypto_authenc_final(actx);
+
+	return res;
+}
+
+/*
+ * Decryption needs a valid tag for the ciphertext, which is the source
+ * buffer repeated up to @data_size bytes. Get it by decrypting that
+ * ciphertext once and encrypting the plaintext again with a second
+ * context.
+ */
+static TEE_Result authenc_make_tag(struct crypto_perf_ctx *ctx, void *actx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	TEE_Result res = TEE_SUCCESS;
+	size_t tag_len = TAG_SIZE;
+	size_t left = r->data_size;
+	uint8_t *tmp = NULL;
+	void *ectx = NULL;
+	size_t chunk = 0;
+	size_t len = 0;
+
+	chunk = MIN(left, (size_t)DATA_CHUNK_SIZE);
+	tmp = malloc(MAX(chunk, (size_t)TAG_SIZE));
+	if (!tmp)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	res = alloc_authenc(&ectx, r->algo, r->backend);
+	if (res)
+		goto out_free;
+
+	res = authenc_init(ctx, actx, TEE_MODE_DECRYPT);
+	if (res)
+		goto out;
+	res = authenc_init(ctx, ectx, TEE_MODE_ENCRYPT);
+	if (res)
+		goto out_final;
+
+	do {
+		chunk = MIN(left, (size_t)DATA_CHUNK_SIZE);
+		len = chunk;
+		res = crypto_authenc_update_payload(actx, TEE_MODE_DECRYPT,
+						    ctx->src, chunk, ctx->dst,
+						    &len);
+		if (res)
+			break;
+
+		left -= chunk;
+		len = chunk;
+		if (left)
+			res = crypto_authenc_update_payload(ectx,
+							    TEE_MODE_ENCRYPT,
+							    ctx->dst, chunk,
+							    tmp, &len);
+		else
+			res = crypto_authenc_enc_final(ectx, ctx->dst, chunk,
+						       tmp, &len, ctx->tag,
+						       &tag_len);
+	} while (!res && left);
+
+	crypto_authenc_final(ectx);
+out_final:
+	crypto_authenc_final(actx);
+out:
+	crypto_authenc_free_ctx(ectx);
+out_free:
+	free(tmp);
+
+	return res;
+}
+
+static TEE_Result run_authenc(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	TEE_OperationMode mode = TEE_MODE_ENCRYPT;
+	TEE_Result res = TEE_SUCCESS;
+	void *actx = NULL;
+	uint32_t n = 0;
+
+	if (r->key_size / 8 > MAX_KEY_SIZE)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = alloc_authenc(&actx, r->algo, r->backend);
+	if (res)
+		return res;
+
+	if (!is_encrypt(ctx)) {
+		mode = TEE_MODE_DECRYPT;
+		res = authenc_make_tag(ctx, actx);
+	}
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		res = authenc_op(ctx, actx, mode);
+		op_end(ctx);
+	}
+
+	crypto_authenc_free_ctx(actx);
+
+	return res;
+}
+
+static uint32_t ecc_curve(uint32_t key_size)
+{
+	switch (key_size) {
+	case 192:
+		return TEE_ECC_CURVE_NIST_P192;
+	case 224:
+		return TEE_ECC_CURVE_NIST_P224;
+	case 256:
+		return TEE_ECC_CURVE_NIST_P256;
+	case 384:
+		return TEE_ECC_CURVE_NIST_P384;
+	case 521:
+		return TEE_ECC_CURVE_NIST_P521;
+	default:
+		return 0;
+	}
+}
+
+static TEE_Result run_ecc(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	bool ecdh = TEE_ALG_GET_MAIN_ALG(r->algo) == TEE_MAIN_ALGO_ECDH;
+	size_t msg_len = TEE_ALG_GET_DIGEST_SIZE(r->algo);
+	uint32_t curve = ecc_curve(r->key_size);
+	struct ecc_public_key pub = { };
+	struct ecc_keypair key = { };
+	TEE_Result res = TEE_SUCCESS;
+	unsigned long secret_len = 0;
+	size_t sig_len = 0;
+	uint32_t n = 0;
+
+	if (!curve)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = crypto_acipher_alloc_ecc_keypair(&key, ecdh ?
+					       TEE_TYPE_ECDH_KEYPAIR :
+					       TEE_TYPE_ECDSA_KEYPAIR,
+					       r->key_size);
+	if (res)
+		return res;
+	res = crypto_acipher_alloc_ecc_public_key(&pub, ecdh ?
+						  TEE_TYPE_ECDH_PUBLIC_KEY :
+						  TEE_TYPE_ECDSA_PUBLIC_KEY,
+						  r->key_size);
+	if (res)
+		goto out_key;
+
+	key.curve = curve;
+	res = crypto_acipher_gen_ecc_key(&key, r->key_size);
+	if (res)
+		goto out;
+	pub.curve = curve;
+	crypto_bignum_copy(pub.x, key.x);
+	crypto_bignum_copy(pub.y, key.y);
+
+	if (!ecdh) {
+		/* Signature to verify, also warms up per-curve tables */
+		sig_len = MAX_SIG_SIZE;
+		res = crypto_acipher_ecc_sign(r->algo, &key, ctx->src,
+					      msg_len, ctx->dst, &sig_len);
+	}
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		if (ecdh) {
+			secret_len = MAX_SIG_SIZE;
+			res = crypto_acipher_ecc_shared_secret(&key, &pub,
+							       ctx->dst,
+							       &secret_len);
+		} else if (r->mode == TEE_MODE_VERIFY) {
+			res = crypto_acipher_ecc_verify(r->algo, &pub,
+							ctx->src, msg_len,
+							ctx->dst, sig_len);
+		} else {
+			sig_len = MAX_SIG_SIZE;
+			res = crypto_acipher_ecc_sign(r->algo, &key, ctx->src,
+						      msg_len, ctx->dst,
+						      &sig_len);
+		}
+		op_end(ctx);
+	}
+
+out:
+	crypto_acipher_free_ecc_public_key(&pub);
+out_key:
+	crypto_bignum_free(&key.d);
+	crypto_bignum_free(&key.x);
+	crypto_bignum_free(&key.y);
+
+	return res;
+}
+
+static TEE_Result run_rsa(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	uint32_t e = TEE_U32_TO_BIG_ENDIAN(65537);
+	size_t msg_len = TEE_ALG_GET_DIGEST_SIZE(r->algo);
+	struct rsa_public_key pub = { };
+	struct rsa_keypair key = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t sig_len = 0;
+	uint32_t n = 0;
+
+	if (r->key_size / 8 > MAX_SIG_SIZE ||
+	    TEE_ALG_GET_CLASS(r->algo) != TEE_OPERATION_ASYMMETRIC_SIGNATURE)
+		return TEE_ERROR_NOT_SUPPORTED;
+	if (!msg_len)
+		msg_len = TEE_ALG_GET_DIGEST_SIZE(TEE_ALG_SHA256);
+
+	res = crypto_acipher_alloc_rsa_keypair(&key, r->key_size);
+	if (res)
+		return res;
+	res = crypto_acipher_alloc_rsa_public_key(&pub, r->key_size);
+	if (res)
+		goto out_key;
+
+	res = crypto_bignum_bin2bn((const uint8_t *)&e, sizeof(e), key.e);
+	if (!res)
+		res = crypto_acipher_gen_rsa_key(&key, r->key_size);
+	if (res)
+		goto out;
+	crypto_bignum_copy(pub.e, key.e);
+	crypto_bignum_copy(pub.n, key.n);
+
+	sig_len = MAX_SIG_SIZE;
+	res = crypto_acipher_rsassa_sign(r->algo, &key, -1, ctx->src, msg_len,
+					 ctx->dst, &sig_len);
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		if (r->mode == TEE_MODE_VERIFY) {
+			res = crypto_acipher_rsassa_verify(r->algo, &pub, -1,
+							   ctx->src, msg_len,
+							   ctx->dst, sig_len);
+		} else {
+			sig_len = MAX_SIG_SIZE;
+			res = crypto_acipher_rsassa_sign(r->algo, &key, -1,
+							 ctx->src, msg_len,
+							 ctx->dst, &sig_len);
+		}
+		op_end(ctx);
+	}
+
+out:
+	crypto_acipher_free_rsa_public_key(&pub);
+out_key:
+	crypto_acipher_free_rsa_keypair(&key);
+
+	return res;
+}
+
+static TEE_Result run_ed25519(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	struct ed25519_public_key pub = { };
+	struct ed25519_keypair key = { };
+	uint8_t sig[ED25519_SIG_SIZE] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t sig_len = 0;
+	uint32_t n = 0;
+
+	/* The message must be contiguous */
+	if (r->data_size > DATA_CHUNK_SIZE)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	res = crypto_acipher_alloc_ed25519_keypair(&key, 256);
+	if (res)
+		return res;
+
+	res = crypto_acipher_gen_ed25519_key(&key, 256);
+	if (res)
+		goto out;
+	pub.pub = key.pub;
+	pub.curve = key.curve;
+
+	sig_len = sizeof(sig);
+	res = crypto_acipher_ed25519_sign(&key, ctx->src, r->data_size, sig,
+					  &sig_len);
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		if (r->mode == TEE_MODE_VERIFY) {
+			res = crypto_acipher_ed25519_verify(&pub, ctx->src,
+							    r->data_size, sig,
+							    sig_len);
+		} else {
+			sig_len = sizeof(sig);
+			res = crypto_acipher_ed25519_sign(&key, ctx->src,
+							  r->data_size, sig,
+							  &sig_len);
+		}
+		op_end(ctx);
+	}
+
+out:
+	free(key.priv);
+	free(key.pub);
+
+	return res;
+}
+
+static TEE_Result run_x25519(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+	struct montgomery_keypair key = { };
+	TEE_Result res = TEE_SUCCESS;
+	unsigned long secret_len = 0;
+	uint32_t n = 0;
+
+	res = crypto_acipher_alloc_x25519_keypair(&key, 256);
+	if (res)
+		return res;
+
+	res = crypto_acipher_gen_x25519_key(&key, 256);
+
+	for (n = 0; !res && n < r->iterations; n++) {
+		op_start(ctx);
+		secret_len = MAX_SIG_SIZE;
+		res = crypto_acipher_x25519_shared_secret(&key, key.pub,
+							  ctx->dst,
+							  &secret_len);
+		op_end(ctx);
+	}
+
+	free(key.priv);
+	free(key.pub);
+
+	return res;
+}
+
+static TEE_Result run_asym(struct crypto_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_crypto_perf *r = ctx->res;
+
+	/* Only the default implementation is reachable for these */
+	if (r->backend != PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT)
+		return TEE_ERROR_NOT_SUPPORTED;
+
+	switch (TEE_ALG_GET_MAIN_ALG(r->algo)) {
+	case TEE_MAIN_ALGO_ECDSA:
+	case TEE_MAIN_ALGO_ECDH:
+		return run_ecc(ctx);
+	case TEE_MAIN_ALGO_RSA:
+		return run_rsa(ctx);
+	case TEE_MAIN_ALGO_ED25519:
+		return run_ed25519(ctx);
+	case TEE_MAIN_ALGO_X25519:
+		return run_x25519(ctx);
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
+static TEE_Result run_benchmark(struct crypto_perf_ctx *ctx)
+{
+	switch (TEE_ALG_GET_CLASS(ctx->res->algo)) {
+	case TEE_OPERATION_DIGEST:
+		return run_hash(ctx);
+	case TEE_OPERATION_MAC:
+		return run_mac(ctx);
+	case TEE_OPERATION_CIPHER:
+		return run_cipher(ctx);
+	case TEE_OPERATION_AE:
+		return run_authenc(ctx);
+	case TEE_OPERATION_ASYMMETRIC_SIGNATURE:
+	case TEE_OPERATION_KEY_DERIVATION:
+		return run_asym(ctx);
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+}
+
+static void compute_rates(struct pta_invoke_tests_crypto_perf *r)
+{
+	uint64_t bytes = (uint64_t)r->data_size * r->iterations;
+	/* A run shorter than a tick is accounted as one tick */
+	uint64_t ticks = MAX(r->total_ticks, 1);
+	uint64_t cycles = 0;
+
+	r->ops_per_sec = (uint64_t)r->iterations * r->cntfrq / ticks;
+	r->kib_per_sec = bytes / 1024 * r->cntfrq / ticks;
+
+	if (!r->cpu_mhz || r->cntfrq < 1000)
+		return;
+
+	/* Scale in two steps to keep the intermediate values in range */
+	cycles = ticks * r->cpu_mhz * 1000 / (r->cntfrq / 1000);
+	r->cycles_per_op = cycles / r->iterations;
+	if (bytes)
+		r->cycles_per_byte_x100 = cycles * 100 / bytes;
+}
+
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	struct pta_invoke_tests_crypto_perf r = { };
+	struct crypto_perf_ctx ctx = { .res = &r };
+	TEE_Result res = TEE_SUCCESS;
+	size_t buf_size = 0;
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (params[0].memref.size < sizeof(r))
+		return TEE_ERROR_SHORT_BUFFER;
+
+	/* Work on a private copy, the client may modify shared memory */
+	memcpy(&r, params[0].memref.buffer, sizeof(r));
+	memset((uint8_t *)&r + offsetof(struct pta_invoke_tests_crypto_perf,
+					 cntfrq), 0,
+	       sizeof(r) -
+	       offsetof(struct pta_invoke_tests_crypto_perf, cntfrq));
+
+	if (!r.iterations || r.iterations > MAX_ITERATIONS ||
+	    r.data_size > MAX_DATA_SIZE ||
+	    (uint64_t)r.data_size * r.iterations > MAX_TOTAL_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	r.cntfrq = read_cntfrq();
+	r.min_ticks = UINT64_MAX;
+
+	/* Room for signatures and digests even when hashing nothing */
+	buf_size = MIN(r.data_size, DATA_CHUNK_SIZE);
+	buf_size = MAX(buf_size, (size_t)MAX_SIG_SIZE);
+	ctx.src = malloc(buf_size);
+	ctx.dst = malloc(buf_size);
+	if (!ctx.src || !ctx.dst) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	for (n = 0; n < buf_size; n++)
+		ctx.src[n] = n;
+	for (n = 0; n < sizeof(ctx.key); n++)
+		ctx.key[n] = n;
+	for (n = 0; n < sizeof(ctx.iv); n++)
+		ctx.iv[n] = 0xA0 + n;
+
+	res = run_benchmark(&ctx);
+	if (res) {
+		DMSG("algo %#"PRIx32" backend %"PRIu32": %#"PRIx32,
+		     r.algo, r.backend, res);
+		goto out;
+	}
+
+	compute_rates(&r);
+	if (IS_ENABLED(CFG_CRYPTO_WITH_CE))
+		r.flags |= PTA_INVOKE_TESTS_CRYPTO_PERF_FLAG_CE;
+
+	memcpy(params[0].memref.buffer, &r, sizeof(r));
+out:
+	free(ctx.src);
+	free(ctx.dst);
+
+	return res;
+}
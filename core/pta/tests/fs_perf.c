@@ -0,0 +1,431 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <kernel/thread.h>
+#include <kernel/ts_manager.h>
+#include <pta_invoke_tests.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tee/fs_htree.h>
+#include <tee/fs_perf.h>
+#include <tee/tee_fs.h>
+#include <tee/tee_fs_rpc.h>
+#include <tee/tee_pobj.h>
+#include <trace.h>
+#include <types_ext.h>
+#include <util.h>
+
+#include "misc.h"
+
+#define BLOCK_SIZE	PTA_INVOKE_TESTS_FS_PERF_BLOCK_SIZE
+
+/* Bounds the heap used for the I/O buffer of the REE FS and RPMB backends */
+#define MAX_IO_SIZE	(4 * BLOCK_SIZE)
+
+/*
+ * In-memory stand-in for tee-supplicant used by the
+ * PTA_INVOKE_TESTS_FS_PERF_HTREE_MEM backend. Encrypted blocks are placed
+ * directly in the non-secure buffer supplied by the client, just like
+ * tee-supplicant would find them in shared memory.
+ */
+struct mem_store {
+	uint8_t *data;
+	size_t data_len;
+	size_t size;
+};
+
+struct fs_perf_ctx {
+	struct pta_invoke_tests_fs_perf *res;
+	struct mem_store store;
+	const struct tee_file_operations *fops;
+	const TEE_UUID *uuid;
+	uint8_t *buf;
+	uint32_t seed;
+	uint32_t rnd;
+};
+
+static void *uint_to_ptr(uintptr_t p)
+{
+	return (void *)p;
+}
+
+static TEE_Result mem_get_offs_size(enum tee_fs_htree_type type, size_t idx,
+				    uint8_t vers, size_t *offs, size_t *size)
+{
+	/*
+	 * File layout, one physical block per node image pair and data
+	 * block version:
+	 *
+	 * phys block 0:		tee_fs_htree_image vers 0 and 1
+	 * phys block 1 + 3 * n:	tee_fs_htree_node_image n vers 0 and 1
+	 * phys block 2 + 3 * n:	data block n vers 0
+	 * phys block 3 + 3 * n:	data block n vers 1
+	 */
+	switch (type) {
+	case TEE_FS_HTREE_TYPE_HEAD:
+		*offs = sizeof(struct tee_fs_htree_image) * vers;
+		*size = sizeof(struct tee_fs_htree_image);
+		return TEE_SUCCESS;
+	case TEE_FS_HTREE_TYPE_NODE:
+		*offs = (1 + 3 * idx) * BLOCK_SIZE +
+			sizeof(struct tee_fs_htree_node_image) * vers;
+		*size = sizeof(struct tee_fs_htree_node_image);
+		return TEE_SUCCESS;
+	case TEE_FS_HTREE_TYPE_BLOCK:
+		*offs = (2 + 3 * idx + vers) * BLOCK_SIZE;
+		*size = BLOCK_SIZE;
+		return TEE_SUCCESS;
+	default:
+		return TEE_ERROR_GENERIC;
+	}
+}
+
+static TEE_Result mem_rpc_init(void *aux, struct tee_fs_rpc_operation *op,
+			       enum tee_fs_htree_type type, size_t idx,
+			       uint8_t vers, void **data)
+{
+	TEE_Result res = TEE_SUCCESS;
+	struct mem_store *s = aux;
+	size_t offs = 0;
+	size_t sz = 0;
+
+	res = mem_get_offs_size(type, idx, vers, &offs, &sz);
+	if (res)
+		return res;
+	if (offs + sz > s->size)
+		return TEE_ERROR_STORAGE_NO_SPACE;
+
+	memset(op, 0, sizeof(*op));
+	op->params[0].u.value.a = (vaddr_t)aux;
+	op->params[0].u.value.b = offs;
+	op->params[0].u.value.c = sz;
+	*data = s->data + offs;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result mem_read_final(struct tee_fs_rpc_operation *op,
+				 size_t *bytes)
+{
+	struct mem_store *s = uint_to_ptr(op->params[0].u.value.a);
+	size_t offs = op->params[0].u.value.b;
+	size_t sz = op->params[0].u.value.c;
+
+	if (offs + sz <= s->data_len)
+		*bytes = sz;
+	else if (offs <= s->data_len)
+		*bytes = s->data_len - offs;
+	else
+		*bytes = 0;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result mem_write_final(struct tee_fs_rpc_operation *op)
+{
+	struct mem_store *s = uint_to_ptr(op->params[0].u.value.a);
+	size_t end = op->params[0].u.value.b + op->params[0].u.value.c;
+
+	if (end > s->data_len)
+		s->data_len = end;
+
+	return TEE_SUCCESS;
+}
+
+static const struct tee_fs_htree_storage mem_htree_ops = {
+	.block_size = BLOCK_SIZE,
+	.rpc_read_init = mem_rpc_init,
+	.rpc_read_final = mem_read_final,
+	.rpc_write_init = mem_rpc_init,
+	.rpc_write_final = mem_write_final,
+};
+
+static uint32_t next_rnd(struct fs_perf_ctx *ctx)
+{
+	/* xorshift32, good enough to scatter block accesses */
+	ctx->rnd ^= ctx->rnd << 13;
+	ctx->rnd ^= ctx->rnd >> 17;
+	ctx->rnd ^= ctx->rnd << 5;
+
+	return ctx->rnd;
+}
+
+/* Returns the object offset of I/O number @n out of @count */
+static size_t io_offset(struct fs_perf_ctx *ctx, size_t n, size_t count)
+{
+	switch (ctx->res->pattern) {
+	case PTA_INVOKE_TESTS_FS_PERF_RANDOM:
+		return (next_rnd(ctx) % count) * ctx->res->io_size;
+	case PTA_INVOKE_TESTS_FS_PERF_REWRITE:
+		return 0;
+	default:
+		return n * ctx->res->io_size;
+	}
+}
+
+static void update_time(uint64_t *total, uint64_t *max, uint64_t begin)
+{
+	uint64_t t = barrier_read_counter_timer() - begin;
+
+	*total += t;
+	if (max && t > *max)
+		*max = t;
+}
+
+static TEE_Result htree_rw(struct fs_perf_ctx *ctx, struct tee_fs_htree **ht,
+			   bool write, size_t offs)
+{
+	struct pta_invoke_tests_fs_perf *r = ctx->res;
+	TEE_Result res = TEE_SUCCESS;
+	size_t bn = offs / BLOCK_SIZE;
+	size_t n = 0;
+
+	for (n = 0; n < r->io_size / BLOCK_SIZE; n++) {
+		if (write)
+			res = tee_fs_htree_write_block(ht, bn + n, ctx->buf);
+		else
+			res = tee_fs_htree_read_block(ht, bn + n, ctx->buf);
+		if (res)
+			return res;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result run_htree_obj(struct fs_perf_ctx *ctx, size_t count)
+{
+	struct pta_invoke_tests_fs_perf *r = ctx->res;
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE] = { };
+	struct tee_fs_htree *ht = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	ctx->store.data_len = 0;
+	ctx->rnd = ctx->seed;
+
+	t = barrier_read_counter_timer();
+	res = tee_fs_htree_open(true, hash, 0, ctx->uuid, &mem_htree_ops,
+				&ctx->store, &ht);
+	update_time(&r->create_ticks, NULL, t);
+	if (res)
+		return res;
+
+	for (n = 0; n < count; n++) {
+		t = barrier_read_counter_timer();
+		res = htree_rw(ctx, &ht, true, io_offset(ctx, n, count));
+		if (!res && r->sync_every && !((n + 1) % r->sync_every))
+			res = tee_fs_htree_sync_to_storage(&ht, hash, NULL);
+		update_time(&r->write_ticks, &r->max_write_ticks, t);
+		if (res)
+			return res;
+		r->write_count++;
+	}
+
+	res = tee_fs_htree_sync_to_storage(&ht, hash, NULL);
+	if (res)
+		return res;
+
+	/* Read back the same chunks in the same order */
+	ctx->rnd = ctx->seed;
+	for (n = 0; n < count; n++) {
+		t = barrier_read_counter_timer();
+		res = htree_rw(ctx, &ht, false, io_offset(ctx, n, count));
+		update_time(&r->read_ticks, &r->max_read_ticks, t);
+		if (res)
+			goto out;
+		r->read_count++;
+	}
+
+out:
+	t = barrier_read_counter_timer();
+	tee_fs_htree_close(&ht);
+	update_time(&r->remove_ticks, NULL, t);
+
+	return res;
+}
+
+static TEE_Result run_file_obj(struct fs_perf_ctx *ctx, size_t obj_num,
+			       size_t count)
+{
+	struct pta_invoke_tests_fs_perf *r = ctx->res;
+	struct tee_file_handle *fh = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct tee_pobj *po = NULL;
+	char oid[32] = { };
+	size_t len = 0;
+	uint64_t t = 0;
+	size_t n = 0;
+
+	ctx->rnd = ctx->seed;
+	snprintf(oid, sizeof(oid), "fs_perf.%"PRIu32".%zu", r->instance,
+		 obj_num);
+
+	t = barrier_read_counter_timer();
+	res = tee_pobj_get((TEE_UUID *)ctx->uuid, oid, strlen(oid),
+			   TEE_DATA_FLAG_ACCESS_WRITE_META,
+			   TEE_POBJ_USAGE_CREATE, ctx->fops, &po);
+	if (res)
+		return res;
+	res = ctx->fops->create(po, true, NULL, 0, NULL, 0, NULL, NULL, 0,
+				&fh);
+	update_time(&r->create_ticks, NULL, t);
+	if (res)
+		goto out_release;
+	tee_pobj_create_final(po);
+
+	for (n = 0; n < count; n++) {
+		t = barrier_read_counter_timer();
+		res = ctx->fops->write(fh, io_offset(ctx, n, count), ctx->buf,
+				       NULL, r->io_size);
+		update_time(&r->write_ticks, &r->max_write_ticks, t);
+		if (res)
+			goto out_close;
+		r->write_count++;
+	}
+
+	ctx->rnd = ctx->seed;
+	for (n = 0; n < count; n++) {
+		len = r->io_size;
+		t = barrier_read_counter_timer();
+		res = ctx->fops->read(fh, io_offset(ctx, n, count), ctx->buf,
+				      NULL, &len);
+		update_time(&r->read_ticks, &r->max_read_ticks, t);
+		if (res)
+			goto out_close;
+		r->read_count++;
+	}
+
+out_close:
+	t = barrier_read_counter_timer();
+	ctx->fops->close(&fh);
+	if (ctx->fops->remove(po) && !res)
+		res = TEE_ERROR_GENERIC;
+	update_time(&r->remove_ticks, NULL, t);
+out_release:
+	tee_pobj_release(po);
+
+	return res;
+}
+
+static TEE_Result run_benchmark(struct fs_perf_ctx *ctx)
+{
+	struct pta_invoke_tests_fs_perf *r = ctx->res;
+	size_t count = r->obj_size / r->io_size;
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	for (n = 0; n < r->num_objs; n++) {
+		if (ctx->fops)
+			res = run_file_obj(ctx, n, count);
+		else
+			res = run_htree_obj(ctx, count);
+		if (res) {
+			EMSG("Object %zu: error %#"PRIx32, n, res);
+			return res;
+		}
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result init_ctx(struct fs_perf_ctx *ctx, TEE_Param *store)
+{
+	struct pta_invoke_tests_fs_perf *r = ctx->res;
+
+	if (!r->io_size || !r->obj_size || r->obj_size % r->io_size ||
+	    r->pattern > PTA_INVOKE_TESTS_FS_PERF_REWRITE)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	switch (r->backend) {
+	case PTA_INVOKE_TESTS_FS_PERF_HTREE_MEM:
+		if (r->io_size % BLOCK_SIZE || !store ||
+		    !store->memref.buffer ||
+		    store->memref.size <
+		    PTA_INVOKE_TESTS_FS_PERF_STORE_SIZE(r->obj_size))
+			return TEE_ERROR_BAD_PARAMETERS;
+		ctx->store.data = store->memref.buffer;
+		ctx->store.size = store->memref.size;
+		break;
+#ifdef CFG_REE_FS
+	case PTA_INVOKE_TESTS_FS_PERF_REE:
+		ctx->fops = &ree_fs_ops;
+		break;
+#endif
+#ifdef CFG_RPMB_FS
+	case PTA_INVOKE_TESTS_FS_PERF_RPMB:
+		ctx->fops = &rpmb_fs_ops;
+		break;
+#endif
+	default:
+		return TEE_ERROR_NOT_SUPPORTED;
+	}
+
+	if (r->io_size > MAX_IO_SIZE)
+		return TEE_ERROR_BAD_PARAMETERS;
+	ctx->buf = malloc(r->io_size);
+	if (!ctx->buf)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	memset(ctx->buf, 0x5a, r->io_size);
+
+	ctx->uuid = &ts_get_current_session()->ctx->uuid;
+	ctx->seed = r->instance * 2654435761U + 1;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_MEMREF_INOUT,
+					  TEE_PARAM_TYPE_NONE,
+					  TEE_PARAM_TYPE_NONE);
+	uint32_t exp_pt_no_store = TEE_PARAM_TYPES(TEE_PARAM_TYPE_MEMREF_INOUT,
+						   TEE_PARAM_TYPE_NONE,
+						   TEE_PARAM_TYPE_NONE,
+						   TEE_PARAM_TYPE_NONE);
+	struct tee_fs_perf_stats stats = { };
+	struct pta_invoke_tests_fs_perf r = { };
+	struct fs_perf_ctx ctx = { .res = &r };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (param_types != exp_pt && param_types != exp_pt_no_store)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (params[0].memref.size < sizeof(r))
+		return TEE_ERROR_SHORT_BUFFER;
+
+	/* Work on a private copy, the client may modify shared memory */
+	memcpy(&r, params[0].memref.buffer, sizeof(r));
+	memset((uint8_t *)&r + offsetof(struct pta_invoke_tests_fs_perf,
+					 cntfrq), 0,
+	       sizeof(r) - offsetof(struct pta_invoke_tests_fs_perf,
+				    cntfrq));
+
+	if (param_types == exp_pt)
+		res = init_ctx(&ctx, params + 1);
+	else
+		res = init_ctx(&ctx, NULL);
+	if (res)
+		return res;
+
+	r.cntfrq = read_cntfrq();
+	tee_fs_perf_attach(&stats);
+	res = run_benchmark(&ctx);
+	tee_fs_perf_detach();
+	free(ctx.buf);
+
+	COMPILE_TIME_ASSERT(PTA_INVOKE_TESTS_FS_PERF_PHASES ==
+			    TEE_FS_PERF_PHASE_COUNT);
+	for (n = 0; n < TEE_FS_PERF_PHASE_COUNT; n++) {
+		r.phase_ticks[n] = stats.ticks[n];
+		r.phase_count[n] = stats.count[n];
+	}
+	memcpy(params[0].memref.buffer, &r, sizeof(r));
+
+	return res;
+}
@@ -424,6 +424,8 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 #if defined(CFG_REE_FS) && defined(CFG_WITH_USER_TA)
 	case PTA_INVOKE_TESTS_CMD_FS_HTREE:
 		return core_fs_htree_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_FS_PERF:
+		return core_fs_perf_tests(nParamTypes, pParams);
 #endif
 	case PTA_INVOKE_TESTS_CMD_MUTEX:
 		return core_mutex_tests(nParamTypes, pParams);
@@ -433,6 +435,10 @@ static TEE_Result invoke_command(void *pSessionContext __unused,
 		return core_aes_perf_tests(nParamTypes, pParams);
 	case PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS:
 		return core_dt_driver_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_MM_PERF:
+		return core_mm_perf_tests(nParamTypes, pParams);
+	case PTA_INVOKE_TESTS_CMD_CRYPTO_PERF:
+		return core_crypto_perf_tests(nParamTypes, pParams);
 	default:
 		break;
 	}
@@ -4,11 +4,18 @@
  */
 #include <assert.h>
 #include <config.h>
+#include <crypto/crypto.h>
+#include <crypto/crypto_impl.h>
+#ifdef CFG_CRYPTO_DRV_QUEUE
+#include <drvcrypt_queue.h>
+#endif
 #include <kernel/dt_driver.h>
 #include <malloc.h>
 #include <stdbool.h>
+#include <string.h>
 #include <trace.h>
 #include <kernel/panic.h>
+#include <utee_defines.h>
 #include <util.h>
 
 #include "misc.h"
@@ -551,6 +558,573 @@ static int self_test_nex_malloc(void)
 }
 #endif
 
+#ifdef CFG_CRYPTO_SHA256
+static int sha256_ref(struct crypto_sha256_mb_job *job, uint8_t *digest)
+{
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+	size_t n = 0;
+
+	if (crypto_hash_alloc_ctx(&ctx, TEE_ALG_SHA256))
+		return -1;
+	res = crypto_hash_init(ctx);
+	for (n = 0; !res && n < job->num_segs; n++)
+		res = crypto_hash_update(ctx, job->seg[n].data,
+					 job->seg[n].len);
+	if (!res)
+		res = crypto_hash_final(ctx, digest, TEE_SHA256_HASH_SIZE);
+	crypto_hash_free_ctx(ctx);
+
+	return res ? -1 : 0;
+}
+
+static int self_test_sha256_mb(void)
+{
+	static const size_t len[] = { 0, 55, 56, 64, 119, 1000, 130 };
+	struct crypto_sha256_mb_job job[ARRAY_SIZE(len)] = { };
+	uint8_t digest[ARRAY_SIZE(len)][TEE_SHA256_HASH_SIZE] = { };
+	uint8_t ref[TEE_SHA256_HASH_SIZE] = { };
+	uint8_t *buf = NULL;
+	size_t offs = 0;
+	size_t n = 0;
+	size_t m = 0;
+	int ret = -1;
+
+	LOG("");
+	LOG("sha256_mb test:");
+
+	buf = malloc(1000);
+	if (!buf)
+		return -1;
+	for (n = 0; n < 1000; n++)
+		buf[n] = n * 7 + 3;
+
+	/* Split each message in up to n + 1 segments of varying size */
+	for (n = 0; n < ARRAY_SIZE(len); n++) {
+		offs = 0;
+		for (m = 0; m <= n % CRYPTO_SHA256_MB_MAX_SEGS; m++) {
+			job[n].seg[m].data = buf + offs;
+			if (m == n % CRYPTO_SHA256_MB_MAX_SEGS)
+				job[n].seg[m].len = len[n] - offs;
+			else
+				job[n].seg[m].len = (len[n] - offs) / 3;
+			offs += job[n].seg[m].len;
+		}
+		job[n].num_segs = m;
+		job[n].digest = digest[n];
+	}
+
+	if (crypto_sha256_mb(job, ARRAY_SIZE(job))) {
+		LOG("- crypto_sha256_mb failed");
+		goto out;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(job); n++) {
+		if (sha256_ref(job + n, ref) ||
+		    memcmp(ref, digest[n], sizeof(ref))) {
+			LOG("- digest mismatch for message %zu", n);
+			goto out;
+		}
+	}
+	ret = 0;
+	LOG("- %zu digests match", ARRAY_SIZE(job));
+out:
+	free(buf);
+	LOG("sha256_mb test done");
+
+	return ret;
+}
+#else
+static int self_test_sha256_mb(void)
+{
+	return 0;
+}
+#endif
+
+#ifdef CFG_CRYPTO_SM4
+/* RFC 8998 appendix A.1 (SM4-GCM) and A.2 (SM4-CCM) */
+static const uint8_t sm4_ae_key[] = {
+	0x01, 0x23, 0x45, 0x67, 0x89, 0xab, 0xcd, 0xef,
+	0xfe, 0xdc, 0xba, 0x98, 0x76, 0x54, 0x32, 0x10,
+};
+static const uint8_t sm4_ae_nonce[] = {
+	0x00, 0x00, 0x12, 0x34, 0x56, 0x78, 0x00, 0x00,
+	0x00, 0x00, 0xab, 0xcd,
+};
+static const uint8_t sm4_ae_aad[] = {
+	0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+	0xfe, 0xed, 0xfa, 0xce, 0xde, 0xad, 0xbe, 0xef,
+	0xab, 0xad, 0xda, 0xd2,
+};
+static const uint8_t sm4_ae_pt[] = {
+	0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+	0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb, 0xbb,
+	0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc, 0xcc,
+	0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd, 0xdd,
+	0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee,
+	0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+	0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee, 0xee,
+	0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+};
+static const uint8_t sm4_gcm_ct[] = {
+	0x17, 0xf3, 0x99, 0xf0, 0x8c, 0x67, 0xd5, 0xee,
+	0x19, 0xd0, 0xdc, 0x99, 0x69, 0xc4, 0xbb, 0x7d,
+	0x5f, 0xd4, 0x6f, 0xd3, 0x75, 0x64, 0x89, 0x06,
+	0x91, 0x57, 0xb2, 0x82, 0xbb, 0x20, 0x07, 0x35,
+	0xd8, 0x27, 0x10, 0xca, 0x5c, 0x22, 0xf0, 0xcc,
+	0xfa, 0x7c, 0xbf, 0x93, 0xd4, 0x96, 0xac, 0x15,
+	0xa5, 0x68, 0x34, 0xcb, 0xcf, 0x98, 0xc3, 0x97,
+	0xb4, 0x02, 0x4a, 0x26, 0x91, 0x23, 0x3b, 0x8d,
+};
+static const uint8_t sm4_gcm_tag[] = {
+	0x83, 0xde, 0x35, 0x41, 0xe4, 0xc2, 0xb5, 0x81,
+	0x77, 0xe0, 0x65, 0xa9, 0xbf, 0x7b, 0x62, 0xec,
+};
+static const uint8_t sm4_ccm_ct[] = {
+	0x48, 0xaf, 0x93, 0x50, 0x1f, 0xa6, 0x2a, 0xdb,
+	0xcd, 0x41, 0x4c, 0xce, 0x60, 0x34, 0xd8, 0x95,
+	0xdd, 0xa1, 0xbf, 0x8f, 0x13, 0x2f, 0x04, 0x20,
+	0x98, 0x66, 0x15, 0x72, 0xe7, 0x48, 0x30, 0x94,
+	0xfd, 0x12, 0xe5, 0x18, 0xce, 0x06, 0x2c, 0x98,
+	0xac, 0xee, 0x28, 0xd9, 0x5d, 0xf4, 0x41, 0x6b,
+	0xed, 0x31, 0xa2, 0xf0, 0x44, 0x76, 0xc1, 0x8b,
+	0xb4, 0x0c, 0x84, 0xa7, 0x4b, 0x97, 0xdc, 0x5b,
+};
+static const uint8_t sm4_ccm_tag[] = {
+	0x16, 0x84, 0x2d, 0x4f, 0xa1, 0x86, 0xf5, 0x6a,
+	0xb3, 0x32, 0x56, 0x97, 0x1f, 0xa1, 0x10, 0xf4,
+};
+
+static int sm4_ae_kat(uint32_t algo, const uint8_t *ct, const uint8_t *tag)
+{
+	uint8_t out[sizeof(sm4_ae_pt)] = { };
+	uint8_t t[TEE_SM4_BLOCK_SIZE] = { };
+	size_t out_len = sizeof(out);
+	size_t t_len = sizeof(t);
+	TEE_Result res = TEE_ERROR_GENERIC;
+	void *ctx = NULL;
+	int ret = -1;
+
+	res = crypto_authenc_alloc_ctx(&ctx, algo);
+	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
+		LOG("- algo %#x not implemented", algo);
+		return 0;
+	}
+	if (res)
+		return -1;
+
+	res = crypto_authenc_init(ctx, TEE_MODE_ENCRYPT, sm4_ae_key,
+				  sizeof(sm4_ae_key), sm4_ae_nonce,
+				  sizeof(sm4_ae_nonce), sizeof(t),
+				  sizeof(sm4_ae_aad), sizeof(sm4_ae_pt));
+	if (!res)
+		res = crypto_authenc_update_aad(ctx, TEE_MODE_ENCRYPT,
+						sm4_ae_aad, sizeof(sm4_ae_aad));
+	if (!res)
+		res = crypto_authenc_enc_final(ctx, sm4_ae_pt,
+					       sizeof(sm4_ae_pt), out,
+					       &out_len, t, &t_len);
+	if (res || memcmp(out, ct, sizeof(out)) ||
+	    t_len != sizeof(t) || memcmp(t, tag, sizeof(t))) {
+		LOG("- algo %#x encryption mismatch", algo);
+		goto out;
+	}
+
+	/* Decrypt in place */
+	out_len = sizeof(out);
+	res = crypto_authenc_init(ctx, TEE_MODE_DECRYPT, sm4_ae_key,
+				  sizeof(sm4_ae_key), sm4_ae_nonce,
+				  sizeof(sm4_ae_nonce), sizeof(t),
+				  sizeof(sm4_ae_aad), sizeof(sm4_ae_pt));
+	if (!res)
+		res = crypto_authenc_update_aad(ctx, TEE_MODE_DECRYPT,
+						sm4_ae_aad, sizeof(sm4_ae_aad));
+	if (!res)
+		res = crypto_authenc_dec_final(ctx, out, sizeof(out), out,
+					       &out_len, tag, sizeof(t));
+	if (res || memcmp(out, sm4_ae_pt, sizeof(out))) {
+		LOG("- algo %#x decryption mismatch", algo);
+		goto out;
+	}
+	ret = 0;
+out:
+	crypto_authenc_final(ctx);
+	crypto_authenc_free_ctx(ctx);
+
+	return ret;
+}
+
+static int self_test_sm4_ae(void)
+{
+	int ret = 0;
+
+	LOG("");
+	LOG("SM4 AE test:");
+	ret = sm4_ae_kat(TEE_ALG_SM4_GCM, sm4_gcm_ct, sm4_gcm_tag);
+	if (!ret)
+		ret = sm4_ae_kat(TEE_ALG_SM4_CCM, sm4_ccm_ct, sm4_ccm_tag);
+	LOG("SM4 AE test done");
+
+	return ret;
+}
+#else
+static int self_test_sm4_ae(void)
+{
+	return 0;
+}
+#endif
+
+#if defined(CFG_CRYPTO_SM4) && defined(CFG_CRYPTO_XTS)
+static int self_test_sm4_xts_multi(void)
+{
+	static const uint8_t key1[16] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	static const uint8_t key2[16] = { 9, 8, 7, 6, 5, 4, 3, 2, 1 };
+	const size_t unit_len = 96;
+	struct crypto_sm4_xts_unit units[11] = { };
+	size_t len = ARRAY_SIZE(units) * unit_len;
+	uint8_t *buf = NULL;
+	uint8_t *ref = NULL;
+	uint8_t *out = NULL;
+	void *ctx = NULL;
+	size_t n = 0;
+	int ret = -1;
+
+	LOG("");
+	LOG("SM4-XTS multi test:");
+
+	buf = malloc(len * 3);
+	if (!buf)
+		return -1;
+	ref = buf + len;
+	out = ref + len;
+	for (n = 0; n < len; n++)
+		buf[n] = n * 5 + 1;
+
+	if (crypto_cipher_alloc_ctx(&ctx, TEE_ALG_SM4_XTS))
+		goto out;
+
+	/* Reference: one data unit at a time */
+	for (n = 0; n < ARRAY_SIZE(units); n++) {
+		units[n].tweak[0] = n;
+		units[n].tweak[15] = 0x80 | n;
+		units[n].src = buf + n * unit_len;
+		units[n].dst = out + n * unit_len;
+		if (crypto_cipher_init(ctx, TEE_MODE_ENCRYPT, key1,
+				       sizeof(key1), key2, sizeof(key2),
+				       units[n].tweak, TEE_SM4_BLOCK_SIZE) ||
+		    crypto_cipher_update(ctx, TEE_MODE_ENCRYPT, true,
+					 units[n].src, unit_len,
+					 ref + n * unit_len))
+			goto out;
+	}
+
+	if (crypto_sm4_xts_multi(TEE_MODE_ENCRYPT, key1, key2, units,
+				 ARRAY_SIZE(units), unit_len) ||
+	    memcmp(out, ref, len)) {
+		LOG("- encryption mismatch");
+		goto out;
+	}
+
+	for (n = 0; n < ARRAY_SIZE(units); n++)
+		units[n].src = units[n].dst;
+	if (crypto_sm4_xts_multi(TEE_MODE_DECRYPT, key1, key2, units,
+				 ARRAY_SIZE(units), unit_len) ||
+	    memcmp(out, buf, len)) {
+		LOG("- decryption mismatch");
+		goto out;
+	}
+	ret = 0;
+	LOG("- %zu data units match", ARRAY_SIZE(units));
+out:
+	crypto_cipher_free_ctx(ctx);
+	free(buf);
+	LOG("SM4-XTS multi test done");
+
+	return ret;
+}
+#else
+static int self_test_sm4_xts_multi(void)
+{
+	return 0;
+}
+#endif
+
+#ifdef CFG_CRYPTO_ECC_COMB
+static int self_test_ecc_comb(void)
+{
+	int ret = 0;
+
+	LOG("");
+	LOG("ECC comb test:");
+	if (crypto_ecc_comb_self_test())
+		ret = -1;
+	LOG("ECC comb test done");
+
+	return ret;
+}
+#else
+static int self_test_ecc_comb(void)
+{
+	return 0;
+}
+#endif
+
+#if defined(CFG_CRYPTO_SIZE_SELECT) && defined(CFG_CRYPTO_SHA256) && \
+	defined(CFG_CRYPTO_AES) && defined(CFG_CRYPTO_CBC)
+#define SELECT_TEST_THRESHOLD	64
+
+/* Message sizes on each side of the threshold */
+static const size_t select_test_len[] = {
+	SELECT_TEST_THRESHOLD - TEE_AES_BLOCK_SIZE, SELECT_TEST_THRESHOLD,
+};
+
+static int select_hash_test(const uint8_t *buf)
+{
+	uint8_t digest[TEE_SHA256_HASH_SIZE] = { };
+	uint8_t ref[TEE_SHA256_HASH_SIZE] = { };
+	struct crypto_hash_ctx *ctx = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	void *sw_ctx = NULL;
+	size_t len = 0;
+	size_t n = 0;
+	int ret = -1;
+
+	res = crypto_select_hash_alloc_ctx_threshold(&ctx, TEE_ALG_SHA256,
+						     SELECT_TEST_THRESHOLD);
+	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
+		LOG("- SHA-256 not implemented by the device");
+		return 0;
+	}
+	if (res || crypto_hash_alloc_sw_ctx(&sw_ctx, TEE_ALG_SHA256))
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(select_test_len); n++) {
+		len = select_test_len[n];
+		if (crypto_hash_init(ctx) ||
+		    crypto_hash_update(ctx, buf, len))
+			goto out;
+		if (crypto_select_hash_on_drv(ctx) !=
+		    (len >= SELECT_TEST_THRESHOLD)) {
+			LOG("- SHA-256 of %zu bytes on the wrong provider",
+			    len);
+			goto out;
+		}
+		if (crypto_hash_final(ctx, digest, sizeof(digest)) ||
+		    crypto_hash_init(sw_ctx) ||
+		    crypto_hash_update(sw_ctx, buf, len) ||
+		    crypto_hash_final(sw_ctx, ref, sizeof(ref)) ||
+		    memcmp(digest, ref, sizeof(ref))) {
+			LOG("- SHA-256 of %zu bytes mismatch", len);
+			goto out;
+		}
+	}
+	ret = 0;
+out:
+	crypto_hash_free_ctx(sw_ctx);
+	crypto_hash_free_ctx(ctx);
+
+	return ret;
+}
+
+static int select_cipher_test(const uint8_t *buf)
+{
+	static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+	static const uint8_t iv[TEE_AES_BLOCK_SIZE] = { 8, 7, 6, 5, 4 };
+	uint8_t out[SELECT_TEST_THRESHOLD] = { };
+	uint8_t ref[SELECT_TEST_THRESHOLD] = { };
+	struct crypto_cipher_ctx *ctx = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	void *sw_ctx = NULL;
+	size_t len = 0;
+	size_t n = 0;
+	int ret = -1;
+
+	res = crypto_select_cipher_alloc_ctx_threshold(&ctx,
+						       TEE_ALG_AES_CBC_NOPAD,
+						       SELECT_TEST_THRESHOLD);
+	if (res == TEE_ERROR_NOT_IMPLEMENTED) {
+		LOG("- AES-CBC not implemented by the device");
+		return 0;
+	}
+	if (res ||
+	    crypto_cipher_alloc_sw_ctx(&sw_ctx, TEE_ALG_AES_CBC_NOPAD))
+		goto out;
+
+	for (n = 0; n < ARRAY_SIZE(select_test_len); n++) {
+		len = select_test_len[n];
+		if (crypto_cipher_init(ctx, TEE_MODE_ENCRYPT, key,
+				       sizeof(key), NULL, 0, iv, sizeof(iv)) ||
+		    crypto_cipher_update(ctx, TEE_MODE_ENCRYPT, true, buf,
+					 len, out))
+			goto out;
+		crypto_cipher_final(ctx);
+		if (crypto_select_cipher_on_drv(ctx) !=
+		    (len >= SELECT_TEST_THRESHOLD)) {
+			LOG("- AES-CBC of %zu bytes on the wrong provider",
+			    len);
+			goto out;
+		}
+		if (crypto_cipher_init(sw_ctx, TEE_MODE_ENCRYPT, key,
+				       sizeof(key), NULL, 0, iv, sizeof(iv)) ||
+		    crypto_cipher_update(sw_ctx, TEE_MODE_ENCRYPT, true, buf,
+					 len, ref))
+			goto out;
+		crypto_cipher_final(sw_ctx);
+		if (memcmp(out, ref, len)) {
+			LOG("- AES-CBC of %zu bytes mismatch", len);
+			goto out;
+		}
+	}
+	ret = 0;
+out:
+	crypto_cipher_free_ctx(sw_ctx);
+	crypto_cipher_free_ctx(ctx);
+
+	return ret;
+}
+
+static int self_test_crypto_select(void)
+{
+	uint8_t buf[SELECT_TEST_THRESHOLD] = { };
+	size_t n = 0;
+	int ret = 0;
+
+	LOG("");
+	LOG("crypto size selection test:");
+
+	for (n = 0; n < sizeof(buf); n++)
+		buf[n] = n * 3 + 1;
+
+	ret = select_hash_test(buf);
+	if (!ret)
+		ret = select_cipher_test(buf);
+	LOG("crypto size selection test done");
+
+	return ret;
+}
+#else
+static int self_test_crypto_select(void)
+{
+	return 0;
+}
+#endif
+
+#ifdef CFG_CRYPTO_DRV_QUEUE
+#define TEST_QUEUE_JOBS	6
+
+/* Software engine running up to two jobs, completed when reaped */
+struct test_engine {
+	struct drvcrypt_job *running[2];
+	size_t nb_running;
+	size_t nb_done;
+};
+
+static void test_engine_submit(struct drvcrypt_queue *queue,
+			       struct drvcrypt_job **jobs, size_t nb_jobs)
+{
+	struct test_engine *eng = queue->priv;
+	size_t n = 0;
+
+	for (n = 0; n < nb_jobs; n++) {
+		if (eng->nb_running == ARRAY_SIZE(eng->running))
+			drvcrypt_queue_complete(queue, jobs[n],
+						TEE_ERROR_BUSY);
+		else
+			eng->running[eng->nb_running++] = jobs[n];
+	}
+}
+
+static void test_engine_reap(struct drvcrypt_queue *queue)
+{
+	struct test_engine *eng = queue->priv;
+	size_t n = 0;
+
+	for (n = 0; n < eng->nb_running; n++) {
+		*(size_t *)eng->running[n]->data = eng->nb_done++;
+		drvcrypt_queue_complete(queue, eng->running[n], TEE_SUCCESS);
+	}
+	eng->nb_running = 0;
+}
+
+static void test_job_done(struct drvcrypt_job *job)
+{
+	(*(size_t *)job->context)++;
+}
+
+static int self_test_drvcrypt_queue(void)
+{
+	static const struct drvcrypt_queue_ops ops = {
+		.submit = test_engine_submit,
+		.reap = test_engine_reap,
+	};
+	struct drvcrypt_job job[TEST_QUEUE_JOBS + 1] = { };
+	size_t order[TEST_QUEUE_JOBS + 1] = { };
+	struct drvcrypt_queue queue = { };
+	struct test_engine eng = { };
+	size_t nb_callbacks = 0;
+	size_t n = 0;
+	int ret = -1;
+
+	LOG("");
+	LOG("drvcrypt queue test:");
+
+	/* Two engine slots, four pending jobs, two jobs started at once */
+	if (drvcrypt_queue_init(&queue, &ops, &eng, 4, 2, 2))
+		return -1;
+
+	for (n = 0; n < TEST_QUEUE_JOBS; n++) {
+		job[n].data = order + n;
+		if (n == TEST_QUEUE_JOBS - 1) {
+			job[n].done = test_job_done;
+			job[n].context = &nb_callbacks;
+		}
+		if (drvcrypt_queue_submit(&queue, job + n)) {
+			LOG("- submit %zu failed", n);
+			goto out;
+		}
+	}
+
+	job[n].data = order + n;
+	if (!drvcrypt_queue_saturated(&queue) ||
+	    drvcrypt_queue_submit(&queue, job + n) != TEE_ERROR_BUSY) {
+		LOG("- full queue not reported");
+		goto out;
+	}
+
+	for (n = 0; n < TEST_QUEUE_JOBS - 1; n++) {
+		if (drvcrypt_queue_wait(&queue, job + n) || order[n] != n) {
+			LOG("- job %zu not completed in order", n);
+			goto out;
+		}
+	}
+	if (nb_callbacks != 1 || order[n] != n) {
+		LOG("- completion callback not called");
+		goto out;
+	}
+
+	n = TEST_QUEUE_JOBS;
+	if (drvcrypt_queue_run(&queue, job + n) || order[n] != n ||
+	    drvcrypt_queue_saturated(&queue)) {
+		LOG("- synchronous job failed");
+		goto out;
+	}
+
+	ret = 0;
+	LOG("- %d jobs completed", TEST_QUEUE_JOBS + 1);
+out:
+	if (!ret)
+		drvcrypt_queue_release(&queue);
+	LOG("drvcrypt queue test done");
+
+	return ret;
+}
+#else
+static int self_test_drvcrypt_queue(void)
+{
+	return 0;
+}
+#endif
+
 /* exported entry points for some basic test */
 TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 		TEE_Param pParams[TEE_NUM_PARAMS] __unused)
@@ -558,7 +1132,10 @@ TEE_Result core_self_tests(uint32_t nParamTypes __unused,
 	if (self_test_mul_signed_overflow() || self_test_add_overflow() ||
 	    self_test_sub_overflow() || self_test_mul_unsigned_overflow() ||
 	    self_test_division() || self_test_malloc() ||
-	    self_test_nex_malloc()) {
+	    self_test_nex_malloc() || self_test_sha256_mb() ||
+	    self_test_sm4_ae() || self_test_sm4_xts_multi() ||
+	    self_test_ecc_comb() || self_test_crypto_select() ||
+	    self_test_drvcrypt_queue()) {
 		EMSG("some self_test_xxx failed! you should enable local LOG");
 		return TEE_ERROR_GENERIC;
 	}
@@ -16,6 +16,9 @@ TEE_Result core_self_tests(uint32_t nParamTypes,
 TEE_Result core_fs_htree_tests(uint32_t nParamTypes,
 			       TEE_Param pParams[TEE_NUM_PARAMS]);
 
+TEE_Result core_fs_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS]);
+
 TEE_Result core_mutex_tests(uint32_t nParamTypes,
 			    TEE_Param pParams[TEE_NUM_PARAMS]);
 
@@ -34,6 +37,12 @@ static inline TEE_Result core_lockdep_tests(
 TEE_Result core_aes_perf_tests(uint32_t param_types,
 			       TEE_Param params[TEE_NUM_PARAMS]);
 
+TEE_Result core_mm_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS]);
+
+TEE_Result core_crypto_perf_tests(uint32_t param_types,
+				  TEE_Param params[TEE_NUM_PARAMS]);
+
 TEE_Result core_dt_driver_tests(uint32_t param_types,
 				TEE_Param params[TEE_NUM_PARAMS]);
 
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <kernel/thread.h>
+#include <mm/core_mmu.h>
+#include <mm/tee_mm.h>
+#include <pta_invoke_tests.h>
+#include <stdlib.h>
+#include <trace.h>
+#include <types_ext.h>
+
+#include "misc.h"
+
+/* Entries are allocated from the core heap, keep their number bounded */
+#define MAX_ENTRIES	1024
+/* Largest allocation in pages, also the largest hole left in the pool */
+#define MAX_PAGES	4
+/* Arbitrary base, the pool is only used for bookkeeping */
+#define POOL_BASE	0x40000000
+
+static uint32_t next_rnd(uint32_t *rnd)
+{
+	*rnd ^= *rnd << 13;
+	*rnd ^= *rnd >> 17;
+	*rnd ^= *rnd << 5;
+
+	return *rnd;
+}
+
+/* Returns the average duration in ns of @count operations taking @ticks */
+static uint32_t ticks_to_ns(uint64_t ticks, uint32_t count)
+{
+	/* Scale in two steps to keep the intermediate values in range */
+	return ticks * 1000 / count * 1000000 / read_cntfrq();
+}
+
+/*
+ * Fills the pool with @count entries of random size and frees every other
+ * entry, leaving holes of random size all over the pool.
+ */
+static TEE_Result fragment_pool(tee_mm_pool_t *pool, tee_mm_entry_t **mm,
+				size_t count, uint32_t *rnd)
+{
+	size_t n = 0;
+
+	for (n = 0; n < count; n++) {
+		mm[n] = tee_mm_alloc(pool, (1 + next_rnd(rnd) % MAX_PAGES) *
+					   SMALL_PAGE_SIZE);
+		if (!mm[n])
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	for (n = 0; n < count; n += 2) {
+		tee_mm_free(mm[n]);
+		mm[n] = NULL;
+	}
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result run_alloc_free(tee_mm_pool_t *pool, uint32_t iterations,
+				 uint32_t *rnd, uint64_t *ticks)
+{
+	tee_mm_entry_t *mm = NULL;
+	uint64_t t = 0;
+	uint32_t n = 0;
+	size_t sz = 0;
+
+	t = barrier_read_counter_timer();
+	for (n = 0; n < iterations; n++) {
+		sz = (1 + next_rnd(rnd) % MAX_PAGES) * SMALL_PAGE_SIZE;
+
+		mm = tee_mm_alloc(pool, sz);
+		tee_mm_free(mm);
+
+		if (!mm)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+	*ticks = barrier_read_counter_timer() - t;
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result run_find(tee_mm_pool_t *pool, tee_mm_entry_t **mm,
+			   size_t count, uint32_t iterations, uint32_t *rnd,
+			   uint64_t *ticks)
+{
+	tee_mm_entry_t *found = NULL;
+	paddr_t pa = 0;
+	uint64_t t = 0;
+	uint32_t n = 0;
+	size_t idx = 0;
+
+	t = barrier_read_counter_timer();
+	for (n = 0; n < iterations; n++) {
+		/* Entries with an odd index are the ones still allocated */
+		idx = (next_rnd(rnd) % (count / 2)) * 2 + 1;
+		pa = tee_mm_get_smem(mm[idx]) + tee_mm_get_bytes(mm[idx]) - 1;
+
+		found = tee_mm_find(pool, pa);
+
+		if (found != mm[idx]) {
+			EMSG("tee_mm_find(%#"PRIxPA") returned %p expected %p",
+			     pa, (void *)found, (void *)mm[idx]);
+			return TEE_ERROR_GENERIC;
+		}
+	}
+	*ticks = barrier_read_counter_timer() - t;
+
+	return TEE_SUCCESS;
+}
+
+TEE_Result core_mm_perf_tests(uint32_t param_types,
+			      TEE_Param params[TEE_NUM_PARAMS])
+{
+	uint32_t exp_pt = TEE_PARAM_TYPES(TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_INPUT,
+					  TEE_PARAM_TYPE_VALUE_OUTPUT,
+					  TEE_PARAM_TYPE_NONE);
+	uint32_t count = params[0].value.a;
+	uint32_t flags = params[0].value.b;
+	uint32_t iterations = params[1].value.a;
+	TEE_Result res = TEE_SUCCESS;
+	tee_mm_entry_t **mm = NULL;
+	tee_mm_pool_t pool = { };
+	uint64_t alloc_ticks = 0;
+	uint64_t find_ticks = 0;
+	uint32_t rnd = 1;
+	size_t n = 0;
+
+	if (param_types != exp_pt)
+		return TEE_ERROR_BAD_PARAMETERS;
+	if (count < 2 || count > MAX_ENTRIES || !iterations ||
+	    (flags & ~TEE_MM_POOL_HI_ALLOC))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	mm = calloc(count, sizeof(*mm));
+	if (!mm)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	/* Room for all entries plus a free tail of the same size */
+	if (!tee_mm_init(&pool, POOL_BASE,
+			 2 * count * MAX_PAGES * SMALL_PAGE_SIZE,
+			 SMALL_PAGE_SHIFT, flags)) {
+		res = TEE_ERROR_GENERIC;
+		goto out;
+	}
+
+	res = fragment_pool(&pool, mm, count, &rnd);
+	if (res)
+		goto out_final;
+
+	res = run_alloc_free(&pool, iterations, &rnd, &alloc_ticks);
+	if (res)
+		goto out_final;
+
+	res = run_find(&pool, mm, count, iterations, &rnd, &find_ticks);
+	if (res)
+		goto out_final;
+
+	params[2].value.a = ticks_to_ns(alloc_ticks, iterations);
+	params[2].value.b = ticks_to_ns(find_ticks, iterations);
+
+out_final:
+	for (n = 0; n < count; n++)
+		tee_mm_free(mm[n]);
+	tee_mm_final(&pool);
+out:
+	free(mm);
+	return res;
+}
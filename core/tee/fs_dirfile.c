@@ -9,16 +9,69 @@
 #include <stdlib.h>
 #include <string.h>
 #include <tee/fs_dirfile.h>
+#include <tee/fs_perf.h>
 #include <types_ext.h>
+#include <util.h>
 
+/*
+ * In-memory index of the dirfile
+ *
+ * Each used entry is linked into the chain of bucket
+ * @key[idx] & (@nbuckets - 1) where @key[idx] is a hash of the TA UUID
+ * and object ID, so finding an object only reads the entries with a
+ * matching hash. @used tracks which entries are in use and
+ * @free_dent_hint is a lower bound of the first free entry, in the same
+ * way @free_file_hint is a lower bound of the first free file number.
+ */
+struct dent_index {
+	int cap;
+	bitstr_t *used;
+	uint32_t *key;
+	int *next;
+	int *buckets;
+	size_t nbuckets;
+	int free_dent_hint;
+};
+
+/*
+ * @dent_cache holds @dent_cache_count consecutive entries starting at
+ * index @dent_cache_idx. It's filled with a single read so scanning the
+ * dirfile only decrypts each block once instead of once per entry.
+ * @index_valid is false until the handle is fully opened and if the index
+ * no longer matches the entries written to the dirfile.
+ */
 struct tee_fs_dirfile_dirh {
 	const struct tee_fs_dirfile_operations *fops;
 	struct tee_file_handle *fh;
 	int nbits;
 	bitstr_t *files;
+	int free_file_hint;
 	size_t ndents;
+	struct dent_index index;
+	bool index_valid;
+	struct dirfile_entry *dent_cache;
+	size_t dent_cache_idx;
+	size_t dent_cache_count;
 };
 
+/*
+ * File number bitmap and index of the last dirfile handle closed without
+ * uncommitted changes, together with the hash and version counter of the
+ * dirfile they describe. tee_fs_dirfile_open() takes them over if it
+ * opens that same version instead of scanning all entries again. All
+ * dirfile operations are serialized by the user of this interface.
+ */
+static struct {
+	bool valid;
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE];
+	uint32_t counter;
+	int nbits;
+	bitstr_t *files;
+	int free_file_hint;
+	size_t ndents;
+	struct dent_index index;
+} saved_state;
+
 struct dirfile_entry {
 	TEE_UUID uuid;
 	uint8_t oid[TEE_OBJECT_ID_MAX_LEN];
@@ -29,6 +82,12 @@ struct dirfile_entry {
 
 #define OID_EMPTY_NAME 1
 
+/* Roughly one 4 KiB block of the REE FS */
+#define DENT_CACHE_COUNT	(4096 / sizeof(struct dirfile_entry))
+
+#define INDEX_MIN_CAP		32
+#define INDEX_NO_ENTRY		-1
+
 /*
  * An object can have an ID of size zero. This object is represented by
  * oidlen == 0 and oid[0] == OID_EMPTY_NAME. When both are zero, the entry is
@@ -81,8 +140,11 @@ static TEE_Result set_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 
 static void clear_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 {
-	if (idx < dirh->nbits)
+	if (idx < dirh->nbits) {
 		bit_clear(dirh->files, idx);
+		if (idx < dirh->free_file_hint)
+			dirh->free_file_hint = idx;
+	}
 }
 
 static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
@@ -93,19 +155,252 @@ static bool test_file(struct tee_fs_dirfile_dirh *dirh, int idx)
 	return false;
 }
 
+static uint32_t dent_key(const TEE_UUID *uuid, const void *oid, size_t oidlen)
+{
+	const uint8_t *p = (const uint8_t *)uuid;
+	uint32_t h = 2166136261U;	/* FNV-1a */
+	size_t n = 0;
+
+	for (n = 0; n < sizeof(*uuid); n++)
+		h = (h ^ p[n]) * 16777619U;
+	p = oid;
+	for (n = 0; n < oidlen; n++)
+		h = (h ^ p[n]) * 16777619U;
+
+	return h;
+}
+
+static int *index_bucket(struct dent_index *ix, uint32_t key)
+{
+	return ix->buckets + (key & (ix->nbuckets - 1));
+}
+
+static void index_link(struct dent_index *ix, int idx)
+{
+	int *b = index_bucket(ix, ix->key[idx]);
+
+	ix->next[idx] = *b;
+	*b = idx;
+}
+
+static TEE_Result index_rehash(struct dent_index *ix, size_t nbuckets)
+{
+	int *b = malloc(nbuckets * sizeof(*b));
+	size_t n = 0;
+
+	if (!b)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	free(ix->buckets);
+	ix->buckets = b;
+	ix->nbuckets = nbuckets;
+	for (n = 0; n < nbuckets; n++)
+		b[n] = INDEX_NO_ENTRY;
+
+	for (n = 0; n < (size_t)ix->cap; n++)
+		if (bit_test(ix->used, n))
+			index_link(ix, n);
+
+	return TEE_SUCCESS;
+}
+
+static TEE_Result index_grow(struct dent_index *ix, int idx)
+{
+	int cap = MAX(ix->cap * 2, INDEX_MIN_CAP);
+	size_t nbuckets = MAX(ix->nbuckets, (size_t)INDEX_MIN_CAP / 2);
+	bitstr_t *used = NULL;
+	uint32_t *key = NULL;
+	int *next = NULL;
+
+	if (idx < ix->cap)
+		return TEE_SUCCESS;
+	if (cap <= idx)
+		cap = idx + 1;
+
+	used = realloc(ix->used, bitstr_size(cap));
+	if (!used)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	if (ix->cap)
+		bit_nclear(used, ix->cap, cap - 1);
+	else
+		memset(used, 0, bitstr_size(cap));
+	ix->used = used;
+
+	key = realloc(ix->key, cap * sizeof(*key));
+	if (!key)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	ix->key = key;
+
+	next = realloc(ix->next, cap * sizeof(*next));
+	if (!next)
+		return TEE_ERROR_OUT_OF_MEMORY;
+	ix->next = next;
+
+	ix->cap = cap;
+
+	/* Keep the average chain length at most 2 */
+	while ((size_t)cap > nbuckets * 2)
+		nbuckets *= 2;
+	if (nbuckets != ix->nbuckets)
+		return index_rehash(ix, nbuckets);
+
+	return TEE_SUCCESS;
+}
+
+static void index_remove(struct dent_index *ix, int idx)
+{
+	int *p = NULL;
+
+	if (idx >= ix->cap || !bit_test(ix->used, idx))
+		return;
+
+	for (p = index_bucket(ix, ix->key[idx]); *p != idx; p = ix->next + *p)
+		assert(*p != INDEX_NO_ENTRY);
+	*p = ix->next[idx];
+
+	bit_clear(ix->used, idx);
+	if (idx < ix->free_dent_hint)
+		ix->free_dent_hint = idx;
+}
+
+static TEE_Result index_add(struct dent_index *ix, int idx,
+			    const struct dirfile_entry *dent)
+{
+	TEE_Result res = index_grow(ix, idx);
+
+	if (res)
+		return res;
+
+	index_remove(ix, idx);
+	ix->key[idx] = dent_key(&dent->uuid, dent->oid, dent->oidlen);
+	index_link(ix, idx);
+	bit_set(ix->used, idx);
+
+	return TEE_SUCCESS;
+}
+
+static void index_free(struct dent_index *ix)
+{
+	free(ix->used);
+	free(ix->key);
+	free(ix->next);
+	free(ix->buckets);
+	memset(ix, 0, sizeof(*ix));
+}
+
+static void drop_saved_state(void)
+{
+	index_free(&saved_state.index);
+	free(saved_state.files);
+	memset(&saved_state, 0, sizeof(saved_state));
+}
+
+static void save_state(struct tee_fs_dirfile_dirh *dirh)
+{
+	drop_saved_state();
+
+	if (!dirh->index_valid || !dirh->fops->get_hash ||
+	    dirh->fops->get_hash(dirh->fh, saved_state.hash,
+				 &saved_state.counter))
+		return;
+
+	saved_state.nbits = dirh->nbits;
+	saved_state.files = dirh->files;
+	saved_state.free_file_hint = dirh->free_file_hint;
+	saved_state.ndents = dirh->ndents;
+	saved_state.index = dirh->index;
+	saved_state.valid = true;
+
+	dirh->nbits = 0;
+	dirh->files = NULL;
+	memset(&dirh->index, 0, sizeof(dirh->index));
+}
+
+static bool restore_state(struct tee_fs_dirfile_dirh *dirh)
+{
+	uint8_t hash[TEE_FS_HTREE_HASH_SIZE] = { };
+	uint32_t counter = 0;
+
+	if (!saved_state.valid)
+		return false;
+
+	if (!dirh->fops->get_hash ||
+	    dirh->fops->get_hash(dirh->fh, hash, &counter) ||
+	    counter != saved_state.counter ||
+	    memcmp(hash, saved_state.hash, sizeof(hash))) {
+		drop_saved_state();
+		return false;
+	}
+
+	dirh->nbits = saved_state.nbits;
+	dirh->files = saved_state.files;
+	dirh->free_file_hint = saved_state.free_file_hint;
+	dirh->ndents = saved_state.ndents;
+	dirh->index = saved_state.index;
+	memset(&saved_state, 0, sizeof(saved_state));
+
+	return true;
+}
+
+static bool dent_is_cached(struct tee_fs_dirfile_dirh *dirh, size_t idx)
+{
+	return idx >= dirh->dent_cache_idx &&
+	       idx - dirh->dent_cache_idx < dirh->dent_cache_count;
+}
+
+static TEE_Result fill_dent_cache(struct tee_fs_dirfile_dirh *dirh,
+				  size_t idx)
+{
+	TEE_Result res;
+	size_t l;
+
+	if (!dirh->dent_cache) {
+		dirh->dent_cache = calloc(DENT_CACHE_COUNT,
+					  sizeof(*dirh->dent_cache));
+		if (!dirh->dent_cache)
+			return TEE_ERROR_OUT_OF_MEMORY;
+	}
+
+	dirh->dent_cache_count = 0;
+	l = DENT_CACHE_COUNT * sizeof(*dirh->dent_cache);
+	res = dirh->fops->read(dirh->fh, sizeof(struct dirfile_entry) * idx,
+			       dirh->dent_cache, &l);
+	if (res)
+		return res;
+
+	dirh->dent_cache_idx = idx;
+	dirh->dent_cache_count = l / sizeof(struct dirfile_entry);
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result read_dent(struct tee_fs_dirfile_dirh *dirh, int idx,
 			    struct dirfile_entry *dent)
 {
 	TEE_Result res;
 	size_t l;
 
-	l = sizeof(*dent);
-	res = dirh->fops->read(dirh->fh, sizeof(struct dirfile_entry) * idx,
-			       dent, &l);
-	if (!res && l != sizeof(*dent))
-		res = TEE_ERROR_ITEM_NOT_FOUND;
+	if (!dent_is_cached(dirh, idx)) {
+		res = fill_dent_cache(dirh, idx);
+		if (res == TEE_ERROR_OUT_OF_MEMORY) {
+			/* Fall back to reading a single entry */
+			l = sizeof(*dent);
+			res = dirh->fops->read(dirh->fh,
+					       sizeof(struct dirfile_entry) *
+					       idx, dent, &l);
+			if (!res && l != sizeof(*dent))
+				res = TEE_ERROR_ITEM_NOT_FOUND;
+			return res;
+		}
+		if (res)
+			return res;
+		if (!dent_is_cached(dirh, idx))
+			return TEE_ERROR_ITEM_NOT_FOUND;
+	}
 
-	return res;
+	*dent = dirh->dent_cache[idx - dirh->dent_cache_idx];
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
@@ -115,9 +410,30 @@ static TEE_Result write_dent(struct tee_fs_dirfile_dirh *dirh, size_t n,
 
 	res = dirh->fops->write(dirh->fh, sizeof(*dent) * n, dent,
 				sizeof(*dent));
-	if (!res && n >= dirh->ndents)
+	if (res) {
+		dirh->dent_cache_count = 0;
+		return res;
+	}
+
+	if (dent_is_cached(dirh, n))
+		dirh->dent_cache[n - dirh->dent_cache_idx] = *dent;
+	if (n >= dirh->ndents)
 		dirh->ndents = n + 1;
 
+	if (is_free(dent)) {
+		index_remove(&dirh->index, n);
+		return TEE_SUCCESS;
+	}
+
+	/*
+	 * The entry is already written, if the index can't be updated
+	 * there's no way to keep it consistent. The caller will close the
+	 * dirfile handle on error and the index is rebuilt on next open.
+	 */
+	res = index_add(&dirh->index, n, dent);
+	if (res)
+		dirh->index_valid = false;
+
 	return res;
 }
 
@@ -137,13 +453,18 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash, uint32_t min_counter,
 	if (res)
 		goto out;
 
+	if (restore_state(dirh))
+		goto out;
+
 	for (n = 0;; n++) {
 		struct dirfile_entry dent = { };
 
 		res = read_dent(dirh, n, &dent);
 		if (res) {
-			if (res == TEE_ERROR_ITEM_NOT_FOUND)
+			if (res == TEE_ERROR_ITEM_NOT_FOUND) {
+				dirh->ndents = n;
 				res = TEE_SUCCESS;
+			}
 			goto out;
 		}
 
@@ -163,10 +484,14 @@ TEE_Result tee_fs_dirfile_open(bool create, uint8_t *hash, uint32_t min_counter,
 		res = set_file(dirh, dent.file_number);
 		if (res != TEE_SUCCESS)
 			goto out;
+
+		res = index_add(&dirh->index, n, &dent);
+		if (res != TEE_SUCCESS)
+			goto out;
 	}
 out:
 	if (!res) {
-		dirh->ndents = n;
+		dirh->index_valid = true;
 		*dirh_ret = dirh;
 	} else {
 		tee_fs_dirfile_close(dirh);
@@ -177,7 +502,10 @@ out:
 void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 {
 	if (dirh) {
+		save_state(dirh);
 		dirh->fops->close(dirh->fh);
+		index_free(&dirh->index);
+		free(dirh->dent_cache);
 		free(dirh->files);
 		free(dirh);
 	}
@@ -186,24 +514,29 @@ void tee_fs_dirfile_close(struct tee_fs_dirfile_dirh *dirh)
 TEE_Result tee_fs_dirfile_commit_writes(struct tee_fs_dirfile_dirh *dirh,
 					uint8_t *hash, uint32_t *counter)
 {
-	return dirh->fops->commit_writes(dirh->fh, hash, counter);
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = dirh->fops->commit_writes(dirh->fh, hash, counter);
+	tee_fs_perf_end(TEE_FS_PERF_DIRFILE, t);
+
+	return res;
 }
 
 TEE_Result tee_fs_dirfile_get_tmp(struct tee_fs_dirfile_dirh *dirh,
 				  struct tee_fs_dirfile_fileh *dfh)
 {
 	TEE_Result res;
-	int i = 0;
+	int i = dirh->free_file_hint;
 
-	if (dirh->nbits) {
-		bit_ffc(dirh->files, dirh->nbits, &i);
-		if (i == -1)
-			i = dirh->nbits;
-	}
+	while (i < dirh->nbits && bit_test(dirh->files, i))
+		i++;
 
 	res = set_file(dirh, i);
-	if (!res)
+	if (!res) {
 		dfh->file_number = i;
+		dirh->free_file_hint = i + 1;
+	}
 
 	return res;
 }
@@ -212,17 +545,27 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 			       const TEE_UUID *uuid, const void *oid,
 			       size_t oidlen, struct tee_fs_dirfile_fileh *dfh)
 {
+	struct dent_index *ix = &dirh->index;
 	TEE_Result res = TEE_SUCCESS;
 	struct dirfile_entry dent = { };
+	uint32_t key = 0;
 	int n = 0;
 
-	for (n = 0;; n++) {
+	if (!ix->nbuckets)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	key = dent_key(uuid, oid, oidlen);
+	for (n = *index_bucket(ix, key);; n = ix->next[n]) {
+		if (n == INDEX_NO_ENTRY)
+			return TEE_ERROR_ITEM_NOT_FOUND;
+		if (ix->key[n] != key)
+			continue;
+
 		res = read_dent(dirh, n, &dent);
 		if (res)
 			return res;
 
-		if (is_free(&dent))
-			continue;
+		assert(!is_free(&dent));
 		if (dent.oidlen != oidlen)
 			continue;
 
@@ -244,19 +587,13 @@ TEE_Result tee_fs_dirfile_find(struct tee_fs_dirfile_dirh *dirh,
 
 static TEE_Result find_empty_idx(struct tee_fs_dirfile_dirh *dh, int *idx)
 {
-	struct dirfile_entry dent = { };
-	TEE_Result res = TEE_SUCCESS;
-	int n = 0;
+	struct dent_index *ix = &dh->index;
+	int n = ix->free_dent_hint;
 
-	for (n = 0;; n++) {
-		res = read_dent(dh, n, &dent);
-		if (res == TEE_ERROR_ITEM_NOT_FOUND)
-			break;
-		if (res)
-			return res;
-		if (is_free(&dent))
-			break;
-	}
+	/* Entries past the end of the index are either free or appended */
+	while (n < ix->cap && bit_test(ix->used, n))
+		n++;
+	ix->free_dent_hint = n;
 
 	*idx = n;
 	return TEE_SUCCESS;
@@ -5,12 +5,14 @@
 
 #include <assert.h>
 #include <crypto/crypto.h>
+#include <crypto/internal_aes-gcm.h>
 #include <initcall.h>
 #include <kernel/tee_common_otp.h>
 #include <stdlib.h>
 #include <string_ext.h>
 #include <string.h>
 #include <tee/fs_htree.h>
+#include <tee/fs_perf.h>
 #include <tee/tee_fs_key_manager.h>
 #include <tee/tee_fs_rpc.h>
 #include <utee_defines.h>
@@ -26,6 +28,23 @@
 #define TEE_FS_HTREE_AUTH_ENC_ALG	TEE_ALG_AES_GCM
 #define TEE_FS_HTREE_HMAC_ALG		TEE_ALG_HMAC_SHA256
 
+/*
+ * When AES-GCM is provided by the internal (possibly CE accelerated)
+ * implementation the expanded AES key and the GHASH key of the FEK are
+ * computed once per hash tree and reused for each block instead of
+ * allocating and keying a new crypto_authenc context for each block.
+ */
+#if defined(CFG_CRYPTO_GCM) && !defined(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB) && \
+	!defined(CFG_CRYPTO_DRV_AUTHENC)
+#define HTREE_GCM_PRECOMP_KEY	1
+#else
+#define HTREE_GCM_PRECOMP_KEY	0
+#endif
+
+/* Largest AAD used, see authenc_init() */
+#define HTREE_AAD_MAX_SIZE	(TEE_FS_HTREE_FEK_SIZE + sizeof(uint32_t) + \
+				 TEE_FS_HTREE_FEK_SIZE + TEE_FS_HTREE_IV_SIZE)
+
 #define BLOCK_NUM_TO_NODE_ID(num)	((num) + 1)
 
 #define NODE_ID_TO_BLOCK_NUM(id)	((id) - 1)
@@ -89,6 +108,10 @@ struct tee_fs_htree {
 	struct htree_node root;
 	struct tee_fs_htree_image head;
 	uint8_t fek[TEE_FS_HTREE_FEK_SIZE];
+#if HTREE_GCM_PRECOMP_KEY
+	struct internal_aes_gcm_precomp_key gcm_key;
+	bool gcm_key_valid;
+#endif
 	struct tee_fs_htree_imeta imeta;
 	bool dirty;
 	const TEE_UUID *uuid;
@@ -399,9 +422,9 @@ static TEE_Result init_tree_from_data(struct tee_fs_htree *ht)
 	return TEE_SUCCESS;
 }
 
-static TEE_Result calc_node_hash(struct htree_node *node,
-				 struct tee_fs_htree_meta *meta, void *ctx,
-				 uint8_t *digest)
+static TEE_Result __calc_node_hash(struct htree_node *node,
+				   struct tee_fs_htree_meta *meta, void *ctx,
+				   uint8_t *digest)
 {
 	TEE_Result res;
 	uint8_t *ndata = (uint8_t *)&node->node + sizeof(node->node.hash);
@@ -438,6 +461,19 @@ static TEE_Result calc_node_hash(struct htree_node *node,
 	return crypto_hash_final(ctx, digest, TEE_FS_HTREE_HASH_SIZE);
 }
 
+static TEE_Result calc_node_hash(struct htree_node *node,
+				 struct tee_fs_htree_meta *meta, void *ctx,
+				 uint8_t *digest)
+{
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = __calc_node_hash(node, meta, ctx, digest);
+	tee_fs_perf_end(TEE_FS_PERF_CRYPTO, t);
+
+	return res;
+}
+
 static TEE_Result authenc_init(void **ctx_ret, TEE_OperationMode mode,
 			       struct tee_fs_htree *ht,
 			       struct tee_fs_htree_node_image *ni,
@@ -544,53 +580,238 @@ static TEE_Result authenc_encrypt_final(void *ctx, uint8_t *tag,
 	return res;
 }
 
+#if HTREE_GCM_PRECOMP_KEY
+static TEE_Result init_fek_key(struct tee_fs_htree *ht)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	res = internal_aes_gcm_expand_key(&ht->gcm_key, ht->fek,
+					  sizeof(ht->fek));
+	if (res)
+		return res;
+
+	ht->gcm_key_valid = true;
+	return TEE_SUCCESS;
+}
+
+static void wipe_fek_key(struct tee_fs_htree *ht)
+{
+	memzero_explicit(&ht->gcm_key, sizeof(ht->gcm_key));
+	ht->gcm_key_valid = false;
+}
+
+/*
+ * Same as authenc_init() followed by authenc_{en,de}crypt_final(), but
+ * using the precomputed key of the hash tree.
+ */
+static TEE_Result gcm_crypt(TEE_OperationMode mode, struct tee_fs_htree *ht,
+			    struct tee_fs_htree_node_image *ni,
+			    const void *src, size_t len, void *dst)
+{
+	uint8_t aad[HTREE_AAD_MAX_SIZE] = { };
+	size_t tag_len = TEE_FS_HTREE_TAG_SIZE;
+	TEE_Result res = TEE_SUCCESS;
+	size_t aad_len = 0;
+	uint8_t *tag = NULL;
+	uint8_t *iv = NULL;
+
+	if (ni) {
+		iv = ni->iv;
+		tag = ni->tag;
+	} else {
+		iv = ht->head.iv;
+		tag = ht->head.tag;
+	}
+
+	if (mode == TEE_MODE_ENCRYPT) {
+		res = crypto_rng_read(iv, TEE_FS_HTREE_IV_SIZE);
+		if (res != TEE_SUCCESS)
+			return res;
+	}
+
+	if (!ni) {
+		memcpy(aad, ht->root.node.hash, TEE_FS_HTREE_FEK_SIZE);
+		aad_len += TEE_FS_HTREE_FEK_SIZE;
+		memcpy(aad + aad_len, &ht->head.counter,
+		       sizeof(ht->head.counter));
+		aad_len += sizeof(ht->head.counter);
+	}
+	memcpy(aad + aad_len, ht->head.enc_fek, TEE_FS_HTREE_FEK_SIZE);
+	aad_len += TEE_FS_HTREE_FEK_SIZE;
+	memcpy(aad + aad_len, iv, TEE_FS_HTREE_IV_SIZE);
+	aad_len += TEE_FS_HTREE_IV_SIZE;
+
+	if (mode == TEE_MODE_ENCRYPT) {
+		res = internal_aes_gcm_enc_precomp(&ht->gcm_key, iv,
+						   TEE_FS_HTREE_IV_SIZE, aad,
+						   aad_len, src, len, dst, tag,
+						   &tag_len);
+		if (res == TEE_SUCCESS && tag_len != TEE_FS_HTREE_TAG_SIZE)
+			return TEE_ERROR_GENERIC;
+	} else {
+		res = internal_aes_gcm_dec_precomp(&ht->gcm_key, iv,
+						   TEE_FS_HTREE_IV_SIZE, aad,
+						   aad_len, src, len, dst, tag,
+						   TEE_FS_HTREE_TAG_SIZE);
+		if (res == TEE_ERROR_MAC_INVALID)
+			return TEE_ERROR_CORRUPT_OBJECT;
+	}
+
+	return res;
+}
+#else
+static TEE_Result init_fek_key(struct tee_fs_htree *ht __unused)
+{
+	return TEE_SUCCESS;
+}
+
+static void wipe_fek_key(struct tee_fs_htree *ht __unused)
+{
+}
+#endif
+
+/*
+ * Encrypts or decrypts @len bytes from @src into @dst and produces or
+ * verifies the tag of @ni, or of the header if @ni is NULL.
+ */
+static TEE_Result __authenc_crypt(TEE_OperationMode mode,
+				  struct tee_fs_htree *ht,
+				  struct tee_fs_htree_node_image *ni,
+				  const void *src, size_t len, void *dst)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint8_t *tag = ni ? ni->tag : ht->head.tag;
+	void *ctx = NULL;
+
+#if HTREE_GCM_PRECOMP_KEY
+	if (ht->gcm_key_valid)
+		return gcm_crypt(mode, ht, ni, src, len, dst);
+#endif
+
+	res = authenc_init(&ctx, mode, ht, ni, len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (mode == TEE_MODE_ENCRYPT)
+		return authenc_encrypt_final(ctx, tag, src, len, dst);
+	return authenc_decrypt_final(ctx, tag, src, len, dst);
+}
+
+static TEE_Result authenc_crypt(TEE_OperationMode mode,
+				struct tee_fs_htree *ht,
+				struct tee_fs_htree_node_image *ni,
+				const void *src, size_t len, void *dst)
+{
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = __authenc_crypt(mode, ht, ni, src, len, dst);
+	tee_fs_perf_end(TEE_FS_PERF_CRYPTO, t);
+
+	return res;
+}
+
 static TEE_Result verify_root(struct tee_fs_htree *ht)
 {
 	TEE_Result res;
-	void *ctx;
 
 	res = tee_fs_fek_crypt(ht->uuid, TEE_MODE_DECRYPT, ht->head.enc_fek,
 			       sizeof(ht->fek), ht->fek);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, NULL, sizeof(ht->imeta));
+	res = init_fek_key(ht);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	return authenc_decrypt_final(ctx, ht->head.tag, ht->head.imeta,
-				     sizeof(ht->imeta), &ht->imeta);
+	return authenc_crypt(TEE_MODE_DECRYPT, ht, NULL, ht->head.imeta,
+			     sizeof(ht->imeta), &ht->imeta);
+}
+
+/*
+ * The node hashes are independent of each other when verifying since each
+ * node is hashed together with the hashes stored in its children, so they
+ * are collected and computed in batches with crypto_sha256_mb().
+ */
+#define HTREE_VERIFY_BATCH	8
+
+static_assert(TEE_FS_HTREE_HASH_ALG == TEE_ALG_SHA256);
+
+struct verify_batch {
+	struct crypto_sha256_mb_job job[HTREE_VERIFY_BATCH];
+	struct htree_node *node[HTREE_VERIFY_BATCH];
+	uint8_t digest[HTREE_VERIFY_BATCH][TEE_FS_HTREE_HASH_SIZE];
+	size_t count;
+};
+
+static TEE_Result verify_batch_flush(struct verify_batch *vb)
+{
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	res = crypto_sha256_mb(vb->job, vb->count);
+	tee_fs_perf_end(TEE_FS_PERF_CRYPTO, t);
+	if (res)
+		return res;
+
+	for (n = 0; n < vb->count; n++)
+		if (consttime_memcmp(vb->digest[n], vb->node[n]->node.hash,
+				     TEE_FS_HTREE_HASH_SIZE))
+			return TEE_ERROR_CORRUPT_OBJECT;
+
+	vb->count = 0;
+
+	return TEE_SUCCESS;
 }
 
 static TEE_Result verify_node(struct traverse_arg *targ,
 			      struct htree_node *node)
 {
-	void *ctx = targ->arg;
-	TEE_Result res;
-	uint8_t digest[TEE_FS_HTREE_HASH_SIZE];
+	struct verify_batch *vb = targ->arg;
+	struct crypto_sha256_mb_job *job = vb->job + vb->count;
+	size_t n = 0;
+
+	memset(job, 0, sizeof(*job));
+	job->seg[0].data = (uint8_t *)&node->node + sizeof(node->node.hash);
+	job->seg[0].len = sizeof(node->node) - sizeof(node->node.hash);
+	job->num_segs = 1;
+	if (!node->parent) {
+		job->seg[1].data = &targ->ht->imeta.meta;
+		job->seg[1].len = sizeof(targ->ht->imeta.meta);
+		job->num_segs++;
+	}
+	for (n = 0; n < ARRAY_SIZE(node->child); n++) {
+		if (node->child[n]) {
+			job->seg[job->num_segs].data = node->child[n]->node.hash;
+			job->seg[job->num_segs].len =
+				sizeof(node->child[n]->node.hash);
+			job->num_segs++;
+		}
+	}
+	job->digest = vb->digest[vb->count];
+	vb->node[vb->count] = node;
+	vb->count++;
 
-	if (node->parent)
-		res = calc_node_hash(node, NULL, ctx, digest);
-	else
-		res = calc_node_hash(node, &targ->ht->imeta.meta, ctx, digest);
-	if (res == TEE_SUCCESS &&
-	    consttime_memcmp(digest, node->node.hash, sizeof(digest)))
-		return TEE_ERROR_CORRUPT_OBJECT;
+	if (vb->count == HTREE_VERIFY_BATCH)
+		return verify_batch_flush(vb);
 
-	return res;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result verify_tree(struct tee_fs_htree *ht)
 {
-	TEE_Result res;
-	void *ctx;
+	struct verify_batch *vb = NULL;
+	TEE_Result res = TEE_SUCCESS;
 
-	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
-	if (res != TEE_SUCCESS)
-		return res;
+	vb = calloc(1, sizeof(*vb));
+	if (!vb)
+		return TEE_ERROR_OUT_OF_MEMORY;
 
-	res = htree_traverse_post_order(ht, verify_node, ctx);
-	crypto_hash_free_ctx(ctx);
+	res = htree_traverse_post_order(ht, verify_node, vb);
+	if (!res && vb->count)
+		res = verify_batch_flush(vb);
+	free(vb);
 
 	return res;
 }
@@ -643,6 +864,10 @@ TEE_Result tee_fs_htree_open(bool create, uint8_t *hash, uint32_t min_counter,
 		if (res != TEE_SUCCESS)
 			goto out;
 
+		res = init_fek_key(ht);
+		if (res != TEE_SUCCESS)
+			goto out;
+
 		res = init_root_node(ht);
 		if (res != TEE_SUCCESS)
 			goto out;
@@ -686,6 +911,18 @@ void tee_fs_htree_meta_set_dirty(struct tee_fs_htree *ht)
 	ht->root.dirty = true;
 }
 
+TEE_Result tee_fs_htree_get_hash(struct tee_fs_htree *ht, uint8_t *hash,
+				 uint32_t *counter)
+{
+	if (ht->dirty)
+		return TEE_ERROR_BAD_STATE;
+
+	memcpy(hash, ht->root.node.hash, sizeof(ht->root.node.hash));
+	*counter = ht->head.counter;
+
+	return TEE_SUCCESS;
+}
+
 static TEE_Result free_node(struct traverse_arg *targ __unused,
 			    struct htree_node *node)
 {
@@ -699,6 +936,7 @@ void tee_fs_htree_close(struct tee_fs_htree **ht)
 	if (!*ht)
 		return;
 	htree_traverse_post_order(*ht, free_node, NULL);
+	wipe_fek_key(*ht);
 	free(*ht);
 	*ht = NULL;
 }
@@ -747,17 +985,10 @@ static TEE_Result htree_sync_node_to_storage(struct traverse_arg *targ,
 
 static TEE_Result update_root(struct tee_fs_htree *ht)
 {
-	TEE_Result res;
-	void *ctx;
-
 	ht->head.counter++;
 
-	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, NULL, sizeof(ht->imeta));
-	if (res != TEE_SUCCESS)
-		return res;
-
-	return authenc_encrypt_final(ctx, ht->head.tag, &ht->imeta,
-				     sizeof(ht->imeta), &ht->head.imeta);
+	return authenc_crypt(TEE_MODE_ENCRYPT, ht, NULL, &ht->imeta,
+			     sizeof(ht->imeta), &ht->head.imeta);
 }
 
 TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
@@ -766,6 +997,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	TEE_Result res;
 	struct tee_fs_htree *ht = *ht_arg;
 	void *ctx;
+	uint64_t t = 0;
 
 	if (!ht)
 		return TEE_ERROR_CORRUPT_OBJECT;
@@ -773,6 +1005,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 	if (!ht->dirty)
 		return TEE_SUCCESS;
 
+	t = tee_fs_perf_begin();
 	res = crypto_hash_alloc_ctx(&ctx, TEE_FS_HTREE_HASH_ALG);
 	if (res != TEE_SUCCESS)
 		return res;
@@ -797,6 +1030,7 @@ TEE_Result tee_fs_htree_sync_to_storage(struct tee_fs_htree **ht_arg,
 		*counter = ht->head.counter;
 out:
 	crypto_hash_free_ctx(ctx);
+	tee_fs_perf_end(TEE_FS_PERF_HTREE, t);
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
 	return res;
@@ -823,7 +1057,6 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	struct tee_fs_rpc_operation op;
 	struct htree_node *node = NULL;
 	uint8_t block_vers;
-	void *ctx;
 	void *enc_block;
 
 	if (!ht)
@@ -843,12 +1076,8 @@ TEE_Result tee_fs_htree_write_block(struct tee_fs_htree **ht_arg,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = authenc_init(&ctx, TEE_MODE_ENCRYPT, ht, &node->node,
-			   ht->stor->block_size);
-	if (res != TEE_SUCCESS)
-		goto out;
-	res = authenc_encrypt_final(ctx, node->node.tag, block,
-				    ht->stor->block_size, enc_block);
+	res = authenc_crypt(TEE_MODE_ENCRYPT, ht, &node->node, block,
+			    ht->stor->block_size, enc_block);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -874,7 +1103,6 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 	struct htree_node *node;
 	uint8_t block_vers;
 	size_t len;
-	void *ctx;
 	void *enc_block;
 
 	if (!ht)
@@ -899,13 +1127,8 @@ TEE_Result tee_fs_htree_read_block(struct tee_fs_htree **ht_arg,
 		goto out;
 	}
 
-	res = authenc_init(&ctx, TEE_MODE_DECRYPT, ht, &node->node,
-			   ht->stor->block_size);
-	if (res != TEE_SUCCESS)
-		goto out;
-
-	res = authenc_decrypt_final(ctx, node->node.tag, enc_block,
-				    ht->stor->block_size, block);
+	res = authenc_crypt(TEE_MODE_DECRYPT, ht, &node->node, enc_block,
+			    ht->stor->block_size, block);
 out:
 	if (res != TEE_SUCCESS)
 		tee_fs_htree_close(ht_arg);
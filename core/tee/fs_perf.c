@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: BSD-2-Clause
+/*
+ * Copyright (c) 2024, Analog Devices Incorporated
+ */
+
+#include <kernel/thread.h>
+#include <tee/fs_perf.h>
+
+static struct tee_fs_perf_stats *thread_stats[CFG_NUM_THREADS];
+
+static struct tee_fs_perf_stats **get_slot(void)
+{
+	short int id = thread_get_id_may_fail();
+
+	if (id < 0)
+		return NULL;
+	return thread_stats + id;
+}
+
+void tee_fs_perf_attach(struct tee_fs_perf_stats *stats)
+{
+	thread_stats[thread_get_id()] = stats;
+}
+
+void tee_fs_perf_detach(void)
+{
+	thread_stats[thread_get_id()] = NULL;
+}
+
+uint64_t tee_fs_perf_begin(void)
+{
+	struct tee_fs_perf_stats **slot = get_slot();
+
+	if (!slot || !*slot)
+		return TEE_FS_PERF_DISABLED;
+	return barrier_read_counter_timer();
+}
+
+void tee_fs_perf_end(enum tee_fs_perf_phase phase, uint64_t begin)
+{
+	struct tee_fs_perf_stats **slot = get_slot();
+	struct tee_fs_perf_stats *stats = NULL;
+
+	if (begin == TEE_FS_PERF_DISABLED || !slot || !*slot ||
+	    phase >= TEE_FS_PERF_PHASE_COUNT)
+		return;
+
+	stats = *slot;
+	stats->ticks[phase] += barrier_read_counter_timer() - begin;
+	stats->count[phase]++;
+}
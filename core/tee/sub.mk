@@ -38,6 +38,7 @@ srcs-y += tee_ta_enc_manager.c
 endif #CFG_WITH_USER_TA,y
 
 srcs-$(_CFG_WITH_SECURE_STORAGE) += tee_fs_key_manager.c
+srcs-$(CFG_TEE_FS_PERF_STATS) += fs_perf.c
 srcs-$(CFG_RPMB_FS) += tee_rpmb_fs.c
 srcs-$(CFG_REE_FS) += tee_ree_fs.c
 srcs-$(CFG_REE_FS) += fs_dirfile.c
@@ -74,6 +74,8 @@ TEE_Result tee_cipher_get_block_size(uint32_t algo, size_t *size)
 	case TEE_ALG_SM4_CBC_NOPAD:
 	case TEE_ALG_SM4_XTS:
 	case TEE_ALG_SM4_CTR:
+	case TEE_ALG_SM4_CCM:
+	case TEE_ALG_SM4_GCM:
 		*size = 16;
 		break;
 
@@ -12,6 +12,7 @@
 #include <string_ext.h>
 #include <string.h>
 #include <tee/fs_dirfile.h>
+#include <tee/fs_perf.h>
 #include <tee/tee_fs.h>
 #include <tee/tee_fs_rpc.h>
 #include <tee/tee_pobj.h>
@@ -46,7 +47,13 @@ static TEE_Result create_filename(void *buf, size_t blen,
 
 static TEE_Result operation_commit(struct tee_fs_rpc_operation *op)
 {
-	return thread_rpc_cmd(op->id, op->num_params, op->params);
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = thread_rpc_cmd(op->id, op->num_params, op->params);
+	tee_fs_perf_end(TEE_FS_PERF_RPC, t);
+
+	return res;
 }
 
 static TEE_Result operation_open_dfh(uint32_t id, unsigned int cmd,
@@ -3,6 +3,7 @@
  * Copyright (c) 2014, STMicroelectronics International N.V.
  */
 
+#include <kernel/handle.h>
 #include <mm/vm.h>
 #include <stdlib.h>
 #include <tee_api_defines.h>
@@ -13,28 +14,34 @@
 #include <tee/tee_svc_storage.h>
 #include <trace.h>
 
-void tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
+TEE_Result tee_obj_add(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	TAILQ_INSERT_TAIL(&utc->objects, o, link);
+
+	o->handle = handle_table_add(&utc->object_handles, o);
+	if (!o->handle)
+		return TEE_ERROR_OUT_OF_MEMORY;
+
+	return TEE_SUCCESS;
 }
 
-TEE_Result tee_obj_get(struct user_ta_ctx *utc, vaddr_t obj_id,
+TEE_Result tee_obj_get(struct user_ta_ctx *utc, uint32_t obj_id,
 		       struct tee_obj **obj)
 {
-	struct tee_obj *o;
+	struct tee_obj *o = handle_table_lookup(&utc->object_handles, obj_id);
 
-	TAILQ_FOREACH(o, &utc->objects, link) {
-		if (obj_id == (vaddr_t)o) {
-			*obj = o;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_STATE;
+	if (!o)
+		return TEE_ERROR_BAD_STATE;
+
+	*obj = o;
+	return TEE_SUCCESS;
 }
 
 void tee_obj_close(struct user_ta_ctx *utc, struct tee_obj *o)
 {
 	TAILQ_REMOVE(&utc->objects, o, link);
+	if (o->handle)
+		handle_table_remove(&utc->object_handles, o->handle);
 
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_PERSISTENT)) {
 		o->pobj->fops->close(&o->fh);
@@ -50,6 +57,8 @@ void tee_obj_close_all(struct user_ta_ctx *utc)
 
 	while (!TAILQ_EMPTY(objects))
 		tee_obj_close(utc, TAILQ_FIRST(objects));
+
+	handle_table_destroy(&utc->object_handles);
 }
 
 TEE_Result tee_obj_verify(struct tee_ta_session *sess, struct tee_obj *o)
@@ -492,6 +492,17 @@ static TEE_Result ree_dirf_commit_writes(struct tee_file_handle *fh,
 	return res;
 }
 
+static TEE_Result ree_dirf_get_hash(struct tee_file_handle *fh,
+				    uint8_t *hash, uint32_t *counter)
+{
+	struct tee_fs_fd *fdp = (struct tee_fs_fd *)fh;
+
+	if (!fdp->ht)
+		return TEE_ERROR_CORRUPT_OBJECT;
+
+	return tee_fs_htree_get_hash(fdp->ht, hash, counter);
+}
+
 static TEE_Result dirf_read(struct tee_file_handle *fh, size_t pos, void *buf,
 			    size_t *len)
 {
@@ -510,6 +521,7 @@ static const struct tee_fs_dirfile_operations ree_dirf_ops = {
 	.read = dirf_read,
 	.write = dirf_write,
 	.commit_writes = ree_dirf_commit_writes,
+	.get_hash = ree_dirf_get_hash,
 };
 
 static struct tee_fs_dirfile_dirh *ree_fs_dirh;
@@ -25,6 +25,7 @@
 #include <string_ext.h>
 #include <string.h>
 #include <sys/queue.h>
+#include <tee/fs_perf.h>
 #include <tee/tee_fs.h>
 #include <tee/tee_fs_key_manager.h>
 #include <tee/tee_pobj.h>
@@ -255,6 +256,7 @@ struct rpmb_dev_info {
  * @key_derived      Flag indicating if key has been generated.
  * @key_verified     Flag indicating the key generated is verified ok.
  * @dev_info_synced  Flag indicating if dev info has been retrieved from RPMB.
+ * @hmac_ctx         HMAC-SHA256 context reused for all frames MAC operations.
  */
 struct tee_rpmb_ctx {
 	uint8_t key[RPMB_KEY_MAC_SIZE];
@@ -267,6 +269,7 @@ struct tee_rpmb_ctx {
 	bool key_derived;
 	bool key_verified;
 	bool dev_info_synced;
+	void *hmac_ctx;
 };
 
 static struct tee_rpmb_ctx *rpmb_ctx;
@@ -367,8 +370,31 @@ static void get_op_result_bits(uint8_t *bytes, uint8_t *res)
 	*res = *(bytes + 1) & RPMB_RESULT_MASK;
 }
 
+/*
+ * Returns the HMAC context of the RPMB context, initialized with the RPMB
+ * key. The context is allocated once and reused for each request.
+ */
+static TEE_Result tee_rpmb_mac_init(void **ctx)
+{
+	TEE_Result res = TEE_SUCCESS;
+
+	if (!rpmb_ctx->hmac_ctx) {
+		res = crypto_mac_alloc_ctx(&rpmb_ctx->hmac_ctx,
+					   TEE_ALG_HMAC_SHA256);
+		if (res)
+			return res;
+	}
+
+	res = crypto_mac_init(rpmb_ctx->hmac_ctx, rpmb_ctx->key,
+			      RPMB_KEY_MAC_SIZE);
+	if (res)
+		return res;
+
+	*ctx = rpmb_ctx->hmac_ctx;
+	return TEE_SUCCESS;
+}
+
 static TEE_Result tee_rpmb_mac_calc(uint8_t *mac, uint32_t macsize,
-				    uint8_t *key, uint32_t keysize,
 				    struct rpmb_data_frame *datafrms,
 				    uint16_t blkcnt)
 {
@@ -376,104 +402,94 @@ static TEE_Result tee_rpmb_mac_calc(uint8_t *mac, uint32_t macsize,
 	int i;
 	void *ctx = NULL;
 
-	if (!mac || !key || !datafrms)
+	if (!mac || !datafrms)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
-	if (res)
-		return res;
-
-	res = crypto_mac_init(ctx, key, keysize);
+	res = tee_rpmb_mac_init(&ctx);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
+		return res;
 
 	for (i = 0; i < blkcnt; i++) {
 		res = crypto_mac_update(ctx, datafrms[i].data,
 					RPMB_MAC_PROTECT_DATA_SIZE);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 	}
 
-	res = crypto_mac_final(ctx, mac, macsize);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = TEE_SUCCESS;
-
-func_exit:
-	crypto_mac_free_ctx(ctx);
-	return res;
+	return crypto_mac_final(ctx, mac, macsize);
 }
 
+/*
+ * RPC memory used for a single RPMB request. The request and the response
+ * share one per-thread cached shared memory buffer: the request starts at
+ * offset 0 and the response at @resp_offs. This avoids two RPCs to
+ * allocate and two RPCs to free shared memory for each RPMB request, so a
+ * file operation issuing a sequence of reads and authenticated writes only
+ * allocates its shared memory once.
+ */
 struct tee_rpmb_mem {
-	struct mobj *phreq_mobj;
-	struct mobj *phresp_mobj;
+	struct mobj *mobj;
 	size_t req_size;
+	size_t resp_offs;
 	size_t resp_size;
 };
 
 static void tee_rpmb_free(struct tee_rpmb_mem *mem)
 {
-	if (!mem)
-		return;
-
-	if (mem->phreq_mobj) {
-		thread_rpc_free_payload(mem->phreq_mobj);
-		mem->phreq_mobj = NULL;
-	}
-	if (mem->phresp_mobj) {
-		thread_rpc_free_payload(mem->phresp_mobj);
-		mem->phresp_mobj = NULL;
-	}
+	/*
+	 * The shared memory itself is owned by the thread shm cache and
+	 * released when the current standard call returns.
+	 */
+	if (mem)
+		mem->mobj = NULL;
 }
 
 
 static TEE_Result tee_rpmb_alloc(size_t req_size, size_t resp_size,
 		struct tee_rpmb_mem *mem, void **req, void **resp)
 {
-	TEE_Result res = TEE_SUCCESS;
 	size_t req_s = ROUNDUP(req_size, sizeof(uint32_t));
 	size_t resp_s = ROUNDUP(resp_size, sizeof(uint32_t));
+	uint8_t *va = NULL;
 
 	if (!mem)
 		return TEE_ERROR_BAD_PARAMETERS;
 
 	memset(mem, 0, sizeof(*mem));
 
-	mem->phreq_mobj = thread_rpc_alloc_payload(req_s);
-	mem->phresp_mobj = thread_rpc_alloc_payload(resp_s);
+	va = thread_rpc_shm_cache_alloc(THREAD_SHM_CACHE_USER_RPMB,
+					THREAD_SHM_TYPE_APPLICATION,
+					req_s + resp_s, &mem->mobj);
+	if (!va)
+		return TEE_ERROR_OUT_OF_MEMORY;
 
-	if (!mem->phreq_mobj || !mem->phresp_mobj) {
-		res = TEE_ERROR_OUT_OF_MEMORY;
-		goto out;
-	}
+	/* The buffer is recycled, don't leak a previous request/response */
+	memset(va, 0, req_s + resp_s);
 
-	*req = mobj_get_va(mem->phreq_mobj, 0, req_s);
-	*resp = mobj_get_va(mem->phresp_mobj, 0, resp_s);
-	if (!*req || !*resp) {
-		res = TEE_ERROR_GENERIC;
-		goto out;
-	}
+	*req = va;
+	*resp = va + req_s;
 
 	mem->req_size = req_size;
+	mem->resp_offs = req_s;
 	mem->resp_size = resp_size;
 
-out:
-	if (res != TEE_SUCCESS)
-		tee_rpmb_free(mem);
-	return res;
+	return TEE_SUCCESS;
 }
 
 static TEE_Result tee_rpmb_invoke(struct tee_rpmb_mem *mem)
 {
 	struct thread_param params[2] = {
-		[0] = THREAD_PARAM_MEMREF(IN, mem->phreq_mobj, 0,
-					  mem->req_size),
-		[1] = THREAD_PARAM_MEMREF(OUT, mem->phresp_mobj, 0,
+		[0] = THREAD_PARAM_MEMREF(IN, mem->mobj, 0, mem->req_size),
+		[1] = THREAD_PARAM_MEMREF(OUT, mem->mobj, mem->resp_offs,
 					  mem->resp_size),
 	};
+	uint64_t t = tee_fs_perf_begin();
+	TEE_Result res = TEE_SUCCESS;
+
+	res = thread_rpc_cmd(OPTEE_RPC_CMD_RPMB, 2, params);
+	tee_fs_perf_end(TEE_FS_PERF_RPC, t);
 
-	return thread_rpc_cmd(OPTEE_RPC_CMD_RPMB, 2, params);
+	return res;
 }
 
 static bool is_zero(const uint8_t *buf, size_t size)
@@ -551,6 +567,7 @@ static TEE_Result tee_rpmb_req_pack(struct rpmb_req *req,
 	TEE_Result res = TEE_ERROR_GENERIC;
 	int i;
 	struct rpmb_data_frame *datafrm;
+	void *mac_ctx = NULL;
 
 	if (!req || !rawdata || !nbr_frms)
 		return TEE_ERROR_BAD_PARAMETERS;
@@ -574,6 +591,18 @@ static TEE_Result tee_rpmb_req_pack(struct rpmb_req *req,
 	if (!datafrm)
 		return TEE_ERROR_OUT_OF_MEMORY;
 
+	/*
+	 * The MAC of an authenticated write covers all frames. Feed each
+	 * frame to the MAC as soon as it's complete, while it's still hot
+	 * in the cache, instead of making a second pass over all frames.
+	 */
+	if (rawdata->key_mac &&
+	    rawdata->msg_type == RPMB_MSG_TYPE_REQ_AUTH_DATA_WRITE) {
+		res = tee_rpmb_mac_init(&mac_ctx);
+		if (res != TEE_SUCCESS)
+			goto func_exit;
+	}
+
 	for (i = 0; i < nbr_frms; i++) {
 		u16_to_bytes(rawdata->msg_type, datafrm[i].msg_type);
 
@@ -614,15 +643,19 @@ static TEE_Result tee_rpmb_req_pack(struct rpmb_req *req,
 				       RPMB_DATA_SIZE);
 			}
 		}
+
+		if (mac_ctx) {
+			res = crypto_mac_update(mac_ctx, datafrm[i].data,
+						RPMB_MAC_PROTECT_DATA_SIZE);
+			if (res != TEE_SUCCESS)
+				goto func_exit;
+		}
 	}
 
 	if (rawdata->key_mac) {
-		if (rawdata->msg_type == RPMB_MSG_TYPE_REQ_AUTH_DATA_WRITE) {
-			res =
-			    tee_rpmb_mac_calc(rawdata->key_mac,
-					      RPMB_KEY_MAC_SIZE, rpmb_ctx->key,
-					      RPMB_KEY_MAC_SIZE, datafrm,
-					      nbr_frms);
+		if (mac_ctx) {
+			res = crypto_mac_final(mac_ctx, rawdata->key_mac,
+					       RPMB_KEY_MAC_SIZE);
 			if (res != TEE_SUCCESS)
 				goto func_exit;
 		}
@@ -658,8 +691,7 @@ static TEE_Result data_cpy_mac_calc_1b(struct rpmb_raw_data *rawdata,
 	if (rawdata->len + rawdata->byte_offset > RPMB_DATA_SIZE)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = tee_rpmb_mac_calc(rawdata->key_mac, RPMB_KEY_MAC_SIZE,
-				rpmb_ctx->key, RPMB_KEY_MAC_SIZE, frm, 1);
+	res = tee_rpmb_mac_calc(rawdata->key_mac, RPMB_KEY_MAC_SIZE, frm, 1);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -697,13 +729,9 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 
 	data = rawdata->data;
 
-	res = crypto_mac_alloc_ctx(&ctx, TEE_ALG_HMAC_SHA256);
-	if (res)
-		goto func_exit;
-
-	res = crypto_mac_init(ctx, rpmb_ctx->key, RPMB_KEY_MAC_SIZE);
+	res = tee_rpmb_mac_init(&ctx);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
+		return res;
 
 	/*
 	 * Note: JEDEC JESD84-B51: "In every packet the address is the start
@@ -724,7 +752,7 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 		res = crypto_mac_update(ctx, localfrm.data,
 					RPMB_MAC_PROTECT_DATA_SIZE);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 
 		if (i == 0) {
 			/* First block */
@@ -739,7 +767,7 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 		res = decrypt(data, &localfrm, size, offset, start_idx + i,
 			      fek, uuid);
 		if (res != TEE_SUCCESS)
-			goto func_exit;
+			return res;
 
 		data += size;
 	}
@@ -751,22 +779,14 @@ static TEE_Result tee_rpmb_data_cpy_mac_calc(struct rpmb_data_frame *datafrm,
 	res = decrypt(data, lastfrm, size, 0, start_idx + nbr_frms - 1, fek,
 		      uuid);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
+		return res;
 
 	/* Update MAC against the last block */
 	res = crypto_mac_update(ctx, lastfrm->data, RPMB_MAC_PROTECT_DATA_SIZE);
 	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = crypto_mac_final(ctx, rawdata->key_mac, RPMB_KEY_MAC_SIZE);
-	if (res != TEE_SUCCESS)
-		goto func_exit;
-
-	res = TEE_SUCCESS;
+		return res;
 
-func_exit:
-	crypto_mac_free_ctx(ctx);
-	return res;
+	return crypto_mac_final(ctx, rawdata->key_mac, RPMB_KEY_MAC_SIZE);
 }
 
 static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
@@ -863,8 +883,6 @@ static TEE_Result tee_rpmb_resp_unpack_verify(struct rpmb_data_frame *datafrm,
 				return TEE_ERROR_GENERIC;
 
 			res = tee_rpmb_mac_calc(rawdata->key_mac,
-						RPMB_KEY_MAC_SIZE,
-						rpmb_ctx->key,
 						RPMB_KEY_MAC_SIZE,
 						&lastfrm, 1);
 
@@ -1106,6 +1124,7 @@ static TEE_Result tee_rpmb_init(uint16_t dev_id)
 		if (!rpmb_ctx)
 			return TEE_ERROR_OUT_OF_MEMORY;
 	} else if (rpmb_ctx->dev_id != dev_id) {
+		crypto_mac_free_ctx(rpmb_ctx->hmac_ctx);
 		memset(rpmb_ctx, 0x00, sizeof(struct tee_rpmb_ctx));
 	}
 
@@ -1138,11 +1157,17 @@ static TEE_Result tee_rpmb_init(uint16_t dev_id)
 
 		memcpy(rpmb_ctx->cid, dev_info.cid, RPMB_EMMC_CID_SIZE);
 
-#ifdef RPMB_DRIVER_MULTIPLE_WRITE_FIXED
-		rpmb_ctx->rel_wr_blkcnt = dev_info.rel_wr_sec_c * 2;
-#else
-		rpmb_ctx->rel_wr_blkcnt = 1;
-#endif
+		/*
+		 * A reliable write sector is 512 bytes, that is two RPMB
+		 * data frames. Pack as many frames as the device accepts
+		 * in one authenticated write when the normal world driver
+		 * supports multi-frame writes.
+		 */
+		if (IS_ENABLED(CFG_RPMB_DRIVER_MULTIPLE_WRITE_FIXED) &&
+		    dev_info.rel_wr_sec_c)
+			rpmb_ctx->rel_wr_blkcnt = dev_info.rel_wr_sec_c * 2;
+		else
+			rpmb_ctx->rel_wr_blkcnt = 1;
 
 		rpmb_ctx->dev_info_synced = true;
 	}
@@ -1954,6 +1979,18 @@ static struct rpmb_file_handle *alloc_file_handle(struct tee_pobj *po,
 	return fh;
 }
 
+static TEE_Result check_fat_address(uint32_t fat_address)
+{
+	/* Protect partition data. */
+	if (fat_address < sizeof(struct rpmb_fs_partition))
+		return TEE_ERROR_ACCESS_CONFLICT;
+
+	if (fat_address % sizeof(struct rpmb_fat_entry) != 0)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	return TEE_SUCCESS;
+}
+
 /**
  * write_fat_entry: Store info in a fat_entry to RPMB.
  */
@@ -1961,16 +1998,9 @@ static TEE_Result write_fat_entry(struct rpmb_file_handle *fh)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 
-	/* Protect partition data. */
-	if (fh->rpmb_fat_address < sizeof(struct rpmb_fs_partition)) {
-		res = TEE_ERROR_ACCESS_CONFLICT;
-		goto out;
-	}
-
-	if (fh->rpmb_fat_address % sizeof(struct rpmb_fat_entry) != 0) {
-		res = TEE_ERROR_BAD_PARAMETERS;
+	res = check_fat_address(fh->rpmb_fat_address);
+	if (res)
 		goto out;
-	}
 
 	res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, fh->rpmb_fat_address,
 			     (uint8_t *)&fh->fat_entry,
@@ -1987,6 +2017,53 @@ out:
 	return res;
 }
 
+/**
+ * write_fat_entry_and_last: Store the fat_entry of @fh and the new last
+ * FAT entry @last_fh that immediately follows it to RPMB.
+ * Both entries are stored with a single authenticated write when the
+ * device can write them reliably in one go. Otherwise the new last entry
+ * is written first so the FAT stays terminated if we're interrupted
+ * between the two writes.
+ */
+static TEE_Result write_fat_entry_and_last(struct rpmb_file_handle *fh,
+					   struct rpmb_file_handle *last_fh)
+{
+	struct rpmb_fat_entry fe[2] = { };
+	TEE_Result res = TEE_ERROR_GENERIC;
+
+	assert(last_fh->rpmb_fat_address ==
+	       fh->rpmb_fat_address + sizeof(struct rpmb_fat_entry));
+
+	if (!tee_rpmb_write_is_atomic(CFG_RPMB_FS_DEV_ID, fh->rpmb_fat_address,
+				      sizeof(fe))) {
+		res = write_fat_entry(last_fh);
+		if (res)
+			return res;
+		return write_fat_entry(fh);
+	}
+
+	res = check_fat_address(fh->rpmb_fat_address);
+	if (res)
+		return res;
+
+	fe[0] = fh->fat_entry;
+	fe[1] = last_fh->fat_entry;
+	res = tee_rpmb_write(CFG_RPMB_FS_DEV_ID, fh->rpmb_fat_address,
+			     (uint8_t *)fe, sizeof(fe), NULL, NULL);
+
+	dump_fat();
+
+	if (CFG_RPMB_FS_CACHE_ENTRIES && !res) {
+		res = fat_entry_dir_update(&fh->fat_entry,
+					   fh->rpmb_fat_address);
+		if (!res)
+			res = fat_entry_dir_update(&last_fh->fat_entry,
+						   last_fh->rpmb_fat_address);
+	}
+
+	return res;
+}
+
 /**
  * rpmb_fs_setup: Setup RPMB FS.
  * Set initial partition and FS values and write to RPMB.
@@ -2126,8 +2203,13 @@ static TEE_Result get_fat_start_address(uint32_t *addr)
  * Return matching FAT entry for read, rm rename and stat.
  * Build up memory pool and return matching entry for write operation.
  * "Last FAT entry" can be returned during write.
+ * If the FAT must be expanded and @last_fh isn't NULL, the new last FAT
+ * entry is returned in @last_fh instead of being written, so the caller can
+ * store it together with the entry of @fh. @last_fh->rpmb_fat_address is
+ * left 0 if the FAT doesn't need to be expanded.
  */
-static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
+static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p,
+			   struct rpmb_file_handle *last_fh)
 {
 	TEE_Result res = TEE_ERROR_GENERIC;
 	tee_mm_entry_t *mm = NULL;
@@ -2135,10 +2217,13 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 	uint32_t fat_address;
 	bool entry_found = false;
 	bool expand_fat = false;
-	struct rpmb_file_handle last_fh;
+	struct rpmb_file_handle tmp_fh;
 
 	DMSG("fat_address %d", fh->rpmb_fat_address);
 
+	if (last_fh)
+		memset(last_fh, 0, sizeof(*last_fh));
+
 	res = fat_entry_dir_init();
 	if (res)
 		goto out;
@@ -2232,12 +2317,17 @@ static TEE_Result read_fat(struct rpmb_file_handle *fh, tee_mm_pool_t *p)
 			 * entry.
 			 */
 			fat_address -= sizeof(struct rpmb_fat_entry);
-			memset(&last_fh, 0, sizeof(last_fh));
-			last_fh.fat_entry.flags = FILE_IS_LAST_ENTRY;
-			last_fh.rpmb_fat_address = fat_address;
-			res = write_fat_entry(&last_fh);
-			if (res != TEE_SUCCESS)
-				goto out;
+			if (last_fh) {
+				last_fh->fat_entry.flags = FILE_IS_LAST_ENTRY;
+				last_fh->rpmb_fat_address = fat_address;
+			} else {
+				memset(&tmp_fh, 0, sizeof(tmp_fh));
+				tmp_fh.fat_entry.flags = FILE_IS_LAST_ENTRY;
+				tmp_fh.rpmb_fat_address = fat_address;
+				res = write_fat_entry(&tmp_fh);
+				if (res != TEE_SUCCESS)
+					goto out;
+			}
 		}
 	}
 
@@ -2271,6 +2361,7 @@ static TEE_Result rpmb_fs_open_internal(struct rpmb_file_handle *fh,
 	bool pool_result;
 	paddr_size_t pool_sz = 0;
 	TEE_Result res = TEE_ERROR_GENERIC;
+	struct rpmb_file_handle last_fh = { };
 
 	/* We need to do setup in order to make sure fs_par is filled in */
 	res = rpmb_fs_setup();
@@ -2292,12 +2383,12 @@ static TEE_Result rpmb_fs_open_internal(struct rpmb_file_handle *fh,
 			goto out;
 		}
 
-		res = read_fat(fh, &p);
+		res = read_fat(fh, &p, &last_fh);
 		tee_mm_final(&p);
 		if (res != TEE_SUCCESS)
 			goto out;
 	} else {
-		res = read_fat(fh, NULL);
+		res = read_fat(fh, NULL, NULL);
 		if (res != TEE_SUCCESS)
 			goto out;
 	}
@@ -2322,7 +2413,18 @@ static TEE_Result rpmb_fs_open_internal(struct rpmb_file_handle *fh,
 			     (void *)fh->fat_entry.fek);
 			DHEXDUMP(fh->fat_entry.fek, sizeof(fh->fat_entry.fek));
 
-			res = write_fat_entry(fh);
+			/*
+			 * If the FAT was expanded, the new entry and the
+			 * new last entry are adjacent: store them together.
+			 */
+			if (last_fh.rpmb_fat_address)
+				res = write_fat_entry_and_last(fh, &last_fh);
+			else
+				res = write_fat_entry(fh);
+			if (res != TEE_SUCCESS)
+				goto out;
+		} else if (last_fh.rpmb_fat_address) {
+			res = write_fat_entry(&last_fh);
 			if (res != TEE_SUCCESS)
 				goto out;
 		}
@@ -2359,7 +2461,7 @@ static TEE_Result rpmb_fs_read(struct tee_file_handle *tfh, size_t pos,
 
 	dump_fh(fh);
 
-	res = read_fat(fh, NULL);
+	res = read_fat(fh, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2507,7 +2609,7 @@ static TEE_Result rpmb_fs_write_primitive(struct rpmb_file_handle *fh,
 		goto out;
 	}
 
-	res = read_fat(fh, &p);
+	res = read_fat(fh, &p, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2601,7 +2703,7 @@ static TEE_Result rpmb_fs_remove_internal(struct rpmb_file_handle *fh)
 {
 	TEE_Result res;
 
-	res = read_fat(fh, NULL);
+	res = read_fat(fh, NULL, NULL);
 	if (res)
 		return res;
 
@@ -2659,11 +2761,11 @@ static  TEE_Result rpmb_fs_rename_internal(struct tee_pobj *old,
 		goto out;
 	}
 
-	res = read_fat(fh_old, NULL);
+	res = read_fat(fh_old, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = read_fat(fh_new, NULL);
+	res = read_fat(fh_new, NULL, NULL);
 	if (res == TEE_SUCCESS) {
 		if (!overwrite) {
 			res = TEE_ERROR_ACCESS_CONFLICT;
@@ -2722,7 +2824,7 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 	}
 	newsize = length;
 
-	res = read_fat(fh, NULL);
+	res = read_fat(fh, NULL, NULL);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -2739,7 +2841,7 @@ static TEE_Result rpmb_fs_truncate(struct tee_file_handle *tfh, size_t length)
 			res = TEE_ERROR_OUT_OF_MEMORY;
 			goto out;
 		}
-		res = read_fat(fh, &p);
+		res = read_fat(fh, &p, NULL);
 		if (res != TEE_SUCCESS)
 			goto out;
 
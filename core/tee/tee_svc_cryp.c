@@ -47,10 +47,11 @@ enum cryp_state {
 typedef void (*tee_cryp_ctx_finalize_func_t) (void *ctx);
 struct tee_cryp_state {
 	TAILQ_ENTRY(tee_cryp_state) link;
+	uint32_t handle;
 	uint32_t algo;
 	uint32_t mode;
-	vaddr_t key1;
-	vaddr_t key2;
+	uint32_t key1;
+	uint32_t key2;
 	void *ctx;
 	tee_cryp_ctx_finalize_func_t ctx_finalize;
 	enum cryp_state state;
@@ -1179,7 +1180,7 @@ TEE_Result syscall_cryp_obj_get_info(unsigned long obj,
 	struct tee_obj *o = NULL;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(obj), &o);
+			  obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -1209,7 +1210,7 @@ TEE_Result syscall_cryp_obj_restrict_usage(unsigned long obj,
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res)
 		return res;
 
@@ -1291,7 +1292,7 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	void *attr = NULL;
 	uint32_t obj_usage = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return TEE_ERROR_ITEM_NOT_FOUND;
 
@@ -1327,11 +1328,29 @@ TEE_Result syscall_cryp_obj_get_attr(unsigned long obj, unsigned long attr_id,
 	return ops->to_user(attr, sess, buffer, size);
 }
 
+/*
+ * Only contexts of implementations with a reinit() callback are cached,
+ * these wipe the expanded key when the context is freed.
+ */
+static void tee_obj_key_cache_clear(struct tee_obj *o)
+{
+	if (!o->key_ctx)
+		return;
+
+	if (TEE_ALG_GET_CLASS(o->key_ctx_algo) == TEE_OPERATION_AE)
+		crypto_authenc_free_ctx(o->key_ctx);
+	else
+		crypto_cipher_free_ctx(o->key_ctx);
+	o->key_ctx = NULL;
+	o->key_ctx_algo = 0;
+}
+
 void tee_obj_attr_free(struct tee_obj *o)
 {
 	const struct tee_cryp_obj_type_props *tp;
 	size_t n;
 
+	tee_obj_key_cache_clear(o);
 	if (!o->attr)
 		return;
 	tp = tee_svc_find_type_props(o->info.objectType);
@@ -1350,6 +1369,7 @@ void tee_obj_attr_clear(struct tee_obj *o)
 	const struct tee_cryp_obj_type_props *tp;
 	size_t n;
 
+	tee_obj_key_cache_clear(o);
 	if (!o->attr)
 		return;
 	tp = tee_svc_find_type_props(o->info.objectType);
@@ -1405,6 +1425,7 @@ TEE_Result tee_obj_attr_from_binary(struct tee_obj *o, const void *data,
 	size_t n;
 	size_t offs = 0;
 
+	tee_obj_key_cache_clear(o);
 	if (o->info.objectType == TEE_TYPE_DATA)
 		return TEE_SUCCESS; /* pure data object */
 	if (!o->attr)
@@ -1434,6 +1455,7 @@ TEE_Result tee_obj_attr_copy_from(struct tee_obj *o, const struct tee_obj *src)
 	void *attr;
 	void *src_attr;
 
+	tee_obj_key_cache_clear(o);
 	if (o->info.objectType == TEE_TYPE_DATA)
 		return TEE_SUCCESS; /* pure data object */
 	if (!o->attr)
@@ -1672,9 +1694,9 @@ TEE_Result syscall_cryp_obj_alloc(unsigned long obj_type,
 		return res;
 	}
 
-	tee_obj_add(to_user_ta_ctx(sess->ctx), o);
-
-	res = copy_kaddr_to_uref(obj, o);
+	res = tee_obj_add(to_user_ta_ctx(sess->ctx), o);
+	if (res == TEE_SUCCESS)
+		res = copy_to_user_private(obj, &o->handle, sizeof(o->handle));
 	if (res != TEE_SUCCESS)
 		tee_obj_close(to_user_ta_ctx(sess->ctx), o);
 	return res;
@@ -1686,7 +1708,7 @@ TEE_Result syscall_cryp_obj_close(unsigned long obj)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1707,7 +1729,7 @@ TEE_Result syscall_cryp_obj_reset(unsigned long obj)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -1998,7 +2020,7 @@ TEE_Result syscall_cryp_obj_populate(unsigned long obj,
 	TEE_Attribute *attrs = NULL;
 	size_t alloc_size = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2048,12 +2070,12 @@ TEE_Result syscall_cryp_obj_copy(unsigned long dst, unsigned long src)
 	struct tee_obj *src_o = NULL;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(dst), &dst_o);
+			  dst, &dst_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	res = tee_obj_get(to_user_ta_ctx(sess->ctx),
-			  uref_to_vaddr(src), &src_o);
+			  src, &src_o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2420,7 +2442,7 @@ TEE_Result syscall_obj_generate_key(unsigned long obj, unsigned long key_size,
 	TEE_Attribute *params = NULL;
 	size_t alloc_size = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -2567,19 +2589,18 @@ out:
 }
 
 static TEE_Result tee_svc_cryp_get_state(struct ts_session *sess,
-					 vaddr_t state_id,
+					 uint32_t state_id,
 					 struct tee_cryp_state **state)
 {
-	struct tee_cryp_state *s;
 	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	struct tee_cryp_state *s = NULL;
 
-	TAILQ_FOREACH(s, &utc->cryp_states, link) {
-		if (state_id == (vaddr_t)s) {
-			*state = s;
-			return TEE_SUCCESS;
-		}
-	}
-	return TEE_ERROR_BAD_PARAMETERS;
+	s = handle_table_lookup(&utc->cryp_state_handles, state_id);
+	if (!s)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	*state = s;
+	return TEE_SUCCESS;
 }
 
 static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
@@ -2592,6 +2613,8 @@ static void cryp_state_free(struct user_ta_ctx *utc, struct tee_cryp_state *cs)
 		tee_obj_close(utc, o);
 
 	TAILQ_REMOVE(&utc->cryp_states, cs, link);
+	if (cs->handle)
+		handle_table_remove(&utc->cryp_state_handles, cs->handle);
 	if (cs->ctx_finalize != NULL)
 		cs->ctx_finalize(cs->ctx);
 
@@ -2781,7 +2804,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	algo = translate_compat_algo(algo);
 
 	if (key1 != 0) {
-		res = tee_obj_get(utc, uref_to_vaddr(key1), &o1);
+		res = tee_obj_get(utc, key1, &o1);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o1->busy)
@@ -2791,7 +2814,7 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 			return res;
 	}
 	if (key2 != 0) {
-		res = tee_obj_get(utc, uref_to_vaddr(key2), &o2);
+		res = tee_obj_get(utc, key2, &o2);
 		if (res != TEE_SUCCESS)
 			return res;
 		if (o2->busy)
@@ -2809,6 +2832,12 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	cs->mode = mode;
 	cs->state = CRYP_STATE_UNINITIALIZED;
 
+	cs->handle = handle_table_add(&utc->cryp_state_handles, cs);
+	if (!cs->handle) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
 	switch (TEE_ALG_GET_CLASS(algo)) {
 	case TEE_OPERATION_CIPHER:
 		if ((TEE_ALG_GET_CHAIN_MODE(algo) == TEE_CHAIN_MODE_XTS &&
@@ -2875,18 +2904,18 @@ TEE_Result syscall_cryp_state_alloc(unsigned long algo, unsigned long mode,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = copy_kaddr_to_uref(state, cs);
+	res = copy_to_user_private(state, &cs->handle, sizeof(cs->handle));
 	if (res != TEE_SUCCESS)
 		goto out;
 
 	/* Register keys */
 	if (o1 != NULL) {
 		o1->busy = true;
-		cs->key1 = (vaddr_t)o1;
+		cs->key1 = o1->handle;
 	}
 	if (o2 != NULL) {
 		o2->busy = true;
-		cs->key2 = (vaddr_t)o2;
+		cs->key2 = o2->handle;
 	}
 
 out:
@@ -2895,6 +2924,47 @@ out:
 	return res;
 }
 
+/*
+ * Hash and cipher contexts of the same algorithm can be backed by
+ * different implementations, replaces the context of @cs_dst by one
+ * matching @cs_src so that the state can be copied.
+ */
+static TEE_Result cryp_state_match_impl(struct tee_cryp_state *cs_dst,
+					struct tee_cryp_state *cs_src)
+{
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+
+	switch (TEE_ALG_GET_CLASS(cs_src->algo)) {
+	case TEE_OPERATION_CIPHER:
+		if (crypto_cipher_same_impl(cs_dst->ctx, cs_src->ctx))
+			return TEE_SUCCESS;
+		res = crypto_cipher_alloc_ctx_like(&ctx, cs_src->algo,
+						   cs_src->ctx);
+		if (res)
+			return res;
+		if (cs_dst->ctx_finalize)
+			cs_dst->ctx_finalize(cs_dst->ctx);
+		crypto_cipher_free_ctx(cs_dst->ctx);
+		break;
+	case TEE_OPERATION_DIGEST:
+		if (crypto_hash_same_impl(cs_dst->ctx, cs_src->ctx))
+			return TEE_SUCCESS;
+		res = crypto_hash_alloc_ctx_like(&ctx, cs_src->algo,
+						 cs_src->ctx);
+		if (res)
+			return res;
+		crypto_hash_free_ctx(cs_dst->ctx);
+		break;
+	default:
+		return TEE_SUCCESS;
+	}
+
+	cs_dst->ctx = ctx;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 {
 	struct ts_session *sess = ts_get_current_session();
@@ -2902,16 +2972,20 @@ TEE_Result syscall_cryp_state_copy(unsigned long dst, unsigned long src)
 	struct tee_cryp_state *cs_dst = NULL;
 	struct tee_cryp_state *cs_src = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(dst), &cs_dst);
+	res = tee_svc_cryp_get_state(sess, dst, &cs_dst);
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(src), &cs_src);
+	res = tee_svc_cryp_get_state(sess, src, &cs_src);
 	if (res != TEE_SUCCESS)
 		return res;
 	if (cs_dst->algo != cs_src->algo || cs_dst->mode != cs_src->mode)
 		return TEE_ERROR_BAD_PARAMETERS;
 
+	res = cryp_state_match_impl(cs_dst, cs_src);
+	if (res)
+		return res;
+
 	switch (TEE_ALG_GET_CLASS(cs_src->algo)) {
 	case TEE_OPERATION_CIPHER:
 		crypto_cipher_copy_state(cs_dst->ctx, cs_src->ctx);
@@ -2941,6 +3015,8 @@ void tee_svc_cryp_free_states(struct user_ta_ctx *utc)
 
 	while (!TAILQ_EMPTY(states))
 		cryp_state_free(utc, TAILQ_FIRST(states));
+
+	handle_table_destroy(&utc->cryp_state_handles);
 }
 
 TEE_Result syscall_cryp_state_free(unsigned long state)
@@ -2949,7 +3025,7 @@ TEE_Result syscall_cryp_state_free(unsigned long state)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_cryp_state *cs = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 	cryp_state_free(to_user_ta_ctx(sess->ctx), cs);
@@ -2964,7 +3040,7 @@ TEE_Result syscall_hash_init(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_cryp_state *cs = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3027,7 +3103,7 @@ TEE_Result syscall_hash_update(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3097,7 +3173,7 @@ TEE_Result syscall_hash_final(unsigned long state, const void *chunk,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3183,6 +3259,45 @@ out:
 	return res;
 }
 
+/*
+ * Initializes the cipher operation @cs with the key in @o. With
+ * CFG_TEE_OBJ_KEY_CACHE the keyed context is kept in @o after the first
+ * init, following inits with the same algorithm and implementation then
+ * copy the expanded key instead of running the key schedule again.
+ */
+static TEE_Result cipher_init_cached(struct tee_cryp_state *cs,
+				     struct tee_obj *o, const void *iv,
+				     size_t iv_len)
+{
+	struct tee_cryp_obj_secret *key = o->attr;
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+
+	if (o->key_ctx && o->key_ctx_algo == cs->algo &&
+	    crypto_cipher_same_impl(cs->ctx, o->key_ctx)) {
+		crypto_cipher_copy_state(cs->ctx, o->key_ctx);
+		return crypto_cipher_reinit(cs->ctx, cs->mode, iv, iv_len);
+	}
+
+	res = crypto_cipher_init(cs->ctx, cs->mode, (uint8_t *)(key + 1),
+				 key->key_size, NULL, 0, iv, iv_len);
+	if (res || !IS_ENABLED(CFG_TEE_OBJ_KEY_CACHE))
+		return res;
+
+	/* Only worth caching if the context can be restarted */
+	if (!crypto_cipher_can_reinit(cs->ctx))
+		return TEE_SUCCESS;
+	if (crypto_cipher_alloc_ctx_like(&ctx, cs->algo, cs->ctx))
+		return TEE_SUCCESS;
+
+	crypto_cipher_copy_state(ctx, cs->ctx);
+	tee_obj_key_cache_clear(o);
+	o->key_ctx = ctx;
+	o->key_ctx_algo = cs->algo;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 			size_t iv_len)
 {
@@ -3191,23 +3306,24 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 	struct tee_cryp_obj_secret *key1 = NULL;
 	struct tee_cryp_state *cs = NULL;
 	TEE_Result res = TEE_SUCCESS;
+	struct tee_obj *o1 = NULL;
 	struct tee_obj *o = NULL;
 	void *iv_bbuf = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
 	if (TEE_ALG_GET_CLASS(cs->algo) != TEE_OPERATION_CIPHER)
 		return TEE_ERROR_BAD_STATE;
 
-	res = tee_obj_get(utc, cs->key1, &o);
+	res = tee_obj_get(utc, cs->key1, &o1);
 	if (res != TEE_SUCCESS)
 		return res;
-	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
+	if ((o1->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	key1 = o->attr;
+	key1 = o1->attr;
 
 	res = bb_memdup_user(iv, iv_len, &iv_bbuf);
 	if (res)
@@ -3224,9 +3340,7 @@ TEE_Result syscall_cipher_init(unsigned long state, const void *iv,
 					 (uint8_t *)(key2 + 1), key2->key_size,
 					 iv_bbuf, iv_len);
 	} else {
-		res = crypto_cipher_init(cs->ctx, cs->mode,
-					 (uint8_t *)(key1 + 1), key1->key_size,
-					 NULL, 0, iv_bbuf, iv_len);
+		res = cipher_init_cached(cs, o1, iv_bbuf, iv_len);
 	}
 	if (res != TEE_SUCCESS)
 		return res;
@@ -3246,7 +3360,7 @@ static TEE_Result tee_svc_cipher_update_helper(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3687,7 +3801,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	TEE_Attribute *params = NULL;
 	size_t alloc_size = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -3706,7 +3820,7 @@ TEE_Result syscall_cryp_derive_key(unsigned long state,
 	if (res != TEE_SUCCESS)
 		goto out;
 
-	res = tee_obj_get(utc, uref_to_vaddr(derived_key), &so);
+	res = tee_obj_get(utc, derived_key, &so);
 	if (res != TEE_SUCCESS)
 		goto out;
 
@@ -4071,18 +4185,53 @@ TEE_Result syscall_cryp_random_number_generate(void *buf, size_t blen)
 	return res;
 }
 
+/* Like cipher_init_cached() but for AE operations */
+static TEE_Result authenc_init_cached(struct tee_cryp_state *cs,
+				      struct tee_obj *o, const void *nonce,
+				      size_t nonce_len, size_t tag_len,
+				      size_t aad_len, size_t payload_len)
+{
+	struct tee_cryp_obj_secret *key = o->attr;
+	TEE_Result res = TEE_SUCCESS;
+	void *ctx = NULL;
+
+	if (o->key_ctx && o->key_ctx_algo == cs->algo) {
+		crypto_authenc_copy_state(cs->ctx, o->key_ctx);
+		return crypto_authenc_reinit(cs->ctx, cs->mode, nonce,
+					     nonce_len, tag_len, aad_len,
+					     payload_len);
+	}
+
+	res = crypto_authenc_init(cs->ctx, cs->mode, (uint8_t *)(key + 1),
+				  key->key_size, nonce, nonce_len, tag_len,
+				  aad_len, payload_len);
+	if (res || !IS_ENABLED(CFG_TEE_OBJ_KEY_CACHE))
+		return res;
+
+	if (!crypto_authenc_can_reinit(cs->ctx))
+		return TEE_SUCCESS;
+	if (crypto_authenc_alloc_ctx(&ctx, cs->algo))
+		return TEE_SUCCESS;
+
+	crypto_authenc_copy_state(ctx, cs->ctx);
+	tee_obj_key_cache_clear(o);
+	o->key_ctx = ctx;
+	o->key_ctx_algo = cs->algo;
+
+	return TEE_SUCCESS;
+}
+
 TEE_Result syscall_authenc_init(unsigned long state, const void *nonce,
 				size_t nonce_len, size_t tag_len,
 				size_t aad_len, size_t payload_len)
 {
 	struct ts_session *sess = ts_get_current_session();
-	struct tee_cryp_obj_secret *key = NULL;
 	struct tee_cryp_state *cs = NULL;
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 	void *nonce_bbuf = NULL;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4092,14 +4241,11 @@ TEE_Result syscall_authenc_init(unsigned long state, const void *nonce,
 	if ((o->info.handleFlags & TEE_HANDLE_FLAG_INITIALIZED) == 0)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	key = o->attr;
-
 	res = bb_memdup_user(nonce, nonce_len, &nonce_bbuf);
 	if (res)
 		return res;
 
-	res = crypto_authenc_init(cs->ctx, cs->mode, (uint8_t *)(key + 1),
-				  key->key_size, nonce_bbuf, nonce_len, tag_len,
+	res = authenc_init_cached(cs, o, nonce_bbuf, nonce_len, tag_len,
 				  aad_len, payload_len);
 	if (res != TEE_SUCCESS)
 		return res;
@@ -4126,7 +4272,7 @@ TEE_Result syscall_authenc_update_aad(unsigned long state,
 	if (res != TEE_SUCCESS)
 		return res;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4156,7 +4302,7 @@ TEE_Result syscall_authenc_update_payload(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4220,7 +4366,7 @@ TEE_Result syscall_authenc_enc_final(unsigned long state, const void *src_data,
 	size_t dlen = 0;
 	size_t tlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4310,7 +4456,7 @@ TEE_Result syscall_authenc_dec_final(unsigned long state,
 	TEE_Result res = TEE_SUCCESS;
 	size_t dlen = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4380,6 +4526,198 @@ out:
 	return res;
 }
 
+static TEE_Result cryp_batch_check_op(struct user_mode_ctx *uctx,
+				      struct utee_cryp_batch_op *op,
+				      struct tee_cryp_state *cs)
+{
+	uint32_t class = TEE_ALG_GET_CLASS(cs->algo);
+	TEE_Result res = TEE_SUCCESS;
+	bool with_dst = false;
+
+	if (cs->state != CRYP_STATE_INITIALIZED)
+		return TEE_ERROR_BAD_STATE;
+
+	switch (op->op) {
+	case UTEE_CRYP_BATCH_CIPHER_UPDATE:
+	case UTEE_CRYP_BATCH_CIPHER_FINAL:
+		if (class != TEE_OPERATION_CIPHER)
+			return TEE_ERROR_BAD_STATE;
+		with_dst = true;
+		break;
+	case UTEE_CRYP_BATCH_MAC_UPDATE:
+	case UTEE_CRYP_BATCH_MAC_FINAL:
+		if (class != TEE_OPERATION_DIGEST && class != TEE_OPERATION_MAC)
+			return TEE_ERROR_BAD_STATE;
+		with_dst = op->op == UTEE_CRYP_BATCH_MAC_FINAL;
+		break;
+	case UTEE_CRYP_BATCH_AE_UPDATE_AAD:
+	case UTEE_CRYP_BATCH_AE_UPDATE:
+		if (class != TEE_OPERATION_AE)
+			return TEE_ERROR_BAD_STATE;
+		with_dst = op->op == UTEE_CRYP_BATCH_AE_UPDATE;
+		break;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+
+	if (!op->src && op->src_len)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	op->src = memtag_strip_tag_vaddr((void *)(vaddr_t)op->src);
+	res = vm_check_access_rights(uctx,
+				     TEE_MEMORY_ACCESS_READ |
+				     TEE_MEMORY_ACCESS_ANY_OWNER,
+				     op->src, op->src_len);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (!with_dst)
+		return TEE_SUCCESS;
+
+	op->dst = memtag_strip_tag_vaddr((void *)(vaddr_t)op->dst);
+	return vm_check_access_rights(uctx,
+				      TEE_MEMORY_ACCESS_READ |
+				      TEE_MEMORY_ACCESS_WRITE |
+				      TEE_MEMORY_ACCESS_ANY_OWNER,
+				      op->dst, op->dst_len);
+}
+
+/* Called with user access enabled, @op has passed cryp_batch_check_op() */
+static TEE_Result cryp_batch_do_op(struct utee_cryp_batch_op *op,
+				   struct tee_cryp_state *cs)
+{
+	bool last_block = op->op == UTEE_CRYP_BATCH_CIPHER_FINAL;
+	const void *src = (const void *)(vaddr_t)op->src;
+	void *dst = (void *)(vaddr_t)op->dst;
+	TEE_Result res = TEE_SUCCESS;
+	size_t src_len = op->src_len;
+	size_t dlen = op->dst_len;
+	size_t hash_size = 0;
+
+	switch (op->op) {
+	case UTEE_CRYP_BATCH_CIPHER_UPDATE:
+	case UTEE_CRYP_BATCH_CIPHER_FINAL:
+		op->dst_len = src_len;
+		if (dlen < src_len)
+			return TEE_ERROR_SHORT_BUFFER;
+
+		if (src_len)
+			res = tee_do_cipher_update(cs->ctx, cs->algo, cs->mode,
+						   last_block, src, src_len,
+						   dst);
+		if (last_block && cs->ctx_finalize) {
+			cs->ctx_finalize(cs->ctx);
+			cs->ctx_finalize = NULL;
+		}
+		return res;
+
+	case UTEE_CRYP_BATCH_MAC_UPDATE:
+		if (!src_len)
+			return TEE_SUCCESS;
+		if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_DIGEST)
+			return crypto_hash_update(cs->ctx, src, src_len);
+		return crypto_mac_update(cs->ctx, src, src_len);
+
+	case UTEE_CRYP_BATCH_MAC_FINAL:
+		if (is_xof_algo(cs->algo)) {
+			hash_size = dlen;
+		} else {
+			res = tee_alg_get_digest_size(cs->algo, &hash_size);
+			if (res != TEE_SUCCESS)
+				return res;
+			op->dst_len = hash_size;
+			if (dlen < hash_size)
+				return TEE_ERROR_SHORT_BUFFER;
+		}
+
+		if (TEE_ALG_GET_CLASS(cs->algo) == TEE_OPERATION_DIGEST) {
+			if (src_len)
+				res = crypto_hash_update(cs->ctx, src, src_len);
+			if (!res)
+				res = crypto_hash_final(cs->ctx, dst, hash_size);
+			/* Start over, like TEE_DigestDoFinal() */
+			if (!res)
+				res = crypto_hash_init(cs->ctx);
+		} else {
+			if (src_len)
+				res = crypto_mac_update(cs->ctx, src, src_len);
+			if (!res)
+				res = crypto_mac_final(cs->ctx, dst, hash_size);
+		}
+		return res;
+
+	case UTEE_CRYP_BATCH_AE_UPDATE_AAD:
+		return crypto_authenc_update_aad(cs->ctx, cs->mode, src,
+						 src_len);
+
+	case UTEE_CRYP_BATCH_AE_UPDATE:
+		if (dlen < src_len) {
+			op->dst_len = src_len;
+			return TEE_ERROR_SHORT_BUFFER;
+		}
+
+		res = crypto_authenc_update_payload(cs->ctx, cs->mode, src,
+						    src_len, dst, &dlen);
+		if (!res)
+			op->dst_len = dlen;
+		return res;
+
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+TEE_Result syscall_cryp_batch(struct utee_cryp_batch_op *ops, size_t count)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_mode_ctx *uctx = &to_user_ta_ctx(sess->ctx)->uctx;
+	struct utee_cryp_batch_op *kops = NULL;
+	struct tee_cryp_state **cs = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	size_t size = 0;
+	size_t n = 0;
+
+	if (!count || count > UTEE_CRYP_BATCH_MAX_OPS)
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	size = count * sizeof(*kops);
+	ops = memtag_strip_tag(ops);
+	res = BB_MEMDUP_USER_PRIVATE(ops, size, &kops);
+	if (res)
+		return res;
+
+	cs = calloc(count, sizeof(*cs));
+	if (!cs) {
+		res = TEE_ERROR_OUT_OF_MEMORY;
+		goto out;
+	}
+
+	/*
+	 * Resolve all states and check all buffers first so the operations
+	 * can run back to back with a single user access window. A
+	 * descriptor failing the checks is skipped, the others still run.
+	 */
+	for (n = 0; n < count; n++) {
+		kops[n].res = tee_svc_cryp_get_state(sess, kops[n].state,
+						     cs + n);
+		if (!kops[n].res)
+			kops[n].res = cryp_batch_check_op(uctx, kops + n,
+							  cs[n]);
+	}
+
+	enter_user_access();
+	for (n = 0; n < count; n++)
+		if (!kops[n].res)
+			kops[n].res = cryp_batch_do_op(kops + n, cs[n]);
+	exit_user_access();
+
+	res = copy_to_user_private(ops, kops, size);
+out:
+	free(cs);
+	bb_free(kops, size);
+	return res;
+}
+
 static int pkcs1_get_salt_len(const TEE_Attribute *params, uint32_t num_params,
 			      size_t default_len)
 {
@@ -4419,7 +4757,7 @@ TEE_Result syscall_asymm_operate(unsigned long state,
 	TEE_Attribute *params = NULL;
 	size_t alloc_size = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -4655,7 +4993,7 @@ TEE_Result syscall_asymm_verify(unsigned long state,
 	int salt_len = 0;
 	size_t alloc_size = 0;
 
-	res = tee_svc_cryp_get_state(sess, uref_to_vaddr(state), &cs);
+	res = tee_svc_cryp_get_state(sess, state, &cs);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -34,10 +34,17 @@ struct tee_svc_storage_head {
 	uint32_t have_attrs;
 };
 
+/*
+ * @pending holds an entry already returned by readdir() but not yet
+ * delivered to the TA since it didn't fit in the buffer supplied to
+ * syscall_storage_next_enum_ids().
+ */
 struct tee_storage_enum {
 	TAILQ_ENTRY(tee_storage_enum) link;
 	struct tee_fs_dir *dir;
 	const struct tee_file_operations *fops;
+	struct tee_fs_dirent pending;
+	bool have_pending;
 };
 
 static TEE_Result tee_svc_storage_get_enum(struct user_ta_ctx *utc,
@@ -212,7 +219,9 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 	o->info.handleFlags = TEE_HANDLE_FLAG_PERSISTENT |
 			      TEE_HANDLE_FLAG_INITIALIZED | flags;
 	o->pobj = po;
-	tee_obj_add(utc, o);
+	res = tee_obj_add(utc, o);
+	if (res)
+		goto oclose;
 
 	tee_pobj_lock_usage(o->pobj);
 	res = tee_svc_storage_read_head(o);
@@ -225,7 +234,7 @@ TEE_Result syscall_storage_obj_open(unsigned long storage_id, void *object_id,
 		goto oclose;
 	}
 
-	res = copy_kaddr_to_uref(obj, o);
+	res = copy_to_user_private(obj, &o->handle, sizeof(o->handle));
 	if (res != TEE_SUCCESS)
 		goto oclose;
 
@@ -356,7 +365,7 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 		goto err;
 
 	if (attr != TEE_HANDLE_NULL) {
-		res = tee_obj_get(utc, uref_to_vaddr(attr), &attr_o);
+		res = tee_obj_get(utc, attr, &attr_o);
 		if (res != TEE_SUCCESS)
 			goto err;
 		/* The supplied handle must be one of an initialized object */
@@ -408,10 +417,13 @@ TEE_Result syscall_storage_obj_create(unsigned long storage_id, void *object_id,
 			goto err;
 
 		po = NULL; /* o owns it from now on */
-		tee_obj_add(utc, o);
+		res = tee_obj_add(utc, o);
+		if (res)
+			goto oclose;
 
 		if (obj) {
-			res = copy_kaddr_to_uref(obj, o);
+			res = copy_to_user_private(obj, &o->handle,
+						   sizeof(o->handle));
 			if (res != TEE_SUCCESS)
 				goto oclose;
 		}
@@ -450,7 +462,7 @@ TEE_Result syscall_storage_obj_del(unsigned long obj)
 	TEE_Result res = TEE_SUCCESS;
 	struct tee_obj *o = NULL;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -489,7 +501,7 @@ TEE_Result syscall_storage_obj_rename(unsigned long obj, void *object_id,
 	if (object_id_len > TEE_OBJECT_ID_MAX_LEN)
 		return TEE_ERROR_BAD_PARAMETERS;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -552,6 +564,7 @@ TEE_Result syscall_storage_alloc_enum(uint32_t *obj_enum)
 
 	e->dir = NULL;
 	e->fops = NULL;
+	e->have_pending = false;
 	TAILQ_INSERT_TAIL(&utc->storage_enums, e, link);
 
 	return copy_kaddr_to_uref(obj_enum, e);
@@ -589,6 +602,7 @@ TEE_Result syscall_storage_reset_enum(unsigned long obj_enum)
 		e->dir = NULL;
 	}
 	assert(!e->dir);
+	e->have_pending = false;
 
 	return TEE_SUCCESS;
 }
@@ -611,6 +625,7 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 		e->fops->closedir(e->dir);
 		e->dir = NULL;
 	}
+	e->have_pending = false;
 
 	if (!fops)
 		return TEE_ERROR_ITEM_NOT_FOUND;
@@ -620,6 +635,18 @@ TEE_Result syscall_storage_start_enum(unsigned long obj_enum,
 	return fops->opendir(&sess->ctx->uuid, &e->dir);
 }
 
+static TEE_Result enum_readdir(struct tee_storage_enum *e,
+			       struct tee_fs_dirent **d)
+{
+	if (e->have_pending) {
+		e->have_pending = false;
+		*d = &e->pending;
+		return TEE_SUCCESS;
+	}
+
+	return e->fops->readdir(e->dir, d);
+}
+
 TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 				     struct utee_object_info *info,
 				     void *obj_id, uint64_t *len)
@@ -656,7 +683,7 @@ TEE_Result syscall_storage_next_enum(unsigned long obj_enum,
 		goto exit;
 	}
 
-	res = e->fops->readdir(e->dir, &d);
+	res = enum_readdir(e, &d);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -712,6 +739,106 @@ exit:
 	return res;
 }
 
+static bool has_prefix(const struct tee_fs_dirent *d, const void *prefix,
+		       size_t prefix_len)
+{
+	return d->oidlen >= prefix_len && !memcmp(d->oid, prefix, prefix_len);
+}
+
+TEE_Result syscall_storage_next_enum_ids(unsigned long obj_enum,
+					 const void *prefix, size_t prefix_len,
+					 void *buf, uint64_t *len,
+					 uint32_t *count)
+{
+	struct ts_session *sess = ts_get_current_session();
+	struct user_ta_ctx *utc = to_user_ta_ctx(sess->ctx);
+	uint8_t kprefix[TEE_OBJECT_ID_MAX_LEN] = { };
+	struct tee_storage_enum *e = NULL;
+	struct tee_fs_dirent *d = NULL;
+	TEE_Result res = TEE_SUCCESS;
+	struct utee_object_id_entry ent = { };
+	uint64_t blen = 0;
+	size_t offs = 0;
+	size_t esz = 0;
+	uint32_t n = 0;
+
+	res = tee_svc_storage_get_enum(utc, uref_to_vaddr(obj_enum), &e);
+	if (res != TEE_SUCCESS)
+		return res;
+
+	if (prefix_len > sizeof(kprefix))
+		return TEE_ERROR_BAD_PARAMETERS;
+	res = copy_from_user(kprefix, prefix, prefix_len);
+	if (res)
+		return res;
+
+	res = copy_from_user_private(&blen, len, sizeof(blen));
+	if (res)
+		return res;
+
+	if (!e->fops)
+		return TEE_ERROR_ITEM_NOT_FOUND;
+
+	/*
+	 * Only the IDs are returned, the objects themselves are never
+	 * opened. Entries are read from the directory until either the
+	 * enumeration is exhausted or the next matching entry doesn't fit
+	 * in the buffer, in which case it's kept for the next call.
+	 */
+	while (true) {
+		res = enum_readdir(e, &d);
+		if (res)
+			break;
+		if (!has_prefix(d, kprefix, prefix_len))
+			continue;
+
+		esz = ROUNDUP(sizeof(ent) + d->oidlen, sizeof(uint32_t));
+		if (blen - offs < esz) {
+			if (d != &e->pending)
+				e->pending = *d;
+			e->have_pending = true;
+			if (!n) {
+				blen = esz;
+				res = copy_to_user_private(len, &blen,
+							   sizeof(blen));
+				if (!res)
+					res = TEE_ERROR_SHORT_BUFFER;
+				return res;
+			}
+			break;
+		}
+
+		ent.id_len = d->oidlen;
+		res = copy_to_user((uint8_t *)buf + offs, &ent, sizeof(ent));
+		if (!res)
+			res = copy_to_user((uint8_t *)buf + offs + sizeof(ent),
+					   d->oid, d->oidlen);
+		if (res) {
+			/* Deliver the entry again in next call */
+			if (d != &e->pending)
+				e->pending = *d;
+			e->have_pending = true;
+			return res;
+		}
+		offs += esz;
+		n++;
+	}
+
+	/*
+	 * A readdir() error after some entries has been collected is
+	 * reported by the next call instead.
+	 */
+	if (!n)
+		return res;
+
+	blen = offs;
+	res = copy_to_user_private(len, &blen, sizeof(blen));
+	if (res)
+		return res;
+
+	return copy_to_user_private(count, &n, sizeof(n));
+}
+
 TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 				    uint64_t *count)
 {
@@ -723,7 +850,7 @@ TEE_Result syscall_storage_obj_read(unsigned long obj, void *data, size_t len,
 	size_t pos_tmp = 0;
 	size_t bytes = 0;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -775,7 +902,7 @@ TEE_Result syscall_storage_obj_write(unsigned long obj, void *data, size_t len)
 	struct tee_obj *o = NULL;
 	size_t pos_tmp = 0;
 
-	res = tee_obj_get(utc, uref_to_vaddr(obj), &o);
+	res = tee_obj_get(utc, obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -833,7 +960,7 @@ TEE_Result syscall_storage_obj_trunc(unsigned long obj, size_t len)
 	size_t off = 0;
 	size_t attr_size = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		goto exit;
 
@@ -886,7 +1013,7 @@ TEE_Result syscall_storage_obj_seek(unsigned long obj, int32_t offset,
 	struct tee_obj *o = NULL;
 	tee_fs_off_t new_pos = 0;
 
-	res = tee_obj_get(to_user_ta_ctx(sess->ctx), uref_to_vaddr(obj), &o);
+	res = tee_obj_get(to_user_ta_ctx(sess->ctx), obj, &o);
 	if (res != TEE_SUCCESS)
 		return res;
 
@@ -7,8 +7,18 @@
 #define MBEDTLS_HAVE_INT32
 #endif
 #ifdef ARM64
+#ifdef CFG_CORE_BIGNUM_ASM
+/*
+ * With GCC on AArch64 bignum.h always uses 64-bit limbs and defines
+ * MBEDTLS_HAVE_INT64 itself. Setting it here would only force the limb
+ * size of the portable C code, which check_config.h rejects in
+ * combination with MBEDTLS_HAVE_ASM, so only the latter is set.
+ */
+#define MBEDTLS_HAVE_ASM
+#else
 #define MBEDTLS_HAVE_INT64
 #endif
+#endif
 #define MBEDTLS_BIGNUM_C
 #define MBEDTLS_GENPRIME
 
@@ -120,6 +130,7 @@
 #define MBEDTLS_ECP_DP_BP512R1_ENABLED
 #define MBEDTLS_ECP_DP_CURVE25519_ENABLED
 #define MBEDTLS_ECP_C
+#define MBEDTLS_ECP_NIST_OPTIM
 #define MBEDTLS_ECDSA_C
 #define MBEDTLS_ECDH_C
 #define MBEDTLS_ECDH_LEGACY_CONTEXT
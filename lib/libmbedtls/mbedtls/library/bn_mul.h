@@ -270,6 +270,47 @@
          : "x4", "x5", "x6", "x7", "cc"                                 \
     );
 
+/*
+ * Four limbs per step: the products are formed first and the partial sums
+ * are then folded in with two ADCS chains, which keeps the multipliers busy
+ * and avoids the per-limb carry round trips of MULADDC_X1_CORE.
+ */
+#define MULADDC_X4_INIT             \
+    asm(
+
+#define MULADDC_X4_CORE                         \
+        "ldp x4, x5, [%2], #16      \n\t"       \
+        "ldp x6, x7, [%2], #16      \n\t"       \
+        "mul x12, x4, %4            \n\t"       \
+        "mul x13, x5, %4            \n\t"       \
+        "mul x14, x6, %4            \n\t"       \
+        "mul x15, x7, %4            \n\t"       \
+        "umulh x4, x4, %4           \n\t"       \
+        "umulh x5, x5, %4           \n\t"       \
+        "umulh x6, x6, %4           \n\t"       \
+        "umulh x7, x7, %4           \n\t"       \
+        "ldp x8, x9, [%1]           \n\t"       \
+        "ldp x10, x11, [%1, #16]    \n\t"       \
+        "adds x12, x12, %0          \n\t"       \
+        "adcs x13, x13, x4          \n\t"       \
+        "adcs x14, x14, x5          \n\t"       \
+        "adcs x15, x15, x6          \n\t"       \
+        "adc x7, x7, xzr            \n\t"       \
+        "adds x8, x8, x12           \n\t"       \
+        "adcs x9, x9, x13           \n\t"       \
+        "adcs x10, x10, x14         \n\t"       \
+        "adcs x11, x11, x15         \n\t"       \
+        "adc %0, x7, xzr            \n\t"       \
+        "stp x8, x9, [%1], #16      \n\t"       \
+        "stp x10, x11, [%1], #16    \n\t"
+
+#define MULADDC_X4_STOP                                                 \
+         : "+r" (c),  "+r" (d), "+r" (s), "+m" (*(uint64_t (*)[16]) d)  \
+         : "r" (b), "m" (*(const uint64_t (*)[16]) s)                   \
+         : "x4", "x5", "x6", "x7", "x8", "x9", "x10", "x11",            \
+           "x12", "x13", "x14", "x15", "cc"                             \
+    );
+
 #endif /* Aarch64 */
 
 #if defined(__mc68020__) || defined(__mcpu32__)
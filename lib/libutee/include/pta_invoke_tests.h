@@ -6,6 +6,8 @@
 #ifndef __PTA_INVOKE_TESTS_H
 #define __PTA_INVOKE_TESTS_H
 
+#include <stdint.h>
+
 #define PTA_INVOKE_TESTS_UUID \
 		{ 0xd96a5b40, 0xc3e5, 0x21e3, \
 			{ 0x87, 0x94, 0x10, 0x02, 0xa5, 0xd5, 0xc6, 0x1b } }
@@ -108,5 +110,156 @@
  */
 #define PTA_INVOKE_TESTS_CMD_DT_DRIVER_TESTS	11
 
+/*
+ * Secure storage backends, block patterns and result buffer for
+ * PTA_INVOKE_TESTS_CMD_FS_PERF
+ *
+ * PTA_INVOKE_TESTS_FS_PERF_HTREE_MEM drives the hash tree directly with
+ * memref[1] as backing store instead of tee-supplicant, the other backends
+ * go through the REE FS or RPMB file operations.
+ *
+ * PTA_INVOKE_TESTS_FS_PERF_SEQ writes and reads the object front to back,
+ * PTA_INVOKE_TESTS_FS_PERF_RANDOM accesses io_size aligned chunks in
+ * pseudo random order and PTA_INVOKE_TESTS_FS_PERF_REWRITE repeatedly
+ * rewrites the first chunk of the object.
+ */
+#define PTA_INVOKE_TESTS_FS_PERF_HTREE_MEM	0
+#define PTA_INVOKE_TESTS_FS_PERF_REE		1
+#define PTA_INVOKE_TESTS_FS_PERF_RPMB		2
+
+#define PTA_INVOKE_TESTS_FS_PERF_SEQ		0
+#define PTA_INVOKE_TESTS_FS_PERF_RANDOM		1
+#define PTA_INVOKE_TESTS_FS_PERF_REWRITE	2
+
+/* RPC wait, crypto, hash tree update and dirfile commit */
+#define PTA_INVOKE_TESTS_FS_PERF_PHASES		4
+
+/*
+ * All times are in counter timer ticks, @cntfrq ticks per second. Phase
+ * times nest: dirfile commit includes hash tree update which includes
+ * crypto and RPC wait.
+ */
+struct pta_invoke_tests_fs_perf {
+	/* Input */
+	uint32_t backend;
+	uint32_t pattern;
+	uint32_t obj_size;
+	uint32_t io_size;
+	uint32_t num_objs;
+	/* Sync hash tree every n writes, 0 only at close (HTREE_MEM only) */
+	uint32_t sync_every;
+	/* Distinguishes object IDs of concurrent sessions */
+	uint32_t instance;
+	uint32_t reserved;
+	/* Output */
+	uint64_t cntfrq;
+	uint64_t create_ticks;
+	uint64_t write_ticks;
+	uint64_t read_ticks;
+	uint64_t remove_ticks;
+	uint64_t max_write_ticks;
+	uint64_t max_read_ticks;
+	uint32_t write_count;
+	uint32_t read_count;
+	uint64_t phase_ticks[PTA_INVOKE_TESTS_FS_PERF_PHASES];
+	uint32_t phase_count[PTA_INVOKE_TESTS_FS_PERF_PHASES];
+};
+
+/*
+ * Secure storage performance tests
+ *
+ * Each session of this PTA can run the benchmark concurrently, use a
+ * distinct @instance per session.
+ *
+ * [in/out] memref[0]	struct pta_invoke_tests_fs_perf
+ * [in/out] memref[1]	Backing store for PTA_INVOKE_TESTS_FS_PERF_HTREE_MEM,
+ *			at least
+ *			PTA_INVOKE_TESTS_FS_PERF_STORE_SIZE(obj_size) bytes,
+ *			unused (none) for the other backends
+ */
+#define PTA_INVOKE_TESTS_FS_PERF_BLOCK_SIZE	4096
+#define PTA_INVOKE_TESTS_FS_PERF_STORE_SIZE(obj_size) \
+	((1 + 3 * (((obj_size) + PTA_INVOKE_TESTS_FS_PERF_BLOCK_SIZE - 1) / \
+		   PTA_INVOKE_TESTS_FS_PERF_BLOCK_SIZE)) * \
+	 PTA_INVOKE_TESTS_FS_PERF_BLOCK_SIZE)
+#define PTA_INVOKE_TESTS_CMD_FS_PERF		12
+
+/*
+ * tee_mm allocator performance tests
+ *
+ * A private pool is filled with value[0].a entries of random size and
+ * every other entry is freed to fragment it. Then value[1].a random sized
+ * allocations are made and freed, and as many lookups of the remaining
+ * entries are done.
+ *
+ * [in]     value[0].a	Number of entries, 2 to 1024
+ * [in]     value[0].b	Pool flags, 0 or 1 (TEE_MM_POOL_HI_ALLOC)
+ * [in]     value[1].a	Iteration count
+ * [out]    value[2].a	Average time of tee_mm_alloc() + tee_mm_free() in ns
+ * [out]    value[2].b	Average time of tee_mm_find() in ns
+ */
+#define PTA_INVOKE_TESTS_CMD_MM_PERF		13
+
+/*
+ * PTA_INVOKE_TESTS_CMD_CRYPTO_PERF
+ *
+ * PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT uses the implementation TAs get,
+ * PTA_INVOKE_TESTS_CRYPTO_PERF_SW forces the software implementation and
+ * PTA_INVOKE_TESTS_CRYPTO_PERF_DRV the crypto driver. Asymmetric
+ * algorithms only support the default backend.
+ */
+#define PTA_INVOKE_TESTS_CRYPTO_PERF_DEFAULT	0
+#define PTA_INVOKE_TESTS_CRYPTO_PERF_SW		1
+#define PTA_INVOKE_TESTS_CRYPTO_PERF_DRV	2
+
+/* The core is built with the Armv8 Cryptographic Extensions */
+#define PTA_INVOKE_TESTS_CRYPTO_PERF_FLAG_CE	(1 << 0)
+
+/*
+ * Times are in counter timer ticks, @cntfrq ticks per second. @total_ticks
+ * runs from the start of the first operation to the end of the last one,
+ * the rates are derived from it, counting at least one tick. An operation
+ * is a complete init, update and final sequence, or a single sign, verify
+ * or key derivation.
+ */
+struct pta_invoke_tests_crypto_perf {
+	/* Input */
+	uint32_t algo;		/* TEE_ALG_* */
+	/* TEE_MODE_DECRYPT or TEE_MODE_VERIFY, otherwise encrypt or sign */
+	uint32_t mode;
+	uint32_t key_size;	/* In bits, selects the curve for ECC */
+	uint32_t data_size;	/* Bytes processed per operation */
+	uint32_t iterations;
+	uint32_t backend;
+	/* CPU clock used to derive cycle counts, 0 if unknown */
+	uint32_t cpu_mhz;
+	uint32_t reserved;
+	/* Output */
+	uint64_t cntfrq;
+	uint64_t total_ticks;
+	uint64_t min_ticks;
+	uint64_t max_ticks;
+	uint64_t cycles_per_op;		/* 0 without @cpu_mhz */
+	uint32_t cycles_per_byte_x100;	/* 0 without @cpu_mhz or data */
+	uint32_t ops_per_sec;
+	uint32_t kib_per_sec;
+	uint32_t flags;
+};
+
+/*
+ * Cryptographic algorithm performance tests
+ *
+ * Runs @iterations operations of @algo on @data_size bytes, at most 1 MiB.
+ * @iterations is at most 65536 and @iterations * @data_size at most
+ * 256 MiB, TEE_ERROR_BAD_PARAMETERS is returned otherwise.
+ * The data is fed from a buffer in secure memory of at most 64 KiB, larger
+ * sizes take several updates. Ed25519 messages are limited to the buffer
+ * size. Key generation, the signature to verify and the tag to check are
+ * done before timing starts.
+ *
+ * [in/out] memref[0]	struct pta_invoke_tests_crypto_perf
+ */
+#define PTA_INVOKE_TESTS_CMD_CRYPTO_PERF	14
+
 #endif /*__PTA_INVOKE_TESTS_H*/
 
@@ -91,4 +91,70 @@ struct pta_stats_ta {
 #define STATS_DRIVER_TYPE_CLOCK		0
 #define STATS_DRIVER_TYPE_REGULATOR	1
 
+/*
+ * STATS_CMD_MALLOC_CACHE_STATS - Get statistics on the per-CPU small
+ * allocation caches of the core heap
+ *
+ * [out]    memref[0]        Array of struct pta_stats_malloc_cache, one
+ *                           per size class
+ */
+#define STATS_CMD_MALLOC_CACHE_STATS	6
+
+struct pta_stats_malloc_cache {
+	uint32_t obj_size;	/* Size class in bytes */
+	uint32_t cached;	/* Buffers currently cached on all CPUs */
+	uint32_t alloc_hit;	/* Allocations served from a cache */
+	uint32_t alloc_miss;	/* Allocations needing a refill */
+	uint32_t free_hit;	/* Frees put in a cache */
+	uint32_t refill;	/* Batched refills from the heap */
+	uint32_t flush;		/* Batched flushes to the heap */
+};
+
+/*
+ * STATS_CMD_MUTEX_STATS - Get contention statistics of the core mutexes
+ *
+ * [out]    memref[0]        struct pta_stats_mutex
+ */
+#define STATS_CMD_MUTEX_STATS		7
+
+struct pta_stats_mutex {
+	uint32_t contended;	/* Lock attempts finding the mutex busy */
+	uint32_t spin_acquired;	/* Contended locks acquired by spinning */
+	uint32_t spin_timeout;	/* Spins given up after the time limit */
+	uint32_t owner_inactive; /* Spins skipped, owner not on a core */
+	uint32_t sleep;		/* Waits in normal world */
+};
+
+/*
+ * STATS_CMD_WAIT_QUEUE_STATS - Get statistics of the core wait queues
+ *
+ * [out]    memref[0]        struct pta_stats_wait_queue
+ */
+#define STATS_CMD_WAIT_QUEUE_STATS	8
+
+struct pta_stats_wait_queue {
+	uint32_t waits;		/* Waits in normal world, all queues */
+	uint32_t wakeups;	/* Wakeup notifications sent */
+	uint32_t contended;	/* Queue spinlocks found taken */
+	uint32_t max_queue_waits; /* Most waits seen on a single queue */
+};
+
+/*
+ * STATS_CMD_THREAD_STATS - Get usage statistics of the core thread pool
+ *
+ * [out]    memref[0]        struct pta_stats_thread
+ */
+#define STATS_CMD_THREAD_STATS		9
+
+struct pta_stats_thread {
+	uint32_t num_threads;	/* CFG_NUM_THREADS */
+	uint32_t free;		/* Threads currently free */
+	uint32_t active;	/* Threads currently executing */
+	uint32_t suspended;	/* Threads currently waiting for normal world */
+	uint32_t max_in_use;	/* Most threads in use at the same time */
+	uint32_t allocs;	/* Threads allocated for yielding calls */
+	uint32_t affinity_hits;	/* Allocations reusing the core's last thread */
+	uint32_t no_free_thread; /* Yielding calls returned busy */
+};
+
 #endif /*__PTA_STATS_H*/
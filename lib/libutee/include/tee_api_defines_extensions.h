@@ -103,6 +103,12 @@
  */
 #define TEE_ALG_SM4_XTS 0xF0000414
 
+/*
+ *  SM4-CCM and SM4-GCM (RFC 8998)
+ */
+#define TEE_ALG_SM4_CCM 0xF0000714
+#define TEE_ALG_SM4_GCM 0xF0000814
+
 /*
  * Implementation-specific object storage constants
  */
@@ -12,6 +12,7 @@
 #include <stdio.h>
 #include <tee_api_defines_extensions.h>
 #include <tee_api_types.h>
+#include <utee_types.h>
 
 void tee_user_mem_mark_heap(void);
 size_t tee_user_mem_check_heap(void);
@@ -78,4 +79,88 @@ TEE_Result tee_invoke_supp_plugin(const TEE_UUID *uuid, uint32_t cmd,
 				  uint32_t sub_cmd, void *buf, size_t len,
 				  size_t *outlen);
 
+/*
+ * TEE_GetNextPersistentObjectIDs() - batched persistent object enumeration
+ * @objectEnumerator:	enumerator started with TEE_StartPersistentObjectEnumerator()
+ * @prefix:		only return objects with an ID starting with @prefix
+ * @prefixLen:		length of @prefix, 0 to return all objects
+ * @buffer:		receives struct utee_object_id_entry entries
+ * @bufferLen:		[in] size of @buffer, [out] number of bytes used
+ * @count:		number of entries in @buffer
+ *
+ * Unlike TEE_GetNextPersistentObject() this returns as many object IDs as
+ * fit in @buffer per call and doesn't open the objects to read their
+ * information. Iterate over the entries with TEE_NextObjectIDEntry().
+ *
+ * Returns TEE_SUCCESS, TEE_ERROR_ITEM_NOT_FOUND when there are no more
+ * objects, TEE_ERROR_SHORT_BUFFER with the size needed for the next entry
+ * in *bufferLen, TEE_ERROR_CORRUPT_OBJECT or
+ * TEE_ERROR_STORAGE_NOT_AVAILABLE.
+ */
+TEE_Result TEE_GetNextPersistentObjectIDs(TEE_ObjectEnumHandle objectEnumerator,
+					  const void *prefix, size_t prefixLen,
+					  void *buffer, size_t *bufferLen,
+					  uint32_t *count);
+
+static inline const struct utee_object_id_entry *
+TEE_NextObjectIDEntry(const struct utee_object_id_entry *entry)
+{
+	return (const void *)((const uint8_t *)entry +
+			      ((sizeof(*entry) + entry->id_len + 3) & ~3UL));
+}
+
+/*
+ * struct TEE_CryptoBatchEntry - one operation of TEE_CryptoBatch()
+ * @operation:	initialized operation handle matching @op
+ * @op:		UTEE_CRYP_BATCH_* operation
+ * @src:	input data
+ * @srcLen:	length of @src
+ * @dest:	output buffer, unused by MAC update and AE AAD operations
+ * @destLen:	[in] size of @dest, [out] number of bytes written or needed
+ * @result:	[out] result of this entry
+ */
+typedef struct {
+	TEE_OperationHandle operation;
+	uint32_t op;
+	const void *src;
+	size_t srcLen;
+	void *dest;
+	size_t destLen;
+	TEE_Result result;
+} TEE_CryptoBatchEntry;
+
+/*
+ * TEE_CryptoBatch() - run many small symmetric operations at once
+ * @entries:	operations to run, in order
+ * @count:	number of entries
+ *
+ * The entries are passed to the TEE core in as few syscalls as possible
+ * where all buffers are checked once before the operations run back to
+ * back. An operation is the equivalent of TEE_CipherUpdate(),
+ * TEE_CipherDoFinal(), TEE_MACUpdate(), TEE_MACComputeFinal(),
+ * TEE_AEUpdateAAD() or TEE_AEUpdate() on its operation handle. The
+ * UTEE_CRYP_BATCH_MAC_* operations on a digest operation are the
+ * equivalent of TEE_DigestUpdate() and TEE_DigestDoFinal(). Since the
+ * partial block buffering of those functions is bypassed, cipher and AE
+ * payload entries must hold whole blocks and the operation must not have
+ * buffered data. XTS and CTS operations and digests being extracted
+ * aren't supported. AE final operations and all init functions still
+ * have to be called separately.
+ *
+ * Each entry is checked against the state its operation is left in by
+ * the preceding entries, assuming they succeed. An entry only valid if
+ * an earlier one fails, like a MAC update after a MAC final, is rejected
+ * with TEE_ERROR_BAD_STATE.
+ *
+ * The result of each entry is stored in its @result field, an entry that
+ * fails with anything else than TEE_ERROR_SHORT_BUFFER leaves its
+ * operation in an undefined state.
+ *
+ * Returns TEE_SUCCESS when all entries have been processed, or
+ * TEE_ERROR_OUT_OF_MEMORY if the TEE core ran out of memory. In that case
+ * the entries not yet run have @result set to TEE_ERROR_OUT_OF_MEMORY and
+ * their operations are unchanged.
+ */
+TEE_Result TEE_CryptoBatch(TEE_CryptoBatchEntry *entries, size_t count);
+
 #endif
@@ -79,8 +79,10 @@
 #define TEE_SCN_SE_CHANNEL_CLOSE__DEPRECATED		69
 /* End of deprecated Secure Element API syscalls */
 #define TEE_SCN_CACHE_OPERATION			70
+#define TEE_SCN_STORAGE_ENUM_NEXT_IDS		71
+#define TEE_SCN_CRYP_BATCH			72
 
-#define TEE_SCN_MAX				70
+#define TEE_SCN_MAX				72
 
 /* Maximum number of allowed arguments for a syscall */
 #define TEE_SVC_MAX_ARGS			8
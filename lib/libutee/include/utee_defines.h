@@ -73,6 +73,8 @@ static inline uint32_t __tee_alg_get_class(uint32_t algo)
 		return TEE_OPERATION_MAC;
 	if (algo == TEE_ALG_SM4_XTS)
 		return TEE_OPERATION_CIPHER;
+	if (algo == TEE_ALG_SM4_CCM || algo == TEE_ALG_SM4_GCM)
+		return TEE_OPERATION_AE;
 	if (algo == TEE_ALG_RSASSA_PKCS1_PSS_MGF1_MD5)
 		return TEE_OPERATION_ASYMMETRIC_SIGNATURE;
 	if (algo == TEE_ALG_RSAES_PKCS1_OAEP_MGF1_MD5)
@@ -149,6 +149,12 @@ TEE_Result _utee_authenc_dec_final(unsigned long state, const void *src_data,
 				   uint64_t *dest_len, const void *tag,
 				   size_t tag_len);
 
+/*
+ * Runs @count descriptors back to back, the result of each descriptor is
+ * returned in its @res field
+ */
+TEE_Result _utee_cryp_batch(struct utee_cryp_batch_op *ops, size_t count);
+
 TEE_Result _utee_asymm_operate(unsigned long state,
 			       const struct utee_attribute *params,
 			       unsigned long num_params, const void *src_data,
@@ -203,6 +209,16 @@ TEE_Result _utee_storage_next_enum(unsigned long obj_enum,
 				   struct utee_object_info *info,
 				   void *obj_id, uint64_t *len);
 
+/*
+ * obj_enum is of type TEE_ObjectEnumHandle
+ * Fills @buf with struct utee_object_id_entry for objects with an ID
+ * starting with @prefix, *len is updated with the used size
+ */
+TEE_Result _utee_storage_next_enum_ids(unsigned long obj_enum,
+				       const void *prefix, size_t prefix_len,
+				       void *buf, uint64_t *len,
+				       uint32_t *count);
+
 /* Data Stream Access Functions */
 /* obj is of type TEE_ObjectHandle */
 TEE_Result _utee_storage_obj_read(unsigned long obj, void *data, size_t len,
@@ -67,4 +67,45 @@ struct utee_object_info {
 	uint32_t handle_flags;
 };
 
+/*
+ * Entry returned by _utee_storage_next_enum_ids(), the next entry starts
+ * at the following 32-bit aligned offset.
+ */
+struct utee_object_id_entry {
+	uint32_t id_len;
+	uint8_t id[];
+};
+
+/*
+ * Operations of struct utee_cryp_batch_op, UTEE_CRYP_BATCH_MAC_* also
+ * apply to digest operations. A digest is initialized again by
+ * UTEE_CRYP_BATCH_MAC_FINAL.
+ */
+#define UTEE_CRYP_BATCH_CIPHER_UPDATE	0
+#define UTEE_CRYP_BATCH_CIPHER_FINAL	1
+#define UTEE_CRYP_BATCH_MAC_UPDATE	2
+#define UTEE_CRYP_BATCH_MAC_FINAL	3
+#define UTEE_CRYP_BATCH_AE_UPDATE_AAD	4
+#define UTEE_CRYP_BATCH_AE_UPDATE	5
+
+/* Maximum number of descriptors passed to _utee_cryp_batch() */
+#define UTEE_CRYP_BATCH_MAX_OPS		64
+
+/*
+ * Descriptor passed to _utee_cryp_batch(), @src and @dst are user space
+ * addresses. @dst_len is updated with the number of bytes written to
+ * @dst, or the number of bytes needed if @res is TEE_ERROR_SHORT_BUFFER.
+ * @res receives the result of this descriptor.
+ */
+struct utee_cryp_batch_op {
+	uint32_t state;
+	uint32_t op;
+	uint64_t src;
+	uint64_t src_len;
+	uint64_t dst;
+	uint64_t dst_len;
+	uint32_t res;
+	uint32_t pad;
+};
+
 #endif /* UTEE_TYPES_H */
@@ -6,6 +6,7 @@
 #include <string.h>
 
 #include <tee_api.h>
+#include <tee_internal_api_extensions.h>
 #include <utee_syscalls.h>
 #include "tee_api_private.h"
 
@@ -889,6 +890,42 @@ out:
 	return res;
 }
 
+TEE_Result TEE_GetNextPersistentObjectIDs(TEE_ObjectEnumHandle objectEnumerator,
+					  const void *prefix, size_t prefixLen,
+					  void *buffer, size_t *bufferLen,
+					  uint32_t *count)
+{
+	TEE_Result res = TEE_SUCCESS;
+	uint32_t cnt = 0;
+	uint64_t len = 0;
+
+	__utee_check_inout_annotation(bufferLen, sizeof(*bufferLen));
+	__utee_check_out_annotation(count, sizeof(*count));
+
+	if (!buffer || (prefixLen && !prefix)) {
+		res = TEE_ERROR_BAD_PARAMETERS;
+		goto out;
+	}
+
+	len = *bufferLen;
+	res = _utee_storage_next_enum_ids((unsigned long)objectEnumerator,
+					  prefix, prefixLen, buffer, &len,
+					  &cnt);
+	if (res == TEE_SUCCESS || res == TEE_ERROR_SHORT_BUFFER)
+		*bufferLen = len;
+	*count = cnt;
+
+out:
+	if (res != TEE_SUCCESS &&
+	    res != TEE_ERROR_ITEM_NOT_FOUND &&
+	    res != TEE_ERROR_SHORT_BUFFER &&
+	    res != TEE_ERROR_CORRUPT_OBJECT &&
+	    res != TEE_ERROR_STORAGE_NOT_AVAILABLE)
+		TEE_Panic(res);
+
+	return res;
+}
+
 /* Data and Key Storage API  - Data Stream Access Functions */
 
 TEE_Result TEE_ReadObjectData(TEE_ObjectHandle object, void *buffer,
@@ -142,6 +142,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 	case TEE_ALG_AES_ECB_NOPAD:
 	case TEE_ALG_AES_CBC_NOPAD:
 	case TEE_ALG_AES_CCM:
+	case TEE_ALG_SM4_CCM:
 	case TEE_ALG_DES_ECB_NOPAD:
 	case TEE_ALG_DES_CBC_NOPAD:
 	case TEE_ALG_DES3_ECB_NOPAD:
@@ -158,6 +159,7 @@ TEE_Result TEE_AllocateOperation(TEE_OperationHandle *operation,
 		fallthrough;
 	case TEE_ALG_AES_CTR:
 	case TEE_ALG_AES_GCM:
+	case TEE_ALG_SM4_GCM:
 		if (mode == TEE_MODE_ENCRYPT)
 			req_key_usage = TEE_USAGE_ENCRYPT;
 		else if (mode == TEE_MODE_DECRYPT)
@@ -1585,7 +1587,8 @@ TEE_Result TEE_AEInit(TEE_OperationHandle operation, const void *nonce,
 	 * according to the same principle so we have to check here instead to
 	 * be GP compliant.
 	 */
-	if (operation->info.algorithm == TEE_ALG_AES_GCM) {
+	if (operation->info.algorithm == TEE_ALG_AES_GCM ||
+	    operation->info.algorithm == TEE_ALG_SM4_GCM) {
 		/*
 		 * From GP spec: For AES-GCM, can be 128, 120, 112, 104, or 96
 		 */
@@ -1999,6 +2002,221 @@ TEE_Result __GP11_TEE_AEDecryptFinal(TEE_OperationHandle operation,
 	return res;
 }
 
+/* Cryptographic Operations API - Batched Symmetric Functions (extension) */
+
+/* Number of entries passed to the TEE core per syscall */
+#define CRYPTO_BATCH_CHUNK	16
+
+/*
+ * State of an operation once the entries of the current chunk preceding
+ * the one being prepared have succeeded
+ */
+struct crypto_batch_state {
+	TEE_OperationHandle operation;
+	uint32_t handle_state;
+	uint32_t operation_state;
+};
+
+static TEE_Result crypto_batch_check(const TEE_CryptoBatchEntry *e,
+				     struct crypto_batch_state *s)
+{
+	TEE_OperationHandle o = e->operation;
+	bool initialized = s->handle_state & TEE_HANDLE_FLAG_INITIALIZED;
+	uint32_t op_class = o->info.operationClass;
+
+	switch (e->op) {
+	case UTEE_CRYP_BATCH_CIPHER_UPDATE:
+	case UTEE_CRYP_BATCH_CIPHER_FINAL:
+		if (op_class != TEE_OPERATION_CIPHER || !initialized ||
+		    s->operation_state != TEE_OPERATION_STATE_ACTIVE)
+			return TEE_ERROR_BAD_STATE;
+		/* Whole blocks only, see tee_buffer_update() */
+		if (o->buffer_two_blocks || o->buffer_offs ||
+		    e->srcLen % o->block_size)
+			return TEE_ERROR_BAD_PARAMETERS;
+		if (e->op == UTEE_CRYP_BATCH_CIPHER_FINAL) {
+			s->handle_state &= ~TEE_HANDLE_FLAG_INITIALIZED;
+			s->operation_state = TEE_OPERATION_STATE_INITIAL;
+		}
+		return TEE_SUCCESS;
+	case UTEE_CRYP_BATCH_MAC_UPDATE:
+	case UTEE_CRYP_BATCH_MAC_FINAL:
+		if (op_class == TEE_OPERATION_DIGEST) {
+			/* Extraction is buffered by TEE_DigestExtract() */
+			if (s->operation_state ==
+			    TEE_OPERATION_STATE_EXTRACTING)
+				return TEE_ERROR_BAD_STATE;
+			if (e->op == UTEE_CRYP_BATCH_MAC_UPDATE)
+				s->operation_state =
+					TEE_OPERATION_STATE_ACTIVE;
+			else
+				s->operation_state =
+					TEE_OPERATION_STATE_INITIAL;
+			return TEE_SUCCESS;
+		}
+		if (op_class != TEE_OPERATION_MAC || !initialized ||
+		    s->operation_state != TEE_OPERATION_STATE_ACTIVE)
+			return TEE_ERROR_BAD_STATE;
+		if (e->op == UTEE_CRYP_BATCH_MAC_FINAL) {
+			s->handle_state &= ~TEE_HANDLE_FLAG_INITIALIZED;
+			s->operation_state = TEE_OPERATION_STATE_INITIAL;
+		}
+		return TEE_SUCCESS;
+	case UTEE_CRYP_BATCH_AE_UPDATE_AAD:
+		if (op_class != TEE_OPERATION_AE || !initialized ||
+		    s->operation_state != TEE_OPERATION_STATE_INITIAL)
+			return TEE_ERROR_BAD_STATE;
+		return TEE_SUCCESS;
+	case UTEE_CRYP_BATCH_AE_UPDATE:
+		if (op_class != TEE_OPERATION_AE || !initialized)
+			return TEE_ERROR_BAD_STATE;
+		if (o->buffer_offs || e->srcLen % o->block_size)
+			return TEE_ERROR_BAD_PARAMETERS;
+		/* The first payload moves the operation to the active state */
+		if (e->srcLen)
+			s->operation_state = TEE_OPERATION_STATE_ACTIVE;
+		return TEE_SUCCESS;
+	default:
+		return TEE_ERROR_BAD_PARAMETERS;
+	}
+}
+
+/*
+ * Checks @e against the state its operation is left in by the entries
+ * already in the chunk, @st holds the @num_st operations they use.
+ */
+static TEE_Result crypto_batch_prepare(const TEE_CryptoBatchEntry *e,
+				       struct crypto_batch_state *st,
+				       size_t *num_st,
+				       struct utee_cryp_batch_op *op)
+{
+	TEE_OperationHandle o = e->operation;
+	struct crypto_batch_state s = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t n = 0;
+
+	if (o == TEE_HANDLE_NULL || (!e->src && e->srcLen))
+		return TEE_ERROR_BAD_PARAMETERS;
+
+	for (n = 0; n < *num_st; n++)
+		if (st[n].operation == o)
+			break;
+	if (n < *num_st)
+		s = st[n];
+	else
+		s = (struct crypto_batch_state){
+			.operation = o,
+			.handle_state = o->info.handleState,
+			.operation_state = o->operationState,
+		};
+
+	res = crypto_batch_check(e, &s);
+	if (res)
+		return res;
+
+	st[n] = s;
+	if (n == *num_st)
+		(*num_st)++;
+
+	*op = (struct utee_cryp_batch_op){
+		.state = o->state,
+		.op = e->op,
+		.src = (vaddr_t)e->src,
+		.src_len = e->srcLen,
+		.dst = (vaddr_t)e->dest,
+		.dst_len = e->destLen,
+	};
+
+	return TEE_SUCCESS;
+}
+
+static void crypto_batch_complete(TEE_CryptoBatchEntry *e,
+				  const struct utee_cryp_batch_op *op)
+{
+	TEE_OperationHandle o = e->operation;
+
+	e->result = op->res;
+	if (e->op != UTEE_CRYP_BATCH_MAC_UPDATE &&
+	    e->op != UTEE_CRYP_BATCH_AE_UPDATE_AAD &&
+	    (op->res == TEE_SUCCESS || op->res == TEE_ERROR_SHORT_BUFFER))
+		e->destLen = op->dst_len;
+	if (op->res != TEE_SUCCESS)
+		return;
+
+	switch (e->op) {
+	case UTEE_CRYP_BATCH_MAC_UPDATE:
+		if (o->info.operationClass == TEE_OPERATION_DIGEST)
+			o->operationState = TEE_OPERATION_STATE_ACTIVE;
+		break;
+	case UTEE_CRYP_BATCH_MAC_FINAL:
+		if (o->info.operationClass == TEE_OPERATION_DIGEST) {
+			/* Initialized again by the TEE core */
+			o->buffer_offs = 0;
+			o->operationState = TEE_OPERATION_STATE_INITIAL;
+			break;
+		}
+		fallthrough;
+	case UTEE_CRYP_BATCH_CIPHER_FINAL:
+		o->info.handleState &= ~TEE_HANDLE_FLAG_INITIALIZED;
+		o->operationState = TEE_OPERATION_STATE_INITIAL;
+		break;
+	case UTEE_CRYP_BATCH_AE_UPDATE:
+		if (e->srcLen)
+			o->operationState = TEE_OPERATION_STATE_ACTIVE;
+		break;
+	default:
+		break;
+	}
+}
+
+TEE_Result TEE_CryptoBatch(TEE_CryptoBatchEntry *entries, size_t count)
+{
+	struct crypto_batch_state st[CRYPTO_BATCH_CHUNK] = { };
+	struct utee_cryp_batch_op ops[CRYPTO_BATCH_CHUNK] = { };
+	size_t idx[CRYPTO_BATCH_CHUNK] = { };
+	TEE_Result res = TEE_SUCCESS;
+	size_t num_st = 0;
+	size_t size = 0;
+	size_t num = 0;
+	size_t n = 0;
+	size_t m = 0;
+
+	if (MUL_OVERFLOW(count, sizeof(*entries), &size))
+		TEE_Panic(0);
+	__utee_check_inout_annotation(entries, size);
+
+	while (n < count) {
+		/* Entries failing the checks are never passed on */
+		num_st = 0;
+		for (num = 0; n < count && num < CRYPTO_BATCH_CHUNK; n++) {
+			entries[n].result = crypto_batch_prepare(entries + n,
+								 st, &num_st,
+								 ops + num);
+			if (entries[n].result == TEE_SUCCESS)
+				idx[num++] = n;
+		}
+		if (!num)
+			continue;
+
+		res = _utee_cryp_batch(ops, num);
+		if (res == TEE_ERROR_OUT_OF_MEMORY) {
+			/* Nothing in this chunk has run */
+			for (m = 0; m < num; m++)
+				entries[idx[m]].result = res;
+			for (m = n; m < count; m++)
+				entries[m].result = res;
+			return res;
+		}
+		if (res != TEE_SUCCESS)
+			TEE_Panic(res);
+
+		for (m = 0; m < num; m++)
+			crypto_batch_complete(entries + idx[m], ops + m);
+	}
+
+	return TEE_SUCCESS;
+}
+
 /* Cryptographic Operations API - Asymmetric Functions */
 
 TEE_Result TEE_AsymmetricEncrypt(TEE_OperationHandle operation,
@@ -2582,6 +2800,15 @@ TEE_Result TEE_IsAlgorithmSupported(uint32_t alg, uint32_t element)
 			if (alg == TEE_ALG_SM4_XTS)
 				goto check_element_none;
 		}
+		if (IS_ENABLED(CFG_CRYPTO_CCM)) {
+			if (alg == TEE_ALG_SM4_CCM)
+				goto check_element_none;
+		}
+		if (IS_ENABLED(CFG_CRYPTO_GCM) && IS_ENABLED(CFG_CRYPTO_AES) &&
+		    !IS_ENABLED(CFG_CRYPTO_AES_GCM_FROM_CRYPTOLIB)) {
+			if (alg == TEE_ALG_SM4_GCM)
+				goto check_element_none;
+		}
 	}
 	if (IS_ENABLED(CFG_CRYPTO_RSA)) {
 		if (IS_ENABLED(CFG_CRYPTO_MD5)) {
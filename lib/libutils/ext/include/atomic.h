@@ -23,6 +23,12 @@ static inline bool atomic_cas_u32(uint32_t *p, uint32_t *oval, uint32_t nval)
 	return __compiler_compare_and_swap(p, oval, nval);
 }
 
+static inline bool atomic_cas_short(short int *p, short int *oval,
+				    short int nval)
+{
+	return __compiler_compare_and_swap(p, oval, nval);
+}
+
 static inline int atomic_load_int(int *p)
 {
 	return __compiler_atomic_load(p);
@@ -63,4 +69,22 @@ static inline void atomic_store_u32(uint32_t *p, uint32_t val)
 	__compiler_atomic_store(p, val);
 }
 
+/*
+ * Stores @val in *@p, all memory accesses before the call are visible to
+ * an observer of the new value
+ */
+static inline void atomic_store_release_short(short int *p, short int val)
+{
+	__atomic_store_n(p, val, __ATOMIC_RELEASE);
+}
+
+/*
+ * Clears the bits in @mask in *@p, all memory accesses before the call
+ * are visible to an observer of the new value
+ */
+static inline void atomic_clear_bits_release_u32(uint32_t *p, uint32_t mask)
+{
+	__atomic_fetch_and(p, ~mask, __ATOMIC_RELEASE);
+}
+
 #endif /*__ATOMIC_H*/
@@ -94,7 +94,10 @@
 #if defined(__KERNEL__)
 /* Compiling for TEE Core */
 #include <kernel/asan.h>
+#include <kernel/misc.h>
+#include <kernel/panic.h>
 #include <kernel/spinlock.h>
+#include <kernel/thread.h>
 #include <kernel/unwind.h>
 
 static void *memset_unchecked(void *s, int c, size_t n)
@@ -270,6 +273,346 @@ static void tag_asan_free(void *buf __maybe_unused, size_t len __maybe_unused)
 #endif
 }
 
+/*
+ * Per-CPU magazine caches for small allocations
+ *
+ * Each core keeps a small stack (magazine) of free buffers per size class.
+ * malloc(), calloc() and free() of small buffers are served from the
+ * magazine of the current core, only taking the global heap lock to refill
+ * or flush half a magazine at a time. Buffers in a magazine are still
+ * allocated as far as bget is concerned, they are wiped when cached so
+ * that a buffer handed out again never holds data of its previous owner.
+ *
+ * Since bget doesn't see buffers going into a magazine it can't detect
+ * double frees of them. Instead the first word of a freed buffer is set
+ * to its address xored with MAG_FREE_TAG. Freeing a buffer which carries
+ * that tag triggers a search of the magazines and a panic if the buffer
+ * is found there.
+ *
+ * Lock order: per-core magazine lock before the heap lock.
+ */
+#if defined(__KERNEL__) && defined(CFG_CORE_MALLOC_MAGAZINES) && \
+	!defined(ENABLE_MDBG) && !defined(CFG_CORE_SANITIZE_KADDRESS)
+#define WITH_MAGAZINES	1
+
+#define MAG_NUM_CLASSES	4
+#define MAG_MIN_SIZE	32
+#define MAG_MAX_SIZE	(MAG_MIN_SIZE << (MAG_NUM_CLASSES - 1))
+#define MAG_SIZE	8
+#define MAG_BATCH	(MAG_SIZE / 2)
+#define MAG_FREE_TAG	((uintptr_t)0xa55a5aa5c33c3cc3ULL)
+
+struct malloc_mag {
+	void *buf[MAG_SIZE];
+	unsigned int count;
+	/* Statistics */
+	uint32_t alloc_hit;
+	uint32_t alloc_miss;
+	uint32_t free_hit;
+	uint32_t refill;
+	uint32_t flush;
+};
+
+struct malloc_mag_cpu {
+	unsigned int lock;
+	size_t cached_bytes;
+	struct malloc_mag mag[MAG_NUM_CLASSES];
+} __aligned(64);
+
+static struct malloc_mag_cpu malloc_mags[CFG_TEE_CORE_NB_CORE];
+
+static size_t mag_class_size(unsigned int cls)
+{
+	return MAG_MIN_SIZE << cls;
+}
+
+/* Returns the smallest class which can hold @size bytes */
+static int mag_alloc_class(size_t size)
+{
+	unsigned int cls = 0;
+
+	if (size > MAG_MAX_SIZE)
+		return -1;
+
+	while (mag_class_size(cls) < size)
+		cls++;
+
+	return cls;
+}
+
+/* Returns the class a buffer of @buf_size usable bytes is recycled into */
+static int mag_free_class(size_t buf_size)
+{
+	int cls = MAG_NUM_CLASSES - 1;
+
+	if (buf_size < MAG_MIN_SIZE || buf_size >= MAG_MAX_SIZE * 2)
+		return -1;
+
+	while (mag_class_size(cls) > buf_size)
+		cls--;
+
+	return cls;
+}
+
+static size_t mag_buf_bytes(void *buf)
+{
+	return bget_buf_size(buf) + sizeof(struct bhead);
+}
+
+static uintptr_t mag_free_tag(void *buf)
+{
+	return (uintptr_t)buf ^ MAG_FREE_TAG;
+}
+
+/* Returns true if @buf is cached in magazine @cls of any core */
+static bool mag_is_cached(void *buf, int cls)
+{
+	uint32_t exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	struct malloc_mag *m = NULL;
+	bool found = false;
+	size_t n = 0;
+	unsigned int i = 0;
+
+	for (n = 0; n < ARRAY_SIZE(malloc_mags) && !found; n++) {
+		cpu_spin_lock(&malloc_mags[n].lock);
+		m = malloc_mags[n].mag + cls;
+		for (i = 0; i < m->count && !found; i++)
+			found = m->buf[i] == buf;
+		cpu_spin_unlock(&malloc_mags[n].lock);
+	}
+	thread_unmask_exceptions(exceptions);
+
+	return found;
+}
+
+static struct malloc_mag_cpu *mag_cpu_lock(uint32_t *exceptions)
+{
+	struct malloc_mag_cpu *mc = NULL;
+
+	*exceptions = thread_mask_exceptions(THREAD_EXCP_ALL);
+	mc = malloc_mags + get_core_pos();
+	cpu_spin_lock(&mc->lock);
+
+	return mc;
+}
+
+static void mag_cpu_unlock(struct malloc_mag_cpu *mc, uint32_t exceptions)
+{
+	cpu_spin_unlock(&mc->lock);
+	thread_unmask_exceptions(exceptions);
+}
+
+/* Called with the magazine lock held and exceptions masked */
+static void mag_refill(struct malloc_mag_cpu *mc, struct malloc_mag *m,
+		       size_t size, struct malloc_ctx *ctx)
+{
+	void *p = NULL;
+
+	cpu_spin_lock(&ctx->spinlock);
+	while (m->count < MAG_BATCH) {
+		p = bget(SizeQ, 0, size, &ctx->poolset);
+		if (!p)
+			break;
+		m->buf[m->count++] = p;
+		mc->cached_bytes += mag_buf_bytes(p);
+	}
+#ifdef BufStats
+	if (ctx->poolset.totalloc > ctx->mstats.max_allocated)
+		ctx->mstats.max_allocated = ctx->poolset.totalloc;
+#endif
+	cpu_spin_unlock(&ctx->spinlock);
+	m->refill++;
+}
+
+/* Called with the magazine lock held and exceptions masked */
+static void mag_flush(struct malloc_mag_cpu *mc, struct malloc_mag *m,
+		      unsigned int keep, struct malloc_ctx *ctx)
+{
+	void *p = NULL;
+
+	cpu_spin_lock(&ctx->spinlock);
+	while (m->count > keep) {
+		p = m->buf[--m->count];
+		mc->cached_bytes -= mag_buf_bytes(p);
+		brel(p, &ctx->poolset, false /* !wipe */);
+	}
+	cpu_spin_unlock(&ctx->spinlock);
+	m->flush++;
+}
+
+static void *mag_alloc(size_t size)
+{
+	struct malloc_mag_cpu *mc = NULL;
+	struct malloc_mag *m = NULL;
+	uint32_t exceptions = 0;
+	void *p = NULL;
+	int cls = mag_alloc_class(size);
+
+	if (cls < 0 || MEMTAG_IS_ENABLED)
+		return NULL;
+
+	mc = mag_cpu_lock(&exceptions);
+	m = mc->mag + cls;
+	if (m->count) {
+		m->alloc_hit++;
+	} else {
+		m->alloc_miss++;
+		mag_refill(mc, m, mag_class_size(cls), &malloc_ctx);
+	}
+	if (m->count) {
+		p = m->buf[--m->count];
+		mc->cached_bytes -= mag_buf_bytes(p);
+		*(uintptr_t *)p = 0;
+	}
+	mag_cpu_unlock(mc, exceptions);
+
+	return p;
+}
+
+static bool mag_free(void *ptr)
+{
+	struct malloc_mag_cpu *mc = NULL;
+	struct malloc_mag *m = NULL;
+	uint32_t exceptions = 0;
+	size_t sz = 0;
+	int cls = 0;
+
+	if (!ptr || MEMTAG_IS_ENABLED)
+		return false;
+
+	/* The size of an allocated buffer doesn't change, no lock needed */
+	sz = bget_buf_size(ptr);
+	cls = mag_free_class(sz);
+	if (cls < 0)
+		return false;
+
+	if (*(uintptr_t *)ptr == mag_free_tag(ptr) && mag_is_cached(ptr, cls)) {
+		EMSG("Double free of %p", ptr);
+		panic();
+	}
+
+	memset_unchecked(ptr, 0, sz);
+	*(uintptr_t *)ptr = mag_free_tag(ptr);
+
+	mc = mag_cpu_lock(&exceptions);
+	m = mc->mag + cls;
+	if (m->count == MAG_SIZE)
+		mag_flush(mc, m, MAG_SIZE - MAG_BATCH, &malloc_ctx);
+	m->buf[m->count++] = ptr;
+	mc->cached_bytes += mag_buf_bytes(ptr);
+	m->free_hit++;
+	mag_cpu_unlock(mc, exceptions);
+
+	return true;
+}
+
+/* Returns all cached buffers to the heap, used when the heap is exhausted */
+static bool mag_drain(void)
+{
+	struct malloc_mag_cpu *mc = NULL;
+	uint32_t exceptions = 0;
+	bool drained = false;
+	size_t n = 0;
+	size_t c = 0;
+
+	for (n = 0; n < ARRAY_SIZE(malloc_mags); n++) {
+		mc = malloc_mags + n;
+		exceptions = cpu_spin_lock_xsave(&mc->lock);
+		for (c = 0; c < MAG_NUM_CLASSES; c++) {
+			if (mc->mag[c].count) {
+				mag_flush(mc, mc->mag + c, 0, &malloc_ctx);
+				drained = true;
+			}
+		}
+		cpu_spin_unlock_xrestore(&mc->lock, exceptions);
+	}
+
+	return drained;
+}
+
+static size_t mag_cached_bytes(void)
+{
+	uint32_t exceptions = 0;
+	size_t bytes = 0;
+	size_t n = 0;
+
+	for (n = 0; n < ARRAY_SIZE(malloc_mags); n++) {
+		exceptions = cpu_spin_lock_xsave(&malloc_mags[n].lock);
+		bytes += malloc_mags[n].cached_bytes;
+		cpu_spin_unlock_xrestore(&malloc_mags[n].lock, exceptions);
+	}
+
+	return bytes;
+}
+
+#ifdef CFG_WITH_STATS
+size_t malloc_get_cache_stats(struct pta_stats_malloc_cache *stats,
+			      size_t count)
+{
+	struct pta_stats_malloc_cache st[MAG_NUM_CLASSES] = { };
+	struct malloc_mag *m = NULL;
+	uint32_t exceptions = 0;
+	size_t n = 0;
+	size_t c = 0;
+
+	if (!stats)
+		return MAG_NUM_CLASSES;
+
+	for (c = 0; c < MAG_NUM_CLASSES; c++)
+		st[c].obj_size = mag_class_size(c);
+
+	for (n = 0; n < ARRAY_SIZE(malloc_mags); n++) {
+		exceptions = cpu_spin_lock_xsave(&malloc_mags[n].lock);
+		for (c = 0; c < MAG_NUM_CLASSES; c++) {
+			m = malloc_mags[n].mag + c;
+			st[c].cached += m->count;
+			st[c].alloc_hit += m->alloc_hit;
+			st[c].alloc_miss += m->alloc_miss;
+			st[c].free_hit += m->free_hit;
+			st[c].refill += m->refill;
+			st[c].flush += m->flush;
+		}
+		cpu_spin_unlock_xrestore(&malloc_mags[n].lock, exceptions);
+	}
+
+	memcpy(stats, st, MIN(count, (size_t)MAG_NUM_CLASSES) * sizeof(*st));
+
+	return MAG_NUM_CLASSES;
+}
+#endif /*CFG_WITH_STATS*/
+
+#else /*CFG_CORE_MALLOC_MAGAZINES*/
+
+static __maybe_unused void *mag_alloc(size_t size __unused)
+{
+	return NULL;
+}
+
+static __maybe_unused bool mag_free(void *ptr __unused)
+{
+	return false;
+}
+
+static __maybe_unused bool mag_drain(void)
+{
+	return false;
+}
+
+static size_t __maybe_unused mag_cached_bytes(void)
+{
+	return 0;
+}
+
+#if defined(__KERNEL__) && defined(CFG_WITH_STATS)
+size_t malloc_get_cache_stats(struct pta_stats_malloc_cache *stats __unused,
+			      size_t count __unused)
+{
+	return 0;
+}
+#endif
+
+#endif /*CFG_CORE_MALLOC_MAGAZINES*/
+
 #ifdef BufStats
 
 static void *raw_malloc_return_hook(void *p, size_t hdr_size,
@@ -320,6 +663,8 @@ static void gen_malloc_get_stats(struct malloc_ctx *ctx,
 void malloc_get_stats(struct pta_stats_alloc *stats)
 {
 	gen_malloc_get_stats(&malloc_ctx, stats);
+	/* Buffers cached in the magazines are free from a user perspective */
+	stats->allocated -= mag_cached_bytes();
 }
 
 #else /* BufStats */
@@ -786,17 +1131,30 @@ void *realloc(void *ptr, size_t size)
 void *malloc(size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
+
+	p = mag_alloc(size);
+	if (p)
+		return p;
 
+	exceptions = malloc_lock(&malloc_ctx);
 	p = raw_malloc(0, 0, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!p && mag_drain())
+		return malloc(size);
+
 	return p;
 }
 
 static void free_helper(void *ptr, bool wipe)
 {
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
+
+	if (mag_free(ptr))
+		return;
 
+	exceptions = malloc_lock(&malloc_ctx);
 	raw_free(ptr, &malloc_ctx, wipe);
 	malloc_unlock(&malloc_ctx, exceptions);
 }
@@ -804,10 +1162,22 @@ static void free_helper(void *ptr, bool wipe)
 void *calloc(size_t nmemb, size_t size)
 {
 	void *p;
-	uint32_t exceptions = malloc_lock(&malloc_ctx);
+	uint32_t exceptions;
+	size_t s = 0;
 
+	if (!MUL_OVERFLOW(nmemb, size, &s)) {
+		p = mag_alloc(s);
+		if (p)
+			return memset(p, 0, s);
+	}
+
+	exceptions = malloc_lock(&malloc_ctx);
 	p = raw_calloc(0, 0, nmemb, size, &malloc_ctx);
 	malloc_unlock(&malloc_ctx, exceptions);
+
+	if (!p && mag_drain())
+		return calloc(nmemb, size);
+
 	return p;
 }
 
@@ -84,6 +84,14 @@ void malloc_add_pool(void *buf, size_t len);
 /* Get/reset allocation statistics */
 void malloc_get_stats(struct pta_stats_alloc *stats);
 void malloc_reset_stats(void);
+
+/*
+ * Get statistics of the core heap per-CPU small allocation caches. Fills
+ * at most @count entries of @stats, one per size class, and returns the
+ * number of size classes.
+ */
+size_t malloc_get_cache_stats(struct pta_stats_malloc_cache *stats,
+			      size_t count);
 #endif /* CFG_WITH_STATS */
 
 
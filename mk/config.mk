@@ -197,6 +197,15 @@ CFG_RPMB_FS_CACHE_ENTRIES ?= 0
 # Print RPMB data frames sent to and received from the RPMB device
 CFG_RPMB_FS_DEBUG_DATA ?= n
 
+# Pack up to the device "Reliable Write Sector Count" worth of data frames
+# in a single authenticated RPMB write instead of one frame per write. Only
+# enable this when the normal world RPMB driver (tee-supplicant and the eMMC
+# host driver) supports multi-frame authenticated writes. Each authenticated
+# write costs one RPC round trip and one write counter increment, so this
+# greatly reduces the number of RPMB transactions for file data and FAT
+# updates.
+CFG_RPMB_DRIVER_MULTIPLE_WRITE_FIXED ?= n
+
 # Clear RPMB content at cold boot
 CFG_RPMB_RESET_FAT ?= n
 
@@ -215,6 +224,12 @@ CFG_RPMB_WRITE_KEY ?= n
 
 _CFG_WITH_SECURE_STORAGE := $(call cfg-one-enabled,CFG_REE_FS CFG_RPMB_FS)
 
+# Accumulate per thread timing of secure storage phases (RPC wait, crypto,
+# hash tree update and dirfile commit) for the secure storage benchmark in
+# the invoke tests pseudo TA. Defaults to enabled when the core self tests
+# are embedded.
+CFG_TEE_FS_PERF_STATS ?= $(CFG_TEE_CORE_EMBED_INTERNAL_TESTS)
+
 # Signing key for OP-TEE TA's
 # When performing external HSM signing for TA's TA_SIGN_KEY can be set to dummy
 # key and then set TA_PUBLIC_KEY to match public key from the HSM.
@@ -433,6 +448,12 @@ CFG_CORE_PAGE_TAG_AND_IV ?= $(CFG_PAGED_USER_TA)
 CFG_LOCKDEP ?= n
 CFG_LOCKDEP_RECORD_STACK ?= y
 
+# CFG_CORE_MUTEX_SPIN_US, when non-zero, makes a thread finding a mutex
+# write locked by a thread running on another core poll it for up to this
+# many microseconds before waiting in normal world. This saves the two world
+# switches of a sleep and wakeup when the lock is only held briefly.
+CFG_CORE_MUTEX_SPIN_US ?= 0
+
 # BestFit algorithm in bget reduces the fragmentation of the heap when running
 # with the pager enabled or lockdep
 CFG_CORE_BGET_BESTFIT ?= $(call cfg-one-enabled, CFG_WITH_PAGER CFG_LOCKDEP)
@@ -575,6 +596,14 @@ CFG_BOOT_SECONDARY_REQUEST ?= n
 # Default heap size for Core, 64 kB
 CFG_CORE_HEAP_SIZE ?= 65536
 
+# CFG_CORE_MALLOC_MAGAZINES, when enabled, serves small core heap
+# allocations (up to 256 bytes) from per-CPU caches of free buffers and only
+# takes the global heap lock to refill or flush a batch of buffers. This
+# reduces lock contention when several cores allocate concurrently, at the
+# cost of a few kB of heap held in the caches. The caches are bypassed with
+# memory tagging, KASan and malloc debug.
+CFG_CORE_MALLOC_MAGAZINES ?= n
+
 # Default size of nexus heap. 16 kB. Used only if CFG_NS_VIRTUALIZATION
 # is enabled
 CFG_CORE_NEX_HEAP_SIZE ?= 16384
@@ -689,6 +718,19 @@ CFG_CORE_THREAD_SHIFT ?= 0
 # non-secure memory).
 CFG_CORE_DYN_SHM ?= y
 
+# CFG_TA_PARAM_MAP_CACHE_ENTRIES, when non-zero, is the number of memref
+# parameter regions of registered shared memory which a user TA context
+# keeps between calls from the same session. If the next call passes the
+# same buffer its mapping is reused as is, without page table or TLB
+# maintenance. Otherwise the buffer is unmapped before the TA is entered
+# and only the virtual address range is kept, so a TA can't access a
+# cached buffer in calls where it isn't passed as a parameter. A later
+# call passing the buffer maps it again at the same address. The regions
+# are removed before the TA is entered once normal world has unregistered
+# the shared memory.
+# Has no effect without CFG_CORE_DYN_SHM or with CFG_CORE_FFA.
+CFG_TA_PARAM_MAP_CACHE_ENTRIES ?= 0
+
 # Enable support for reserved shared memory (shared memory in a carved out
 # memory area).
 CFG_CORE_RESERVED_SHM ?= y
@@ -710,6 +752,13 @@ CFG_TA_BIGNUM_MAX_BITS ?= 2048
 # Set this to a lower value to reduce the memory footprint.
 CFG_CORE_BIGNUM_MAX_BITS ?= 4096
 
+# CFG_CORE_BIGNUM_ASM, when enabled, uses the AArch64 inline assembly
+# multiply-accumulate kernels of the MbedTLS bignum implementation in the
+# TEE core. They are the inner loops of Montgomery multiplication and thus
+# of RSA, DH and ECC whether MbedTLS or LibTomCrypt is the crypto library.
+CFG_CORE_BIGNUM_ASM ?= n
+$(eval $(call cfg-depends-all,CFG_CORE_BIGNUM_ASM,CFG_ARM64_core))
+
 # Not used since libmpa was removed. Force the values to catch build scripts
 # that would set = n.
 $(call force,CFG_TA_MBEDTLS_MPI,y)
@@ -730,6 +779,15 @@ CFG_TA_MBEDTLS_SELF_TEST ?= y
 CFG_CRYPTOLIB_NAME ?= tomcrypt
 CFG_CRYPTOLIB_DIR ?= core/lib/libtomcrypt
 
+# CFG_TEE_OBJ_KEY_CACHE, when enabled, keeps the crypto context keyed by a
+# cipher or AE init in the key object used. A later init of the same
+# algorithm with that object copies the expanded key (and GHASH key for
+# AES-GCM) instead of deriving it again. The cached context is freed when
+# the object is closed or its attributes change. Only implementations which
+# can be restarted with a new IV are cached, currently AES ECB, CBC, CTR
+# and GCM.
+CFG_TEE_OBJ_KEY_CACHE ?= n
+
 # Not used since libmpa was removed. Force the value to catch build scripts
 # that would set = n.
 $(call force,CFG_CORE_MBEDTLS_MPI,y)